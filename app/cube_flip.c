@@ -147,12 +147,12 @@ int Entry(int argc, char **argv) {
         }
 
     float aspect = (float)window.width / (float)window.height;
-    drawFrame.projection = M4MakePerspectiveProjection(PI32/4.0f, aspect, 0.1f, 100.f);
+    set_projection(M4MakePerspectiveProjection(PI32/4.0f, aspect, 0.1f, 100.f));
 
     Vec3 camPos = Vec3(sinf(camYaw)*cosf(camPitch)*camDist,
                            sinf(camPitch)*camDist,
                            cosf(camYaw)*cosf(camPitch)*camDist);
-    drawFrame.cameraXform = M4MakeLookAt(camPos, Vec3(0,0,0), Vec3(0,1,0));
+    set_camera_xform(M4MakeLookAt(camPos, Vec3(0,0,0), Vec3(0,1,0)));
 
         // draw board
         for(int y=0;y<BOARD_SIZE;y++)
@@ -24,6 +24,7 @@ typedef enum {
     BACKEND_VULKAN,
     BACKEND_D3D11,
     BACKEND_SOFTWARE,
+    BACKEND_NULL, // Draws nothing, needs no SDL or display
     BACKEND_AUTO // Auto-detect based on platform
 } Graphics_Backend;
 
@@ -46,6 +47,7 @@ void print_usage(const char* program_name) {
     printf("  --vulkan              Use Vulkan backend\n");
     printf("  --d3d11               Use Direct3D 11 backend (Windows only)\n");
     printf("  --software            Use Software rendering backend\n");
+    printf("  --null                Use Null backend (draws nothing, no SDL or display needed)\n");
     printf("  --auto                Auto-detect best graphics backend (default)\n");
     printf("  --interactive         Interactive mode for build options\n");
     printf("  --help                Show this help\n");
@@ -100,13 +102,15 @@ void get_interactive_options(Build_Options* opts) {
         printf("\n4. Direct3D 11");
     }
     printf("\n5. Software (CPU) renderer\n");
+    printf("6. Null (headless, draws nothing)\n");
     
-    choice = get_user_choice("Select graphics backend", "1-5");
+    choice = get_user_choice("Select graphics backend", "1-6");
     switch (choice) {
         case '2': opts->graphics_backend = BACKEND_OPENGL; break;
         case '3': opts->graphics_backend = BACKEND_VULKAN; break;
         case '4': opts->graphics_backend = IS_WINDOWS ? BACKEND_D3D11 : BACKEND_AUTO; break;
         case '5': opts->graphics_backend = BACKEND_SOFTWARE; break;
+        case '6': opts->graphics_backend = BACKEND_NULL; break;
         case '1':
         default:  opts->graphics_backend = BACKEND_AUTO; break;
     }
@@ -139,6 +143,8 @@ Build_Options parse_args(int argc, char** argv) {
             opts.graphics_backend = BACKEND_D3D11;
         } else if (strcmp(argv[i], "--software") == 0) {
             opts.graphics_backend = BACKEND_SOFTWARE;
+        } else if (strcmp(argv[i], "--null") == 0) {
+            opts.graphics_backend = BACKEND_NULL;
         } else if (strcmp(argv[i], "--auto") == 0) {
             opts.graphics_backend = BACKEND_AUTO;
         } else if (strcmp(argv[i], "--interactive") == 0) {
@@ -236,6 +242,11 @@ int main(int argc, char **argv) {
             backend_flags = "-DRENDERER_OPENGL=0 -DRENDERER_VULKAN=0 -DRENDERER_D3D11=0 -DRENDERER_SOFTWARE=1";
             break;
             
+        case BACKEND_NULL:
+            backend_name = "Null";
+            backend_flags = "-DRENDERER_OPENGL=0 -DRENDERER_VULKAN=0 -DRENDERER_D3D11=0 -DRENDERER_SOFTWARE=0 -DRENDERER_NULL=1";
+            break;
+            
         default:
             backend_name = "Unknown";
             backend_flags = "-DRENDERER_OPENGL=0 -DRENDERER_VULKAN=0 -DRENDERER_D3D11=0 -DRENDERER_SOFTWARE=1";
@@ -247,10 +258,13 @@ int main(int argc, char **argv) {
     // No need to compile them separately - this avoids multiple definition errors
     const char *gal_source_files = "";
     
-    // Add SDL2 dependency for GAL
-    char* extended_backend_flags = malloc(strlen(backend_flags) + 100);
-    sprintf(extended_backend_flags, "%s -lSDL2", backend_flags);
-    backend_flags = extended_backend_flags;
+    // Add SDL2 dependency for GAL, the null backend doesn't use it
+    int needs_sdl2 = opts.graphics_backend != BACKEND_NULL;
+    if (needs_sdl2) {
+        char* extended_backend_flags = malloc(strlen(backend_flags) + 100);
+        sprintf(extended_backend_flags, "%s -lSDL2", backend_flags);
+        backend_flags = extended_backend_flags;
+    }
     
     // Build command based on platform
     #if IS_WINDOWS
@@ -306,8 +320,8 @@ int main(int argc, char **argv) {
     #elif IS_LINUX
         printf("Building for Linux with %s backend...\n", backend_name);
         
-        // Check for necessary dependencies - SDL2 is always needed for GAL
-        int sdl2_available = system("pkg-config --exists sdl2") == 0;
+        // Check for necessary dependencies - SDL2 is needed for every GAL backend except null
+        int sdl2_available = !needs_sdl2 || system("pkg-config --exists sdl2") == 0;
         
         if (!sdl2_available) {
             printf("Warning: SDL2 development libraries not found, but required for GAL.\n");
@@ -322,8 +336,8 @@ int main(int argc, char **argv) {
         char full_files[512];
         sprintf(full_files, "%s%s", files, gal_source_files);
 
-        // Build the command - SDL2 is always required for GAL
-        const char* sdl_flags = "`pkg-config --cflags --libs sdl2`";
+        // Build the command
+        const char* sdl_flags = needs_sdl2 ? "`pkg-config --cflags --libs sdl2`" : "";
 
         cmd = "gcc -I. "
               "%s "  // Optimization flags
@@ -0,0 +1,185 @@
+#ifndef OOGABOOGA_ARRAY_H
+#define OOGABOOGA_ARRAY_H
+
+#include <stdint.h>
+#include <string.h>
+#include "base.h"
+
+/*
+
+	Typed dynamic arrays.
+
+	Unlike growing_array, these know their type at compile time so pushing is just a capacity
+	check and a store, and counts are u64.
+
+	DECLARE_ARRAY(Type) goes where the type is declared (usually a header) and DEFINE_ARRAY(Type)
+	in the .c file. That gives you Type_Array:
+
+		typedef struct Type_Array {
+			Type *data;
+			u64 count;
+			u64 capacity;
+			Allocator allocator;
+		} Type_Array;
+
+	DECLARE_SMALL_ARRAY(Name, Type, N)/DEFINE_SMALL_ARRAY(Name, Type, N) does the same but keeps
+	the first N items inline in the struct, so short lists don't allocate at all. Since data
+	points into the struct itself while the items are inline, a small array must not be copied
+	by value until it has grown past N.
+
+	Full API, where Name is Type_Array or the name you gave the small array:
+
+		void  Name_init(Name *a, Allocator allocator);
+		void  Name_init_reserve(Name *a, u64 count_to_reserve, Allocator allocator);
+		void  Name_deinit(Name *a);
+
+		void  Name_reserve(Name *a, u64 count_to_reserve);
+		void  Name_resize(Name *a, u64 new_count); // New items are uninitialized
+
+		Type *Name_push(Name *a, Type item);
+		Type *Name_push_uninitialized(Name *a);
+		Type *Name_push_n_uninitialized(Name *a, u64 n); // Returns the first of the n new items
+		void  Name_pop(Name *a);
+		void  Name_clear(Name *a);
+
+		void  Name_ordered_remove(Name *a, u64 index);
+		void  Name_unordered_remove(Name *a, u64 index);
+
+	A zero initialized array is valid and will use the heap allocator when it first grows.
+
+	Usage:
+
+		// thing.h
+		DECLARE_ARRAY(Thing)
+		// thing.c
+		DEFINE_ARRAY(Thing)
+
+		Thing_Array things = ZERO(Thing_Array);
+		Thing_Array_push(&things, thing);
+		for (u64 i = 0; i < things.count; i++) do_thing(&things.data[i]);
+		Thing_Array_deinit(&things);
+
+	Growth:
+
+		Capacity doubles, and the allocation is rounded up to ARRAY_ALLOCATION_GRANULARITY since
+		the heap hands out that granularity anyway, so the slack becomes usable capacity.
+		None of our allocators can grow a block in place (heap reallocate is alloc+copy+free and
+		temp/arena don't reallocate at all), so we allocate the new block ourselves and copy only
+		the valid items rather than the whole old capacity.
+
+*/
+
+#define ARRAY_MIN_CAPACITY 8
+// Same as HEAP_ALIGNMENT
+#define ARRAY_ALLOCATION_GRANULARITY 16
+
+#define _ARRAY_NO_INLINE_STORAGE(a) (0)
+#define _ARRAY_INLINE_STORAGE(a) ((a)->inline_items)
+
+#define _DECLARE_ARRAY_FUNCTIONS(Name, Type) \
+	void  Name##_init(Name *a, Allocator allocator); \
+	void  Name##_init_reserve(Name *a, u64 count_to_reserve, Allocator allocator); \
+	void  Name##_deinit(Name *a); \
+	void  Name##_grow(Name *a, u64 min_capacity); \
+	void  Name##_reserve(Name *a, u64 count_to_reserve); \
+	void  Name##_resize(Name *a, u64 new_count); \
+	Type *Name##_push(Name *a, Type item); \
+	Type *Name##_push_uninitialized(Name *a); \
+	Type *Name##_push_n_uninitialized(Name *a, u64 n); \
+	void  Name##_pop(Name *a); \
+	void  Name##_clear(Name *a); \
+	void  Name##_ordered_remove(Name *a, u64 index); \
+	void  Name##_unordered_remove(Name *a, u64 index);
+
+#define DECLARE_ARRAY(Type) \
+	typedef struct Type##_Array { \
+		Type *data; \
+		u64 count; \
+		u64 capacity; \
+		Allocator allocator; \
+	} Type##_Array; \
+	_DECLARE_ARRAY_FUNCTIONS(Type##_Array, Type)
+
+#define DECLARE_SMALL_ARRAY(Name, Type, inline_capacity) \
+	typedef struct Name { \
+		Type *data; \
+		u64 count; \
+		u64 capacity; \
+		Allocator allocator; \
+		Type inline_items[inline_capacity]; \
+	} Name; \
+	_DECLARE_ARRAY_FUNCTIONS(Name, Type)
+
+#define DEFINE_ARRAY(Type) _DEFINE_ARRAY(Type##_Array, Type, 0, _ARRAY_NO_INLINE_STORAGE)
+#define DEFINE_SMALL_ARRAY(Name, Type, inline_capacity) _DEFINE_ARRAY(Name, Type, inline_capacity, _ARRAY_INLINE_STORAGE)
+
+#define _DEFINE_ARRAY(Name, Type, inline_capacity, INLINE_STORAGE) \
+	void Name##_init(Name *a, Allocator allocator) { \
+		a->data = (Type*)INLINE_STORAGE(a); \
+		a->count = 0; \
+		a->capacity = (inline_capacity); \
+		a->allocator = allocator; \
+	} \
+	void Name##_init_reserve(Name *a, u64 count_to_reserve, Allocator allocator) { \
+		Name##_init(a, allocator); \
+		Name##_reserve(a, count_to_reserve); \
+	} \
+	void Name##_deinit(Name *a) { \
+		if (a->data && a->data != (Type*)INLINE_STORAGE(a)) Dealloc(a->allocator, a->data); \
+		a->data = 0; \
+		a->count = 0; \
+		a->capacity = 0; \
+	} \
+	void Name##_grow(Name *a, u64 min_capacity) { \
+		if (!a->allocator.proc) a->allocator = GetHeapAllocator(); \
+		u64 new_capacity = max(max(a->capacity*2, ARRAY_MIN_CAPACITY), min_capacity); \
+		u64 bytes = align_next(new_capacity*sizeof(Type), ARRAY_ALLOCATION_GRANULARITY); \
+		new_capacity = bytes/sizeof(Type); \
+		Type *new_data = (Type*)alloc_uninitialized(a->allocator, bytes); \
+		if (a->count) memcpy(new_data, a->data, a->count*sizeof(Type)); \
+		if (a->data && a->data != (Type*)INLINE_STORAGE(a)) Dealloc(a->allocator, a->data); \
+		a->data = new_data; \
+		a->capacity = new_capacity; \
+	} \
+	void Name##_reserve(Name *a, u64 count_to_reserve) { \
+		if (count_to_reserve > a->capacity) Name##_grow(a, count_to_reserve); \
+	} \
+	void Name##_resize(Name *a, u64 new_count) { \
+		Name##_reserve(a, new_count); \
+		a->count = new_count; \
+	} \
+	inline Type *Name##_push(Name *a, Type item) { \
+		if (a->count == a->capacity) Name##_grow(a, a->count + 1); \
+		Type *p = &a->data[a->count++]; \
+		*p = item; \
+		return p; \
+	} \
+	inline Type *Name##_push_uninitialized(Name *a) { \
+		if (a->count == a->capacity) Name##_grow(a, a->count + 1); \
+		return &a->data[a->count++]; \
+	} \
+	inline Type *Name##_push_n_uninitialized(Name *a, u64 n) { \
+		if (a->count + n > a->capacity) Name##_grow(a, a->count + n); \
+		Type *first = &a->data[a->count]; \
+		a->count += n; \
+		return first; \
+	} \
+	void Name##_pop(Name *a) { \
+		assert(a->count > 0, "No items to pop in " #Name); \
+		a->count -= 1; \
+	} \
+	void Name##_clear(Name *a) { \
+		a->count = 0; \
+	} \
+	void Name##_ordered_remove(Name *a, u64 index) { \
+		assert(index < a->count, #Name " index out of range"); \
+		memmove(&a->data[index], &a->data[index+1], (a->count-index-1)*sizeof(Type)); \
+		a->count -= 1; \
+	} \
+	void Name##_unordered_remove(Name *a, u64 index) { \
+		assert(index < a->count, #Name " index out of range"); \
+		a->data[index] = a->data[a->count-1]; \
+		a->count -= 1; \
+	}
+
+#endif
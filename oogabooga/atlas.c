@@ -0,0 +1,393 @@
+
+///
+// Texture atlas
+//
+
+typedef Atlas_Sprite *Atlas_Sprite_Pointer;
+
+// Tallest first packs tightest with a skyline. The rest is just so the order doesn't depend
+// on the sort.
+DEFINE_SORT(Atlas_Sprite_Pointer,
+	a[0]->image.height != b[0]->image.height ? a[0]->image.height > b[0]->image.height :
+	a[0]->image.width  != b[0]->image.width  ? a[0]->image.width  > b[0]->image.width  :
+	a[0]->index < b[0]->index)
+
+void atlas_init(Texture_Atlas *atlas, u32 page_width, u32 page_height, u32 channels, Allocator allocator) {
+	assert(page_width > 0 && page_height > 0, "Atlas pages can't be empty");
+	assert(channels >= 1 && channels <= 4, "Atlas pages need 1-4 channels, got %u", channels);
+
+	*atlas = ZERO(Texture_Atlas);
+	atlas->page_width  = page_width;
+	atlas->page_height = page_height;
+	atlas->channels    = channels;
+	atlas->padding     = 1;
+	atlas->extrude     = true;
+	atlas->max_pages   = ATLAS_MAX_PAGES;
+	atlas->allocator   = allocator;
+
+	bucket_array_init(&atlas->sprites, sizeof(Atlas_Sprite));
+}
+
+void atlas_deinit(Texture_Atlas *atlas) {
+	for (u32 i = 0; i < atlas->page_count; i++) {
+		Atlas_Page *page = &atlas->pages[i];
+		gal_destroy_image(&page->image);
+		Dealloc(atlas->allocator, page->pixels);
+		Dealloc(atlas->allocator, page->skyline);
+	}
+	bucket_array_deinit(&atlas->sprites);
+	*atlas = ZERO(Texture_Atlas);
+}
+
+bool atlas_is_resident(Gal_Image *sprite) {
+	assert(sprite->atlas_sprite, "atlas_is_resident: image is not an atlas sprite");
+	return sprite->atlas_sprite->page != 0;
+}
+
+void atlas_page_reset(Texture_Atlas *atlas, Atlas_Page *page) {
+	page->skyline[0].x = 0;
+	page->skyline[0].y = 0;
+	page->skyline[0].width = atlas->page_width;
+	page->skyline_count = 1;
+	page->used_area = 0;
+}
+
+Atlas_Page *atlas_make_page(Texture_Atlas *atlas) {
+	assert(atlas->page_count < ATLAS_MAX_PAGES, "Too many atlas pages");
+
+	Atlas_Page *page = &atlas->pages[atlas->page_count];
+	*page = ZERO(Atlas_Page);
+
+	u64 size = (u64)atlas->page_width*atlas->page_height*atlas->channels;
+	page->pixels = (u8*)alloc_uninitialized(atlas->allocator, size);
+	memset(page->pixels, 0, size);
+	// Every placed rect adds at most one node, and nodes are at least a pixel wide
+	page->skyline = (Atlas_Skyline_Node*)alloc_uninitialized(atlas->allocator, (atlas->page_width+1)*sizeof(Atlas_Skyline_Node));
+	atlas_page_reset(atlas, page);
+
+	if (gal_create_image(&page->image, atlas->page_width, atlas->page_height, atlas->channels, page->pixels, false, atlas->allocator) != GAL_RESULT_SUCCESS) {
+		// No renderer (yet), the page still works on the CPU
+		page->image.width    = atlas->page_width;
+		page->image.height   = atlas->page_height;
+		page->image.channels = atlas->channels;
+		page->image.allocator = atlas->allocator;
+	}
+
+	atlas->page_count += 1;
+	return page;
+}
+
+// Where a width*height rect fits on top of the skyline starting at node i
+bool atlas_skyline_fit(Texture_Atlas *atlas, Atlas_Page *page, u32 i, u32 width, u32 height, u32 *y) {
+	u32 x = page->skyline[i].x;
+	if (x + width > atlas->page_width) return false;
+
+	u32 top = 0;
+	s64 remaining = width;
+	while (remaining > 0) {
+		top = max(top, page->skyline[i].y);
+		if (top + height > atlas->page_height) return false;
+		remaining -= page->skyline[i].width;
+		i += 1;
+	}
+	*y = top;
+	return true;
+}
+
+// Bottom-left: the spot where the top of the rect ends up lowest, then the narrowest node
+bool atlas_skyline_find(Texture_Atlas *atlas, Atlas_Page *page, u32 width, u32 height, u32 *node_index, u32 *x, u32 *y) {
+	u32 best_top = 0xFFFFFFFF;
+	u32 best_width = 0xFFFFFFFF;
+	bool found = false;
+
+	for (u32 i = 0; i < page->skyline_count; i++) {
+		u32 fit_y;
+		if (!atlas_skyline_fit(atlas, page, i, width, height, &fit_y)) continue;
+
+		u32 top = fit_y + height;
+		if (top < best_top || (top == best_top && page->skyline[i].width < best_width)) {
+			best_top = top;
+			best_width = page->skyline[i].width;
+			*node_index = i;
+			*x = page->skyline[i].x;
+			*y = fit_y;
+			found = true;
+		}
+	}
+	return found;
+}
+
+void atlas_skyline_add(Atlas_Page *page, u32 node_index, u32 x, u32 y, u32 width, u32 height) {
+	Atlas_Skyline_Node *nodes = page->skyline;
+
+	memmove(&nodes[node_index+1], &nodes[node_index], (page->skyline_count-node_index)*sizeof(Atlas_Skyline_Node));
+	nodes[node_index].x = x;
+	nodes[node_index].y = y + height;
+	nodes[node_index].width = width;
+	page->skyline_count += 1;
+
+	// Cut away what's now under the new node
+	u32 i = node_index + 1;
+	while (i < page->skyline_count) {
+		u32 end = nodes[i-1].x + nodes[i-1].width;
+		if (nodes[i].x >= end) break;
+
+		u32 shrink = end - nodes[i].x;
+		if (nodes[i].width > shrink) {
+			nodes[i].x += shrink;
+			nodes[i].width -= shrink;
+			break;
+		}
+		memmove(&nodes[i], &nodes[i+1], (page->skyline_count-i-1)*sizeof(Atlas_Skyline_Node));
+		page->skyline_count -= 1;
+	}
+
+	for (u32 j = 0; j+1 < page->skyline_count; ) {
+		if (nodes[j].y == nodes[j+1].y) {
+			nodes[j].width += nodes[j+1].width;
+			memmove(&nodes[j+1], &nodes[j+2], (page->skyline_count-j-2)*sizeof(Atlas_Skyline_Node));
+			page->skyline_count -= 1;
+		} else {
+			j += 1;
+		}
+	}
+
+	page->used_area += (u64)width*height;
+}
+
+void atlas_upload_rows(Texture_Atlas *atlas, Atlas_Page *page, u32 y, u32 height) {
+	u64 row_bytes = (u64)atlas->page_width*atlas->channels;
+	// Whole rows are contiguous in the page, so no staging copy is needed
+	gal_update_image_data(&page->image, 0, y, atlas->page_width, height, page->pixels + y*row_bytes);
+}
+
+// Copies the pixels to the inside of the padded rect at x, y and fills the padding
+void atlas_blit(Texture_Atlas *atlas, Atlas_Page *page, u32 x, u32 y, u32 width, u32 height, const u8 *pixels) {
+	u32 c = atlas->channels;
+	u32 p = atlas->padding;
+	u64 row_bytes = (u64)atlas->page_width*c;
+
+	for (u32 row = 0; row < height; row++) {
+		u8 *dst = page->pixels + (y+p+row)*row_bytes + (u64)(x+p)*c;
+		memcpy(dst, pixels + (u64)row*width*c, (u64)width*c);
+
+		if (atlas->extrude) {
+			for (u32 i = 1; i <= p; i++) {
+				memcpy(dst - i*c, dst, c);
+				memcpy(dst + (u64)(width-1+i)*c, dst + (u64)(width-1)*c, c);
+			}
+		}
+	}
+
+	if (atlas->extrude) {
+		u64 padded_bytes = (u64)(width + 2*p)*c;
+		u8 *first = page->pixels + (y+p)*row_bytes + (u64)x*c;
+		u8 *last  = page->pixels + (y+p+height-1)*row_bytes + (u64)x*c;
+		for (u32 i = 1; i <= p; i++) {
+			memcpy(first - i*row_bytes, first, padded_bytes);
+			memcpy(last  + i*row_bytes, last,  padded_bytes);
+		}
+	}
+}
+
+void atlas_place_sprite(Texture_Atlas *atlas, Atlas_Sprite *sprite, u32 page_index, u32 x, u32 y) {
+	Atlas_Page *page = &atlas->pages[page_index];
+	u32 p = atlas->padding;
+
+	sprite->page = &page->image;
+	sprite->page_index = page_index;
+	sprite->x = x;
+	sprite->y = y;
+	sprite->uv.x = (float32)(x + p) / (float32)atlas->page_width;
+	sprite->uv.y = (float32)(y + p) / (float32)atlas->page_height;
+	sprite->uv.z = (float32)(x + p + sprite->image.width)  / (float32)atlas->page_width;
+	sprite->uv.w = (float32)(y + p + sprite->image.height) / (float32)atlas->page_height;
+}
+
+// Finds room in the existing pages
+bool atlas_try_place(Texture_Atlas *atlas, u32 padded_width, u32 padded_height, u32 *page_index, u32 *x, u32 *y) {
+	for (u32 i = 0; i < atlas->page_count; i++) {
+		Atlas_Page *page = &atlas->pages[i];
+		u32 node_index;
+		if (atlas_skyline_find(atlas, page, padded_width, padded_height, &node_index, x, y)) {
+			atlas_skyline_add(page, node_index, *x, *y, padded_width, padded_height);
+			*page_index = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void atlas_repack(Texture_Atlas *atlas) {
+	u64 sprite_count = bucket_array_get_count(&atlas->sprites);
+
+	Atlas_Sprite_Pointer *sprites = 0;
+	u64 resident_count = 0;
+	if (sprite_count) {
+		sprites = (Atlas_Sprite_Pointer*)alloc_uninitialized(GetHeapAllocator(), sprite_count*sizeof(Atlas_Sprite_Pointer));
+		for (u64 i = 0; i < sprite_count; i++) {
+			Atlas_Sprite *sprite = (Atlas_Sprite*)bucket_array_get(&atlas->sprites, i);
+			if (sprite->in_use && sprite->page) sprites[resident_count++] = sprite;
+		}
+	}
+	sort_Atlas_Sprite_Pointer(sprites, resident_count);
+
+	// Pack into fresh buffers and copy over from the old ones
+	u8 *old_pixels[ATLAS_MAX_PAGES];
+	u32 old_page_count = atlas->page_count;
+	u64 page_size = (u64)atlas->page_width*atlas->page_height*atlas->channels;
+	for (u32 i = 0; i < old_page_count; i++) {
+		Atlas_Page *page = &atlas->pages[i];
+		old_pixels[i] = page->pixels;
+		page->pixels = (u8*)alloc_uninitialized(atlas->allocator, page_size);
+		memset(page->pixels, 0, page_size);
+		atlas_page_reset(atlas, page);
+	}
+
+	u64 row_bytes = (u64)atlas->page_width*atlas->channels;
+	for (u64 i = 0; i < resident_count; i++) {
+		Atlas_Sprite *sprite = sprites[i];
+		u32 padded_width  = sprite->image.width  + 2*atlas->padding;
+		u32 padded_height = sprite->image.height + 2*atlas->padding;
+
+		u32 page_index, x, y;
+		bool placed = atlas_try_place(atlas, padded_width, padded_height, &page_index, &x, &y);
+		// Sorted packing is almost always tighter than what we had, but not guaranteed to be
+		if (!placed && atlas->page_count < min(atlas->max_pages, ATLAS_MAX_PAGES)) {
+			atlas_make_page(atlas);
+			placed = atlas_try_place(atlas, padded_width, padded_height, &page_index, &x, &y);
+		}
+		if (!placed) {
+			log_warning("Atlas repack ran out of room, evicting a %ux%u sprite", sprite->image.width, sprite->image.height);
+			sprite->page = 0;
+			atlas->eviction_count += 1;
+			continue;
+		}
+
+		u8 *src = old_pixels[sprite->page_index] + sprite->y*row_bytes + (u64)sprite->x*atlas->channels;
+		u8 *dst = atlas->pages[page_index].pixels + y*row_bytes + (u64)x*atlas->channels;
+		for (u32 row = 0; row < padded_height; row++) {
+			memcpy(dst + row*row_bytes, src + row*row_bytes, (u64)padded_width*atlas->channels);
+		}
+
+		atlas_place_sprite(atlas, sprite, page_index, x, y);
+	}
+
+	for (u32 i = 0; i < old_page_count; i++) {
+		Dealloc(atlas->allocator, old_pixels[i]);
+		atlas_upload_rows(atlas, &atlas->pages[i], 0, atlas->page_height);
+	}
+	for (u32 i = old_page_count; i < atlas->page_count; i++) {
+		atlas_upload_rows(atlas, &atlas->pages[i], 0, atlas->page_height);
+	}
+	if (sprites) Dealloc(GetHeapAllocator(), sprites);
+
+	atlas->removed_area = 0;
+	atlas->generation += 1;
+	atlas->repack_count += 1;
+}
+
+// Evicts the evictable sprite that was drawn the longest time ago. Returns its padded area,
+// or 0 if there was nothing to evict.
+u64 atlas_evict_one(Texture_Atlas *atlas) {
+	Atlas_Sprite *oldest = 0;
+	for (u64 i = 0; i < bucket_array_get_count(&atlas->sprites); i++) {
+		Atlas_Sprite *sprite = (Atlas_Sprite*)bucket_array_get(&atlas->sprites, i);
+		if (!sprite->in_use || !sprite->page || !(sprite->flags & ATLAS_SPRITE_EVICTABLE)) continue;
+		if (!oldest || sprite->last_drawn < oldest->last_drawn) oldest = sprite;
+	}
+	if (!oldest) return 0;
+
+	oldest->page = 0;
+	atlas->eviction_count += 1;
+
+	u64 area = (u64)(oldest->image.width + 2*atlas->padding)*(oldest->image.height + 2*atlas->padding);
+	atlas->removed_area += area;
+	return area;
+}
+
+Gal_Image *atlas_add(Texture_Atlas *atlas, u32 width, u32 height, const void *pixels, u32 flags) {
+	assert(width > 0 && height > 0, "atlas_add: empty image");
+	assert(pixels, "atlas_add: no pixels");
+
+	u32 padded_width  = width  + 2*atlas->padding;
+	u32 padded_height = height + 2*atlas->padding;
+	if (padded_width > atlas->page_width || padded_height > atlas->page_height) {
+		log_warning("Image of %ux%u doesn't fit in a %ux%u atlas page with %u padding", width, height, atlas->page_width, atlas->page_height, atlas->padding);
+		return 0;
+	}
+
+	u32 page_index, x, y;
+	bool placed = atlas_try_place(atlas, padded_width, padded_height, &page_index, &x, &y);
+
+	if (!placed && atlas->removed_area > 0) {
+		atlas_repack(atlas);
+		placed = atlas_try_place(atlas, padded_width, padded_height, &page_index, &x, &y);
+	}
+	if (!placed && atlas->page_count < min(atlas->max_pages, ATLAS_MAX_PAGES)) {
+		atlas_make_page(atlas);
+		placed = atlas_try_place(atlas, padded_width, padded_height, &page_index, &x, &y);
+	}
+	while (!placed) {
+		// Evict about enough to make room, then see if repacking found it
+		u64 needed = (u64)padded_width*padded_height;
+		u64 freed = 0;
+		u64 evicted;
+		while (freed < needed && (evicted = atlas_evict_one(atlas))) freed += evicted;
+		if (freed == 0) break;
+
+		atlas_repack(atlas);
+		placed = atlas_try_place(atlas, padded_width, padded_height, &page_index, &x, &y);
+	}
+	if (!placed) return 0;
+
+	Atlas_Sprite *sprite;
+	if (atlas->first_free) {
+		sprite = (Atlas_Sprite*)bucket_array_get(&atlas->sprites, atlas->first_free-1);
+		atlas->first_free = sprite->next_free;
+	} else {
+		sprite = (Atlas_Sprite*)bucket_array_push(&atlas->sprites);
+	}
+	*sprite = ZERO(Atlas_Sprite);
+	sprite->image.width    = width;
+	sprite->image.height   = height;
+	sprite->image.channels = atlas->channels;
+	sprite->image.format   = atlas->pages[page_index].image.format;
+	sprite->image.allocator = atlas->allocator;
+	sprite->image.atlas_sprite = sprite;
+	sprite->flags = flags;
+	sprite->in_use = true;
+	sprite->last_drawn = rdtsc();
+	sprite->index = atlas->next_index++;
+
+	atlas_blit(atlas, &atlas->pages[page_index], x, y, width, height, (const u8*)pixels);
+	atlas_upload_rows(atlas, &atlas->pages[page_index], y, padded_height);
+	atlas_place_sprite(atlas, sprite, page_index, x, y);
+
+	return &sprite->image;
+}
+
+void atlas_remove(Texture_Atlas *atlas, Gal_Image *image) {
+	Atlas_Sprite *sprite = image->atlas_sprite;
+	assert(sprite && sprite->in_use, "atlas_remove: image is not a sprite in this atlas");
+
+	// Evicted sprites are already counted
+	if (sprite->page) {
+		atlas->removed_area += (u64)(sprite->image.width + 2*atlas->padding)*(sprite->image.height + 2*atlas->padding);
+	}
+
+	u64 index = 0;
+	for (u64 c = 0; c < bucket_array_get_chunk_count(&atlas->sprites); c++) {
+		u64 n;
+		Atlas_Sprite *chunk = (Atlas_Sprite*)bucket_array_get_chunk(&atlas->sprites, c, &n);
+		if (sprite >= chunk && sprite < chunk + n) {
+			index += (u64)(sprite - chunk);
+			break;
+		}
+		index += n;
+	}
+
+	*sprite = ZERO(Atlas_Sprite);
+	sprite->next_free = atlas->first_free;
+	atlas->first_free = index + 1;
+}
@@ -0,0 +1,143 @@
+#ifndef OOGABOOGA_ATLAS_H
+#define OOGABOOGA_ATLAS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "base.h"
+#include "linmath.h"
+#include "gal.h"
+#include "bucket_array.h"
+
+/*
+
+	Texture atlas: packs many small images into a few shared pages, so sprites with different
+	images can still be drawn in the same draw call.
+
+	Adding an image gives back a Gal_Image* for the sprite which can be passed to draw_image
+	and friends like any other image. They draw it as the sprite's uv rect in its page instead.
+
+	Full API:
+
+		void atlas_init(Texture_Atlas *atlas, u32 page_width, u32 page_height, u32 channels, Allocator allocator);
+		void atlas_deinit(Texture_Atlas *atlas);
+
+		// Pixels are width*height*channels bytes, laid out like for gal_create_image.
+		// Returns 0 if the image doesn't fit in a page at all, or if the atlas is full and
+		// nothing could be evicted.
+		Gal_Image *atlas_add(Texture_Atlas *atlas, u32 width, u32 height, const void *pixels, u32 flags);
+		void atlas_remove(Texture_Atlas *atlas, Gal_Image *sprite);
+
+		// Packs all sprites again from scratch, which gets back the space of removed sprites
+		void atlas_repack(Texture_Atlas *atlas);
+
+		// False if the sprite was evicted
+		bool atlas_is_resident(Gal_Image *sprite);
+
+	Usage:
+
+		Texture_Atlas atlas;
+		atlas_init(&atlas, 2048, 2048, 4, GetHeapAllocator());
+
+		Gal_Image *player = atlas_add(&atlas, 16, 16, player_pixels, 0);
+		...
+		draw_image(player, v2(x, y), v2(16, 16), COLOR_WHITE);
+
+	Packing:
+
+		- Pages are packed with a bottom-left skyline, which is fast and wastes little space for
+			sprites that are added over time. atlas_repack sorts everything by height first,
+			which packs tighter.
+		- Each sprite gets atlas.padding pixels of border (1 by default). With atlas.extrude
+			(the default) the border repeats the sprite's edge pixels so linear filtering and
+			mip levels don't bleed in the neighbours, otherwise it's left transparent.
+		- When no page has room: if sprites were removed the atlas is repacked, then a new
+			page is made if there are less than atlas.max_pages, and after that the sprites
+			added with ATLAS_SPRITE_EVICTABLE which were drawn the longest time ago are evicted.
+		- Pages keep a copy of their pixels on the CPU so they can be repacked, and the rows
+			that change are uploaded right away.
+
+	Things to know:
+
+		- Repacking moves sprites. Quads that were already drawn or recorded in a Draw_List
+			keep the old uv, so invalidate draw lists when atlas.generation changes.
+		- An evicted sprite's Gal_Image stays valid but draws without a texture, check
+			atlas_is_resident and add the image again if you still need it.
+		- Draw_Quad.uv set after drawing a sprite is in page space, not sprite space.
+		- Sprites point into the Texture_Atlas, so don't move it after atlas_init.
+		- Not thread safe, add and remove from one thread at a time. Drawing sprites from several
+			threads is fine.
+
+*/
+
+#define ATLAS_MAX_PAGES 16
+
+// The atlas may evict the sprite when it runs out of pages. For sprites that can be loaded
+// again, like a cache of icons.
+#define ATLAS_SPRITE_EVICTABLE (1 << 0)
+
+typedef struct Atlas_Sprite {
+	// What's handed out for drawing, image.atlas_sprite points back here
+	Gal_Image image;
+	// The page image, 0 while the sprite is evicted
+	Gal_Image *page;
+	// x1, y1, x2, y2 of the sprite in the page, without padding
+	Vector4 uv;
+	uint32_t page_index;
+	// Top left corner of the padded rect in the page
+	uint32_t x, y;
+	uint32_t flags;
+	bool in_use;
+	// rdtsc of the last time an evictable sprite was drawn
+	uint64_t last_drawn;
+	// Order of adding, so repacking is deterministic
+	uint64_t index;
+	uint64_t next_free;
+} Atlas_Sprite;
+
+typedef struct Atlas_Skyline_Node {
+	uint32_t x, y, width;
+} Atlas_Skyline_Node;
+
+typedef struct Atlas_Page {
+	Gal_Image image;
+	uint8_t *pixels;
+	// Left to right, covering the whole page width
+	Atlas_Skyline_Node *skyline;
+	uint32_t skyline_count;
+	uint64_t used_area;
+} Atlas_Page;
+
+typedef struct Texture_Atlas {
+	uint32_t page_width, page_height, channels;
+	// Can be changed before the first sprite is added
+	uint32_t padding;
+	bool extrude;
+	uint32_t max_pages;
+
+	Atlas_Page pages[ATLAS_MAX_PAGES];
+	uint32_t page_count;
+
+	// Atlas_Sprite's, never move so the Gal_Image's handed out stay valid
+	Bucket_Array sprites;
+	// Index+1 of the first removed sprite, they're linked through next_free
+	uint64_t first_free;
+	uint64_t next_index;
+	// Padded area of removed sprites which is still taken in the pages
+	uint64_t removed_area;
+
+	// Bumped every time sprites move
+	uint64_t generation;
+	uint64_t repack_count;
+	uint64_t eviction_count;
+
+	Allocator allocator;
+} Texture_Atlas;
+
+void atlas_init(Texture_Atlas *atlas, uint32_t page_width, uint32_t page_height, uint32_t channels, Allocator allocator);
+void atlas_deinit(Texture_Atlas *atlas);
+Gal_Image *atlas_add(Texture_Atlas *atlas, uint32_t width, uint32_t height, const void *pixels, uint32_t flags);
+void atlas_remove(Texture_Atlas *atlas, Gal_Image *sprite);
+void atlas_repack(Texture_Atlas *atlas);
+bool atlas_is_resident(Gal_Image *sprite);
+
+#endif
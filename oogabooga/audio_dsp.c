@@ -0,0 +1,487 @@
+/*
+	Every kernel has a scalar, an SSE2 and an AVX2 version. The SIMD ones do what fits in
+	whole registers and leave the rest to the scalar one. The AVX2 ones are compiled for
+	AVX2 on their own, so the rest of the program doesn't need the flag, and are only run
+	if query_cpu_capabilities says the CPU has it.
+
+	Clamping is max then min in all paths, so NaN ends up at the bottom of the range the
+	same way everywhere.
+*/
+
+#if COMPILER_GCC || COMPILER_CLANG
+    #define AUDIO_DSP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define AUDIO_DSP_TARGET_AVX2
+#endif
+
+static Audio_Dsp_Path audio_dsp_path = AUDIO_DSP_PATH_AUTO;
+
+static Audio_Dsp_Path audio_dsp_best_path(void) {
+#if SIMD_ENABLE_SSE2
+	Cpu_Capabilities caps = query_cpu_capabilities();
+	if (caps.avx2) return AUDIO_DSP_PATH_AVX2;
+	if (caps.sse2) return AUDIO_DSP_PATH_SSE2;
+#endif
+	return AUDIO_DSP_PATH_SCALAR;
+}
+
+Audio_Dsp_Path audio_dsp_set_path(Audio_Dsp_Path path) {
+	Audio_Dsp_Path best = audio_dsp_best_path();
+	if (path == AUDIO_DSP_PATH_AUTO || path > best) path = best;
+	audio_dsp_path = path;
+	return path;
+}
+
+Audio_Dsp_Path audio_dsp_get_path(void) {
+	if (audio_dsp_path == AUDIO_DSP_PATH_AUTO) audio_dsp_set_path(AUDIO_DSP_PATH_AUTO);
+	return audio_dsp_path;
+}
+
+const char *audio_dsp_path_name(Audio_Dsp_Path path) {
+	switch (path) {
+		case AUDIO_DSP_PATH_AVX2:   return "AVX2";
+		case AUDIO_DSP_PATH_SSE2:   return "SSE2";
+		case AUDIO_DSP_PATH_SCALAR: return "scalar code";
+		default:                    return "auto";
+	}
+}
+
+void audio_dsp_init(void) {
+	audio_dsp_set_path(AUDIO_DSP_PATH_AUTO);
+	log_verbose("Mixing audio with %cs", audio_dsp_path_name(audio_dsp_path));
+}
+
+void audio_stereo_pan_gains(f32 pan, f32 *left_gain, f32 *right_gain) {
+	pan = pan > -1.0f ? pan : -1.0f;
+	pan = pan <  1.0f ? pan :  1.0f;
+	f32 angle = (pan + 1.0f)*PI32*0.25f;
+	*left_gain  = cosf(angle);
+	*right_gain = sinf(angle);
+}
+
+///
+// Scalar
+
+static inline f32 audio_dsp_clamp(f32 x, f32 lo, f32 hi) {
+	x = x > lo ? x : lo;
+	return x < hi ? x : hi;
+}
+
+// x is already in s16 range, rounds to the nearest like cvtps2dq
+static inline s16 audio_dsp_to_s16(f32 x) {
+	return (s16)lrintf(audio_dsp_clamp(x, -32768.0f, 32767.0f));
+}
+
+static void audio_mix_f32_scalar(f32 *dst, const f32 *src, u64 count) {
+	for (u64 i = 0; i < count; i++) {
+		dst[i] += src[i];
+	}
+}
+
+static void audio_saturate_f32_scalar(f32 *samples, u64 count) {
+	for (u64 i = 0; i < count; i++) {
+		samples[i] = audio_dsp_clamp(samples[i], -1.0f, 1.0f);
+	}
+}
+
+static void audio_mix_s16_scalar(s16 *dst, const s16 *src, u64 count) {
+	for (u64 i = 0; i < count; i++) {
+		s32 x = (s32)dst[i] + (s32)src[i];
+		dst[i] = (s16)(x < -32768 ? -32768 : x > 32767 ? 32767 : x);
+	}
+}
+
+static void audio_convert_s16_to_f32_scalar(f32 *dst, const s16 *src, u64 count) {
+	for (u64 i = 0; i < count; i++) {
+		dst[i] = (f32)src[i]*(1.0f/32768.0f);
+	}
+}
+
+static void audio_convert_f32_to_s16_scalar(s16 *dst, const f32 *src, u64 count) {
+	for (u64 i = 0; i < count; i++) {
+		dst[i] = audio_dsp_to_s16(src[i]*32768.0f);
+	}
+}
+
+// From first_frame, so the SIMD paths can hand over what's left
+static void audio_gain_ramp_f32_scalar(f32 *frames, u64 first_frame, u64 frame_count, int channels, f32 gain_from, f32 step) {
+	for (u64 f = first_frame; f < frame_count; f++) {
+		f32 gain = gain_from + step*(f32)f;
+		for (int c = 0; c < channels; c++) {
+			frames[f*channels + c] *= gain;
+		}
+	}
+}
+
+static void audio_gain_ramp_s16_scalar(s16 *frames, u64 first_frame, u64 frame_count, int channels, f32 gain_from, f32 step) {
+	for (u64 f = first_frame; f < frame_count; f++) {
+		f32 gain = gain_from + step*(f32)f;
+		for (int c = 0; c < channels; c++) {
+			s16 *s = &frames[f*channels + c];
+			*s = audio_dsp_to_s16((f32)*s*gain);
+		}
+	}
+}
+
+static void audio_pan_stereo_f32_scalar(f32 *frames, u64 first_frame, u64 frame_count, f32 left_gain, f32 right_gain) {
+	for (u64 f = first_frame; f < frame_count; f++) {
+		frames[f*2 + 0] *= left_gain;
+		frames[f*2 + 1] *= right_gain;
+	}
+}
+
+static void audio_pan_stereo_s16_scalar(s16 *frames, u64 first_frame, u64 frame_count, f32 left_gain, f32 right_gain) {
+	for (u64 f = first_frame; f < frame_count; f++) {
+		frames[f*2 + 0] = audio_dsp_to_s16((f32)frames[f*2 + 0]*left_gain);
+		frames[f*2 + 1] = audio_dsp_to_s16((f32)frames[f*2 + 1]*right_gain);
+	}
+}
+
+#if SIMD_ENABLE_SSE2
+
+///
+// SSE2, 4 samples at a time
+
+static inline __m128 audio_load_s16x4_sse2(const s16 *p) {
+	__m128i v = _mm_loadl_epi64((const __m128i*)p);
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+
+// x is already in s16 range
+static inline void audio_store_s16x4_sse2(s16 *p, __m128 x) {
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f));
+	__m128i i = _mm_cvtps_epi32(x);
+	_mm_storel_epi64((__m128i*)p, _mm_packs_epi32(i, i));
+}
+
+static void audio_mix_f32_sse2(f32 *dst, const f32 *src, u64 count) {
+	u64 i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+	}
+	audio_mix_f32_scalar(dst + i, src + i, count - i);
+}
+
+static void audio_saturate_f32_sse2(f32 *samples, u64 count) {
+	__m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+	u64 i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + i), lo), hi));
+	}
+	audio_saturate_f32_scalar(samples + i, count - i);
+}
+
+static void audio_mix_s16_sse2(s16 *dst, const s16 *src, u64 count) {
+	u64 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(dst + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(src + i));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epi16(a, b));
+	}
+	audio_mix_s16_scalar(dst + i, src + i, count - i);
+}
+
+static void audio_convert_s16_to_f32_sse2(f32 *dst, const s16 *src, u64 count) {
+	__m128 scale = _mm_set1_ps(1.0f/32768.0f);
+	u64 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		__m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		_mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+	}
+	audio_convert_s16_to_f32_scalar(dst + i, src + i, count - i);
+}
+
+static void audio_convert_f32_to_s16_sse2(s16 *dst, const f32 *src, u64 count) {
+	__m128 scale = _mm_set1_ps(32768.0f);
+	__m128 lo = _mm_set1_ps(-32768.0f), hi = _mm_set1_ps(32767.0f);
+	u64 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128 a = _mm_mul_ps(_mm_loadu_ps(src + i),     scale);
+		__m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+		__m128i ia = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(a, lo), hi));
+		__m128i ib = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(b, lo), hi));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(ia, ib));
+	}
+	audio_convert_f32_to_s16_scalar(dst + i, src + i, count - i);
+}
+
+// Frame of each of the 4 samples in a register, relative to the first one
+static inline __m128 audio_lane_frames_sse2(int channels) {
+	switch (channels) {
+		case 1:  return _mm_setr_ps(0, 1, 2, 3);
+		case 2:  return _mm_setr_ps(0, 0, 1, 1);
+		default: return _mm_setzero_ps();
+	}
+}
+
+static void audio_gain_ramp_f32_sse2(f32 *frames, u64 frame_count, int channels, f32 gain_from, f32 step) {
+	u64 f = 0;
+	if (4 % channels == 0) {
+		u64 frames_per_step = 4/channels;
+		__m128 lane_frames = audio_lane_frames_sse2(channels);
+		__m128 from = _mm_set1_ps(gain_from), steps = _mm_set1_ps(step);
+		for (; f + frames_per_step <= frame_count; f += frames_per_step) {
+			__m128 frame = _mm_add_ps(_mm_set1_ps((f32)f), lane_frames);
+			__m128 gain = _mm_add_ps(from, _mm_mul_ps(steps, frame));
+			f32 *p = frames + f*channels;
+			_mm_storeu_ps(p, _mm_mul_ps(_mm_loadu_ps(p), gain));
+		}
+	}
+	audio_gain_ramp_f32_scalar(frames, f, frame_count, channels, gain_from, step);
+}
+
+static void audio_gain_ramp_s16_sse2(s16 *frames, u64 frame_count, int channels, f32 gain_from, f32 step) {
+	u64 f = 0;
+	if (4 % channels == 0) {
+		u64 frames_per_step = 4/channels;
+		__m128 lane_frames = audio_lane_frames_sse2(channels);
+		__m128 from = _mm_set1_ps(gain_from), steps = _mm_set1_ps(step);
+		for (; f + frames_per_step <= frame_count; f += frames_per_step) {
+			__m128 frame = _mm_add_ps(_mm_set1_ps((f32)f), lane_frames);
+			__m128 gain = _mm_add_ps(from, _mm_mul_ps(steps, frame));
+			s16 *p = frames + f*channels;
+			audio_store_s16x4_sse2(p, _mm_mul_ps(audio_load_s16x4_sse2(p), gain));
+		}
+	}
+	audio_gain_ramp_s16_scalar(frames, f, frame_count, channels, gain_from, step);
+}
+
+static void audio_pan_stereo_f32_sse2(f32 *frames, u64 frame_count, f32 left_gain, f32 right_gain) {
+	__m128 gain = _mm_setr_ps(left_gain, right_gain, left_gain, right_gain);
+	u64 f = 0;
+	for (; f + 2 <= frame_count; f += 2) {
+		_mm_storeu_ps(frames + f*2, _mm_mul_ps(_mm_loadu_ps(frames + f*2), gain));
+	}
+	audio_pan_stereo_f32_scalar(frames, f, frame_count, left_gain, right_gain);
+}
+
+static void audio_pan_stereo_s16_sse2(s16 *frames, u64 frame_count, f32 left_gain, f32 right_gain) {
+	__m128 gain = _mm_setr_ps(left_gain, right_gain, left_gain, right_gain);
+	u64 f = 0;
+	for (; f + 2 <= frame_count; f += 2) {
+		s16 *p = frames + f*2;
+		audio_store_s16x4_sse2(p, _mm_mul_ps(audio_load_s16x4_sse2(p), gain));
+	}
+	audio_pan_stereo_s16_scalar(frames, f, frame_count, left_gain, right_gain);
+}
+
+///
+// AVX2, 8 samples at a time (16 for s16 mixing)
+
+AUDIO_DSP_TARGET_AVX2 static inline __m256 audio_load_s16x8_avx2(const s16 *p) {
+	return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)p)));
+}
+
+// x is already in s16 range
+AUDIO_DSP_TARGET_AVX2 static inline void audio_store_s16x8_avx2(s16 *p, __m256 x) {
+	x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-32768.0f)), _mm256_set1_ps(32767.0f));
+	__m256i i = _mm256_cvtps_epi32(x);
+	_mm_storeu_si128((__m128i*)p, _mm_packs_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+}
+
+AUDIO_DSP_TARGET_AVX2 static void audio_mix_f32_avx2(f32 *dst, const f32 *src, u64 count) {
+	u64 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+	}
+	audio_mix_f32_scalar(dst + i, src + i, count - i);
+}
+
+AUDIO_DSP_TARGET_AVX2 static void audio_saturate_f32_avx2(f32 *samples, u64 count) {
+	__m256 lo = _mm256_set1_ps(-1.0f), hi = _mm256_set1_ps(1.0f);
+	u64 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(samples + i, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(samples + i), lo), hi));
+	}
+	audio_saturate_f32_scalar(samples + i, count - i);
+}
+
+AUDIO_DSP_TARGET_AVX2 static void audio_mix_s16_avx2(s16 *dst, const s16 *src, u64 count) {
+	u64 i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epi16(a, b));
+	}
+	audio_mix_s16_scalar(dst + i, src + i, count - i);
+}
+
+AUDIO_DSP_TARGET_AVX2 static void audio_convert_s16_to_f32_avx2(f32 *dst, const s16 *src, u64 count) {
+	__m256 scale = _mm256_set1_ps(1.0f/32768.0f);
+	u64 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(dst + i, _mm256_mul_ps(audio_load_s16x8_avx2(src + i), scale));
+	}
+	audio_convert_s16_to_f32_scalar(dst + i, src + i, count - i);
+}
+
+AUDIO_DSP_TARGET_AVX2 static void audio_convert_f32_to_s16_avx2(s16 *dst, const f32 *src, u64 count) {
+	__m256 scale = _mm256_set1_ps(32768.0f);
+	u64 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		audio_store_s16x8_avx2(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), scale));
+	}
+	audio_convert_f32_to_s16_scalar(dst + i, src + i, count - i);
+}
+
+AUDIO_DSP_TARGET_AVX2 static inline __m256 audio_lane_frames_avx2(int channels) {
+	switch (channels) {
+		case 1:  return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+		case 2:  return _mm256_setr_ps(0, 0, 1, 1, 2, 2, 3, 3);
+		case 4:  return _mm256_setr_ps(0, 0, 0, 0, 1, 1, 1, 1);
+		default: return _mm256_setzero_ps();
+	}
+}
+
+AUDIO_DSP_TARGET_AVX2 static void audio_gain_ramp_f32_avx2(f32 *frames, u64 frame_count, int channels, f32 gain_from, f32 step) {
+	u64 f = 0;
+	if (8 % channels == 0) {
+		u64 frames_per_step = 8/channels;
+		__m256 lane_frames = audio_lane_frames_avx2(channels);
+		__m256 from = _mm256_set1_ps(gain_from), steps = _mm256_set1_ps(step);
+		for (; f + frames_per_step <= frame_count; f += frames_per_step) {
+			__m256 frame = _mm256_add_ps(_mm256_set1_ps((f32)f), lane_frames);
+			__m256 gain = _mm256_add_ps(from, _mm256_mul_ps(steps, frame));
+			f32 *p = frames + f*channels;
+			_mm256_storeu_ps(p, _mm256_mul_ps(_mm256_loadu_ps(p), gain));
+		}
+	}
+	audio_gain_ramp_f32_scalar(frames, f, frame_count, channels, gain_from, step);
+}
+
+AUDIO_DSP_TARGET_AVX2 static void audio_gain_ramp_s16_avx2(s16 *frames, u64 frame_count, int channels, f32 gain_from, f32 step) {
+	u64 f = 0;
+	if (8 % channels == 0) {
+		u64 frames_per_step = 8/channels;
+		__m256 lane_frames = audio_lane_frames_avx2(channels);
+		__m256 from = _mm256_set1_ps(gain_from), steps = _mm256_set1_ps(step);
+		for (; f + frames_per_step <= frame_count; f += frames_per_step) {
+			__m256 frame = _mm256_add_ps(_mm256_set1_ps((f32)f), lane_frames);
+			__m256 gain = _mm256_add_ps(from, _mm256_mul_ps(steps, frame));
+			s16 *p = frames + f*channels;
+			audio_store_s16x8_avx2(p, _mm256_mul_ps(audio_load_s16x8_avx2(p), gain));
+		}
+	}
+	audio_gain_ramp_s16_scalar(frames, f, frame_count, channels, gain_from, step);
+}
+
+AUDIO_DSP_TARGET_AVX2 static void audio_pan_stereo_f32_avx2(f32 *frames, u64 frame_count, f32 left_gain, f32 right_gain) {
+	__m256 gain = _mm256_setr_ps(left_gain, right_gain, left_gain, right_gain, left_gain, right_gain, left_gain, right_gain);
+	u64 f = 0;
+	for (; f + 4 <= frame_count; f += 4) {
+		_mm256_storeu_ps(frames + f*2, _mm256_mul_ps(_mm256_loadu_ps(frames + f*2), gain));
+	}
+	audio_pan_stereo_f32_scalar(frames, f, frame_count, left_gain, right_gain);
+}
+
+AUDIO_DSP_TARGET_AVX2 static void audio_pan_stereo_s16_avx2(s16 *frames, u64 frame_count, f32 left_gain, f32 right_gain) {
+	__m256 gain = _mm256_setr_ps(left_gain, right_gain, left_gain, right_gain, left_gain, right_gain, left_gain, right_gain);
+	u64 f = 0;
+	for (; f + 4 <= frame_count; f += 4) {
+		s16 *p = frames + f*2;
+		audio_store_s16x8_avx2(p, _mm256_mul_ps(audio_load_s16x8_avx2(p), gain));
+	}
+	audio_pan_stereo_s16_scalar(frames, f, frame_count, left_gain, right_gain);
+}
+
+#endif // SIMD_ENABLE_SSE2
+
+///
+// Dispatch
+
+void audio_mix_f32(f32 *dst, const f32 *src, u64 count) {
+	switch (audio_dsp_get_path()) {
+#if SIMD_ENABLE_SSE2
+		case AUDIO_DSP_PATH_AVX2: audio_mix_f32_avx2(dst, src, count); break;
+		case AUDIO_DSP_PATH_SSE2: audio_mix_f32_sse2(dst, src, count); break;
+#endif
+		default:                  audio_mix_f32_scalar(dst, src, count); break;
+	}
+}
+
+void audio_saturate_f32(f32 *samples, u64 count) {
+	switch (audio_dsp_get_path()) {
+#if SIMD_ENABLE_SSE2
+		case AUDIO_DSP_PATH_AVX2: audio_saturate_f32_avx2(samples, count); break;
+		case AUDIO_DSP_PATH_SSE2: audio_saturate_f32_sse2(samples, count); break;
+#endif
+		default:                  audio_saturate_f32_scalar(samples, count); break;
+	}
+}
+
+void audio_mix_s16(s16 *dst, const s16 *src, u64 count) {
+	switch (audio_dsp_get_path()) {
+#if SIMD_ENABLE_SSE2
+		case AUDIO_DSP_PATH_AVX2: audio_mix_s16_avx2(dst, src, count); break;
+		case AUDIO_DSP_PATH_SSE2: audio_mix_s16_sse2(dst, src, count); break;
+#endif
+		default:                  audio_mix_s16_scalar(dst, src, count); break;
+	}
+}
+
+void audio_convert_s16_to_f32(f32 *dst, const s16 *src, u64 count) {
+	switch (audio_dsp_get_path()) {
+#if SIMD_ENABLE_SSE2
+		case AUDIO_DSP_PATH_AVX2: audio_convert_s16_to_f32_avx2(dst, src, count); break;
+		case AUDIO_DSP_PATH_SSE2: audio_convert_s16_to_f32_sse2(dst, src, count); break;
+#endif
+		default:                  audio_convert_s16_to_f32_scalar(dst, src, count); break;
+	}
+}
+
+void audio_convert_f32_to_s16(s16 *dst, const f32 *src, u64 count) {
+	switch (audio_dsp_get_path()) {
+#if SIMD_ENABLE_SSE2
+		case AUDIO_DSP_PATH_AVX2: audio_convert_f32_to_s16_avx2(dst, src, count); break;
+		case AUDIO_DSP_PATH_SSE2: audio_convert_f32_to_s16_sse2(dst, src, count); break;
+#endif
+		default:                  audio_convert_f32_to_s16_scalar(dst, src, count); break;
+	}
+}
+
+void audio_gain_ramp_f32(f32 *frames, u64 frame_count, int channels, f32 gain_from, f32 gain_to) {
+	if (frame_count == 0 || channels <= 0) return;
+	f32 step = (gain_to - gain_from)/(f32)frame_count;
+	switch (audio_dsp_get_path()) {
+#if SIMD_ENABLE_SSE2
+		case AUDIO_DSP_PATH_AVX2: audio_gain_ramp_f32_avx2(frames, frame_count, channels, gain_from, step); break;
+		case AUDIO_DSP_PATH_SSE2: audio_gain_ramp_f32_sse2(frames, frame_count, channels, gain_from, step); break;
+#endif
+		default:                  audio_gain_ramp_f32_scalar(frames, 0, frame_count, channels, gain_from, step); break;
+	}
+}
+
+void audio_gain_ramp_s16(s16 *frames, u64 frame_count, int channels, f32 gain_from, f32 gain_to) {
+	if (frame_count == 0 || channels <= 0) return;
+	f32 step = (gain_to - gain_from)/(f32)frame_count;
+	switch (audio_dsp_get_path()) {
+#if SIMD_ENABLE_SSE2
+		case AUDIO_DSP_PATH_AVX2: audio_gain_ramp_s16_avx2(frames, frame_count, channels, gain_from, step); break;
+		case AUDIO_DSP_PATH_SSE2: audio_gain_ramp_s16_sse2(frames, frame_count, channels, gain_from, step); break;
+#endif
+		default:                  audio_gain_ramp_s16_scalar(frames, 0, frame_count, channels, gain_from, step); break;
+	}
+}
+
+void audio_pan_stereo_f32(f32 *frames, u64 frame_count, f32 left_gain, f32 right_gain) {
+	switch (audio_dsp_get_path()) {
+#if SIMD_ENABLE_SSE2
+		case AUDIO_DSP_PATH_AVX2: audio_pan_stereo_f32_avx2(frames, frame_count, left_gain, right_gain); break;
+		case AUDIO_DSP_PATH_SSE2: audio_pan_stereo_f32_sse2(frames, frame_count, left_gain, right_gain); break;
+#endif
+		default:                  audio_pan_stereo_f32_scalar(frames, 0, frame_count, left_gain, right_gain); break;
+	}
+}
+
+void audio_pan_stereo_s16(s16 *frames, u64 frame_count, f32 left_gain, f32 right_gain) {
+	switch (audio_dsp_get_path()) {
+#if SIMD_ENABLE_SSE2
+		case AUDIO_DSP_PATH_AVX2: audio_pan_stereo_s16_avx2(frames, frame_count, left_gain, right_gain); break;
+		case AUDIO_DSP_PATH_SSE2: audio_pan_stereo_s16_sse2(frames, frame_count, left_gain, right_gain); break;
+#endif
+		default:                  audio_pan_stereo_s16_scalar(frames, 0, frame_count, left_gain, right_gain); break;
+	}
+}
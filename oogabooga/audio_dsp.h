@@ -0,0 +1,97 @@
+#ifndef OOGABOOGA_AUDIO_DSP_H
+#define OOGABOOGA_AUDIO_DSP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "base.h"
+#include "linmath.h"
+#include "utility.h"
+
+/*
+
+	Audio DSP kernels: the inner loops of the mixer, for f32 samples in -1..1 and s16 samples.
+	They work on whole interleaved buffers, so the sample format is picked once per buffer
+	instead of once per sample.
+
+	Full API:
+
+		// Picks the fastest path this CPU can run, oogabooga_init calls it
+		void           audio_dsp_init(void);
+		// AUDIO_DSP_PATH_AUTO or a path the CPU can't run picks the fastest one. Returns the
+		// path that is used from now on.
+		Audio_Dsp_Path audio_dsp_set_path(Audio_Dsp_Path path);
+		Audio_Dsp_Path audio_dsp_get_path(void);
+		const char    *audio_dsp_path_name(Audio_Dsp_Path path);
+
+		// dst += src, count is in samples. f32 isn't clamped so a mix can go over 1 and come
+		// back without distorting, saturate it once when it's done. s16 is clamped to its range.
+		void audio_mix_f32(f32 *dst, const f32 *src, u64 count);
+		void audio_mix_s16(s16 *dst, const s16 *src, u64 count);
+		// Clamps to -1..1, for a finished f32 mix
+		void audio_saturate_f32(f32 *samples, u64 count);
+
+		// s16 is divided by 32768. f32 is clamped, times 32768 and rounded to the nearest.
+		void audio_convert_s16_to_f32(f32 *dst, const s16 *src, u64 count);
+		void audio_convert_f32_to_s16(s16 *dst, const f32 *src, u64 count);
+
+		// Frame f is multiplied by gain_from + (gain_to-gain_from)*f/frame_count, so
+		// gain_from == gain_to is a plain volume, and the next buffer can go on from gain_to.
+		void audio_gain_ramp_f32(f32 *frames, u64 frame_count, int channels, f32 gain_from, f32 gain_to);
+		void audio_gain_ramp_s16(s16 *frames, u64 frame_count, int channels, f32 gain_from, f32 gain_to);
+
+		// Multiplies the left and right samples of interleaved stereo frames
+		void audio_pan_stereo_f32(f32 *frames, u64 frame_count, f32 left_gain, f32 right_gain);
+		void audio_pan_stereo_s16(s16 *frames, u64 frame_count, f32 left_gain, f32 right_gain);
+		// Constant power gains for pan in -1 (left) .. 1 (right), both are 0.707 in the middle
+		void audio_stereo_pan_gains(f32 pan, f32 *left_gain, f32 *right_gain);
+
+	Usage:
+
+		// Mixing a mono voice panned into a stereo f32 bus
+		audio_convert_s16_to_f32(voice_buffer, voice_pcm, frame_count);
+		audio_gain_ramp_f32(voice_buffer, frame_count, 1, voice->last_volume, voice->volume);
+		...
+		audio_stereo_pan_gains(voice->pan, &left, &right);
+		audio_pan_stereo_f32(voice_stereo, frame_count, left, right);
+		audio_mix_f32(bus, voice_stereo, frame_count*2);
+		...
+		audio_saturate_f32(bus, frame_count*2);
+
+	Notes:
+
+		- Mixing and converting give the same results on all paths. With gains, f32 results
+			can differ in the last bit, which can move an s16 result by one.
+		- Buffers don't need to be aligned.
+		- Gain ramps with 1, 2 or 4 channels (and 8 with AVX2) are vectorised, other channel
+			counts go one frame at a time.
+		- NaN samples become -1 or -32768 where they are clamped.
+
+*/
+
+typedef enum Audio_Dsp_Path {
+	AUDIO_DSP_PATH_AUTO = 0,
+	AUDIO_DSP_PATH_SCALAR,
+	AUDIO_DSP_PATH_SSE2,
+	AUDIO_DSP_PATH_AVX2,
+} Audio_Dsp_Path;
+
+void           audio_dsp_init(void);
+Audio_Dsp_Path audio_dsp_set_path(Audio_Dsp_Path path);
+Audio_Dsp_Path audio_dsp_get_path(void);
+const char    *audio_dsp_path_name(Audio_Dsp_Path path);
+
+void audio_mix_f32(f32 *dst, const f32 *src, u64 count);
+void audio_mix_s16(s16 *dst, const s16 *src, u64 count);
+void audio_saturate_f32(f32 *samples, u64 count);
+
+void audio_convert_s16_to_f32(f32 *dst, const s16 *src, u64 count);
+void audio_convert_f32_to_s16(s16 *dst, const f32 *src, u64 count);
+
+void audio_gain_ramp_f32(f32 *frames, u64 frame_count, int channels, f32 gain_from, f32 gain_to);
+void audio_gain_ramp_s16(s16 *frames, u64 frame_count, int channels, f32 gain_from, f32 gain_to);
+
+void audio_pan_stereo_f32(f32 *frames, u64 frame_count, f32 left_gain, f32 right_gain);
+void audio_pan_stereo_s16(s16 *frames, u64 frame_count, f32 left_gain, f32 right_gain);
+void audio_stereo_pan_gains(f32 pan, f32 *left_gain, f32 *right_gain);
+
+#endif
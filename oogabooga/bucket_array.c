@@ -0,0 +1,168 @@
+
+///
+// Bucket array chunk pool
+
+// #Global
+ogb_instance Spinlock bucket_array_chunk_pool_lock;
+ogb_instance u8 *bucket_array_chunk_pool_first_free;
+
+#if !OOGABOOGA_LINK_EXTERNAL_INSTANCE
+Spinlock bucket_array_chunk_pool_lock = {0};
+// Free chunks are linked through their first 8 bytes
+u8 *bucket_array_chunk_pool_first_free = 0;
+#endif
+
+u8 *bucket_array_chunk_pool_get() {
+	spinlock_acquire_or_wait(&bucket_array_chunk_pool_lock);
+	u8 *chunk = bucket_array_chunk_pool_first_free;
+	if (chunk) bucket_array_chunk_pool_first_free = *(u8**)chunk;
+	spinlock_release(&bucket_array_chunk_pool_lock);
+
+	if (!chunk) chunk = (u8*)alloc_uninitialized(GetHeapAllocator(), BUCKET_ARRAY_CHUNK_SIZE);
+
+	return chunk;
+}
+void bucket_array_chunk_pool_put(u8 *chunk) {
+	spinlock_acquire_or_wait(&bucket_array_chunk_pool_lock);
+	*(u8**)chunk = bucket_array_chunk_pool_first_free;
+	bucket_array_chunk_pool_first_free = chunk;
+	spinlock_release(&bucket_array_chunk_pool_lock);
+}
+
+///
+// Bucket array
+
+void bucket_array_init(Bucket_Array *b, u64 item_size) {
+	assert(item_size > 0 && item_size <= BUCKET_ARRAY_CHUNK_SIZE, "Bucket array items must be 1-%d bytes, got %llu", BUCKET_ARRAY_CHUNK_SIZE, (unsigned long long)item_size);
+
+	*b = ZERO(Bucket_Array);
+	b->item_size = item_size;
+
+	b->items_per_chunk = 1;
+	b->items_per_chunk_log2 = 0;
+	while (b->items_per_chunk*2*item_size <= BUCKET_ARRAY_CHUNK_SIZE) {
+		b->items_per_chunk *= 2;
+		b->items_per_chunk_log2 += 1;
+	}
+}
+void bucket_array_deinit(Bucket_Array *b) {
+	for (u64 i = 0; i < b->allocated_chunk_count; i++) {
+		bucket_array_chunk_pool_put(b->chunks[i]);
+	}
+	if (b->chunks) Dealloc(GetHeapAllocator(), (void*)b->chunks);
+
+	b->chunks = 0;
+	b->allocated_chunk_count = 0;
+	b->count = 0;
+}
+void bucket_array_clear(Bucket_Array *b) {
+	// We keep the chunks for next time
+	b->count = 0;
+}
+
+// Slow path for pushes that land in a chunk that isn't allocated yet
+u8 *bucket_array_get_chunk_for_push(Bucket_Array *b, u64 chunk_index) {
+	assert(chunk_index < BUCKET_ARRAY_MAX_CHUNKS, "Bucket array is full (%d chunks)", BUCKET_ARRAY_MAX_CHUNKS);
+
+	while (!compare_and_swap_bool(&b->chunk_lock, true, false)) {
+		// spinny boi
+	}
+
+	if (!b->chunks) {
+		b->chunks = (u8*volatile*)Alloc(GetHeapAllocator(), BUCKET_ARRAY_MAX_CHUNKS*sizeof(u8*));
+	}
+	while (b->allocated_chunk_count <= chunk_index) {
+		b->chunks[b->allocated_chunk_count] = bucket_array_chunk_pool_get();
+		// Other threads may read the chunk as soon as they see the new count
+		MEMORY_BARRIER;
+		b->allocated_chunk_count += 1;
+	}
+
+	u8 *chunk = b->chunks[chunk_index];
+
+	MEMORY_BARRIER;
+	b->chunk_lock = false;
+
+	return chunk;
+}
+
+void bucket_array_reserve(Bucket_Array *b, u64 count_to_reserve) {
+	if (count_to_reserve == 0) return;
+	u64 last_chunk_index = (count_to_reserve-1) >> b->items_per_chunk_log2;
+	if (last_chunk_index >= b->allocated_chunk_count) bucket_array_get_chunk_for_push(b, last_chunk_index);
+}
+
+inline void *bucket_array_push(Bucket_Array *b) {
+	u64 index = b->count;
+	u64 chunk_index = index >> b->items_per_chunk_log2;
+
+	u8 *chunk = chunk_index < b->allocated_chunk_count
+	          ? b->chunks[chunk_index]
+	          : bucket_array_get_chunk_for_push(b, chunk_index);
+
+	b->count = index + 1;
+
+	return chunk + (index & (b->items_per_chunk-1))*b->item_size;
+}
+void *bucket_array_push_atomic(Bucket_Array *b) {
+	u64 index = atomic_add_64(&b->count, 1);
+	u64 chunk_index = index >> b->items_per_chunk_log2;
+
+	u8 *chunk = chunk_index < b->allocated_chunk_count
+	          ? b->chunks[chunk_index]
+	          : bucket_array_get_chunk_for_push(b, chunk_index);
+
+	return chunk + (index & (b->items_per_chunk-1))*b->item_size;
+}
+
+// Returns the index of the first of the n new (uninitialized) items
+u64 bucket_array_push_n(Bucket_Array *b, u64 n) {
+	u64 first = b->count;
+	bucket_array_reserve(b, first + n);
+	b->count = first + n;
+	return first;
+}
+
+// Copies count items over the items starting at first_index, one memcpy per chunk they
+// land in. Different threads can write to different ranges at the same time.
+void bucket_array_write(Bucket_Array *b, u64 first_index, const void *items, u64 count) {
+	assert(first_index + count <= b->count, "Bucket array write out of range (%llu + %llu, count is %llu)", (unsigned long long)first_index, (unsigned long long)count, (unsigned long long)b->count);
+	
+	const u8 *src = (const u8*)items;
+	u64 index = first_index;
+	while (count > 0) {
+		u64 index_in_chunk = index & (b->items_per_chunk-1);
+		u64 n = min(count, b->items_per_chunk - index_in_chunk);
+		
+		memcpy(b->chunks[index >> b->items_per_chunk_log2] + index_in_chunk*b->item_size, src, n*b->item_size);
+		
+		index += n;
+		src += n*b->item_size;
+		count -= n;
+	}
+}
+
+void bucket_array_append(Bucket_Array *b, const void *items, u64 count) {
+	u64 first = bucket_array_push_n(b, count);
+	bucket_array_write(b, first, items, count);
+}
+
+inline void *bucket_array_get(Bucket_Array *b, u64 index) {
+	assert(index < b->count, "Bucket array index %llu out of range (count is %llu)", (unsigned long long)index, (unsigned long long)b->count);
+	return b->chunks[index >> b->items_per_chunk_log2] + (index & (b->items_per_chunk-1))*b->item_size;
+}
+u64 bucket_array_get_count(Bucket_Array *b) {
+	return b->count;
+}
+
+u64 bucket_array_get_chunk_count(Bucket_Array *b) {
+	return (b->count + b->items_per_chunk - 1) >> b->items_per_chunk_log2;
+}
+void *bucket_array_get_chunk(Bucket_Array *b, u64 chunk_index, u64 *item_count) {
+	assert(chunk_index < bucket_array_get_chunk_count(b), "Bucket array chunk index %llu out of range", (unsigned long long)chunk_index);
+
+	u64 first = chunk_index << b->items_per_chunk_log2;
+	if (item_count) *item_count = min(b->items_per_chunk, b->count - first);
+
+	return b->chunks[chunk_index];
+}
@@ -0,0 +1,93 @@
+#ifndef OOGABOOGA_BUCKET_ARRAY_H
+#define OOGABOOGA_BUCKET_ARRAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "base.h"
+
+/*
+
+	Bucket array: items live in fixed size chunks which are never moved, so pointers to
+	items stay valid until the array is cleared.
+
+	Chunks are BUCKET_ARRAY_CHUNK_SIZE bytes and come from a global pool shared by all
+	bucket arrays. Clearing keeps the chunks in the array for reuse and deinit gives them
+	back to the pool.
+
+	Full API:
+
+		void  bucket_array_init(Bucket_Array *b, u64 item_size);
+		void  bucket_array_deinit(Bucket_Array *b);
+		void  bucket_array_clear(Bucket_Array *b);
+		void  bucket_array_reserve(Bucket_Array *b, u64 count_to_reserve);
+
+		// Returns uninitialized memory for one item
+		void *bucket_array_push(Bucket_Array *b);
+		// Same but safe to call from several threads at once. Don't call bucket_array_push
+		// at the same time though.
+		void *bucket_array_push_atomic(Bucket_Array *b);
+		// Copies count items to the end, not thread safe either
+		void  bucket_array_append(Bucket_Array *b, const void *items, u64 count);
+		// Adds n uninitialized items and returns the index of the first one
+		u64   bucket_array_push_n(Bucket_Array *b, u64 n);
+		// Copies items over existing ones. Threads can write to separate ranges at the same time.
+		void  bucket_array_write(Bucket_Array *b, u64 first_index, const void *items, u64 count);
+
+		void *bucket_array_get(Bucket_Array *b, u64 index);
+		u64   bucket_array_get_count(Bucket_Array *b);
+
+		// Iterating chunk by chunk
+		u64   bucket_array_get_chunk_count(Bucket_Array *b);
+		void *bucket_array_get_chunk(Bucket_Array *b, u64 chunk_index, u64 *item_count);
+
+	Usage:
+
+		Bucket_Array things;
+		bucket_array_init(&things, sizeof(Thing));
+
+		Thing *thing = (Thing*)bucket_array_push(&things);
+
+		for (u64 c = 0; c < bucket_array_get_chunk_count(&things); c++) {
+			u64 n;
+			Thing *chunk = (Thing*)bucket_array_get_chunk(&things, c, &n);
+			for (u64 i = 0; i < n; i++) do_thing(&chunk[i]);
+		}
+
+*/
+
+#define BUCKET_ARRAY_CHUNK_SIZE (64*1024)
+// With 64kb chunks this is 1gb worth of items
+#define BUCKET_ARRAY_MAX_CHUNKS (16*1024)
+
+typedef struct Bucket_Array {
+	uint64_t item_size;
+	// Power of two so finding an item is a shift and a mask
+	uint64_t items_per_chunk;
+	uint64_t items_per_chunk_log2;
+
+	// Number of items pushed. With bucket_array_push_atomic this can briefly be ahead
+	// of what's been written.
+	volatile uint64_t count;
+
+	// Allocated on first push, BUCKET_ARRAY_MAX_CHUNKS long so it never has to move
+	// under concurrent pushes.
+	uint8_t *volatile *chunks;
+	volatile uint64_t allocated_chunk_count;
+	volatile bool chunk_lock;
+} Bucket_Array;
+
+void     bucket_array_init(Bucket_Array *b, uint64_t item_size);
+void     bucket_array_deinit(Bucket_Array *b);
+void     bucket_array_clear(Bucket_Array *b);
+void     bucket_array_reserve(Bucket_Array *b, uint64_t count_to_reserve);
+void    *bucket_array_push(Bucket_Array *b);
+void    *bucket_array_push_atomic(Bucket_Array *b);
+void     bucket_array_append(Bucket_Array *b, const void *items, uint64_t count);
+uint64_t bucket_array_push_n(Bucket_Array *b, uint64_t n);
+void     bucket_array_write(Bucket_Array *b, uint64_t first_index, const void *items, uint64_t count);
+void    *bucket_array_get(Bucket_Array *b, uint64_t index);
+uint64_t bucket_array_get_count(Bucket_Array *b);
+uint64_t bucket_array_get_chunk_count(Bucket_Array *b);
+void    *bucket_array_get_chunk(Bucket_Array *b, uint64_t chunk_index, uint64_t *item_count);
+
+#endif
@@ -10,6 +10,9 @@ inline bool compare_and_swap_32(volatile uint32_t *a, uint32_t b, uint32_t old);
 inline bool compare_and_swap_64(volatile uint64_t *a, uint64_t b, uint64_t old);
 inline bool compare_and_swap_bool(volatile bool *a, bool b, bool old);
 
+// Returns the value before the add
+inline u64 atomic_add_64(volatile u64 *a, u64 value);
+
 ///
 // Spinlock "primitive"
 // Like a mutex but it eats up the entire core while waiting.
@@ -58,6 +61,54 @@ void ogb_instance
 mutex_release(Mutex *m);
 
 
+///
+// Job pool
+// A fixed set of worker threads for fork/join parallel-for's.
+// job_pool_run() calls proc(data, i) for every i in [0, job_count) and blocks until
+// all of them are done. The calling thread picks up jobs as well, so a pool with 0
+// workers just runs everything serially.
+// Calling job_pool_run() from inside a job runs the nested jobs serially on that thread.
+#define JOB_POOL_MAX_WORKERS 64
+typedef struct Job_Pool Job_Pool;
+typedef void (*Job_Proc)(void *data, u64 job_index);
+
+typedef struct Job_Pool_Worker {
+	Thread thread;
+	Binary_Semaphore wake;
+	Job_Pool *pool;
+} Job_Pool_Worker;
+
+typedef struct Job_Pool {
+	Job_Pool_Worker workers[JOB_POOL_MAX_WORKERS];
+	u64 worker_count;
+	
+	Mutex run_mutex;
+	
+	Job_Proc proc;
+	void *data;
+	u64 job_count;
+	volatile u64 next_job;
+	volatile u64 workers_finished;
+	volatile bool should_exit;
+} Job_Pool;
+
+void ogb_instance
+job_pool_init(Job_Pool *pool, u64 worker_count);
+
+void ogb_instance
+job_pool_destroy(Job_Pool *pool);
+
+void ogb_instance
+job_pool_run(Job_Pool *pool, Job_Proc proc, void *data, u64 job_count);
+
+u64 ogb_instance
+job_pool_get_worker_count(Job_Pool *pool);
+
+// Lazily initialized pool with one worker per logical processor (minus the calling thread)
+ogb_instance Job_Pool*
+get_job_pool();
+
+
 #if !OOGABOOGA_LINK_EXTERNAL_INSTANCE
 
 void spinlock_init(Spinlock *l) {
@@ -131,4 +182,127 @@ void mutex_release(Mutex *m) {
 	}
 }
 
-#endif
\ No newline at end of file
+
+
+inline u64 atomic_add_64(volatile u64 *a, u64 value) {
+	while (true) {
+		u64 old = *a;
+		if (compare_and_swap_64(a, old + value, old)) return old;
+	}
+}
+
+///
+// Job pool
+
+thread_local bool _job_pool_is_running_job = false;
+
+void job_pool_do_jobs(Job_Pool *pool) {
+	_job_pool_is_running_job = true;
+	while (true) {
+		u64 job_index = atomic_add_64(&pool->next_job, 1);
+		if (job_index >= pool->job_count) break;
+		pool->proc(pool->data, job_index);
+	}
+	_job_pool_is_running_job = false;
+}
+
+void job_pool_worker_proc(Thread *t) {
+	Job_Pool_Worker *worker = (Job_Pool_Worker*)t->data;
+	Job_Pool *pool = worker->pool;
+	
+	while (true) {
+		OsBinarySemaphoreWait(&worker->wake);
+		if (pool->should_exit) break;
+		
+		job_pool_do_jobs(pool);
+		
+		atomic_add_64(&pool->workers_finished, 1);
+	}
+}
+
+void job_pool_init(Job_Pool *pool, u64 worker_count) {
+	memset(pool, 0, sizeof(*pool));
+	
+	pool->worker_count = min(worker_count, JOB_POOL_MAX_WORKERS);
+	mutex_init(&pool->run_mutex);
+	
+	for (u64 i = 0; i < pool->worker_count; i++) {
+		Job_Pool_Worker *worker = &pool->workers[i];
+		worker->pool = pool;
+		OsBinarySemaphoreInit(&worker->wake, false);
+		OsThreadInit(&worker->thread, job_pool_worker_proc);
+		worker->thread.data = worker;
+		OsThreadStart(&worker->thread);
+	}
+}
+
+void job_pool_destroy(Job_Pool *pool) {
+	pool->should_exit = true;
+	MEMORY_BARRIER;
+	for (u64 i = 0; i < pool->worker_count; i++) {
+		OsBinarySemaphoreSignal(&pool->workers[i].wake);
+	}
+	for (u64 i = 0; i < pool->worker_count; i++) {
+		OsThreadJoin(&pool->workers[i].thread);
+		OsBinarySemaphoreDestroy(&pool->workers[i].wake);
+	}
+	mutex_destroy(&pool->run_mutex);
+}
+
+void job_pool_run(Job_Pool *pool, Job_Proc proc, void *data, u64 job_count) {
+	if (job_count == 0) return;
+	
+	if (job_count == 1 || pool->worker_count == 0 || _job_pool_is_running_job) {
+		for (u64 i = 0; i < job_count; i++) proc(data, i);
+		return;
+	}
+	
+	mutex_acquire_or_wait(&pool->run_mutex);
+	
+	pool->proc = proc;
+	pool->data = data;
+	pool->job_count = job_count;
+	pool->next_job = 0;
+	pool->workers_finished = 0;
+	MEMORY_BARRIER;
+	
+	// Every woken worker has to report back before we return, otherwise a late worker
+	// could pick up jobs from the next run with this run's proc.
+	u64 woken_count = min(pool->worker_count, job_count-1);
+	for (u64 i = 0; i < woken_count; i++) {
+		OsBinarySemaphoreSignal(&pool->workers[i].wake);
+	}
+	
+	job_pool_do_jobs(pool);
+	
+	while (pool->workers_finished < woken_count) {
+		OsYieldThread();
+	}
+	
+	mutex_release(&pool->run_mutex);
+}
+
+u64 job_pool_get_worker_count(Job_Pool *pool) {
+	return pool->worker_count;
+}
+
+Job_Pool *_global_job_pool = 0;
+Spinlock _global_job_pool_lock = {0};
+
+Job_Pool *get_job_pool() {
+	if (_global_job_pool) return _global_job_pool;
+	
+	spinlock_acquire_or_wait(&_global_job_pool_lock);
+	if (!_global_job_pool) {
+		Job_Pool *pool = (Job_Pool*)Alloc(GetHeapAllocator(), sizeof(Job_Pool));
+		u64 processor_count = os_get_number_of_logical_processors();
+		job_pool_init(pool, processor_count > 1 ? processor_count-1 : 0);
+		MEMORY_BARRIER;
+		_global_job_pool = pool;
+	}
+	spinlock_release(&_global_job_pool_lock);
+	
+	return _global_job_pool;
+}
+
+#endif
@@ -16,4 +16,12 @@ void      mutex_destroy(Mutex *m);
 void      mutex_acquire_or_wait(Mutex *m);
 void      mutex_release(Mutex *m);
 
+typedef struct Job_Pool Job_Pool;
+typedef void (*Job_Proc)(void *data, uint64_t job_index);
+void      job_pool_init(Job_Pool *pool, uint64_t worker_count);
+void      job_pool_destroy(Job_Pool *pool);
+void      job_pool_run(Job_Pool *pool, Job_Proc proc, void *data, uint64_t job_count);
+uint64_t  job_pool_get_worker_count(Job_Pool *pool);
+Job_Pool *get_job_pool(void);
+
 #endif
@@ -2,8 +2,7 @@
 
 // #Portability rip ARM
 
-// I think this is the standard? (sse1)
-#define COMPILER_CAN_DO_SSE 1
+// COMPILER_CAN_DO_XXX is in oogabooga.c since simd.c needs it before we get here
 
 ///
 // Compiler specific stuff
@@ -34,29 +33,6 @@
     	return i;
     }
     
-    #if _M_IX86_FP >= 2
-		#define COMPILER_CAN_DO_SSE2 1
-		#define COMPILER_CAN_DO_SSE41 1
-	#else
-		#define COMPILER_CAN_DO_SSE2 0
-		#define COMPILER_CAN_DO_SSE41 0
-	#endif
-	#ifdef __AVX__
-		#define COMPILER_CAN_DO_AVX 1
-	#else
-		#define COMPILER_CAN_DO_AVX 0
-	#endif
-	#ifdef __AVX2__
-		#define COMPILER_CAN_DO_AVX2 1
-	#else
-		#define COMPILER_CAN_DO_AVX2 0
-	#endif
-	#ifdef __AVX512F__
-		#define COMPILER_CAN_DO_AVX512 1
-	#else
-		#define COMPILER_CAN_DO_AVX512 0
-	#endif
-	
 	#define DEPRECATED(proc, msg) __declspec(deprecated(msg)) func
 	
 	#pragma intrinsic(_InterlockedCompareExchange8)
@@ -128,32 +104,6 @@
 	    return info;
 	}
 	
-	#ifdef __SSE2__
-		#define COMPILER_CAN_DO_SSE2 1
-	#else
-		#define COMPILER_CAN_DO_SSE2 0
-	#endif
-	#ifdef __SSE4_1__
-		#define COMPILER_CAN_DO_SSE41 1
-	#else
-		#define COMPILER_CAN_DO_SSE41 0
-	#endif
-	#ifdef __AVX__
-		#define COMPILER_CAN_DO_AVX 1
-	#else
-		#define COMPILER_CAN_DO_AVX 0
-	#endif
-	#ifdef __AVX2__
-		#define COMPILER_CAN_DO_AVX2 1
-	#else
-		#define COMPILER_CAN_DO_AVX2 0
-	#endif
-	#ifdef __AVX512F__
-		#define COMPILER_CAN_DO_AVX512 1
-	#else
-		#define COMPILER_CAN_DO_AVX512 0
-	#endif
-	
 	#define DEPRECATED(proc, msg) __attribute__((deprecated(msg))) proc 
 	
 	inline bool 
@@ -228,11 +178,6 @@
     inline u64 
     rdtsc() { return 0; }
     inline Cpu_Info_X86 cpuid(u32 function_id) {return (Cpu_Info_X86){0};}
-    #define COMPILER_CAN_DO_SSE2 0
-    #define COMPILER_CAN_DO_AVX 0
-    #define COMPILER_CAN_DO_AVX2 0
-    #define COMPILER_CAN_DO_AVX512 0
-    
     #define DEPRECATED(proc, msg) 
     
     #define MEMORY_BARRIER
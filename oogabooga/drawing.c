@@ -9,6 +9,10 @@
 			in gfx_interface.c.
 		- A practical example for offscreen drawing can be found in examples/offscreen_drawing.c
 		- A practical example for using Draw_Frame's can be found in examples/threaded_drawing.c
+		- To pack many small images into shared textures (so they batch), see atlas.h. The
+			Gal_Image's it hands out work with all the draw_image procedures.
+		- For big worlds, see spatial_index.h to only draw what draw_frame_get_visible_rect()
+			returns instead of culling everything one quad at a time.
 
 
 	The drawing API has two modes: EZ mode and advanced mode.
@@ -45,6 +49,18 @@
 			Draw_Quad *draw_image_xform(Gfx_Image *image, Matrix4 xform, Vector2 size, Vector4 color);
 			
 			void draw_line(Vector2 p0, Vector2 p1, float line_width, Vector4 color);
+			
+		- Drawing many rects/images at once:
+		
+			u64 draw_rects(const Vector2 *positions, const Vector2 *sizes, const Vector4 *colors, u64 count);
+			u64 draw_rects_xform(const Matrix4 *xforms, const Vector2 *sizes, const Vector4 *colors, u64 count);
+			u64 draw_images(Gal_Image *image, const Vector2 *positions, const Vector2 *sizes, const Vector4 *colors, const Vector4 *uvs, u64 count);
+			u64 draw_images_xform(Gal_Image *image, const Matrix4 *xforms, const Vector2 *sizes, const Vector4 *colors, const Vector4 *uvs, u64 count);
+			
+			- Much faster than calling draw_rect etc. in a loop, for tilemaps, particles and such.
+			- colors and uvs can be 0 for white and the whole image.
+			- Returns how many quads were actually drawn (the rest were culled). There are no
+				Draw_Quad*'s to modify retroactively.
 		
 		- Drawing text:
 			
@@ -64,8 +80,8 @@
 			- You mostly shouldn't need to use this as it's quite verbose.
 			- See struct Draw_Quad. 
 			- If you need to customize a quad more, such as setting the UV or image filtering, then most other 
-				draw_xxx functions will return a Draw_Quad* which you can modify Retroactively. Keep in mind 
-				that the returned pointer is only guaranteed to be valid BEFORE you call other draw functions.
+				draw_xxx functions will return a Draw_Quad* which you can modify Retroactively. The returned
+				pointer stays valid until the Draw_Frame is reset.
 				See "- Retroactively modifying quads" for more info about Draw_Quad
 				
 		- Layer sorting, scissor boxing/cropping:
@@ -81,6 +97,9 @@
 			Matrix4 drawFrame.cameraXform
 			void   *drawFrame.cbuffer
 			
+			void set_projection(Matrix4 projection);
+			void set_camera_xform(Matrix4 camera_xform);
+			
 			Since drawFrame is completely reset each GfxUpdate, the projection and cameraXform
 			needs to be set each frame (immediate mode).
 			
@@ -94,6 +113,13 @@
 			The projection and xform gets applied directly in each draw_xxx call. So, you need to set
 			the camera stuff just before drawing stuff to a specific camera.
 			
+			Vector4 draw_frame_get_visible_rect(Draw_Frame *frame) gives the world space x1, y1, x2, y2
+			that the camera can see (within the scissor if one is pushed).
+			
+			The inverse of cameraXform and projection*view are cached in the Draw_Frame rather than
+			computed for every quad. The cache notices changes made with set_projection/
+			set_camera_xform as well as direct assignments to drawFrame.projection/cameraXform.
+			
 			The cbuffer is for passing a constant buffer to the custom shader. For more info on custom
 			shading, see examples/custom_shader.c.
 				
@@ -136,6 +162,11 @@
 				
 			void draw_line_in_frame(Vector2 p0, Vector2 p1, float line_width, Vector4 color, Draw_Frame *frame);
 			
+			u64 draw_rects_in_frame(const Vector2 *positions, const Vector2 *sizes, const Vector4 *colors, u64 count, Draw_Frame *frame);
+			u64 draw_rects_xform_in_frame(const Matrix4 *xforms, const Vector2 *sizes, const Vector4 *colors, u64 count, Draw_Frame *frame);
+			u64 draw_images_in_frame(Gal_Image *image, const Vector2 *positions, const Vector2 *sizes, const Vector4 *colors, const Vector4 *uvs, u64 count, Draw_Frame *frame);
+			u64 draw_images_xform_in_frame(Gal_Image *image, const Matrix4 *xforms, const Vector2 *sizes, const Vector4 *colors, const Vector4 *uvs, u64 count, Draw_Frame *frame);
+			
 			void draw_text_xform_in_frame(Gal_Font *font, string text, u32 raster_height, Matrix4 xform, Vector2 scale, Vector4 color, Draw_Frame *frame);
 			void draw_text_in_frame(Gal_Font *font, string text, u32 raster_height, Vector2 position, Vector2 scale, Vector4 color, Draw_Frame *frame);
 			Gfx_Text_Metrics draw_text_and_measure_in_frame(Gal_Font *font, string text, u32 raster_height, Vector2 position, Vector2 scale, Vector4 color, Draw_Frame *frame);
@@ -158,6 +189,158 @@
 										   drawFrame.enable_z_sorting to true each frame.
 			- Gfx_Filter_Mode Draw_Quad.image_min_filter
 			- Gfx_Filter_Mode Draw_Quad.image_mag_filter
+			
+	- Draw lists
+	
+		For things that don't change between frames (level tiles, backgrounds, UI chrome) the
+		quads can be recorded once in a Draw_List and submitted again each frame. This is
+		cached re-submission, not retained rendering: the replayed quads go into the frame
+		and to the renderer like any other quads, nothing stays on the GPU between frames.
+		
+			void draw_list_init(Draw_List *list); // Or just zero initialize it
+			void draw_list_deinit(Draw_List *list);
+			
+			Draw_Frame *draw_list_begin_recording(Draw_List *list);
+			void draw_list_end_recording(Draw_List *list);
+			void draw_list_invalidate(Draw_List *list);
+			bool draw_list_is_recorded(Draw_List *list);
+			// x1, y1, x2, y2 of the recorded quads, before the replay xform
+			Vector4 draw_list_get_bounds(Draw_List *list);
+			
+			u64 draw_list_replay(Draw_List *list, Matrix4 xform);
+			u64 draw_list_replay_in_frame(Draw_List *list, Matrix4 xform, Draw_Frame *frame);
+			
+		Example:
+		
+			if (!draw_list_is_recorded(&tiles)) {
+				Draw_Frame *recording = draw_list_begin_recording(&tiles);
+				for (...) DrawImageInFrame(tile_image, tile_pos, v2(16, 16), COLOR_WHITE, recording);
+				draw_list_end_recording(&tiles);
+			}
+			draw_list_replay(&tiles, M4Scalar(1.0));
+			
+			// When the level changes
+			draw_list_invalidate(&tiles);
+			
+		- Record with the xxx_in_frame procedures and the frame you get from begin_recording.
+			Quads are kept in world space, they aren't culled or snapped until they are
+			replayed. Don't reset the recording frame or change its projection/camera.
+		- Replaying transforms the quads by the frame's camera and projection times xform,
+			so the same list can be drawn several times at different places.
+		- Quads recorded without a z layer/scissor get the ones pushed in the frame at replay.
+			Recorded scissors are cut down to the frame's, like nested scissors.
+		- If nothing changed since the last replay (camera, xform, window size, z layer and
+			scissor), the quads from last time are just memcpy'd into the frame. If something
+			did (a moving camera), every quad is projected, culled and snapped again on the
+			CPU, straight into the frame. That saves the draw calls and the per call overhead
+			but not the per quad work, replaying 100K quads with a moving camera is only about
+			1.5x faster than drawing them.
+		- Nothing is tracked automatically, call draw_list_invalidate() when the content
+			should change.
+		- For worlds made of many lists (chunks of tiles for example), register each list's
+			bounds in a Spatial_Index and only replay the ones that the query returns.
+		
+	- Parallel recording
+	
+		A frame can be recorded on several threads by drawing into sub frames, which have their
+		own quad buffers and z/scissor stacks, and merging them back into the frame:
+		
+			void draw_record_parallel(Draw_Record_Proc proc, void *data, u64 job_count);
+			void draw_frame_record_parallel(Draw_Frame *frame, Draw_Record_Proc proc, void *data, u64 job_count);
+			
+			// proc is called once for each job_index on the job pool
+			void record_chunk(Draw_Frame *sub_frame, void *data, u64 job_index) {
+				for (...) DrawRectInFrame(..., sub_frame);
+			}
+			draw_record_parallel(record_chunk, world, 8);
+			
+		Or with your own threads:
+		
+			Draw_Frame *draw_frame_begin_sub_frames(Draw_Frame *frame, u64 sub_frame_count);
+			void draw_frame_merge_sub_frames(Draw_Frame *frame);
+			
+		- Sub frames start with the camera, z layer, scissor and flags of the frame.
+		- Merging appends the sub frames in index order after what was drawn to the frame
+			itself, so the result is the same no matter which thread did what or when. The
+			copying is split over the job pool.
+		- If enable_z_sorting is set, merging ends with one stable radix sort by z over the
+			whole frame, which can also be done on its own with draw_frame_sort_by_z().
+		- Draw_Quad pointers from sub frames are only valid until they are merged.
+		
+	- Pixel snapping
+	
+		Quad corners are snapped to whole pixels by default, which fixes sampling artifacts with
+		large atlases but makes slow/small movements jittery (animated text for example).
+		
+			drawFrame.disable_pixel_snapping = true; // For the whole frame, has to be set each frame
+			
+			// For one quad
+			Draw_Quad q = ZERO(Draw_Quad);
+			...
+			q.flags |= DRAW_QUAD_FLAG_NO_PIXEL_SNAP;
+			draw_quad(q);
+			
+		The flag has to be set before drawing since that's when the snapping happens.
+			
+	- Instance streams
+	
+		Draw_Quad is convenient to modify but big (~230 bytes, mostly userdata). Renderers don't
+		need to stream all of that for every quad, so a Draw_Frame can be packed into a
+		Draw_Instance_Stream with 48 byte Draw_Quad_Instance's instead:
+		
+			void draw_frame_build_instance_stream(Draw_Frame *frame, Draw_Instance_Stream *stream);
+			void draw_instance_stream_clear(Draw_Instance_Stream *stream);
+			void draw_instance_stream_deinit(Draw_Instance_Stream *stream);
+			
+		- The quad becomes a 2x3 transform of the unit quad (origin + 2 axes), color is RGBA8 and
+			uv is unorm16, so uv's outside of 0-1 are clamped.
+		- Images and scissors are put in tables in the stream and referenced by a 16 bit index.
+		- Userdata goes in a side stream (extras) which is parallel to the instances, but it's
+			only filled if any quad in the frame has userdata (see draw_quad_set_userdata). Same for quads
+			which aren't parallelograms (like a quad under a perspective projection), for those
+			the top right corner goes in the extras.
+		- Renderers expand the instances back to corners on the GPU, or with
+			draw_quad_instance_get_corners() in software.
+			
+	- Draw calls
+	
+		Building an instance stream also splits it into Draw_Call's, so renderers don't have
+		to find out themselves where a texture or scissor change needs a new draw call:
+		
+			for (u64 i = 0; i < stream.calls.count; i++) {
+				Draw_Call *call = &stream.calls.data[i];
+				// Bind stream.textures.data[call->textures[slot]] to each slot < call->texture_count,
+				// set the scissor unless call->scissor_index is DRAW_INSTANCE_NO_SCISSOR, then draw
+				// call->instance_count instances starting at call->first_instance.
+			}
+			
+		- A call samples from up to DRAW_CALL_MAX_TEXTURES textures and each instance has the
+			slot of its texture in texture_slot, so images changing from quad to quad don't
+			break the batch by themselves. Only a scissor change or running out of slots does.
+		- Set drawFrame.enable_batch_sorting (each frame, like enable_z_sorting) to let the
+			quads within each z layer be reordered by scissor and texture first. Quads in the
+			same layer may then be drawn in a different order, so only do this when they don't
+			overlap or the order doesn't matter. Quads with the same texture and scissor keep
+			their order and quads never move to another layer.
+		- The frame's shader extension applies to every call, it's in stream.shader_extension.
+		- stream.stats has the number of calls and why they were split.
+		
+	- Scissors
+	
+		push_window_scissor takes window pixels with 0, 0 in the bottom left corner. A scissor
+		pushed inside another one is cut down to where they overlap, so quads only ever
+		have one scissor: the effective clip rect.
+		
+		- Quads completely outside the scissor are culled right away like off screen quads
+			(draw_xxx returns a dummy quad), so long scrolled lists don't cost anything for
+			the items out of view. This needs the window size, without one only the screen
+			is culled against.
+		- Set drawFrame.enable_scissor_clipping (each frame) to cut axis aligned quads to
+			their scissor on the CPU when building the instance stream, uv included. Those
+			quads don't need the scissor anymore so they batch with everything else.
+			Rotated quads and circles keep theirs. stream.stats counts how many were
+			cut and how many lost their scissor.
+		- Draw_List replays cut scissors recorded in the list down to the frame's scissor.
 				
 */
 
@@ -195,12 +378,27 @@ typedef struct Gfx_Text_Metrics {
 void draw_frame_init(Draw_Frame *frame) {
 	*frame = ZERO(Draw_Frame);
 	
-	growing_array_init((void**)&frame->quad_buffer, sizeof(Draw_Quad), GetHeapAllocator());
+	bucket_array_init(&frame->quad_buffer, sizeof(Draw_Quad));
 }
 void draw_frame_init_reserve(Draw_Frame *frame, u64 number_of_quads_to_reserve) {
 	*frame = ZERO(Draw_Frame);
 	
-	growing_array_init_reserve((void**)&frame->quad_buffer, sizeof(Draw_Quad), number_of_quads_to_reserve, GetHeapAllocator());
+	bucket_array_init(&frame->quad_buffer, sizeof(Draw_Quad));
+	bucket_array_reserve(&frame->quad_buffer, number_of_quads_to_reserve);
+}
+
+void draw_frame_deinit(Draw_Frame *frame) {
+	bucket_array_deinit(&frame->quad_buffer);
+	if (frame->sort_buffer.item_size) bucket_array_deinit(&frame->sort_buffer);
+	
+	for (u64 i = 0; i < frame->allocated_sub_frame_count; i++) {
+		draw_frame_deinit(&frame->sub_frames[i]);
+	}
+	if (frame->sub_frames) Dealloc(GetHeapAllocator(), frame->sub_frames);
+	
+	frame->sub_frames = 0;
+	frame->sub_frame_count = 0;
+	frame->allocated_sub_frame_count = 0;
 }
 
 void DrawFrameReset(Draw_Frame *frame) {
@@ -211,20 +409,62 @@ void DrawFrameReset(Draw_Frame *frame) {
 	// highest number of quads the program submits in a frame.
 	// For now, we just reset the count in the heap allocated buffer
 
-	Draw_Quad *quad_buffer = frame->quad_buffer;
-	if (quad_buffer) growing_array_clear((void**)&quad_buffer);
+	Bucket_Array quad_buffer = frame->quad_buffer;
+	bucket_array_clear(&quad_buffer);
+	Bucket_Array sort_buffer = frame->sort_buffer;
+	Draw_Frame *sub_frames = frame->sub_frames;
+	u64 allocated_sub_frame_count = frame->allocated_sub_frame_count;
 
 	*frame = (Draw_Frame){0};
 	
 	frame->quad_buffer = quad_buffer;
+	frame->sort_buffer = sort_buffer;
+	frame->sub_frames = sub_frames;
+	frame->allocated_sub_frame_count = allocated_sub_frame_count;
 	
 	frame->projection 
 		= m4_make_orthographic_projection(-window.width/2, window.width/2, -window.height/2, window.height/2, -1, 10);
 	frame->cameraXform = M4Scalar(1.0);
+	frame->camera_dirty = true;
 	
 	frame->highest_bound_slot_index = -1;
 }
 
+void draw_frame_set_projection(Draw_Frame *frame, Matrix4 projection) {
+	frame->projection = projection;
+	frame->camera_dirty = true;
+}
+void draw_frame_set_camera_xform(Draw_Frame *frame, Matrix4 camera_xform) {
+	frame->cameraXform = camera_xform;
+	frame->camera_dirty = true;
+}
+
+void draw_frame_update_camera_cache(Draw_Frame *frame) {
+	// Camera transforms are practically always affine so this is usually the cheap inverse
+	frame->cached_view = m4_inverse_fast(frame->cameraXform);
+	frame->cached_world_to_clip = m4_mul(frame->projection, frame->cached_view);
+	frame->camera_dirty = false;
+	
+	frame->cached_from_projection = frame->projection;
+	frame->cached_from_camera_xform = frame->cameraXform;
+}
+inline void draw_frame_validate_camera_cache(Draw_Frame *frame) {
+	// projection and cameraXform can also be assigned directly, so those are compared too
+	if (frame->camera_dirty
+	    || memcmp(&frame->cached_from_projection, &frame->projection, sizeof(Matrix4)) != 0
+	    || memcmp(&frame->cached_from_camera_xform, &frame->cameraXform, sizeof(Matrix4)) != 0) {
+		draw_frame_update_camera_cache(frame);
+	}
+}
+Matrix4 draw_frame_get_view(Draw_Frame *frame) {
+	draw_frame_validate_camera_cache(frame);
+	return frame->cached_view;
+}
+Matrix4 draw_frame_get_world_to_clip(Draw_Frame *frame) {
+	draw_frame_validate_camera_cache(frame);
+	return frame->cached_world_to_clip;
+}
+
 void draw_frame_bind_image_to_shader(Draw_Frame *frame, Gal_Image *image, int slot_index) {
 	if (slot_index >= MAX_BOUND_IMAGES) {
 		log_error("The highest bind image slot is %i, you tried to bind to %i", MAX_BOUND_IMAGES-1, slot_index);
@@ -242,74 +482,240 @@ ogb_instance Draw_Frame drawFrame;
 Draw_Frame drawFrame;
 #endif // NOT OOGABOOGA_LINK_EXTERNAL_INSTANCE
 
-Draw_Quad _nil_quad = {0};
-Draw_Quad *draw_quad_projected_in_frame(Draw_Quad quad, Matrix4 world_to_clip, Draw_Frame *frame) {
-	quad.bottom_left  = m4_transform(world_to_clip, v4(v2_expand(quad.bottom_left), 0, 1)).xy;
-	quad.top_left     = m4_transform(world_to_clip, v4(v2_expand(quad.top_left), 0, 1)).xy;
-	quad.top_right    = m4_transform(world_to_clip, v4(v2_expand(quad.top_right), 0, 1)).xy;
-	quad.bottom_right = m4_transform(world_to_clip, v4(v2_expand(quad.bottom_right), 0, 1)).xy;
-	
-	bool should_cull = 
-	    (quad.bottom_left.x < -1 && quad.top_left.x < -1 && quad.top_right.x < -1 && quad.bottom_right.x < -1) ||
-	    (quad.bottom_left.x > 1 && quad.top_left.x > 1 && quad.top_right.x > 1 && quad.bottom_right.x > 1) ||
-	    (quad.bottom_left.y < -1 && quad.top_left.y < -1 && quad.top_right.y < -1 && quad.bottom_right.y < -1) ||
-	    (quad.bottom_left.y > 1 && quad.top_left.y > 1 && quad.top_right.y > 1 && quad.bottom_right.y > 1);
-
-	if (should_cull) {
-		return &_nil_quad;
+///
+// Pixel snapping and culling
+//
+// Corners are snapped to whole pixels to fix the annoying artifacts that shows up when
+// sampling from a large atlas, presumably for floating point precision issues or something.
+// That makes small movements look wonky though (animated text for example), so it can be
+// turned off with Draw_Frame.disable_pixel_snapping or DRAW_QUAD_FLAG_NO_PIXEL_SNAP.
+
+Draw_Pixel_Snap draw_get_pixel_snap(Draw_Frame *frame) {
+	Draw_Pixel_Snap *snap = &frame->pixel_snap;
+	if (snap->window_width != window.width || snap->window_height != window.height) {
+		snap->window_width  = window.width;
+		snap->window_height = window.height;
+		snap->enabled = window.width > 0 && window.height > 0;
+		if (snap->enabled) {
+			snap->pixel_width  = 2.0f/(float32)window.width;
+			snap->pixel_height = 2.0f/(float32)window.height;
+			snap->pixels_per_x = (float32)window.width/2.0f;
+			snap->pixels_per_y = (float32)window.height/2.0f;
+		}
+	}
+	
+	Draw_Pixel_Snap result = *snap;
+	result.enabled = result.enabled && !frame->disable_pixel_snapping;
+	return result;
+}
+
+// Scissors are in window pixels with 0, 0 in the bottom left corner
+inline Vector4 draw_scissor_to_clip(Vector4 scissor, Draw_Pixel_Snap snap) {
+	return v4(scissor.x*snap.pixel_width  - 1.0f, scissor.y*snap.pixel_height - 1.0f,
+	          scissor.z*snap.pixel_width  - 1.0f, scissor.w*snap.pixel_height - 1.0f);
+}
+
+// What quads are culled against: the screen in clip space, cut down to the current
+// scissor. Without a window size we can't tell where the scissor is, so it's just the screen.
+Vector4 draw_get_clip_rect(Draw_Frame *frame, Draw_Pixel_Snap snap) {
+	Vector4 clip = v4(-1, -1, 1, 1);
+	if (frame->scissor_count > 0 && snap.window_width > 0 && snap.window_height > 0) {
+		Vector4 s = draw_scissor_to_clip(frame->scissor_stack[frame->scissor_count-1], snap);
+		clip = v4(max(clip.x, s.x), max(clip.y, s.y), min(clip.z, s.z), min(clip.w, s.w));
 	}
+	return clip;
+}
+
+// World space AABB of what the frame can see, the screen cut down to the scissor. Like the
+// culling, this only looks at the x and y rows of world_to_clip.
+Vector4 draw_frame_get_visible_rect(Draw_Frame *frame) {
+	Vector4 clip = draw_get_clip_rect(frame, draw_get_pixel_snap(frame));
+	Matrix4 m = draw_frame_get_world_to_clip(frame);
+	
+	float32 det = m.m[0][0]*m.m[1][1] - m.m[0][1]*m.m[1][0];
+	if (det == 0) return v4(0, 0, 0, 0);
+	float32 inverse_det = 1.0f/det;
 	
-	quad.image_min_filter = GFX_FILTER_MODE_NEAREST;
-	quad.image_mag_filter = GFX_FILTER_MODE_NEAREST;
+	Vector2 corners[4] = { v2(clip.x, clip.y), v2(clip.x, clip.w), v2(clip.z, clip.w), v2(clip.z, clip.y) };
+	Vector4 rect = v4(F32_MAX, F32_MAX, -F32_MAX, -F32_MAX);
+	for (int c = 0; c < 4; c++) {
+		float32 cx = corners[c].x - m.m[0][3];
+		float32 cy = corners[c].y - m.m[1][3];
+		float32 x = ( m.m[1][1]*cx - m.m[0][1]*cy)*inverse_det;
+		float32 y = (-m.m[1][0]*cx + m.m[0][0]*cy)*inverse_det;
+		rect = v4(min(rect.x, x), min(rect.y, y), max(rect.z, x), max(rect.w, y));
+	}
+	return rect;
+}
+
+// Snapping rounds halves up, floor(x + 0.5), on every path. roundf and the SIMD rounding
+// modes disagree on halves, so they aren't used.
+inline float32 draw_round_to_pixel(float32 x) {
+	return floorf(x + 0.5f);
+}
+
+#if SIMD_ENABLE_SSE2
+// Floats this big have no fraction so they don't need rounding (and wouldn't fit the int
+// conversion).
+#define DRAW_ROUND_LIMIT 8388608.0f
+
+inline __m128 draw_round_ps(__m128 v) {
+	v = _mm_add_ps(v, _mm_set1_ps(0.5f));
+#if SIMD_ENABLE_SSE41
+	return _mm_floor_ps(v);
+#else
+	__m128 abs_v = _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+	__m128 small = _mm_cmplt_ps(abs_v, _mm_set1_ps(DRAW_ROUND_LIMIT));
+	// Truncating goes up for negative fractions, so those get 1 taken off
+	__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+	__m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, v), _mm_set1_ps(1.0f)));
+	return _mm_or_ps(_mm_and_ps(small, floored), _mm_andnot_ps(small, v));
+#endif
+}
+#endif
+
+#if SIMD_ENABLE_AVX
+inline __m256 draw_round_ps_avx(__m256 v) {
+	return _mm256_floor_ps(_mm256_add_ps(v, _mm256_set1_ps(0.5f)));
+}
+#endif
+
+// Transforms the 4 corners to clip space in place and snaps them if snap.enabled.
+// Returns false if the quad is completely outside clip (x1, y1, x2, y2 in clip space, see
+// draw_get_clip_rect). If cull is true the corners are left untouched in that case.
+// The corners are kept interleaved (x, y, x, y, ...) and each lane is
+//     a*v + b*swapped(v) + t
+// where a is (m00, m11, ...), b is (m01, m10, ...) and t is (m03, m13, ...), so x and y
+// are done in the same instructions. Only the x and y rows of world_to_clip matter since
+// z is 0, w is 1 and there is no perspective divide.
+bool draw_project_and_snap_corners(Vector2 *corners, Matrix4 m, Draw_Pixel_Snap snap, Vector4 clip, bool cull) {
+#if SIMD_ENABLE_AVX
+	__m256 v = _mm256_loadu_ps(&corners[0].x);
+	__m256 a = _mm256_setr_ps(m.m[0][0], m.m[1][1], m.m[0][0], m.m[1][1], m.m[0][0], m.m[1][1], m.m[0][0], m.m[1][1]);
+	__m256 b = _mm256_setr_ps(m.m[0][1], m.m[1][0], m.m[0][1], m.m[1][0], m.m[0][1], m.m[1][0], m.m[0][1], m.m[1][0]);
+	__m256 t = _mm256_setr_ps(m.m[0][3], m.m[1][3], m.m[0][3], m.m[1][3], m.m[0][3], m.m[1][3], m.m[0][3], m.m[1][3]);
 	
+	__m256 swapped = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+	__m256 p = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, v), _mm256_mul_ps(b, swapped)), t);
 	
-	quad.z = 0;
-	if (frame->z_count > 0)  quad.z = frame->z_stack[frame->z_count-1];
+	// Bits 0x55 are the x's, 0xAA the y's
+	__m256 clip_min = _mm256_setr_ps(clip.x, clip.y, clip.x, clip.y, clip.x, clip.y, clip.x, clip.y);
+	__m256 clip_max = _mm256_setr_ps(clip.z, clip.w, clip.z, clip.w, clip.z, clip.w, clip.z, clip.w);
+	u32 below = (u32)_mm256_movemask_ps(_mm256_cmp_ps(p, clip_min, _CMP_LT_OQ));
+	u32 above = (u32)_mm256_movemask_ps(_mm256_cmp_ps(p, clip_max, _CMP_GT_OQ));
+	bool visible = !((below & 0x55) == 0x55 || (below & 0xAA) == 0xAA || (above & 0x55) == 0x55 || (above & 0xAA) == 0xAA);
+	if (!visible && cull) return false;
 	
-	quad.has_scissor = false;
-	if (frame->scissor_count > 0) {
-		quad.scissor = frame->scissor_stack[frame->scissor_count-1];
-		quad.has_scissor = true;
+	if (snap.enabled) {
+		__m256 to_pixels = _mm256_setr_ps(snap.pixels_per_x, snap.pixels_per_y, snap.pixels_per_x, snap.pixels_per_y, snap.pixels_per_x, snap.pixels_per_y, snap.pixels_per_x, snap.pixels_per_y);
+		__m256 pixel_size = _mm256_setr_ps(snap.pixel_width, snap.pixel_height, snap.pixel_width, snap.pixel_height, snap.pixel_width, snap.pixel_height, snap.pixel_width, snap.pixel_height);
+		p = _mm256_mul_ps(draw_round_ps_avx(_mm256_mul_ps(p, to_pixels)), pixel_size);
 	}
+	_mm256_storeu_ps(&corners[0].x, p);
+#elif SIMD_ENABLE_SSE2
+	__m128 v01 = _mm_loadu_ps(&corners[0].x);
+	__m128 v23 = _mm_loadu_ps(&corners[2].x);
+	__m128 a = _mm_setr_ps(m.m[0][0], m.m[1][1], m.m[0][0], m.m[1][1]);
+	__m128 b = _mm_setr_ps(m.m[0][1], m.m[1][0], m.m[0][1], m.m[1][0]);
+	__m128 t = _mm_setr_ps(m.m[0][3], m.m[1][3], m.m[0][3], m.m[1][3]);
 	
-	memset(quad.userdata, 0, sizeof(quad.userdata));
+	__m128 p01 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, v01), _mm_mul_ps(b, _mm_shuffle_ps(v01, v01, _MM_SHUFFLE(2, 3, 0, 1)))), t);
+	__m128 p23 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, v23), _mm_mul_ps(b, _mm_shuffle_ps(v23, v23, _MM_SHUFFLE(2, 3, 0, 1)))), t);
 	
-	Draw_Quad **target_buffer = &frame->quad_buffer;
+	// Bits 0x5 are the x's, 0xA the y's
+	__m128 clip_min = _mm_setr_ps(clip.x, clip.y, clip.x, clip.y);
+	__m128 clip_max = _mm_setr_ps(clip.z, clip.w, clip.z, clip.w);
+	u32 below = (u32)_mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(p01, clip_min), _mm_cmplt_ps(p23, clip_min)));
+	u32 above = (u32)_mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(p01, clip_max), _mm_cmpgt_ps(p23, clip_max)));
+	bool visible = !((below & 0x5) == 0x5 || (below & 0xA) == 0xA || (above & 0x5) == 0x5 || (above & 0xA) == 0xA);
+	if (!visible && cull) return false;
 	
-	growing_array_add((void**)target_buffer, &quad);
+	if (snap.enabled) {
+		__m128 to_pixels = _mm_setr_ps(snap.pixels_per_x, snap.pixels_per_y, snap.pixels_per_x, snap.pixels_per_y);
+		__m128 pixel_size = _mm_setr_ps(snap.pixel_width, snap.pixel_height, snap.pixel_width, snap.pixel_height);
+		p01 = _mm_mul_ps(draw_round_ps(_mm_mul_ps(p01, to_pixels)), pixel_size);
+		p23 = _mm_mul_ps(draw_round_ps(_mm_mul_ps(p23, to_pixels)), pixel_size);
+	}
+	_mm_storeu_ps(&corners[0].x, p01);
+	_mm_storeu_ps(&corners[2].x, p23);
+#else
+	Vector2 p[4];
+	for (int c = 0; c < 4; c++) {
+		p[c].x = m.m[0][0]*corners[c].x + m.m[0][1]*corners[c].y + m.m[0][3];
+		p[c].y = m.m[1][0]*corners[c].x + m.m[1][1]*corners[c].y + m.m[1][3];
+	}
 	
-	Draw_Quad *q = &(*target_buffer)[growing_array_get_valid_count(*target_buffer)-1];
+	bool visible = !(
+	    (p[0].x < clip.x && p[1].x < clip.x && p[2].x < clip.x && p[3].x < clip.x) ||
+	    (p[0].x > clip.z && p[1].x > clip.z && p[2].x > clip.z && p[3].x > clip.z) ||
+	    (p[0].y < clip.y && p[1].y < clip.y && p[2].y < clip.y && p[3].y < clip.y) ||
+	    (p[0].y > clip.w && p[1].y > clip.w && p[2].y > clip.w && p[3].y > clip.w));
+	if (!visible && cull) return false;
 	
-	// This is meant to fix the annoying artifacts that shows up when sampling from a large atlas
-    // presumably for floating point precision issues or something.
-
-    // #Incomplete
-    // If we want to animate text with small movements then it will look wonky.
-    // This should be optional probably.
+	for (int c = 0; c < 4; c++) {
+		if (snap.enabled) {
+			p[c].x = draw_round_to_pixel(p[c].x*snap.pixels_per_x)*snap.pixel_width;
+			p[c].y = draw_round_to_pixel(p[c].y*snap.pixels_per_y)*snap.pixel_height;
+		}
+		corners[c] = p[c];
+	}
+#endif
+	return visible;
+}
 
-	float pixel_width = 2.0/(float)window.width;
-	float pixel_height = 2.0/(float)window.height;
+Draw_Quad _nil_quad = {0};
+// Takes the quad by pointer so the rect/image calls don't pass ~230 bytes through every level
+Draw_Quad *draw_push_quad_projected(const Draw_Quad *quad, Matrix4 world_to_clip, Draw_Frame *frame) {
+	Draw_Pixel_Snap snap = draw_get_pixel_snap(frame);
+	if (quad->flags & DRAW_QUAD_FLAG_NO_PIXEL_SNAP) snap.enabled = false;
+	
+	bool cull = !frame->disable_culling;
+	Vector4 clip = draw_get_clip_rect(frame, snap);
+	Vector2 corners[4] = { quad->bottom_left, quad->top_left, quad->top_right, quad->bottom_right };
+	if (!draw_project_and_snap_corners(corners, world_to_clip, snap, clip, cull) && cull) {
+		return &_nil_quad;
+	}
+	
+	Draw_Quad *q = (Draw_Quad*)bucket_array_push(&frame->quad_buffer);
+	// Userdata is more than half of the quad, so it's only copied if it's used
+	if (quad->flags & DRAW_QUAD_FLAG_HAS_USERDATA) *q = *quad;
+	else memcpy(q, quad, offsetof(Draw_Quad, userdata));
+	memcpy(&q->bottom_left, corners, sizeof(corners));
+	
+	q->image_min_filter = GFX_FILTER_MODE_NEAREST;
+	q->image_mag_filter = GFX_FILTER_MODE_NEAREST;
 	
-	q->bottom_left.x  = round(q->bottom_left.x  / pixel_width)  * pixel_width;
-    q->bottom_left.y  = round(q->bottom_left.y  / pixel_height) * pixel_height;
-    q->top_left.x     = round(q->top_left.x     / pixel_width)  * pixel_width;
-    q->top_left.y     = round(q->top_left.y     / pixel_height) * pixel_height;
-    q->top_right.x    = round(q->top_right.x    / pixel_width)  * pixel_width;
-    q->top_right.y    = round(q->top_right.y    / pixel_height) * pixel_height;
-    q->bottom_right.x = round(q->bottom_right.x / pixel_width)  * pixel_width;
-    q->bottom_right.y = round(q->bottom_right.y / pixel_height) * pixel_height;
+	q->z = 0;
+	if (frame->z_count > 0)  q->z = frame->z_stack[frame->z_count-1];
+	
+	q->has_scissor = false;
+	if (frame->scissor_count > 0) {
+		q->scissor = frame->scissor_stack[frame->scissor_count-1];
+		q->has_scissor = true;
+	}
 	
 	return q;
 }
+Draw_Quad *draw_quad_projected_in_frame(Draw_Quad quad, Matrix4 world_to_clip, Draw_Frame *frame) {
+	return draw_push_quad_projected(&quad, world_to_clip, frame);
+}
+// Userdata of drawn quads is uninitialized until the first call to this, which zeroes the
+// other slots. Writing q->userdata directly works too, if all of it is written and
+// DRAW_QUAD_FLAG_HAS_USERDATA is set.
+void draw_quad_set_userdata(Draw_Quad *q, u64 index, Vector4 data) {
+	assert(index < VERTEX_USER_DATA_COUNT, "Userdata index %llu out of range (max %d)", (unsigned long long)index, VERTEX_USER_DATA_COUNT-1);
+	if (!(q->flags & DRAW_QUAD_FLAG_HAS_USERDATA)) {
+		memset(q->userdata, 0, sizeof(q->userdata));
+		q->flags |= DRAW_QUAD_FLAG_HAS_USERDATA;
+	}
+	q->userdata[index] = data;
+}
 Draw_Quad *DrawQuadInFrame(Draw_Quad quad, Draw_Frame *frame) {
-	return draw_quad_projected_in_frame(quad, m4_mul(frame->projection, m4_inverse(frame->cameraXform)), frame);
+	return draw_quad_projected_in_frame(quad, draw_frame_get_world_to_clip(frame), frame);
 }
 
 Draw_Quad *DrawQuadXformInFrame(Draw_Quad quad, Matrix4 xform, Draw_Frame *frame) {
-	Matrix4 world_to_clip = M4Scalar(1.0);
-	world_to_clip         = m4_mul(world_to_clip, frame->projection);
-	world_to_clip         = m4_mul(world_to_clip, m4_inverse(frame->cameraXform));
-	world_to_clip         = m4_mul(world_to_clip, xform);
+	Matrix4 world_to_clip = m4_mul(draw_frame_get_world_to_clip(frame), xform);
 	return draw_quad_projected_in_frame(quad, world_to_clip, frame);
 }
 
@@ -328,8 +734,9 @@ Draw_Quad *DrawRectInFrame(Vector2 position, Vector2 size, Vector4 color, Draw_F
 	q.color = color;
 	q.image = 0;
 	q.type = QUAD_TYPE_REGULAR;
+	q.flags = 0;
 	
-	return DrawQuadInFrame(q, frame);
+	return draw_push_quad_projected(&q, draw_frame_get_world_to_clip(frame), frame);
 }
 Draw_Quad *DrawRectXformInFrame(Matrix4 xform, Vector2 size, Vector4 color, Draw_Frame *frame) {
 	// #Copypaste #Volatile	
@@ -359,8 +766,9 @@ Draw_Quad *DrawCircleInFrame(Vector2 position, Vector2 size, Vector4 color, Draw
 	q.color = color;
 	q.image = 0;
 	q.type = QUAD_TYPE_CIRCLE;
+	q.flags = 0;
 	
-	return DrawQuadInFrame(q, frame);
+	return draw_push_quad_projected(&q, draw_frame_get_world_to_clip(frame), frame);
 }
 Draw_Quad *draw_circle_xform_in_frame(Matrix4 xform, Vector2 size, Vector4 color, Draw_Frame *frame) {
 	// #Copypaste #Volatile	
@@ -375,19 +783,31 @@ Draw_Quad *draw_circle_xform_in_frame(Matrix4 xform, Vector2 size, Vector4 color
 	
     return DrawQuadXformInFrame(q, xform, frame);
 }
+// Sprites from a Texture_Atlas are drawn as their uv rect in the atlas page, see atlas.h
+inline Gal_Image *draw_resolve_atlas_sprite(Gal_Image *image, Vector4 *uv) {
+	Atlas_Sprite *sprite = image ? image->atlas_sprite : 0;
+	if (!sprite || !sprite->page) return image;
+	
+	if (sprite->flags & ATLAS_SPRITE_EVICTABLE) sprite->last_drawn = rdtsc();
+	
+	Vector4 r = sprite->uv;
+	*uv = v4(r.x + uv->x*(r.z-r.x), r.y + uv->y*(r.w-r.y), r.x + uv->z*(r.z-r.x), r.y + uv->w*(r.w-r.y));
+	return sprite->page;
+}
+
 Draw_Quad *DrawImageInFrame(Gal_Image *image, Vector2 position, Vector2 size, Vector4 color, Draw_Frame *frame) {
     Draw_Quad *q = DrawRectInFrame(position, size, color, frame);
 	
-	q->image = image;
 	q->uv = v4(0, 0, 1, 1);
+	q->image = draw_resolve_atlas_sprite(image, &q->uv);
 	
 	return q;
 }
 Draw_Quad *DrawImageXformInFrame(Gal_Image *image, Matrix4 xform, Vector2 size, Vector4 color, Draw_Frame *frame) {
     Draw_Quad *q = DrawRectXformInFrame(xform, size, color, frame);
 	
-	q->image = image;
 	q->uv = v4(0, 0, 1, 1);
+	q->image = draw_resolve_atlas_sprite(image, &q->uv);
 	
 	return q;
 }
@@ -452,7 +872,19 @@ void pop_z_layer_in_frame(Draw_Frame *frame) {
 void push_window_scissor_in_frame(Vector2 min, Vector2 max, Draw_Frame *frame) {
 	assert(frame->scissor_count < SCISSOR_STACK_MAX, "Too many scissors pushed. You can pop with pop_window_scissor() when you are done drawing to it.");
 	
-	frame->scissor_stack[frame->scissor_count] = v4(min.x, min.y, max.x, max.y);
+	Vector4 scissor = v4(min.x, min.y, max.x, max.y);
+	
+	// Nested scissors only draw where they overlap the ones they're pushed in, so the top
+	// of the stack is always the effective clip rect.
+	if (frame->scissor_count > 0) {
+		Vector4 outer = frame->scissor_stack[frame->scissor_count-1];
+		scissor.x = clamp(scissor.x, outer.x, outer.z);
+		scissor.y = clamp(scissor.y, outer.y, outer.w);
+		scissor.z = clamp(scissor.z, scissor.x, outer.z);
+		scissor.w = clamp(scissor.w, scissor.y, outer.w);
+	}
+	
+	frame->scissor_stack[frame->scissor_count] = scissor;
 	frame->scissor_count += 1;
 }
 void pop_window_scissor_in_frame(Draw_Frame *frame) {
@@ -461,6 +893,668 @@ void pop_window_scissor_in_frame(Draw_Frame *frame) {
 }
 
 
+///
+// Batched drawing
+//
+// Quads are transformed, culled and pixel snapped DRAW_BATCH_LANES at a time with the
+// corners in SoA lanes, and only the visible ones are written out as Draw_Quad's.
+// Like draw_quad_projected_in_frame, only the x and y rows of world_to_clip matter.
+
+#if SIMD_ENABLE_AVX
+	#define DRAW_BATCH_LANES 8
+#else
+	#define DRAW_BATCH_LANES 4
+#endif
+
+typedef struct Draw_Batch {
+	// Projected bottom left corner and the bottom/left edges of each quad
+	alignat(32) float32 origin_x[DRAW_BATCH_LANES];
+	alignat(32) float32 origin_y[DRAW_BATCH_LANES];
+	alignat(32) float32 edge_x_x[DRAW_BATCH_LANES];
+	alignat(32) float32 edge_x_y[DRAW_BATCH_LANES];
+	alignat(32) float32 edge_y_x[DRAW_BATCH_LANES];
+	alignat(32) float32 edge_y_y[DRAW_BATCH_LANES];
+	
+	// Output corners, same order as Draw_Quad
+	alignat(32) float32 corner_x[4][DRAW_BATCH_LANES];
+	alignat(32) float32 corner_y[4][DRAW_BATCH_LANES];
+} Draw_Batch;
+
+// Returns a bit mask of the lanes that are at least partially inside clip
+u32 draw_batch_cull_and_snap(Draw_Batch *b, Draw_Pixel_Snap snap, Vector4 clip) {
+	u32 visible = 0;
+	
+#if SIMD_ENABLE_AVX
+	__m256 ox  = _mm256_load_ps(b->origin_x);
+	__m256 oy  = _mm256_load_ps(b->origin_y);
+	__m256 exx = _mm256_load_ps(b->edge_x_x);
+	__m256 exy = _mm256_load_ps(b->edge_x_y);
+	__m256 eyx = _mm256_load_ps(b->edge_y_x);
+	__m256 eyy = _mm256_load_ps(b->edge_y_y);
+	
+	__m256 x[4], y[4];
+	x[0] = ox;                                    y[0] = oy;
+	x[1] = _mm256_add_ps(ox, eyx);                y[1] = _mm256_add_ps(oy, eyy);
+	x[2] = _mm256_add_ps(x[1], exx);              y[2] = _mm256_add_ps(y[1], exy);
+	x[3] = _mm256_add_ps(ox, exx);                y[3] = _mm256_add_ps(oy, exy);
+	
+	__m256 min_x = _mm256_min_ps(_mm256_min_ps(x[0], x[1]), _mm256_min_ps(x[2], x[3]));
+	__m256 max_x = _mm256_max_ps(_mm256_max_ps(x[0], x[1]), _mm256_max_ps(x[2], x[3]));
+	__m256 min_y = _mm256_min_ps(_mm256_min_ps(y[0], y[1]), _mm256_min_ps(y[2], y[3]));
+	__m256 max_y = _mm256_max_ps(_mm256_max_ps(y[0], y[1]), _mm256_max_ps(y[2], y[3]));
+	
+	__m256 culled = _mm256_or_ps(
+		_mm256_or_ps(_mm256_cmp_ps(max_x, _mm256_set1_ps(clip.x), _CMP_LT_OQ), _mm256_cmp_ps(min_x, _mm256_set1_ps(clip.z), _CMP_GT_OQ)),
+		_mm256_or_ps(_mm256_cmp_ps(max_y, _mm256_set1_ps(clip.y), _CMP_LT_OQ), _mm256_cmp_ps(min_y, _mm256_set1_ps(clip.w), _CMP_GT_OQ)));
+	visible = ~(u32)_mm256_movemask_ps(culled) & 0xFF;
+	
+	if (snap.enabled) {
+		__m256 to_px_x = _mm256_set1_ps(snap.pixels_per_x), px_x = _mm256_set1_ps(snap.pixel_width);
+		__m256 to_px_y = _mm256_set1_ps(snap.pixels_per_y), px_y = _mm256_set1_ps(snap.pixel_height);
+		for (int c = 0; c < 4; c++) {
+			x[c] = _mm256_mul_ps(draw_round_ps_avx(_mm256_mul_ps(x[c], to_px_x)), px_x);
+			y[c] = _mm256_mul_ps(draw_round_ps_avx(_mm256_mul_ps(y[c], to_px_y)), px_y);
+		}
+	}
+	for (int c = 0; c < 4; c++) {
+		_mm256_store_ps(b->corner_x[c], x[c]);
+		_mm256_store_ps(b->corner_y[c], y[c]);
+	}
+#elif SIMD_ENABLE_SSE2
+	__m128 ox  = _mm_load_ps(b->origin_x);
+	__m128 oy  = _mm_load_ps(b->origin_y);
+	__m128 exx = _mm_load_ps(b->edge_x_x);
+	__m128 exy = _mm_load_ps(b->edge_x_y);
+	__m128 eyx = _mm_load_ps(b->edge_y_x);
+	__m128 eyy = _mm_load_ps(b->edge_y_y);
+	
+	__m128 x[4], y[4];
+	x[0] = ox;                              y[0] = oy;
+	x[1] = _mm_add_ps(ox, eyx);             y[1] = _mm_add_ps(oy, eyy);
+	x[2] = _mm_add_ps(x[1], exx);           y[2] = _mm_add_ps(y[1], exy);
+	x[3] = _mm_add_ps(ox, exx);             y[3] = _mm_add_ps(oy, exy);
+	
+	__m128 min_x = _mm_min_ps(_mm_min_ps(x[0], x[1]), _mm_min_ps(x[2], x[3]));
+	__m128 max_x = _mm_max_ps(_mm_max_ps(x[0], x[1]), _mm_max_ps(x[2], x[3]));
+	__m128 min_y = _mm_min_ps(_mm_min_ps(y[0], y[1]), _mm_min_ps(y[2], y[3]));
+	__m128 max_y = _mm_max_ps(_mm_max_ps(y[0], y[1]), _mm_max_ps(y[2], y[3]));
+	
+	__m128 culled = _mm_or_ps(
+		_mm_or_ps(_mm_cmplt_ps(max_x, _mm_set1_ps(clip.x)), _mm_cmpgt_ps(min_x, _mm_set1_ps(clip.z))),
+		_mm_or_ps(_mm_cmplt_ps(max_y, _mm_set1_ps(clip.y)), _mm_cmpgt_ps(min_y, _mm_set1_ps(clip.w))));
+	visible = ~(u32)_mm_movemask_ps(culled) & 0xF;
+	
+	if (snap.enabled) {
+		__m128 to_px_x = _mm_set1_ps(snap.pixels_per_x), px_x = _mm_set1_ps(snap.pixel_width);
+		__m128 to_px_y = _mm_set1_ps(snap.pixels_per_y), px_y = _mm_set1_ps(snap.pixel_height);
+		for (int c = 0; c < 4; c++) {
+			x[c] = _mm_mul_ps(draw_round_ps(_mm_mul_ps(x[c], to_px_x)), px_x);
+			y[c] = _mm_mul_ps(draw_round_ps(_mm_mul_ps(y[c], to_px_y)), px_y);
+		}
+	}
+	for (int c = 0; c < 4; c++) {
+		_mm_store_ps(b->corner_x[c], x[c]);
+		_mm_store_ps(b->corner_y[c], y[c]);
+	}
+#else
+	for (int i = 0; i < DRAW_BATCH_LANES; i++) {
+		b->corner_x[0][i] = b->origin_x[i];
+		b->corner_y[0][i] = b->origin_y[i];
+		b->corner_x[1][i] = b->origin_x[i] + b->edge_y_x[i];
+		b->corner_y[1][i] = b->origin_y[i] + b->edge_y_y[i];
+		b->corner_x[2][i] = b->corner_x[1][i] + b->edge_x_x[i];
+		b->corner_y[2][i] = b->corner_y[1][i] + b->edge_x_y[i];
+		b->corner_x[3][i] = b->origin_x[i] + b->edge_x_x[i];
+		b->corner_y[3][i] = b->origin_y[i] + b->edge_x_y[i];
+		
+		float32 min_x = b->corner_x[0][i], max_x = min_x, min_y = b->corner_y[0][i], max_y = min_y;
+		for (int c = 1; c < 4; c++) {
+			min_x = fminf(min_x, b->corner_x[c][i]); max_x = fmaxf(max_x, b->corner_x[c][i]);
+			min_y = fminf(min_y, b->corner_y[c][i]); max_y = fmaxf(max_y, b->corner_y[c][i]);
+		}
+		if (!(max_x < clip.x || min_x > clip.z || max_y < clip.y || min_y > clip.w)) visible |= 1u << i;
+		
+		if (snap.enabled) {
+			for (int c = 0; c < 4; c++) {
+				b->corner_x[c][i] = draw_round_to_pixel(b->corner_x[c][i]*snap.pixels_per_x)*snap.pixel_width;
+				b->corner_y[c][i] = draw_round_to_pixel(b->corner_y[c][i]*snap.pixels_per_y)*snap.pixel_height;
+			}
+		}
+	}
+#endif
+	
+	return visible;
+}
+
+// The parts of a Draw_Quad that are the same for the whole batch
+Draw_Quad draw_batch_make_template(Gal_Image *image, Draw_Frame *frame) {
+	Draw_Quad q = ZERO(Draw_Quad);
+	q.color = v4(1, 1, 1, 1);
+	q.uv = v4(0, 0, 1, 1);
+	q.image = draw_resolve_atlas_sprite(image, &q.uv);
+	q.type = QUAD_TYPE_REGULAR;
+	q.image_min_filter = GFX_FILTER_MODE_NEAREST;
+	q.image_mag_filter = GFX_FILTER_MODE_NEAREST;
+	
+	if (frame->z_count > 0) q.z = frame->z_stack[frame->z_count-1];
+	
+	if (frame->scissor_count > 0) {
+		q.scissor = frame->scissor_stack[frame->scissor_count-1];
+		q.has_scissor = true;
+	}
+	return q;
+}
+
+// image is what was passed in, so uvs of atlas sprites can be moved into the page
+u64 draw_batch_emit(Draw_Batch *b, u32 visible, u64 first, Draw_Quad *template, Gal_Image *image, const Vector4 *colors, const Vector4 *uvs, Draw_Frame *frame) {
+	u64 emitted = 0;
+	for (u32 i = 0; visible; i++, visible >>= 1) {
+		if (!(visible & 1)) continue;
+		
+		Draw_Quad *q = (Draw_Quad*)bucket_array_push(&frame->quad_buffer);
+		memcpy(q, template, offsetof(Draw_Quad, userdata));
+		q->bottom_left  = v2(b->corner_x[0][i], b->corner_y[0][i]);
+		q->top_left     = v2(b->corner_x[1][i], b->corner_y[1][i]);
+		q->top_right    = v2(b->corner_x[2][i], b->corner_y[2][i]);
+		q->bottom_right = v2(b->corner_x[3][i], b->corner_y[3][i]);
+		if (colors) q->color = colors[first+i];
+		if (uvs) {
+			q->uv = uvs[first+i];
+			draw_resolve_atlas_sprite(image, &q->uv);
+		}
+		emitted += 1;
+	}
+	return emitted;
+}
+
+u64 draw_images_in_frame(Gal_Image *image, const Vector2 *positions, const Vector2 *sizes, const Vector4 *colors, const Vector4 *uvs, u64 count, Draw_Frame *frame) {
+	Matrix4 m = draw_frame_get_world_to_clip(frame);
+	Draw_Pixel_Snap snap = draw_get_pixel_snap(frame);
+	Vector4 clip = draw_get_clip_rect(frame, snap);
+	Draw_Quad template = draw_batch_make_template(image, frame);
+	
+	bucket_array_reserve(&frame->quad_buffer, bucket_array_get_count(&frame->quad_buffer) + count);
+	
+	Draw_Batch b;
+	u64 emitted = 0;
+	for (u64 first = 0; first < count; first += DRAW_BATCH_LANES) {
+		u64 n = min(DRAW_BATCH_LANES, count - first);
+		const Vector2 *p = positions + first;
+		const Vector2 *s = sizes + first;
+		
+#if SIMD_ENABLE_SSE2
+		if (n == DRAW_BATCH_LANES) {
+			for (u64 l = 0; l < DRAW_BATCH_LANES; l += 4) {
+				// Deinterleave 4 Vector2's into x and y lanes
+				__m128 p01 = _mm_loadu_ps(&p[l].x), p23 = _mm_loadu_ps(&p[l+2].x);
+				__m128 s01 = _mm_loadu_ps(&s[l].x), s23 = _mm_loadu_ps(&s[l+2].x);
+				__m128 px = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0));
+				__m128 py = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1));
+				__m128 sx = _mm_shuffle_ps(s01, s23, _MM_SHUFFLE(2, 0, 2, 0));
+				__m128 sy = _mm_shuffle_ps(s01, s23, _MM_SHUFFLE(3, 1, 3, 1));
+				
+				__m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m[0][0]), px), _mm_mul_ps(_mm_set1_ps(m.m[0][1]), py)), _mm_set1_ps(m.m[0][3]));
+				__m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m[1][0]), px), _mm_mul_ps(_mm_set1_ps(m.m[1][1]), py)), _mm_set1_ps(m.m[1][3]));
+				_mm_store_ps(b.origin_x + l, ox);
+				_mm_store_ps(b.origin_y + l, oy);
+				_mm_store_ps(b.edge_x_x + l, _mm_mul_ps(_mm_set1_ps(m.m[0][0]), sx));
+				_mm_store_ps(b.edge_x_y + l, _mm_mul_ps(_mm_set1_ps(m.m[1][0]), sx));
+				_mm_store_ps(b.edge_y_x + l, _mm_mul_ps(_mm_set1_ps(m.m[0][1]), sy));
+				_mm_store_ps(b.edge_y_y + l, _mm_mul_ps(_mm_set1_ps(m.m[1][1]), sy));
+			}
+		} else
+#endif
+		{
+			for (u64 i = 0; i < DRAW_BATCH_LANES; i++) {
+				// Unused lanes get an empty quad, they're masked out below anyways
+				Vector2 pi = i < n ? p[i] : v2(0, 0);
+				Vector2 si = i < n ? s[i] : v2(0, 0);
+				b.origin_x[i] = m.m[0][0]*pi.x + m.m[0][1]*pi.y + m.m[0][3];
+				b.origin_y[i] = m.m[1][0]*pi.x + m.m[1][1]*pi.y + m.m[1][3];
+				b.edge_x_x[i] = m.m[0][0]*si.x;
+				b.edge_x_y[i] = m.m[1][0]*si.x;
+				b.edge_y_x[i] = m.m[0][1]*si.y;
+				b.edge_y_y[i] = m.m[1][1]*si.y;
+			}
+		}
+		
+		u32 visible = draw_batch_cull_and_snap(&b, snap, clip);
+		if (frame->disable_culling) visible = ~0u;
+		visible &= (1u << n) - 1;
+		emitted += draw_batch_emit(&b, visible, first, &template, image, colors, uvs, frame);
+	}
+	
+	return emitted;
+}
+u64 draw_rects_in_frame(const Vector2 *positions, const Vector2 *sizes, const Vector4 *colors, u64 count, Draw_Frame *frame) {
+	return draw_images_in_frame(0, positions, sizes, colors, 0, count, frame);
+}
+
+u64 draw_images_xform_in_frame(Gal_Image *image, const Matrix4 *xforms, const Vector2 *sizes, const Vector4 *colors, const Vector4 *uvs, u64 count, Draw_Frame *frame) {
+	Matrix4 m = draw_frame_get_world_to_clip(frame);
+	Draw_Pixel_Snap snap = draw_get_pixel_snap(frame);
+	Vector4 clip = draw_get_clip_rect(frame, snap);
+	Draw_Quad template = draw_batch_make_template(image, frame);
+	
+	bucket_array_reserve(&frame->quad_buffer, bucket_array_get_count(&frame->quad_buffer) + count);
+	
+	Draw_Batch b;
+	u64 emitted = 0;
+	for (u64 first = 0; first < count; first += DRAW_BATCH_LANES) {
+		u64 n = min(DRAW_BATCH_LANES, count - first);
+		for (u64 i = 0; i < DRAW_BATCH_LANES; i++) {
+			if (i >= n) {
+				b.origin_x[i] = b.origin_y[i] = b.edge_x_x[i] = b.edge_x_y[i] = b.edge_y_x[i] = b.edge_y_y[i] = 0;
+				continue;
+			}
+			// Only the x and y rows of world_to_clip*xform are needed, and only the
+			// columns that the corners (0, 0), (w, 0), (0, h) use.
+			const Matrix4 *x = &xforms[first+i];
+			Vector2 size = sizes[first+i];
+			float32 r0[4], r1[4];
+			for (int c = 0; c < 4; c++) {
+				r0[c] = m.m[0][0]*x->m[0][c] + m.m[0][1]*x->m[1][c] + m.m[0][2]*x->m[2][c] + m.m[0][3]*x->m[3][c];
+				r1[c] = m.m[1][0]*x->m[0][c] + m.m[1][1]*x->m[1][c] + m.m[1][2]*x->m[2][c] + m.m[1][3]*x->m[3][c];
+			}
+			b.origin_x[i] = r0[3];
+			b.origin_y[i] = r1[3];
+			b.edge_x_x[i] = r0[0]*size.x;
+			b.edge_x_y[i] = r1[0]*size.x;
+			b.edge_y_x[i] = r0[1]*size.y;
+			b.edge_y_y[i] = r1[1]*size.y;
+		}
+		
+		u32 visible = draw_batch_cull_and_snap(&b, snap, clip);
+		if (frame->disable_culling) visible = ~0u;
+		visible &= (1u << n) - 1;
+		emitted += draw_batch_emit(&b, visible, first, &template, image, colors, uvs, frame);
+	}
+	
+	return emitted;
+}
+u64 draw_rects_xform_in_frame(const Matrix4 *xforms, const Vector2 *sizes, const Vector4 *colors, u64 count, Draw_Frame *frame) {
+	return draw_images_xform_in_frame(0, xforms, sizes, colors, 0, count, frame);
+}
+
+///
+// Parallel recording
+//
+
+// Below this many quads merging and sorting is done on the calling thread
+#define DRAW_PARALLEL_THRESHOLD 50000
+
+Draw_Frame *draw_frame_begin_sub_frames(Draw_Frame *frame, u64 sub_frame_count) {
+	assert(sub_frame_count > 0, "Need at least one sub frame");
+	assert(frame->sub_frame_count == 0, "Sub frames were not merged since the last draw_frame_begin_sub_frames");
+	
+	if (sub_frame_count > frame->allocated_sub_frame_count) {
+		Draw_Frame *sub_frames = (Draw_Frame*)alloc_uninitialized(GetHeapAllocator(), sub_frame_count*sizeof(Draw_Frame));
+		if (frame->sub_frames) {
+			memcpy(sub_frames, frame->sub_frames, frame->allocated_sub_frame_count*sizeof(Draw_Frame));
+			Dealloc(GetHeapAllocator(), frame->sub_frames);
+		}
+		for (u64 i = frame->allocated_sub_frame_count; i < sub_frame_count; i++) {
+			draw_frame_init(&sub_frames[i]);
+		}
+		frame->sub_frames = sub_frames;
+		frame->allocated_sub_frame_count = sub_frame_count;
+	}
+	
+	// Sub frames start out with the camera, z layer, scissor and flags of the frame so drawing
+	// to them is the same as drawing to the frame itself.
+	draw_frame_get_world_to_clip(frame);
+	draw_get_pixel_snap(frame);
+	for (u64 i = 0; i < sub_frame_count; i++) {
+		Draw_Frame *sub = &frame->sub_frames[i];
+		bucket_array_clear(&sub->quad_buffer);
+		
+		sub->projection               = frame->projection;
+		sub->cameraXform              = frame->cameraXform;
+		sub->cached_view              = frame->cached_view;
+		sub->cached_world_to_clip     = frame->cached_world_to_clip;
+		sub->camera_dirty             = frame->camera_dirty;
+		sub->cached_from_projection   = frame->cached_from_projection;
+		sub->cached_from_camera_xform = frame->cached_from_camera_xform;
+		sub->cbuffer                  = frame->cbuffer;
+		sub->enable_z_sorting         = frame->enable_z_sorting;
+		sub->enable_batch_sorting     = frame->enable_batch_sorting;
+		sub->enable_scissor_clipping  = frame->enable_scissor_clipping;
+		sub->disable_pixel_snapping   = frame->disable_pixel_snapping;
+		sub->pixel_snap               = frame->pixel_snap;
+		sub->disable_culling          = frame->disable_culling;
+		sub->shader_extension         = frame->shader_extension;
+		sub->highest_bound_slot_index = frame->highest_bound_slot_index;
+		memcpy(sub->bound_images, frame->bound_images, sizeof(frame->bound_images));
+		
+		sub->scissor_count = frame->scissor_count;
+		memcpy(sub->scissor_stack, frame->scissor_stack, frame->scissor_count*sizeof(Vector4));
+		sub->z_count = frame->z_count;
+		memcpy(sub->z_stack, frame->z_stack, frame->z_count*sizeof(s32));
+	}
+	frame->sub_frame_count = sub_frame_count;
+	
+	return frame->sub_frames;
+}
+
+typedef struct Draw_Merge_Job {
+	Draw_Frame *frame;
+	u64 *offsets;
+} Draw_Merge_Job;
+
+void draw_merge_sub_frame_job(void *data, u64 sub_frame_index) {
+	Draw_Merge_Job *job = (Draw_Merge_Job*)data;
+	Draw_Frame *sub = &job->frame->sub_frames[sub_frame_index];
+	
+	u64 offset = job->offsets[sub_frame_index];
+	for (u64 c = 0; c < bucket_array_get_chunk_count(&sub->quad_buffer); c++) {
+		u64 n;
+		void *chunk = bucket_array_get_chunk(&sub->quad_buffer, c, &n);
+		bucket_array_write(&job->frame->quad_buffer, offset, chunk, n);
+		offset += n;
+	}
+}
+
+// Appends the quads of all sub frames to the frame in sub frame order, after the quads that
+// were drawn to the frame itself, so the result doesn't depend on which thread recorded
+// what or when. Then sorts by z if the frame has enable_z_sorting.
+void draw_frame_merge_sub_frames(Draw_Frame *frame) {
+	u64 sub_frame_count = frame->sub_frame_count;
+	if (sub_frame_count == 0) return;
+	
+	// Where each sub frame goes
+	u64 *offsets = (u64*)alloc_uninitialized(GetTemporaryAllocator(), sub_frame_count*sizeof(u64));
+	u64 total = 0;
+	for (u64 i = 0; i < sub_frame_count; i++) {
+		offsets[i] = bucket_array_get_count(&frame->quad_buffer) + total;
+		total += bucket_array_get_count(&frame->sub_frames[i].quad_buffer);
+	}
+	bucket_array_push_n(&frame->quad_buffer, total);
+	
+	Draw_Merge_Job job;
+	job.frame = frame;
+	job.offsets = offsets;
+	if (total >= DRAW_PARALLEL_THRESHOLD) job_pool_run(get_job_pool(), draw_merge_sub_frame_job, &job, sub_frame_count);
+	else for (u64 i = 0; i < sub_frame_count; i++) draw_merge_sub_frame_job(&job, i);
+	
+	frame->sub_frame_count = 0;
+	
+	if (frame->enable_z_sorting) draw_frame_sort_by_z(frame);
+}
+
+typedef struct Draw_Record_Job {
+	Draw_Frame *frame;
+	Draw_Record_Proc proc;
+	void *data;
+} Draw_Record_Job;
+
+void draw_record_job(void *data, u64 job_index) {
+	Draw_Record_Job *job = (Draw_Record_Job*)data;
+	job->proc(&job->frame->sub_frames[job_index], job->data, job_index);
+}
+
+void draw_frame_record_parallel(Draw_Frame *frame, Draw_Record_Proc proc, void *data, u64 job_count) {
+	draw_frame_begin_sub_frames(frame, job_count);
+	
+	Draw_Record_Job job;
+	job.frame = frame;
+	job.proc = proc;
+	job.data = data;
+	job_pool_run(get_job_pool(), draw_record_job, &job, job_count);
+	
+	draw_frame_merge_sub_frames(frame);
+}
+
+typedef struct Draw_Sort_Gather_Job {
+	Bucket_Array *source;
+	Bucket_Array *destination;
+	u64 *sorted;
+	u64 count;
+	u64 job_count;
+} Draw_Sort_Gather_Job;
+
+void draw_sort_gather_job(void *data, u64 job_index) {
+	Draw_Sort_Gather_Job *job = (Draw_Sort_Gather_Job*)data;
+	u64 begin = (job->count * job_index) / job->job_count;
+	u64 end   = (job->count * (job_index+1)) / job->job_count;
+	
+	for (u64 i = begin; i < end; i++) {
+		u64 index = job->sorted[i] & 0xFFFFFFFFull;
+		Draw_Quad *src = (Draw_Quad*)(job->source->chunks[index >> job->source->items_per_chunk_log2]) + (index & (job->source->items_per_chunk-1));
+		Draw_Quad *dst = (Draw_Quad*)(job->destination->chunks[i >> job->destination->items_per_chunk_log2]) + (i & (job->destination->items_per_chunk-1));
+		memcpy(dst, src, sizeof(Draw_Quad));
+	}
+}
+
+// Stable radix sort of all quads in the frame by z. Draw_Quad pointers into the frame are
+// not valid after this.
+void draw_frame_sort_by_z(Draw_Frame *frame) {
+	u64 count = bucket_array_get_count(&frame->quad_buffer);
+	if (count <= 1) return;
+	assert(count <= 0xFFFFFFFFull, "Too many quads to sort");
+	
+	u64 *pairs = (u64*)alloc_uninitialized(GetHeapAllocator(), count*2*sizeof(u64));
+	
+	u64 i = 0;
+	bool is_sorted = true;
+	u64 last_key = 0;
+	for (u64 c = 0; c < bucket_array_get_chunk_count(&frame->quad_buffer); c++) {
+		u64 n;
+		Draw_Quad *quads = (Draw_Quad*)bucket_array_get_chunk(&frame->quad_buffer, c, &n);
+		for (u64 j = 0; j < n; j++) {
+			u64 key = (u64)(s64)(quads[j].z + MAX_Z) & ((1ull << MAX_Z_BITS) - 1);
+			is_sorted = is_sorted && key >= last_key;
+			last_key = key;
+			pairs[i] = (key << 32) | i;
+			i += 1;
+		}
+	}
+	
+	// Usually nothing pushes z layers at all
+	if (is_sorted) {
+		Dealloc(GetHeapAllocator(), pairs);
+		return;
+	}
+	
+	u64 *sorted = radix_sort_key_index_pairs(pairs, pairs + count, count, MAX_Z_BITS);
+	
+	if (frame->sort_buffer.item_size == 0) bucket_array_init(&frame->sort_buffer, sizeof(Draw_Quad));
+	bucket_array_clear(&frame->sort_buffer);
+	bucket_array_push_n(&frame->sort_buffer, count);
+	
+	Draw_Sort_Gather_Job job;
+	job.source = &frame->quad_buffer;
+	job.destination = &frame->sort_buffer;
+	job.sorted = sorted;
+	job.count = count;
+	job.job_count = 1;
+	if (count >= DRAW_PARALLEL_THRESHOLD) {
+		Job_Pool *pool = get_job_pool();
+		job.job_count = job_pool_get_worker_count(pool)+1;
+		job_pool_run(pool, draw_sort_gather_job, &job, job.job_count);
+	} else {
+		draw_sort_gather_job(&job, 0);
+	}
+	
+	Bucket_Array temp = frame->quad_buffer;
+	frame->quad_buffer = frame->sort_buffer;
+	frame->sort_buffer = temp;
+	
+	Dealloc(GetHeapAllocator(), pairs);
+}
+
+///
+// Draw lists
+//
+
+void draw_list_init(Draw_List *list) {
+	*list = ZERO(Draw_List);
+	bucket_array_init(&list->quads, sizeof(Draw_Quad));
+	bucket_array_init(&list->projected, sizeof(Draw_Quad));
+}
+void draw_list_deinit(Draw_List *list) {
+	assert(!list->recording_frame, "Draw_List is still recording");
+	bucket_array_deinit(&list->quads);
+	bucket_array_deinit(&list->projected);
+	list->recorded = false;
+	list->projected_valid = false;
+}
+
+Draw_Frame *draw_list_begin_recording(Draw_List *list) {
+	assert(!list->recording_frame, "Draw_List is already recording");
+	if (list->quads.item_size == 0) draw_list_init(list);
+	
+	Draw_Frame *frame = (Draw_Frame*)alloc_uninitialized(GetHeapAllocator(), sizeof(Draw_Frame));
+	*frame = ZERO(Draw_Frame);
+	// Reuse the chunks from last time
+	frame->quad_buffer = list->quads;
+	DrawFrameReset(frame);
+	
+	// world_to_clip is identity so the quads stay in world space until they are replayed,
+	// and nothing is culled or snapped yet since we don't know the camera.
+	draw_frame_set_projection(frame, M4Scalar(1.0));
+	frame->disable_culling = true;
+	frame->disable_pixel_snapping = true;
+	
+	list->recording_frame = frame;
+	list->recorded = false;
+	list->projected_valid = false;
+	return frame;
+}
+void draw_list_end_recording(Draw_List *list) {
+	assert(list->recording_frame, "Draw_List is not recording");
+	
+	list->quads = list->recording_frame->quad_buffer;
+	
+	list->bounds = v4(0, 0, 0, 0);
+	if (bucket_array_get_count(&list->quads) > 0) {
+		Vector4 b = v4(F32_MAX, F32_MAX, -F32_MAX, -F32_MAX);
+		for (u64 c = 0; c < bucket_array_get_chunk_count(&list->quads); c++) {
+			u64 n;
+			Draw_Quad *quads = (Draw_Quad*)bucket_array_get_chunk(&list->quads, c, &n);
+			for (u64 i = 0; i < n; i++) {
+				Vector2 *corners = &quads[i].bottom_left;
+				for (int k = 0; k < 4; k++) {
+					b = v4(min(b.x, corners[k].x), min(b.y, corners[k].y), max(b.z, corners[k].x), max(b.w, corners[k].y));
+				}
+			}
+		}
+		list->bounds = b;
+	}
+	
+	Dealloc(GetHeapAllocator(), list->recording_frame);
+	list->recording_frame = 0;
+	list->recorded = true;
+}
+
+void draw_list_invalidate(Draw_List *list) {
+	bucket_array_clear(&list->quads);
+	bucket_array_clear(&list->projected);
+	list->recorded = false;
+	list->projected_valid = false;
+}
+bool draw_list_is_recorded(Draw_List *list) {
+	return list->recorded;
+}
+Vector4 draw_list_get_bounds(Draw_List *list) {
+	return list->recorded ? list->bounds : v4(0, 0, 0, 0);
+}
+
+u64 draw_list_replay_in_frame(Draw_List *list, Matrix4 xform, Draw_Frame *frame) {
+	assert(!list->recording_frame, "Draw_List must be done recording before it's replayed");
+	if (!list->recorded) return 0;
+	
+	Matrix4 world_to_clip = m4_mul(draw_frame_get_world_to_clip(frame), xform);
+	Draw_Pixel_Snap snap = draw_get_pixel_snap(frame);
+	bool cull = !frame->disable_culling;
+	Vector4 clip = draw_get_clip_rect(frame, snap);
+	bool can_clip_scissors = snap.window_width > 0 && snap.window_height > 0;
+	
+	s32 z = frame->z_count > 0 ? frame->z_stack[frame->z_count-1] : 0;
+	bool has_scissor = frame->scissor_count > 0;
+	Vector4 scissor = has_scissor ? frame->scissor_stack[frame->scissor_count-1] : v4(0, 0, 0, 0);
+	
+	bool same_as_last_replay = list->replayed
+		&& memcmp(&world_to_clip, &list->projected_world_to_clip, sizeof(Matrix4)) == 0
+		&& snap.enabled == list->projected_snap.enabled
+		&& snap.window_width == list->projected_snap.window_width
+		&& snap.window_height == list->projected_snap.window_height
+		&& cull == list->projected_culled
+		&& z == list->projected_z
+		&& has_scissor == list->projected_has_scissor
+		&& (!has_scissor || memcmp(&scissor, &list->projected_scissor, sizeof(Vector4)) == 0);
+	
+	if (!same_as_last_replay) {
+		list->replayed = true;
+		list->projected_valid = false;
+		list->projected_world_to_clip = world_to_clip;
+		list->projected_snap = snap;
+		list->projected_culled = cull;
+		list->projected_z = z;
+		list->projected_has_scissor = has_scissor;
+		list->projected_scissor = scissor;
+	}
+	
+	// While the transform keeps changing the quads are projected straight into the frame.
+	// They're only cached once the same transform comes twice in a row.
+	if (!same_as_last_replay || !list->projected_valid) {
+		Bucket_Array *dst = same_as_last_replay ? &list->projected : &frame->quad_buffer;
+		if (same_as_last_replay) bucket_array_clear(dst);
+		u64 first = bucket_array_get_count(dst);
+		bucket_array_reserve(dst, first + bucket_array_get_count(&list->quads));
+		
+		for (u64 c = 0; c < bucket_array_get_chunk_count(&list->quads); c++) {
+			u64 n;
+			Draw_Quad *quads = (Draw_Quad*)bucket_array_get_chunk(&list->quads, c, &n);
+			for (u64 i = 0; i < n; i++) {
+				Draw_Quad *src = &quads[i];
+				
+				// Quads recorded without a z layer or scissor get the ones of the frame, and
+				// recorded scissors are cut down to the frame's like nested scissors
+				bool quad_has_scissor = src->has_scissor || has_scissor;
+				Vector4 quad_scissor = src->has_scissor ? src->scissor : scissor;
+				Vector4 quad_clip = clip;
+				if (src->has_scissor) {
+					if (has_scissor) {
+						quad_scissor.x = clamp(quad_scissor.x, scissor.x, scissor.z);
+						quad_scissor.y = clamp(quad_scissor.y, scissor.y, scissor.w);
+						quad_scissor.z = clamp(quad_scissor.z, quad_scissor.x, scissor.z);
+						quad_scissor.w = clamp(quad_scissor.w, quad_scissor.y, scissor.w);
+					}
+					if (can_clip_scissors) {
+						Vector4 s = draw_scissor_to_clip(quad_scissor, snap);
+						quad_clip = v4(max(-1.0f, s.x), max(-1.0f, s.y), min(1.0f, s.z), min(1.0f, s.w));
+					}
+				}
+				
+				Vector2 corners[4] = { src->bottom_left, src->top_left, src->top_right, src->bottom_right };
+				Draw_Pixel_Snap quad_snap = snap;
+				if (src->flags & DRAW_QUAD_FLAG_NO_PIXEL_SNAP) quad_snap.enabled = false;
+				if (!draw_project_and_snap_corners(corners, world_to_clip, quad_snap, quad_clip, cull) && cull) continue;
+				
+				Draw_Quad *q = (Draw_Quad*)bucket_array_push(dst);
+				if (src->flags & DRAW_QUAD_FLAG_HAS_USERDATA) *q = *src;
+				else memcpy(q, src, offsetof(Draw_Quad, userdata));
+				memcpy(&q->bottom_left, corners, sizeof(corners));
+				
+				if (q->z == 0) q->z = z;
+				q->has_scissor = quad_has_scissor;
+				if (quad_has_scissor) q->scissor = quad_scissor;
+			}
+		}
+		
+		if (!same_as_last_replay) return bucket_array_get_count(dst) - first;
+		list->projected_valid = true;
+	}
+	
+	for (u64 c = 0; c < bucket_array_get_chunk_count(&list->projected); c++) {
+		u64 n;
+		void *chunk = bucket_array_get_chunk(&list->projected, c, &n);
+		bucket_array_append(&frame->quad_buffer, chunk, n);
+	}
+	
+	return bucket_array_get_count(&list->projected);
+}
+
 ///
 // Global draw api (draw to global drawFrame)
 //
@@ -521,6 +1615,36 @@ void draw_line(Vector2 p0, Vector2 p1, float line_width, Vector4 color) {
 	draw_line_in_frame(p0, p1, line_width, color, &drawFrame);
 }
 
+inline
+u64 draw_rects(const Vector2 *positions, const Vector2 *sizes, const Vector4 *colors, u64 count) {
+	return draw_rects_in_frame(positions, sizes, colors, count, &drawFrame);
+}
+inline
+u64 draw_rects_xform(const Matrix4 *xforms, const Vector2 *sizes, const Vector4 *colors, u64 count) {
+	return draw_rects_xform_in_frame(xforms, sizes, colors, count, &drawFrame);
+}
+inline
+u64 draw_images(Gal_Image *image, const Vector2 *positions, const Vector2 *sizes, const Vector4 *colors, const Vector4 *uvs, u64 count) {
+	return draw_images_in_frame(image, positions, sizes, colors, uvs, count, &drawFrame);
+}
+inline
+u64 draw_images_xform(Gal_Image *image, const Matrix4 *xforms, const Vector2 *sizes, const Vector4 *colors, const Vector4 *uvs, u64 count) {
+	return draw_images_xform_in_frame(image, xforms, sizes, colors, uvs, count, &drawFrame);
+}
+inline
+void draw_record_parallel(Draw_Record_Proc proc, void *data, u64 job_count) {
+	draw_frame_record_parallel(&drawFrame, proc, data, job_count);
+}
+inline
+u64 draw_list_replay(Draw_List *list, Matrix4 xform) {
+	return draw_list_replay_in_frame(list, xform, &drawFrame);
+}
+
+inline
+void set_projection(Matrix4 projection) { draw_frame_set_projection(&drawFrame, projection); }
+inline
+void set_camera_xform(Matrix4 camera_xform) { draw_frame_set_camera_xform(&drawFrame, camera_xform); }
+
 inline
 void push_z_layer(s32 z) { push_z_layer_in_frame(z, &drawFrame); }
 inline
@@ -538,3 +1662,417 @@ void pop_window_scissor() { pop_window_scissor_in_frame(&drawFrame); }
 #define COLOR_WHITE ((Vector4){1.0, 1.0, 1.0, 1.0})
 #define COLOR_BLACK ((Vector4){0.0, 0.0, 0.0, 1.0})
 
+
+///
+// Instance streams
+//
+
+DEFINE_ARRAY(Draw_Quad_Instance)
+DEFINE_ARRAY(Draw_Quad_Instance_Extra)
+DEFINE_ARRAY(Gal_Image_Pointer)
+DEFINE_ARRAY(Vector4)
+DEFINE_ARRAY(Draw_Call)
+
+// Quads in the same scissor usually come in one run, but a scissor that's pushed again
+// after another one should still get the same index for batching.
+#define DRAW_INSTANCE_SCISSOR_SEARCH 8
+// Batch sorting insertion sorts z layers up to this many instances, radix sorts the rest
+#define DRAW_BATCH_INSERTION_SORT_MAX 64
+
+// Direct mapped cache from image to texture index, so we don't need to search the texture
+// table for every quad.
+#define DRAW_INSTANCE_TEXTURE_CACHE_SIZE 64
+
+inline u32 draw_pack_unorm8(float32 x) {
+	if (!(x > 0.0f)) return 0;
+	if (x >= 1.0f) return 255;
+	return (u32)(x*255.0f + 0.5f);
+}
+inline u16 draw_pack_unorm16(float32 x) {
+	if (!(x > 0.0f)) return 0;
+	if (x >= 1.0f) return 65535;
+	return (u16)(x*65535.0f + 0.5f);
+}
+inline u32 draw_pack_color(Vector4 c) {
+	return draw_pack_unorm8(c.r) | (draw_pack_unorm8(c.g) << 8) | (draw_pack_unorm8(c.b) << 16) | (draw_pack_unorm8(c.a) << 24);
+}
+
+// Same rounding as draw_pack_unorm8/draw_pack_unorm16, NaN becomes 0 too
+inline void draw_pack_color_and_uv(Draw_Quad_Instance *inst, Vector4 color, Vector4 uv) {
+#if SIMD_ENABLE_SSE2
+	__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f);
+	__m128 c = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&color.x), zero), one);
+	__m128i ci = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), half));
+	ci = _mm_packs_epi32(ci, ci);
+	inst->color = (u32)_mm_cvtsi128_si32(_mm_packus_epi16(ci, ci));
+	
+	// No unsigned 32 -> 16 pack in SSE2, so it's done signed around 32768
+	__m128 t = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&uv.x), zero), one);
+	__m128i ti = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(65535.0f)), half));
+	ti = _mm_sub_epi32(ti, _mm_set1_epi32(32768));
+	ti = _mm_xor_si128(_mm_packs_epi32(ti, ti), _mm_set1_epi16((short)0x8000));
+	_mm_storel_epi64((__m128i*)inst->uv, ti);
+#else
+	inst->color = draw_pack_color(color);
+	inst->uv[0] = draw_pack_unorm16(uv.x);
+	inst->uv[1] = draw_pack_unorm16(uv.y);
+	inst->uv[2] = draw_pack_unorm16(uv.z);
+	inst->uv[3] = draw_pack_unorm16(uv.w);
+#endif
+}
+
+void draw_instance_stream_clear(Draw_Instance_Stream *stream) {
+	Draw_Quad_Instance_Array_clear(&stream->instances);
+	Draw_Quad_Instance_Extra_Array_clear(&stream->extras);
+	Gal_Image_Pointer_Array_clear(&stream->textures);
+	Vector4_Array_clear(&stream->scissors);
+	Draw_Call_Array_clear(&stream->calls);
+	stream->stats = ZERO(Draw_Stream_Stats);
+}
+void draw_instance_stream_deinit(Draw_Instance_Stream *stream) {
+	Draw_Quad_Instance_Array_deinit(&stream->instances);
+	Draw_Quad_Instance_Extra_Array_deinit(&stream->extras);
+	Gal_Image_Pointer_Array_deinit(&stream->textures);
+	Vector4_Array_deinit(&stream->scissors);
+	Draw_Call_Array_deinit(&stream->calls);
+	Draw_Quad_Instance_Array_deinit(&stream->sort_scratch);
+	Draw_Quad_Instance_Extra_Array_deinit(&stream->extras_sort_scratch);
+	stream->stats = ZERO(Draw_Stream_Stats);
+}
+
+u16 draw_instance_stream_get_texture_index(Draw_Instance_Stream *stream, Gal_Image *image, Gal_Image **cache_images, u16 *cache_indices) {
+	u64 slot = (pointer_get_hash(image) >> 4) & (DRAW_INSTANCE_TEXTURE_CACHE_SIZE-1);
+	if (cache_images[slot] == image) return cache_indices[slot];
+	
+	u64 index = stream->textures.count;
+	for (u64 i = 0; i < stream->textures.count; i++) {
+		if (stream->textures.data[i] == image) {
+			index = i;
+			break;
+		}
+	}
+	if (index == stream->textures.count) {
+		assert(index < DRAW_INSTANCE_NO_TEXTURE, "Too many different images in one instance stream (max is %d)", DRAW_INSTANCE_NO_TEXTURE-1);
+		Gal_Image_Pointer_Array_push(&stream->textures, image);
+	}
+	
+	cache_images[slot] = image;
+	cache_indices[slot] = (u16)index;
+	return (u16)index;
+}
+
+// Scissor first since a scissor change always needs a new call, while different textures
+// can share one.
+inline u64 draw_instance_batch_key(Draw_Quad_Instance *instance) {
+	return ((u64)instance->scissor_index << 16) | (u64)instance->texture_index;
+}
+
+// Stable sort of each run of instances with the same z by (scissor, texture), so quads never
+// move past a quad in another z layer.
+void draw_instance_stream_sort_for_batching(Draw_Instance_Stream *stream) {
+	u64 count = stream->instances.count;
+	if (count <= 1) return;
+	assert(count <= 0xFFFFFFFFull, "Too many instances to sort for batching");
+	
+	Draw_Quad_Instance *instances = stream->instances.data;
+	
+	// (key << 32) | index, then just the source index for each output index. Only allocated
+	// once some layer actually needs sorting.
+	u64 *pairs = 0;
+	
+	u64 begin = 0;
+	while (begin < count) {
+		s32 z = instances[begin].z;
+		u64 end = begin + 1;
+		bool is_sorted = true;
+		u64 last_key = draw_instance_batch_key(&instances[begin]);
+		while (end < count && instances[end].z == z) {
+			u64 key = draw_instance_batch_key(&instances[end]);
+			is_sorted = is_sorted && key >= last_key;
+			last_key = key;
+			end += 1;
+		}
+		
+		if (!is_sorted) {
+			if (!pairs) {
+				pairs = (u64*)alloc_uninitialized(GetHeapAllocator(), count*2*sizeof(u64));
+				for (u64 i = 0; i < count; i++) pairs[i] = i;
+			}
+			
+			u64 n = end - begin;
+			u64 *run = pairs + begin;
+			for (u64 i = 0; i < n; i++) {
+				run[i] = (draw_instance_batch_key(&instances[begin+i]) << 32) | (begin+i);
+			}
+			
+			if (n <= DRAW_BATCH_INSERTION_SORT_MAX) {
+				// The index in the low bits makes every pair unique, so this is stable
+				for (u64 i = 1; i < n; i++) {
+					u64 pair = run[i];
+					u64 j = i;
+					while (j > 0 && run[j-1] > pair) {
+						run[j] = run[j-1];
+						j -= 1;
+					}
+					run[j] = pair;
+				}
+			} else {
+				u64 *sorted = radix_sort_key_index_pairs(run, pairs + count + begin, n, 32);
+				if (sorted != run) memcpy(run, sorted, n*sizeof(u64));
+			}
+			
+			stream->stats.sorted_layer_count += 1;
+		}
+		
+		begin = end;
+	}
+	
+	if (!pairs) return;
+	
+	Draw_Quad_Instance_Array_resize(&stream->sort_scratch, count);
+	for (u64 i = 0; i < count; i++) {
+		stream->sort_scratch.data[i] = instances[pairs[i] & 0xFFFFFFFFull];
+	}
+	Draw_Quad_Instance_Array temp = stream->instances;
+	stream->instances = stream->sort_scratch;
+	stream->sort_scratch = temp;
+	
+	if (stream->extras.count) {
+		Draw_Quad_Instance_Extra_Array_resize(&stream->extras_sort_scratch, count);
+		for (u64 i = 0; i < count; i++) {
+			stream->extras_sort_scratch.data[i] = stream->extras.data[pairs[i] & 0xFFFFFFFFull];
+		}
+		Draw_Quad_Instance_Extra_Array temp_extras = stream->extras;
+		stream->extras = stream->extras_sort_scratch;
+		stream->extras_sort_scratch = temp_extras;
+	}
+	
+	Dealloc(GetHeapAllocator(), pairs);
+}
+
+// Splits the instances into draw calls and gives every textured instance its texture_slot
+void draw_instance_stream_build_calls(Draw_Instance_Stream *stream) {
+	Draw_Call_Array_clear(&stream->calls);
+	
+	Draw_Stream_Stats *stats = &stream->stats;
+	stats->instance_count = stream->instances.count;
+	stats->scissor_breaks = 0;
+	stats->texture_limit_breaks = 0;
+	
+	Draw_Call *call = 0;
+	// Textures usually repeat from one instance to the next
+	u16 last_texture = DRAW_INSTANCE_NO_TEXTURE;
+	u16 last_slot = 0;
+	
+	for (u64 i = 0; i < stream->instances.count; i++) {
+		Draw_Quad_Instance *inst = &stream->instances.data[i];
+		u16 texture = inst->texture_index;
+		u16 slot = DRAW_INSTANCE_NO_TEXTURE;
+		
+		bool needs_new_call = !call;
+		if (call && inst->scissor_index != call->scissor_index) {
+			needs_new_call = true;
+			stats->scissor_breaks += 1;
+		}
+		
+		if (!needs_new_call && texture != DRAW_INSTANCE_NO_TEXTURE) {
+			if (texture == last_texture) {
+				slot = last_slot;
+			} else {
+				for (u16 t = 0; t < call->texture_count; t++) {
+					if (call->textures[t] == texture) {
+						slot = t;
+						break;
+					}
+				}
+				if (slot == DRAW_INSTANCE_NO_TEXTURE) {
+					if (call->texture_count == DRAW_CALL_MAX_TEXTURES) {
+						needs_new_call = true;
+						stats->texture_limit_breaks += 1;
+					} else {
+						slot = call->texture_count;
+						call->textures[slot] = texture;
+						call->texture_count += 1;
+					}
+				}
+			}
+		}
+		
+		if (needs_new_call) {
+			call = Draw_Call_Array_push_uninitialized(&stream->calls);
+			call->first_instance = (u32)i;
+			call->instance_count = 0;
+			call->scissor_index = inst->scissor_index;
+			call->texture_count = 0;
+			last_texture = DRAW_INSTANCE_NO_TEXTURE;
+			if (texture != DRAW_INSTANCE_NO_TEXTURE) {
+				slot = 0;
+				call->textures[0] = texture;
+				call->texture_count = 1;
+			}
+		}
+		
+		if (texture != DRAW_INSTANCE_NO_TEXTURE) {
+			last_texture = texture;
+			last_slot = slot;
+		}
+		inst->texture_slot = slot;
+		call->instance_count += 1;
+	}
+	
+	stats->draw_call_count = stream->calls.count;
+}
+
+// Cuts an axis aligned quad (uv included) to its scissor so it can be drawn without one.
+// Returns false if the quad has to keep the scissor: it's rotated or skewed, it's a circle
+// (the shape would be cut differently), or there's nothing left of it.
+bool draw_clip_quad_to_scissor(const Draw_Quad *q, Draw_Quad *out, Draw_Pixel_Snap snap, bool *clipped) {
+	if (q->type != QUAD_TYPE_REGULAR && q->type != QUAD_TYPE_TEXT) return false;
+	if (q->bottom_left.x != q->top_left.x || q->bottom_right.x != q->top_right.x
+	 || q->bottom_left.y != q->bottom_right.y || q->top_left.y != q->top_right.y) return false;
+	
+	Vector4 clip = draw_scissor_to_clip(q->scissor, snap);
+	float32 x0 = q->bottom_left.x, x1 = q->bottom_right.x;
+	float32 y0 = q->bottom_left.y, y1 = q->top_left.y;
+	float32 cx0 = clamp(x0, clip.x, clip.z), cx1 = clamp(x1, clip.x, clip.z);
+	float32 cy0 = clamp(y0, clip.y, clip.w), cy1 = clamp(y1, clip.y, clip.w);
+	if (cx0 == cx1 || cy0 == cy1) return false;
+	
+	*out = *q;
+	out->has_scissor = false;
+	*clipped = cx0 != x0 || cx1 != x1 || cy0 != y0 || cy1 != y1;
+	if (!*clipped) return true;
+	
+	// x0 != x1 and y0 != y1 here, otherwise the clamped edges would be equal too
+	float32 du = (q->uv.z - q->uv.x)/(x1 - x0);
+	float32 dv = (q->uv.w - q->uv.y)/(y1 - y0);
+	out->uv = v4(q->uv.x + (cx0-x0)*du, q->uv.y + (cy0-y0)*dv, q->uv.x + (cx1-x0)*du, q->uv.y + (cy1-y0)*dv);
+	
+	out->bottom_left  = v2(cx0, cy0);
+	out->top_left     = v2(cx0, cy1);
+	out->top_right    = v2(cx1, cy1);
+	out->bottom_right = v2(cx1, cy0);
+	return true;
+}
+
+void draw_frame_build_instance_stream(Draw_Frame *frame, Draw_Instance_Stream *stream) {
+	draw_instance_stream_clear(stream);
+	
+	u64 quad_count = bucket_array_get_count(&frame->quad_buffer);
+	Draw_Quad_Instance *instances = Draw_Quad_Instance_Array_push_n_uninitialized(&stream->instances, quad_count);
+	
+	Gal_Image *cache_images[DRAW_INSTANCE_TEXTURE_CACHE_SIZE] = {0};
+	u16 cache_indices[DRAW_INSTANCE_TEXTURE_CACHE_SIZE];
+	Gal_Image *last_image = 0;
+	u16 last_texture_index = DRAW_INSTANCE_NO_TEXTURE;
+	
+	Draw_Pixel_Snap snap = draw_get_pixel_snap(frame);
+	
+	// Pixel snapping moves the corners independently, so a snapped parallelogram can be off
+	// by about a pixel of the frame. That's not worth spending 144 bytes of extras on.
+	float32 tolerance = 0.00001f;
+	if (snap.window_width > 0 && snap.window_height > 0) {
+		tolerance = max(snap.pixel_width, snap.pixel_height) + 0.00001f;
+	}
+	bool clip_scissors = frame->enable_scissor_clipping && snap.window_width > 0 && snap.window_height > 0;
+	Draw_Quad clipped_quad;
+	
+	u64 index = 0;
+	for (u64 c = 0; c < bucket_array_get_chunk_count(&frame->quad_buffer); c++) {
+		u64 n;
+		Draw_Quad *quads = (Draw_Quad*)bucket_array_get_chunk(&frame->quad_buffer, c, &n);
+		for (u64 i = 0; i < n; i++, index++) {
+			Draw_Quad *q = &quads[i];
+			Draw_Quad_Instance *inst = &instances[index];
+			
+			bool clipped;
+			if (clip_scissors && q->has_scissor && draw_clip_quad_to_scissor(q, &clipped_quad, snap, &clipped)) {
+				q = &clipped_quad;
+				stream->stats.dropped_scissor_count += 1;
+				if (clipped) stream->stats.clipped_count += 1;
+			}
+			
+			inst->origin = q->bottom_left;
+			inst->axis_x = v2(q->bottom_right.x-q->bottom_left.x, q->bottom_right.y-q->bottom_left.y);
+			inst->axis_y = v2(q->top_left.x-q->bottom_left.x, q->top_left.y-q->bottom_left.y);
+			draw_pack_color_and_uv(inst, q->color, q->uv);
+			
+			inst->z = q->z;
+			inst->type = q->type;
+			inst->texture_slot = 0;
+			
+			inst->flags = 0;
+			if (q->image_min_filter == GFX_FILTER_MODE_LINEAR) inst->flags |= DRAW_INSTANCE_FLAG_MIN_FILTER_LINEAR;
+			if (q->image_mag_filter == GFX_FILTER_MODE_LINEAR) inst->flags |= DRAW_INSTANCE_FLAG_MAG_FILTER_LINEAR;
+			
+			inst->texture_index = DRAW_INSTANCE_NO_TEXTURE;
+			if (q->image == last_image) {
+				inst->texture_index = last_texture_index;
+			} else if (q->image) {
+				inst->texture_index = draw_instance_stream_get_texture_index(stream, q->image, cache_images, cache_indices);
+				last_image = q->image;
+				last_texture_index = inst->texture_index;
+			}
+			
+			inst->scissor_index = DRAW_INSTANCE_NO_SCISSOR;
+			if (q->has_scissor) {
+				// Quads with the same scissor are almost always next to each other
+				u64 scissor_index = stream->scissors.count;
+				u64 search_end = stream->scissors.count > DRAW_INSTANCE_SCISSOR_SEARCH ? stream->scissors.count-DRAW_INSTANCE_SCISSOR_SEARCH : 0;
+				for (u64 s = stream->scissors.count; s > search_end; s--) {
+					if (memcmp(&stream->scissors.data[s-1], &q->scissor, sizeof(Vector4)) == 0) {
+						scissor_index = s-1;
+						break;
+					}
+				}
+				if (scissor_index == stream->scissors.count) {
+					assert(stream->scissors.count < DRAW_INSTANCE_NO_SCISSOR, "Too many scissor changes in one instance stream (max is %d)", DRAW_INSTANCE_NO_SCISSOR-1);
+					Vector4_Array_push(&stream->scissors, q->scissor);
+				}
+				inst->scissor_index = (u16)scissor_index;
+			}
+			
+			float32 expected_x = q->bottom_left.x + inst->axis_x.x + inst->axis_y.x;
+			float32 expected_y = q->bottom_left.y + inst->axis_x.y + inst->axis_y.y;
+			bool has_top_right = fabsf(q->top_right.x-expected_x) > tolerance || fabsf(q->top_right.y-expected_y) > tolerance;
+			bool has_userdata  = (q->flags & DRAW_QUAD_FLAG_HAS_USERDATA) != 0;
+			
+			if (has_top_right || has_userdata) {
+				if (stream->extras.count == 0) {
+					// First instance that needs extras, so now every instance gets one
+					Draw_Quad_Instance_Extra_Array_resize(&stream->extras, quad_count);
+					memset(stream->extras.data, 0, quad_count*sizeof(Draw_Quad_Instance_Extra));
+				}
+				Draw_Quad_Instance_Extra *extra = &stream->extras.data[index];
+				if (has_userdata) {
+					memcpy(extra->userdata, q->userdata, sizeof(q->userdata));
+					inst->flags |= DRAW_INSTANCE_FLAG_HAS_USERDATA;
+				}
+				if (has_top_right) {
+					extra->top_right = q->top_right;
+					inst->flags |= DRAW_INSTANCE_FLAG_HAS_TOP_RIGHT;
+				}
+			}
+		}
+	}
+	
+	stream->shader_extension = frame->shader_extension;
+	stream->cbuffer = frame->cbuffer;
+	stream->pixel_snap = snap;
+	if (frame->enable_batch_sorting) draw_instance_stream_sort_for_batching(stream);
+	draw_instance_stream_build_calls(stream);
+}
+
+// Corners in the same order as Draw_Quad: bottom left, top left, top right, bottom right
+void draw_quad_instance_get_corners(Draw_Quad_Instance *instance, Draw_Quad_Instance_Extra *extra, Vector2 corners[4]) {
+	Vector2 o = instance->origin;
+	corners[0] = o;
+	corners[1] = v2(o.x + instance->axis_y.x, o.y + instance->axis_y.y);
+	corners[2] = v2(o.x + instance->axis_x.x + instance->axis_y.x, o.y + instance->axis_x.y + instance->axis_y.y);
+	corners[3] = v2(o.x + instance->axis_x.x, o.y + instance->axis_x.y);
+	
+	if (instance->flags & DRAW_INSTANCE_FLAG_HAS_TOP_RIGHT) {
+		assert(extra, "Instance has its top right corner in the extras but no extra was passed");
+		corners[2] = extra->top_right;
+	}
+}
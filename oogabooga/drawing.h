@@ -23,6 +23,8 @@
 
 // Basic types
 #include "utility.h"
+#include "array.h"
+#include "bucket_array.h"
 
 // Drawing constants and types
 #define VERTEX_USER_DATA_COUNT 8
@@ -47,6 +49,11 @@ typedef struct Gal_Shader_Extension {
     void *ps; void *cbuffer; uint64_t cbuffer_size;
 } Gal_Shader_Extension;
 
+// Keep the corners exactly where they were projected to instead of snapping them to pixels
+#define DRAW_QUAD_FLAG_NO_PIXEL_SNAP (1 << 0)
+// The quad has userdata. Without it userdata is left uninitialized and ignored, see draw_quad_set_userdata()
+#define DRAW_QUAD_FLAG_HAS_USERDATA  (1 << 1)
+
 typedef struct Draw_Quad {
     // BEWARE !! These are in ndc
     Vector2 bottom_left, top_left, top_right, bottom_right;
@@ -58,6 +65,8 @@ typedef struct Draw_Quad {
     s32 z;
     uint8_t type;
     bool has_scissor;
+    // DRAW_QUAD_FLAG_XXX
+    uint8_t flags;
     // x1, y1, x2, y2
     Vector4 uv;
     Vector4 scissor;
@@ -65,6 +74,110 @@ typedef struct Draw_Quad {
     Vector4 userdata[VERTEX_USER_DATA_COUNT]; // #Volatile do NOT change this to a pointer
 } Draw_Quad;
 
+// Compact version of a Draw_Quad for submitting to renderers, 48 bytes instead of ~230.
+// See "- Instance streams" in drawing.c.
+#define DRAW_INSTANCE_NO_TEXTURE 0xFFFF
+#define DRAW_INSTANCE_NO_SCISSOR 0xFFFF
+
+#define DRAW_INSTANCE_FLAG_MIN_FILTER_LINEAR (1 << 0)
+#define DRAW_INSTANCE_FLAG_MAG_FILTER_LINEAR (1 << 1)
+// The instance has userdata in Draw_Instance_Stream.extras
+#define DRAW_INSTANCE_FLAG_HAS_USERDATA      (1 << 2)
+// The quad isn't a parallelogram, top right corner is in Draw_Instance_Stream.extras
+#define DRAW_INSTANCE_FLAG_HAS_TOP_RIGHT     (1 << 3)
+
+typedef struct Draw_Quad_Instance {
+    // 2x3 transform of the unit quad, in ndc
+    Vector2 origin; // Bottom left
+    Vector2 axis_x; // Bottom left -> bottom right
+    Vector2 axis_y; // Bottom left -> top left
+    // RGBA8, r in the lowest byte
+    uint32_t color;
+    // x1, y1, x2, y2 as unorm16
+    uint16_t uv[4];
+    int32_t z;
+    uint16_t texture_index; // Into Draw_Instance_Stream.textures
+    uint16_t scissor_index; // Into Draw_Instance_Stream.scissors
+    uint8_t type;
+    uint8_t flags;
+    uint16_t texture_slot;  // Into the Draw_Call's textures
+} Draw_Quad_Instance;
+
+typedef struct Draw_Quad_Instance_Extra {
+    Vector4 userdata[VERTEX_USER_DATA_COUNT];
+    Vector2 top_right;
+    Vector2 reserved;
+} Draw_Quad_Instance_Extra;
+
+typedef Gal_Image *Gal_Image_Pointer;
+
+DECLARE_ARRAY(Draw_Quad_Instance)
+DECLARE_ARRAY(Draw_Quad_Instance_Extra)
+DECLARE_ARRAY(Gal_Image_Pointer)
+DECLARE_ARRAY(Vector4)
+
+// How many textures one draw call can sample from. When a call would need more, a new call
+// is started rather than failing like the old d3d11 renderer did past 32 images.
+#define DRAW_CALL_MAX_TEXTURES 32
+
+// A run of instances that can be drawn with one draw call, see "- Draw calls" in drawing.c.
+typedef struct Draw_Call {
+    uint32_t first_instance;
+    uint32_t instance_count;
+    uint16_t scissor_index; // Into Draw_Instance_Stream.scissors, or DRAW_INSTANCE_NO_SCISSOR
+    uint16_t texture_count;
+    // Bound to slots 0..texture_count-1, indices into Draw_Instance_Stream.textures
+    uint16_t textures[DRAW_CALL_MAX_TEXTURES];
+} Draw_Call;
+
+DECLARE_ARRAY(Draw_Call)
+
+typedef struct Draw_Stream_Stats {
+    uint64_t instance_count;
+    uint64_t draw_call_count;
+    // Why draw calls were split
+    uint64_t scissor_breaks;
+    uint64_t texture_limit_breaks;
+    // z layers which were reordered for batching
+    uint64_t sorted_layer_count;
+    // Quads that didn't need their scissor anymore with Draw_Frame.enable_scissor_clipping,
+    // and how many of those had to be cut
+    uint64_t dropped_scissor_count;
+    uint64_t clipped_count;
+} Draw_Stream_Stats;
+
+// 2/window size and its reciprocal for snapping clip space coordinates to pixels, cached in
+// the Draw_Frame for the window size it was computed for.
+typedef struct Draw_Pixel_Snap {
+	bool enabled;
+	int32_t window_width, window_height;
+	float pixel_width,  pixel_height;
+	float pixels_per_x, pixels_per_y;
+} Draw_Pixel_Snap;
+
+typedef struct Draw_Instance_Stream {
+    Draw_Quad_Instance_Array instances;
+    // Parallel to instances, but empty unless some instance has DRAW_INSTANCE_FLAG_HAS_USERDATA
+    // or DRAW_INSTANCE_FLAG_HAS_TOP_RIGHT.
+    Draw_Quad_Instance_Extra_Array extras;
+    Gal_Image_Pointer_Array textures;
+    Vector4_Array scissors;
+    
+    Draw_Call_Array calls;
+    // A Draw_Frame has one shader extension, so all calls use this one
+    Gal_Shader_Extension shader_extension;
+    // The frame's cbuffer, shader_extension.cbuffer_size bytes for the extension's constants
+    void *cbuffer;
+    // Of the frame it was built from. scissors are window pixels, this has the window size
+    // to take them to clip space with draw_scissor_to_clip.
+    Draw_Pixel_Snap pixel_snap;
+    Draw_Stream_Stats stats;
+    
+    // Scratch for reordering instances when batching
+    Draw_Quad_Instance_Array sort_scratch;
+    Draw_Quad_Instance_Extra_Array extras_sort_scratch;
+} Draw_Instance_Stream;
+
 typedef struct Draw_Frame {
 	Matrix4 projection;
 	// #Cleanup
@@ -73,34 +186,136 @@ typedef struct Draw_Frame {
 		Matrix4 cameraXform;
 	};
 	
+	// view (inverse cameraXform) and projection*view, computed on first use after
+	// projection or cameraXform changed, either with draw_frame_set_projection/
+	// draw_frame_set_camera_xform (which set camera_dirty) or assigned directly.
+	Matrix4 cached_view;
+	Matrix4 cached_world_to_clip;
+	bool camera_dirty;
+	// What the cache was computed from, to notice direct assignments
+	Matrix4 cached_from_projection;
+	Matrix4 cached_from_camera_xform;
+	
 	void *cbuffer;
 	
 	uint64_t scissor_count;
 	Vector4 scissor_stack[SCISSOR_STACK_MAX];
 	
-	Draw_Quad *quad_buffer;
+	// Bucket_Array of Draw_Quad, so Draw_Quad pointers stay valid until the frame is reset
+	Bucket_Array quad_buffer;
 	
 	uint64_t z_count;
 	int32_t z_stack[Z_STACK_MAX];
 	bool enable_z_sorting;
+	// Let quads in the same z layer be reordered by scissor and texture when building draw
+	// calls, see "- Draw calls" in drawing.c. Has to be set each frame.
+	bool enable_batch_sorting;
+	// Cut axis aligned quads to their scissor when building the instance stream so they can
+	// batch with quads that have no scissor, see "- Scissors" in drawing.c. Has to be set
+	// each frame.
+	bool enable_scissor_clipping;
+	
+	// Snapping quad corners to whole pixels is on by default, see "- Pixel snapping" in
+	// drawing.c. Like enable_z_sorting this has to be set each frame.
+	bool disable_pixel_snapping;
+	Draw_Pixel_Snap pixel_snap;
+	
+	// Keep quads that are completely off screen. Draw_List's record with this on.
+	bool disable_culling;
 	
 	Gal_Shader_Extension shader_extension;
 	
 	Gal_Image *bound_images[MAX_BOUND_IMAGES];
 	int highest_bound_slot_index;
 	
+	// For recording on several threads, see "- Parallel recording" in drawing.c. These and
+	// the buffers are kept when the frame is reset.
+	struct Draw_Frame *sub_frames;
+	uint64_t sub_frame_count;
+	uint64_t allocated_sub_frame_count;
+	// Scratch for draw_frame_sort_by_z
+	Bucket_Array sort_buffer;
+	
 } Draw_Frame;
 
+typedef void (*Draw_Record_Proc)(Draw_Frame *sub_frame, void *data, uint64_t job_index);
+
+// Quads recorded once and submitted again into frames (cached on the CPU, not retained by the
+// renderer), see "- Draw lists" in drawing.c
+typedef struct Draw_List {
+	// Draw_Quad's with their corners in world space
+	Bucket_Array quads;
+	Draw_Frame *recording_frame;
+	bool recorded;
+	
+	// Draw_Quad's from the last replay in clip space, culled and snapped. If the next replay
+	// has the same transform and frame state these are just copied. Only filled once a
+	// transform and frame state is replayed twice in a row (see draw_list_replay_in_frame).
+	Bucket_Array projected;
+	bool projected_valid;
+	bool replayed;
+	Matrix4 projected_world_to_clip;
+	Draw_Pixel_Snap projected_snap;
+	bool projected_culled;
+	int32_t projected_z;
+	bool projected_has_scissor;
+	Vector4 projected_scissor;
+	
+	// World space x1, y1, x2, y2 of the recorded quads
+	Vector4 bounds;
+} Draw_List;
+
 // Draw frame initialization functions
 void draw_frame_init(Draw_Frame* frame);
 void draw_frame_init_reserve(Draw_Frame* frame, uint64_t number_of_quads_to_reserve);
+void draw_frame_deinit(Draw_Frame *frame);
+
+// Parallel recording
+Draw_Frame *draw_frame_begin_sub_frames(Draw_Frame *frame, uint64_t sub_frame_count);
+void draw_frame_merge_sub_frames(Draw_Frame *frame);
+void draw_frame_record_parallel(Draw_Frame *frame, Draw_Record_Proc proc, void *data, uint64_t job_count);
+void draw_frame_sort_by_z(Draw_Frame *frame);
 
 // Function declarations
 Draw_Quad* draw_rect(Vector2 position, Vector2 size, Vector4 color);
 Draw_Quad* DrawRectXform(Matrix4 xform, Vector2 size, Vector4 color);
 void draw_text(Gal_Font *font, string text, u32 rasterHeight, Vector2 position, Vector2 scale, Vector4 color);
+
+// Batched drawing, returns the number of quads that weren't culled
+u64 draw_rects_in_frame(const Vector2 *positions, const Vector2 *sizes, const Vector4 *colors, u64 count, Draw_Frame *frame);
+u64 draw_rects_xform_in_frame(const Matrix4 *xforms, const Vector2 *sizes, const Vector4 *colors, u64 count, Draw_Frame *frame);
+u64 draw_images_in_frame(Gal_Image *image, const Vector2 *positions, const Vector2 *sizes, const Vector4 *colors, const Vector4 *uvs, u64 count, Draw_Frame *frame);
+u64 draw_images_xform_in_frame(Gal_Image *image, const Matrix4 *xforms, const Vector2 *sizes, const Vector4 *colors, const Vector4 *uvs, u64 count, Draw_Frame *frame);
 void DrawFrameReset(Draw_Frame *frame);
 
+// Draw lists
+void draw_list_init(Draw_List *list);
+void draw_list_deinit(Draw_List *list);
+Draw_Frame *draw_list_begin_recording(Draw_List *list);
+void draw_list_end_recording(Draw_List *list);
+void draw_list_invalidate(Draw_List *list);
+bool draw_list_is_recorded(Draw_List *list);
+Vector4 draw_list_get_bounds(Draw_List *list);
+u64 draw_list_replay_in_frame(Draw_List *list, Matrix4 xform, Draw_Frame *frame);
+
+// Camera
+void draw_frame_set_projection(Draw_Frame *frame, Matrix4 projection);
+void draw_frame_set_camera_xform(Draw_Frame *frame, Matrix4 camera_xform);
+// Same on drawFrame
+void set_projection(Matrix4 projection);
+void set_camera_xform(Matrix4 camera_xform);
+Matrix4 draw_frame_get_view(Draw_Frame *frame);
+Matrix4 draw_frame_get_world_to_clip(Draw_Frame *frame);
+Vector4 draw_frame_get_visible_rect(Draw_Frame *frame);
+
+// Instance streams
+void draw_frame_build_instance_stream(Draw_Frame *frame, Draw_Instance_Stream *stream);
+void draw_instance_stream_clear(Draw_Instance_Stream *stream);
+void draw_instance_stream_deinit(Draw_Instance_Stream *stream);
+void draw_instance_stream_sort_for_batching(Draw_Instance_Stream *stream);
+void draw_instance_stream_build_calls(Draw_Instance_Stream *stream);
+void draw_quad_instance_get_corners(Draw_Quad_Instance *instance, Draw_Quad_Instance_Extra *extra, Vector2 corners[4]);
+
 // Global draw frame
 extern Draw_Frame drawFrame;
 
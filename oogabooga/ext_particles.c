@@ -168,12 +168,17 @@ typedef struct Emission_Handle {
 } Emission_Handle;
 
 // #Global
+// Bucket_Array of Emission_Instance
 #if OOGABOOGA_LINK_EXTERNAL_INSTANCE
-ogb_instance Emission_Instance *emissions;
+ogb_instance Bucket_Array emissions;
 #else
-Emission_Instance *emissions;
+Bucket_Array emissions;
 #endif
 
+inline Emission_Instance *get_emission(u64 index) {
+	return (Emission_Instance*)bucket_array_get(&emissions, index);
+}
+
 float32 sample_interp_one(Emission_Interpolation_Kind interp, float32 min, float32 max, float t) {
 	switch (interp) {
 		case EMISSION_INTERPOLATION_LINEAR: {
@@ -268,16 +273,17 @@ Emission_Handle emit_particles(Emission_Config config, Vector2 pos) {
 	config.emissions_per_second = max(config.emissions_per_second, 1);
 	if (config.seed == 0) config.seed = get_random();
 
-	for (u64 i = 0; i < growing_array_get_valid_count(emissions); i += 1) {
-		if (!emissions[i].allocated) {
-			emissions[i] = ZERO(Emission_Instance);
-			emissions[i].config = config;
-			emissions[i].pos = pos;
-			emissions[i].start_time = OsGetElapsedSeconds();
-			emissions[i].allocated = true;
-			emissions[i].generation += 1;
+	for (u64 i = 0; i < bucket_array_get_count(&emissions); i += 1) {
+		Emission_Instance *e = get_emission(i);
+		if (!e->allocated) {
+			*e = ZERO(Emission_Instance);
+			e->config = config;
+			e->pos = pos;
+			e->start_time = OsGetElapsedSeconds();
+			e->allocated = true;
+			e->generation += 1;
 			
-			return (Emission_Handle) { i, emissions[i].generation };
+			return (Emission_Handle) { i, e->generation };
 		}
 	}
 
@@ -287,45 +293,45 @@ Emission_Handle emit_particles(Emission_Config config, Vector2 pos) {
 	inst.start_time = OsGetElapsedSeconds();
 	inst.allocated = true;	
 	inst.generation = 0;	
-	growing_array_add((void**)&emissions, &inst);
+	*(Emission_Instance*)bucket_array_push(&emissions) = inst;
 	
-	return (Emission_Handle){ growing_array_get_valid_count(emissions) - 1, 0 };
+	return (Emission_Handle){ bucket_array_get_count(&emissions) - 1, 0 };
 }
 
 void emission_reset(Emission_Handle h) {
-	assert(h.index < growing_array_get_valid_count(emissions), "Invalid Emission_Handle");
-	assert(h.generation == emissions[h.index].generation, "Invalid Emission_Handle; emission has been released");
+	assert(h.index < bucket_array_get_count(&emissions), "Invalid Emission_Handle");
+	assert(h.generation == get_emission(h.index)->generation, "Invalid Emission_Handle; emission has been released");
 	
-	Emission_Instance *e = &emissions[h.index];
+	Emission_Instance *e = get_emission(h.index);
 	e->start_time = OsGetElapsedSeconds();
 }
 
 void emission_set_config(Emission_Handle h, Emission_Config config) {
-	assert(h.index < growing_array_get_valid_count(emissions), "Invalid Emission_Handle");
-	assert(h.generation == emissions[h.index].generation, "Invalid Emission_Handle; emission has been released");
+	assert(h.index < bucket_array_get_count(&emissions), "Invalid Emission_Handle");
+	assert(h.generation == get_emission(h.index)->generation, "Invalid Emission_Handle; emission has been released");
 	
-	Emission_Instance *e = &emissions[h.index];
+	Emission_Instance *e = get_emission(h.index);
 	
 	e->config = config;
 }
 void emission_set_position(Emission_Handle h, Vector2 pos) {
-	assert(h.index < growing_array_get_valid_count(emissions), "Invalid Emission_Handle");
-	assert(h.generation == emissions[h.index].generation, "Invalid Emission_Handle; emission has been released");
+	assert(h.index < bucket_array_get_count(&emissions), "Invalid Emission_Handle");
+	assert(h.generation == get_emission(h.index)->generation, "Invalid Emission_Handle; emission has been released");
 	
-	Emission_Instance *e = &emissions[h.index];
+	Emission_Instance *e = get_emission(h.index);
 	
 	e->pos = pos;
 }
 void emission_release(Emission_Handle h) {
-	assert(h.index < growing_array_get_valid_count(emissions), "Invalid Emission_Handle");
+	assert(h.index < bucket_array_get_count(&emissions), "Invalid Emission_Handle");
 	
-	Emission_Instance *e = &emissions[h.index];
+	Emission_Instance *e = get_emission(h.index);
 	
 	if (e->generation == h.generation) e->allocated = false;
 }
 
 void particles_init() {
-	growing_array_init_reserve((void**)&emissions, sizeof(Emission_Instance), 16, GetHeapAllocator());
+	bucket_array_init(&emissions, sizeof(Emission_Instance));
 }
 
 void particles_update() {
@@ -340,8 +346,8 @@ void particles_draw() {
 
 	u64 backup_seed = seed_for_random;
 	
-	for (u64 i = 0; i < growing_array_get_valid_count(emissions); i += 1) {
-		Emission_Instance *e = &emissions[i];
+	for (u64 i = 0; i < bucket_array_get_count(&emissions); i += 1) {
+		Emission_Instance *e = get_emission(i);
 		if (!e->allocated) continue;
 		
 		float32 passed = now - e->start_time;
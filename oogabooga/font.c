@@ -240,9 +240,10 @@ void font_atlas_init(Gfx_Font_Atlas *atlas, Gfx_Font_Variation *variation, u32 f
 		}
 		
 		if (bitmap) {
-			// #Speed #Loadtimes
+			// Queued a row at a time to flip the bitmap, the queue merges the rows back into
+			// one upload per glyph at the next flush
 			for (int row = 0; row < h; ++row) {
-                gfx_set_image_data(atlas->image, cursor_x, cursor_y + (h - 1 - row), w, 1, bitmap + (row * w));
+                gal_queue_image_update(atlas->image, cursor_x, cursor_y + (h - 1 - row), w, 1, bitmap + (row * w));
             }
 			stbtt_FreeBitmap(bitmap, 0);
 		}
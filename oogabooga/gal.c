@@ -31,15 +31,168 @@ extern GAL_Renderer d3d11_create_renderer(void);
 #if defined(RENDERER_SOFTWARE) && RENDERER_SOFTWARE
 extern GAL_Renderer software_create_renderer(void);
 #endif
+// Always built in, it doesn't need anything
+extern GAL_Renderer null_create_renderer(void);
 
 // Global state
 static struct {
     GAL_Renderer* active_renderer;
     GAL_Backend active_backend;
     bool initialized;
-    bool attempted_backends[5]; // Track which backends we've attempted to use
+    bool attempted_backends[GAL_BACKEND_UNKNOWN]; // Track which backends we've attempted to use
+    // Frames are packed in here for renderers with render_instances
+    Draw_Instance_Stream stream;
 } g_gal = {0};
 
+// ================ UPLOAD QUEUE ================
+
+#define GAL_UPLOAD_STAGING_SIZE (1024*1024)
+#define GAL_UPLOAD_MIN_REGIONS 256
+
+typedef struct GAL_Upload_Region {
+    // 0 if the image was destroyed before the flush
+    GAL_Texture_Handle texture;
+    uint32_t channels;
+    uint32_t x, y, width, height;
+    // Where the pixels are in the staging data
+    uint64_t offset;
+    // Which upload the flush merged it into
+    uint64_t upload;
+} GAL_Upload_Region;
+
+typedef struct GAL_Upload_Staging {
+    uint8_t* data;
+    uint64_t size, capacity;
+    GAL_Upload_Region* regions;
+    uint64_t region_count, region_capacity;
+    GAL_Upload_Fence last_fence;
+} GAL_Upload_Staging;
+
+// A rect of the regions merged together, as it goes to update_texture
+typedef struct GAL_Upload {
+    GAL_Texture_Handle texture;
+    uint32_t channels;
+    uint32_t x, y, width, height;
+    uint64_t first_region;
+    uint64_t region_count;
+    // Into merge_pixels, for uploads of more than one region
+    uint64_t merge_offset;
+} GAL_Upload;
+
+static struct {
+    // Only held to queue, swap and read stats, never while uploading
+    Spinlock lock;
+    // Held for a whole flush, so only one thread flushes at a time. Taken before lock,
+    // and made on first use.
+    Mutex flush_mutex;
+    bool flush_mutex_ready;
+    // Regions are queued in staging[writing] while the other one is being flushed
+    GAL_Upload_Staging staging[2];
+    uint32_t writing;
+    GAL_Upload_Fence next_fence;
+    volatile GAL_Upload_Fence done_fence;
+    GAL_Upload_Stats stats;
+    
+    // Flush scratch, only touched with flush_mutex held
+    GAL_Upload* uploads;
+    uint64_t upload_capacity;
+    uint8_t* merge_pixels;
+    uint64_t merge_capacity;
+} g_upload = {0};
+
+// Grows a block to hold at least needed bytes, keeping the first used bytes
+static void* gal_upload_reserve(void* block, uint64_t used, uint64_t* capacity, uint64_t needed, uint64_t min_capacity) {
+    if (block && needed <= *capacity) {
+        return block;
+    }
+    
+    uint64_t new_capacity = max(max(*capacity*2, needed), min_capacity);
+    void* new_block = alloc_uninitialized(GetHeapAllocator(), new_capacity);
+    if (block) {
+        memcpy(new_block, block, used);
+        Dealloc(GetHeapAllocator(), block);
+    }
+    *capacity = new_capacity;
+    return new_block;
+}
+
+// Merges r into u if the two together are still a rect, so every pixel of the merged upload
+// was queued: same columns with touching or overlapping rows, same rows with touching or
+// overlapping columns, or one inside the other.
+static bool gal_upload_try_merge(GAL_Upload* u, GAL_Upload_Region* r) {
+    uint32_t ux2 = u->x + u->width,  uy2 = u->y + u->height;
+    uint32_t rx2 = r->x + r->width,  ry2 = r->y + r->height;
+    
+    if (r->x == u->x && r->width == u->width && r->y <= uy2 && ry2 >= u->y) {
+        u->y = min(u->y, r->y);
+        u->height = max(uy2, ry2) - u->y;
+    } else if (r->y == u->y && r->height == u->height && r->x <= ux2 && rx2 >= u->x) {
+        u->x = min(u->x, r->x);
+        u->width = max(ux2, rx2) - u->x;
+    } else if (r->x >= u->x && r->y >= u->y && rx2 <= ux2 && ry2 <= uy2) {
+        // Already covered
+    } else if (r->x <= u->x && r->y <= u->y && rx2 >= ux2 && ry2 >= uy2) {
+        u->x = r->x;
+        u->y = r->y;
+        u->width = r->width;
+        u->height = r->height;
+    } else {
+        return false;
+    }
+    
+    u->region_count += 1;
+    return true;
+}
+
+static void gal_upload_acquire_flush(void) {
+    spinlock_acquire_or_wait(&g_upload.lock);
+    if (!g_upload.flush_mutex_ready) {
+        mutex_init(&g_upload.flush_mutex);
+        g_upload.flush_mutex_ready = true;
+    }
+    spinlock_release(&g_upload.lock);
+    mutex_acquire_or_wait(&g_upload.flush_mutex);
+}
+
+// Drops what's queued for a texture that is about to be destroyed. Waits for a flush that is
+// going on, which could still be uploading to it.
+static void gal_cancel_uploads(GAL_Texture_Handle texture) {
+    gal_upload_acquire_flush();
+    spinlock_acquire_or_wait(&g_upload.lock);
+    for (uint32_t s = 0; s < 2; s++) {
+        GAL_Upload_Staging* staging = &g_upload.staging[s];
+        for (uint64_t i = 0; i < staging->region_count; i++) {
+            if (staging->regions[i].texture == texture) {
+                staging->regions[i].texture = NULL;
+            }
+        }
+    }
+    spinlock_release(&g_upload.lock);
+    mutex_release(&g_upload.flush_mutex);
+}
+
+static void gal_upload_queue_deinit(void) {
+    gal_upload_acquire_flush();
+    spinlock_acquire_or_wait(&g_upload.lock);
+    for (uint32_t i = 0; i < 2; i++) {
+        GAL_Upload_Staging* staging = &g_upload.staging[i];
+        if (staging->data) Dealloc(GetHeapAllocator(), staging->data);
+        if (staging->regions) Dealloc(GetHeapAllocator(), staging->regions);
+        *staging = (GAL_Upload_Staging){0};
+    }
+    if (g_upload.uploads) Dealloc(GetHeapAllocator(), g_upload.uploads);
+    if (g_upload.merge_pixels) Dealloc(GetHeapAllocator(), g_upload.merge_pixels);
+    g_upload.uploads = NULL;
+    g_upload.upload_capacity = 0;
+    g_upload.merge_pixels = NULL;
+    g_upload.merge_capacity = 0;
+    
+    // Whatever was still queued is never going in, don't keep anyone waiting on it
+    g_upload.done_fence = g_upload.next_fence;
+    spinlock_release(&g_upload.lock);
+    mutex_release(&g_upload.flush_mutex);
+}
+
 // Default logging functions
 static void default_log_verbose(const char* fmt, ...) {
     va_list args;
@@ -77,6 +230,363 @@ static void default_log_error(const char* fmt, ...) {
     va_end(args);
 }
 
+// ================ TIMING ================
+
+// Regions of frame f are timed with queries (f*GAL_TIMING_MAX_REGIONS + region)*2 and the one after
+typedef struct GAL_Timing_Region {
+    char name[GAL_TIMING_MAX_NAME];
+    uint32_t depth;
+} GAL_Timing_Region;
+
+typedef struct GAL_Timing_Frame {
+    GAL_Timing_Region regions[GAL_TIMING_MAX_REGIONS];
+    uint32_t region_count;
+    // Ended and not read back yet
+    bool pending;
+    // OsGetElapsedSeconds minus the renderer's clock when the frame ended
+    double clock_offset;
+} GAL_Timing_Frame;
+
+static struct {
+    bool enabled;
+    GAL_Timing_Frame frames[GAL_TIMING_FRAMES];
+    // Regions go in this frame, the ones after it are older
+    uint32_t current;
+    // Regions begun and not ended, UINT32_MAX for ones that were dropped
+    uint32_t open[GAL_TIMING_MAX_REGIONS];
+    uint32_t open_count;
+    GAL_Timing_Result results[GAL_TIMING_MAX_REGIONS];
+    uint64_t result_count;
+    GAL_Timing_Stats stats;
+} g_timing = {0};
+
+static uint32_t gal_timing_query(uint32_t frame, uint32_t region) {
+    return (frame*GAL_TIMING_MAX_REGIONS + region)*2;
+}
+
+// The queries belong to the renderer, start over when it changes or timing is turned on
+static void gal_timing_reset(void) {
+    memset(g_timing.frames, 0, sizeof(g_timing.frames));
+    g_timing.current = 0;
+    g_timing.open_count = 0;
+}
+
+void gal_set_timing(bool enabled) {
+    if (enabled && !g_timing.enabled) gal_timing_reset();
+    g_timing.enabled = enabled;
+}
+
+void gal_begin_timing(string name) {
+    GAL_Renderer* renderer = gal_get_renderer();
+    if (!g_timing.enabled || !renderer || !renderer->write_timestamp) return;
+    
+    GAL_Timing_Frame* frame = &g_timing.frames[g_timing.current];
+    if (g_timing.open_count >= GAL_TIMING_MAX_REGIONS) {
+        g_timing.stats.dropped_regions += 1;
+        return;
+    }
+    if (frame->region_count >= GAL_TIMING_MAX_REGIONS) {
+        g_timing.stats.dropped_regions += 1;
+        g_timing.open[g_timing.open_count++] = UINT32_MAX;
+        return;
+    }
+    
+    uint32_t index = frame->region_count++;
+    GAL_Timing_Region* region = &frame->regions[index];
+    uint64_t count = min(name.count, GAL_TIMING_MAX_NAME - 1);
+    memcpy(region->name, name.data, count);
+    region->name[count] = 0;
+    region->depth = g_timing.open_count;
+    g_timing.open[g_timing.open_count++] = index;
+    
+    renderer->write_timestamp(gal_timing_query(g_timing.current, index));
+}
+
+void gal_end_timing(void) {
+    GAL_Renderer* renderer = gal_get_renderer();
+    if (!g_timing.enabled || !renderer || !renderer->write_timestamp) return;
+    if (g_timing.open_count == 0) {
+        g_timing.stats.dropped_regions += 1;
+        return;
+    }
+    
+    uint32_t index = g_timing.open[--g_timing.open_count];
+    if (index != UINT32_MAX) renderer->write_timestamp(gal_timing_query(g_timing.current, index) + 1);
+}
+
+// False if some query of the frame isn't in yet
+static bool gal_timing_read_frame(GAL_Renderer* renderer, uint32_t frame_index) {
+    GAL_Timing_Frame* frame = &g_timing.frames[frame_index];
+    uint64_t times[GAL_TIMING_MAX_REGIONS*2];
+    for (uint32_t i = 0; i < frame->region_count*2; i++) {
+        if (!renderer->read_timestamp(gal_timing_query(frame_index, 0) + i, &times[i])) return false;
+    }
+    
+    for (uint32_t i = 0; i < frame->region_count; i++) {
+        GAL_Timing_Result* result = &g_timing.results[i];
+        memcpy(result->name, frame->regions[i].name, GAL_TIMING_MAX_NAME);
+        result->depth = frame->regions[i].depth;
+        result->start_seconds = (double)times[i*2]*1e-9 + frame->clock_offset;
+        result->seconds = times[i*2 + 1] > times[i*2] ? (double)(times[i*2 + 1] - times[i*2])*1e-9 : 0;
+#if ENABLE_PROFILING
+        _profiler_report_gpu_time(STR(result->name), result->seconds, result->start_seconds);
+#endif
+    }
+    g_timing.result_count = frame->region_count;
+    g_timing.stats.frames += 1;
+    g_timing.stats.regions += frame->region_count;
+    frame->pending = false;
+    return true;
+}
+
+// After each frame gal draws. Reads back every frame whose queries are in, oldest first, and
+// drops the one that's up next if it still isn't in, its queries are about to be written again.
+static void gal_timing_end_frame(GAL_Renderer* renderer) {
+    if (!g_timing.enabled || !renderer->write_timestamp || !renderer->read_timestamp) return;
+    
+    // Regions left open end with the frame
+    while (g_timing.open_count > 0) gal_end_timing();
+    
+    GAL_Timing_Frame* frame = &g_timing.frames[g_timing.current];
+    if (frame->region_count > 0) {
+        uint64_t renderer_now = 0;
+        double now = OsGetElapsedSeconds();
+        bool has_clock = renderer->get_timestamp && renderer->get_timestamp(&renderer_now);
+        frame->clock_offset = has_clock ? now - (double)renderer_now*1e-9 : 0;
+        frame->pending = true;
+    }
+    
+    g_timing.current = (g_timing.current + 1) % GAL_TIMING_FRAMES;
+    for (uint32_t i = 0; i < GAL_TIMING_FRAMES; i++) {
+        uint32_t index = (g_timing.current + i) % GAL_TIMING_FRAMES;
+        if (!g_timing.frames[index].pending) continue;
+        // They finish in order, if this one isn't in the newer ones aren't either
+        if (!gal_timing_read_frame(renderer, index)) break;
+    }
+    
+    GAL_Timing_Frame* next = &g_timing.frames[g_timing.current];
+    if (next->pending) g_timing.stats.dropped_frames += 1;
+    next->pending = false;
+    next->region_count = 0;
+}
+
+uint64_t gal_get_timings(GAL_Timing_Result* results, uint64_t max_results) {
+    if (results) memcpy(results, g_timing.results, min(max_results, g_timing.result_count)*sizeof(GAL_Timing_Result));
+    return g_timing.result_count;
+}
+
+void gal_get_timing_stats(GAL_Timing_Stats* stats) {
+    if (!stats) return;
+    *stats = g_timing.stats;
+}
+
+// ================ FRAME PIPELINE ================
+
+// Sleep until this long before the deadline, then spin. OS sleeps can come back a timer tick late.
+#define GAL_FRAME_PACING_SPIN_SECONDS 0.002
+
+static struct {
+    uint32_t latency;
+    bool started;
+    // A frame was handed to the worker and isn't drawn yet
+    bool in_flight;
+    volatile bool should_exit;
+    // The frame the worker packs, swapped with drawFrame in gal_update
+    Draw_Frame frame;
+    Draw_Instance_Stream stream;
+    // A copy of the frame's cbuffer, the game can write its own for the next frame meanwhile
+    void* cbuffer;
+    uint64_t cbuffer_capacity;
+    Thread thread;
+    Binary_Semaphore pack;
+    Binary_Semaphore packed;
+    double pack_seconds;
+    
+    bool pacing;
+    double refresh_rate;
+    double next_deadline;
+    double last_update_time;
+    
+    GAL_Frame_Stats stats;
+} g_frame_pipeline = {0};
+
+static void gal_frame_pipeline_worker_proc(Thread* t) {
+    (void)t;
+    while (true) {
+        OsBinarySemaphoreWait(&g_frame_pipeline.pack);
+        if (g_frame_pipeline.should_exit) break;
+        
+        double start = OsGetElapsedSeconds();
+        Draw_Frame* frame = &g_frame_pipeline.frame;
+        if (frame->enable_z_sorting) draw_frame_sort_by_z(frame);
+        draw_frame_build_instance_stream(frame, &g_frame_pipeline.stream);
+        g_frame_pipeline.pack_seconds = OsGetElapsedSeconds() - start;
+        
+        MEMORY_BARRIER;
+        OsBinarySemaphoreSignal(&g_frame_pipeline.packed);
+    }
+}
+
+static void gal_frame_pipeline_start(void) {
+    draw_frame_init(&g_frame_pipeline.frame);
+    DrawFrameReset(&g_frame_pipeline.frame);
+    g_frame_pipeline.should_exit = false;
+    OsBinarySemaphoreInit(&g_frame_pipeline.pack, false);
+    OsBinarySemaphoreInit(&g_frame_pipeline.packed, false);
+    OsThreadInit(&g_frame_pipeline.thread, gal_frame_pipeline_worker_proc);
+    OsThreadStart(&g_frame_pipeline.thread);
+    g_frame_pipeline.started = true;
+}
+
+static void gal_frame_pipeline_deinit(void) {
+    gal_finish_frames();
+    if (!g_frame_pipeline.started) return;
+    
+    g_frame_pipeline.should_exit = true;
+    MEMORY_BARRIER;
+    OsBinarySemaphoreSignal(&g_frame_pipeline.pack);
+    OsThreadJoin(&g_frame_pipeline.thread);
+    OsBinarySemaphoreDestroy(&g_frame_pipeline.pack);
+    OsBinarySemaphoreDestroy(&g_frame_pipeline.packed);
+    
+    draw_frame_deinit(&g_frame_pipeline.frame);
+    draw_instance_stream_deinit(&g_frame_pipeline.stream);
+    if (g_frame_pipeline.cbuffer) Dealloc(GetHeapAllocator(), g_frame_pipeline.cbuffer);
+    g_frame_pipeline.cbuffer = NULL;
+    g_frame_pipeline.cbuffer_capacity = 0;
+    g_frame_pipeline.started = false;
+}
+
+// Everything that talks to the renderer for a frame packed into stream
+static void gal_present_instance_stream(GAL_Renderer* renderer, Draw_Instance_Stream* stream) {
+    // Everything queued since the last frame goes in together before anything is drawn
+    gal_flush_uploads();
+    
+    gal_begin_timing(STR("Frame"));
+    if (renderer->begin_frame) renderer->begin_frame();
+    renderer->render_instances(stream, NULL);
+    if (renderer->end_frame) renderer->end_frame();
+    gal_end_timing();
+    if (renderer->present) renderer->present();
+    gal_timing_end_frame(renderer);
+}
+
+void gal_finish_frames(void) {
+    if (!g_frame_pipeline.in_flight) return;
+    
+    double start = OsGetElapsedSeconds();
+    OsBinarySemaphoreWait(&g_frame_pipeline.packed);
+    MEMORY_BARRIER;
+    g_frame_pipeline.in_flight = false;
+    g_frame_pipeline.stats.pack_wait_seconds += OsGetElapsedSeconds() - start;
+    g_frame_pipeline.stats.last_pack_seconds = g_frame_pipeline.pack_seconds;
+    g_frame_pipeline.stats.pipelined_frames += 1;
+    
+    GAL_Renderer* renderer = gal_get_renderer();
+    if (renderer && renderer->render_instances) {
+        gal_present_instance_stream(renderer, &g_frame_pipeline.stream);
+    }
+}
+
+// Draws the frame before and gives frame to the worker, frame gets the one that was drawn
+static void gal_frame_pipeline_push(Draw_Frame* frame) {
+    if (!g_frame_pipeline.started) gal_frame_pipeline_start();
+    
+    gal_finish_frames();
+    
+    Draw_Frame next = g_frame_pipeline.frame;
+    g_frame_pipeline.frame = *frame;
+    *frame = next;
+    
+    Draw_Frame* packing = &g_frame_pipeline.frame;
+    uint64_t cbuffer_size = packing->shader_extension.cbuffer_size;
+    if (packing->cbuffer && cbuffer_size) {
+        if (cbuffer_size > g_frame_pipeline.cbuffer_capacity) {
+            if (g_frame_pipeline.cbuffer) Dealloc(GetHeapAllocator(), g_frame_pipeline.cbuffer);
+            g_frame_pipeline.cbuffer = alloc_uninitialized(GetHeapAllocator(), cbuffer_size);
+            g_frame_pipeline.cbuffer_capacity = cbuffer_size;
+        }
+        memcpy(g_frame_pipeline.cbuffer, packing->cbuffer, cbuffer_size);
+        packing->cbuffer = g_frame_pipeline.cbuffer;
+    }
+    
+    g_frame_pipeline.in_flight = true;
+    MEMORY_BARRIER;
+    OsBinarySemaphoreSignal(&g_frame_pipeline.pack);
+}
+
+static double gal_frame_pacing_refresh_rate(void) {
+    if (g_frame_pipeline.refresh_rate > 0) return g_frame_pipeline.refresh_rate;
+    // Linux doesn't fill in monitors yet
+    if (window.monitor && window.monitor->refresh_rate) return (double)window.monitor->refresh_rate;
+    if (os.primary_monitor && os.primary_monitor->refresh_rate) return (double)os.primary_monitor->refresh_rate;
+    return 60.0;
+}
+
+// Holds gal_update until the next deadline. The deadlines are one refresh apart, so a frame that
+// was a little late is caught up on by the next one. One that was more than a refresh late
+// starts the deadlines over from now instead of rushing out a burst of frames.
+static void gal_frame_pipeline_pace(void) {
+    double now = OsGetElapsedSeconds();
+    
+    if (g_frame_pipeline.pacing) {
+        double interval = 1.0/gal_frame_pacing_refresh_rate();
+        g_frame_pipeline.stats.target_frame_seconds = interval;
+        
+        if (g_frame_pipeline.next_deadline == 0) {
+            g_frame_pipeline.next_deadline = now;
+        } else if (now > g_frame_pipeline.next_deadline) {
+            g_frame_pipeline.stats.missed_deadlines += 1;
+            if (now - g_frame_pipeline.next_deadline > interval) g_frame_pipeline.next_deadline = now;
+        } else {
+            double deadline = g_frame_pipeline.next_deadline;
+            double sleep_start = now;
+            if (deadline - now > GAL_FRAME_PACING_SPIN_SECONDS) {
+                OsHighPrecisionSleep((deadline - now - GAL_FRAME_PACING_SPIN_SECONDS)*1000.0);
+                now = OsGetElapsedSeconds();
+            }
+            g_frame_pipeline.stats.sleep_seconds += now - sleep_start;
+            
+            double spin_start = now;
+            while (now < deadline) now = OsGetElapsedSeconds();
+            g_frame_pipeline.stats.spin_seconds += now - spin_start;
+            
+            g_frame_pipeline.stats.paced_frames += 1;
+        }
+        g_frame_pipeline.next_deadline += interval;
+    }
+    
+    if (g_frame_pipeline.last_update_time != 0) {
+        g_frame_pipeline.stats.last_frame_seconds = now - g_frame_pipeline.last_update_time;
+    }
+    g_frame_pipeline.last_update_time = now;
+    g_frame_pipeline.stats.frames += 1;
+}
+
+void gal_set_frame_latency(uint32_t latency) {
+    if (latency > GAL_MAX_FRAME_LATENCY) {
+        default_log_warning("gal_set_frame_latency: %u is more than GAL_MAX_FRAME_LATENCY, using %u", latency, GAL_MAX_FRAME_LATENCY);
+        latency = GAL_MAX_FRAME_LATENCY;
+    }
+    if (latency == 0) gal_finish_frames();
+    g_frame_pipeline.latency = latency;
+}
+
+uint32_t gal_get_frame_latency(void) {
+    return g_frame_pipeline.latency;
+}
+
+void gal_set_frame_pacing(bool enabled, double refresh_rate) {
+    g_frame_pipeline.pacing = enabled;
+    g_frame_pipeline.refresh_rate = refresh_rate;
+    g_frame_pipeline.next_deadline = 0;
+}
+
+void gal_get_frame_stats(GAL_Frame_Stats* stats) {
+    if (!stats) return;
+    *stats = g_frame_pipeline.stats;
+}
+
 // Create a fallback renderer with no functionality
 static GAL_Renderer create_fallback_renderer(void) {
     GAL_Renderer renderer = {0};
@@ -98,6 +608,10 @@ static GAL_Renderer create_fallback_renderer(void) {
 
 // Attempt to initialize a specific backend
 static GAL_Result attempt_initialize_backend(GAL_Backend backend) {
+    if ((uint32_t)backend >= GAL_BACKEND_UNKNOWN) {
+        default_log_error("Unknown renderer type: %d", backend);
+        return GAL_RESULT_ERROR_UNSUPPORTED_FEATURE;
+    }
     if (g_gal.attempted_backends[backend]) {
         default_log_verbose("Backend %d already attempted, skipping", backend);
         return GAL_RESULT_ERROR_UNSUPPORTED_FEATURE;
@@ -146,6 +660,11 @@ static GAL_Result attempt_initialize_backend(GAL_Backend backend) {
             #endif
             break;
             
+        case GAL_BACKEND_NULL:
+            renderer = null_create_renderer();
+            backend_available = true;
+            break;
+            
         default:
             default_log_error("Unknown renderer type: %d", backend);
             return GAL_RESULT_ERROR_UNSUPPORTED_FEATURE;
@@ -189,6 +708,13 @@ GAL_Result gal_initialize(GAL_Backend preferred_backend) {
     // Clear attempted backends
     memset(g_gal.attempted_backends, 0, sizeof(g_gal.attempted_backends));
     
+    // Whatever is built in, or the null renderer when there is no display
+    if (preferred_backend == GAL_BACKEND_AUTO) {
+        preferred_backend = gal_get_best_backend();
+        default_log_info("Picked the %s renderer%s", gal_backend_to_string(preferred_backend),
+                         gal_has_display() ? "" : " since there is no display");
+    }
+    
     // Allocate memory for the active renderer
     g_gal.active_renderer = malloc(sizeof(GAL_Renderer));
     if (!g_gal.active_renderer) {
@@ -224,6 +750,9 @@ void gal_shutdown(void) {
         return; // Nothing to do
     }
     
+    // The frame in flight still goes out, before the renderer is gone
+    gal_frame_pipeline_deinit();
+    
     if (g_gal.active_renderer) {
         // Call the renderer's shutdown function if available
         if (g_gal.active_renderer->shutdown) {
@@ -235,6 +764,10 @@ void gal_shutdown(void) {
         g_gal.active_renderer = NULL;
     }
     
+    gal_upload_queue_deinit();
+    draw_instance_stream_deinit(&g_gal.stream);
+    gal_timing_reset();
+    
     g_gal.initialized = false;
     default_log_info("GAL shutdown complete");
 }
@@ -250,6 +783,16 @@ GAL_Renderer* gal_get_renderer(void) {
     return g_gal.active_renderer;
 }
 
+bool gal_get_stats(GAL_Stats* stats) {
+    GAL_Renderer *renderer = gal_get_renderer();
+    if (!stats || !renderer || !renderer->get_stats) {
+        return false;
+    }
+    
+    renderer->get_stats(stats);
+    return true;
+}
+
 // ================ GAL UTILITY FUNCTIONS FOR DRAWING SYSTEM ================
 
 // Initialize GAL with auto-detection (only called by build-specified backend)
@@ -265,11 +808,20 @@ void gal_init(void) {
         backend = GAL_BACKEND_D3D11;
     #elif defined(RENDERER_SOFTWARE) && RENDERER_SOFTWARE
         backend = GAL_BACKEND_SOFTWARE;
+    #elif defined(RENDERER_NULL) && RENDERER_NULL
+        backend = GAL_BACKEND_NULL;
     #endif
     
     GAL_Result result = gal_initialize(backend);
     if (result != GAL_RESULT_SUCCESS) {
         default_log_error("Failed to initialize GAL with specified backend, result: %d", result);
+        
+        // Keep the game running without drawing rather than calling into a renderer that isn't there
+        default_log_warning("Falling back to the null renderer");
+        result = gal_initialize(GAL_BACKEND_NULL);
+        if (result != GAL_RESULT_SUCCESS) {
+            return;
+        }
     }
     
     // Create a default window
@@ -298,11 +850,17 @@ void gal_update(void) {
     // Update the renderer
     if (renderer->update) renderer->update();
     
-    // Render the current frame to window
-    gal_render_draw_frame_to_window(&drawFrame);
+    if (g_frame_pipeline.latency > 0 && renderer->render_instances) {
+        gal_frame_pipeline_push(&drawFrame);
+    } else {
+        gal_finish_frames();
+        gal_render_draw_frame_to_window(&drawFrame);
+    }
     
     // Reset for next frame  
     DrawFrameReset(&drawFrame);
+    
+    gal_frame_pipeline_pace();
 }
 
 // Create a Gal_Image from texture description
@@ -351,6 +909,8 @@ void gal_destroy_image(Gal_Image* image) {
         return;
     }
     
+    gal_cancel_uploads(image->gal_handle);
+    
     GAL_Renderer *renderer = gal_get_renderer();
     if (renderer && renderer->destroy_texture) {
         renderer->destroy_texture(image->gal_handle, image->allocator);
@@ -365,27 +925,90 @@ void gal_update_image_data(Gal_Image* image, uint32_t x, uint32_t y, uint32_t w,
         return;
     }
     
+    // Anything queued before this goes in first
+    gal_flush_uploads();
+    
     GAL_Renderer *renderer = gal_get_renderer();
     if (renderer && renderer->update_texture) {
         renderer->update_texture(image->gal_handle, x, y, w, h, data);
     }
 }
 
-// Read image data (placeholder implementation)
+// Read image data
 void gal_read_image_data(Gal_Image* image, uint32_t x, uint32_t y, uint32_t w, uint32_t h, void* output) {
-    // This would need to be implemented per-backend
-    // For now, just log that it's not implemented
-    if (image && output) {
-        default_log_warning("gal_read_image_data not yet implemented");
+    if (!image || !image->gal_handle || !output) {
+        return;
+    }
+    
+    gal_flush_uploads();
+    
+    GAL_Renderer *renderer = gal_get_renderer();
+    if (renderer && renderer->read_texture) {
+        renderer->read_texture(image->gal_handle, x, y, w, h, output);
+    } else {
+        default_log_warning("gal_read_image_data is not supported by the %s", renderer ? renderer->name : "current renderer");
     }
 }
 
+// Clear an image, for images used as render targets
+void gal_clear_image(Gal_Image* image, float r, float g, float b, float a) {
+    if (!image || !image->gal_handle) {
+        return;
+    }
+    
+    gal_flush_uploads();
+    
+    GAL_Renderer *renderer = gal_get_renderer();
+    if (renderer && renderer->clear_render_target) {
+        renderer->clear_render_target(image->gal_handle, r, g, b, a);
+    }
+}
+
+// Pixels of an image without copying, if the backend keeps them in memory
+bool gal_get_image_pixels(Gal_Image* image, GAL_Pixel_View* view) {
+    if (!image || !image->gal_handle || !view) {
+        return false;
+    }
+    
+    gal_flush_uploads();
+    
+    GAL_Renderer *renderer = gal_get_renderer();
+    if (!renderer || !renderer->get_texture_pixels) {
+        return false;
+    }
+    return renderer->get_texture_pixels(image->gal_handle, view);
+}
+
+// Pixels of the last frame drawn to the window without copying, if the backend keeps them in memory
+bool gal_get_framebuffer_pixels(GAL_Pixel_View* view) {
+    if (!view) {
+        return false;
+    }
+    
+    GAL_Renderer *renderer = gal_get_renderer();
+    if (!renderer || !renderer->get_framebuffer_pixels) {
+        return false;
+    }
+    return renderer->get_framebuffer_pixels(view);
+}
+
+// Packs the frame for renderers with render_instances, z sorted first if the frame wants it
+static Draw_Instance_Stream* gal_build_instance_stream(Draw_Frame* frame) {
+    if (frame->enable_z_sorting) draw_frame_sort_by_z(frame);
+    draw_frame_build_instance_stream(frame, &g_gal.stream);
+    return &g_gal.stream;
+}
+
 // Render draw frame to target
 void gal_render_draw_frame(Draw_Frame* frame, Gal_Image* target) {
     GAL_Renderer *renderer = gal_get_renderer();
     if (!renderer || !frame || !target) return;
     
-    if (renderer->render_draw_frame) {
+    gal_flush_uploads();
+    
+    if (renderer->render_instances) {
+        renderer->render_instances(gal_build_instance_stream(frame), target->gal_handle);
+    } else if (renderer->render_draw_frame) {
         renderer->render_draw_frame(frame, target->gal_handle);
     }
 }
@@ -395,14 +1018,413 @@ void gal_render_draw_frame_to_window(Draw_Frame* frame) {
     GAL_Renderer *renderer = gal_get_renderer();
     if (!renderer || !frame) return;
     
-    if (renderer->begin_frame) renderer->begin_frame();
-    
-    if (renderer->render_draw_frame_to_window) {
-        renderer->render_draw_frame_to_window(frame);
+    if (renderer->render_instances) {
+        gal_present_instance_stream(renderer, gal_build_instance_stream(frame));
+        return;
     }
     
+    gal_flush_uploads();
+    
+    gal_begin_timing(STR("Frame"));
+    if (renderer->begin_frame) renderer->begin_frame();
+    if (renderer->render_draw_frame_to_window) renderer->render_draw_frame_to_window(frame);
     if (renderer->end_frame) renderer->end_frame();
+    gal_end_timing();
     if (renderer->present) renderer->present();
+    gal_timing_end_frame(renderer);
+}
+
+// Copies the region into the staging memory, the flush uploads it
+GAL_Upload_Fence gal_queue_image_update(Gal_Image* image, uint32_t x, uint32_t y, uint32_t w, uint32_t h, const void* data) {
+    if (!image || !image->gal_handle || !data || w == 0 || h == 0) {
+        return 0;
+    }
+    if ((uint64_t)x + w > image->width || (uint64_t)y + h > image->height) {
+        default_log_warning("gal_queue_image_update: %ux%u at %u, %u is outside of the %ux%u image", w, h, x, y, image->width, image->height);
+        return 0;
+    }
+    
+    uint64_t bytes = (uint64_t)w*h*image->channels;
+    
+    spinlock_acquire_or_wait(&g_upload.lock);
+    GAL_Upload_Staging* staging = &g_upload.staging[g_upload.writing];
+    
+    if (staging->data && staging->size + bytes > staging->capacity) {
+        g_upload.stats.staging_grows += 1;
+    }
+    staging->data = (uint8_t*)gal_upload_reserve(staging->data, staging->size, &staging->capacity,
+                                                 staging->size + bytes, GAL_UPLOAD_STAGING_SIZE);
+    uint64_t region_bytes = staging->region_capacity*sizeof(GAL_Upload_Region);
+    staging->regions = (GAL_Upload_Region*)gal_upload_reserve(staging->regions, staging->region_count*sizeof(GAL_Upload_Region),
+                                                              &region_bytes, (staging->region_count + 1)*sizeof(GAL_Upload_Region),
+                                                              GAL_UPLOAD_MIN_REGIONS*sizeof(GAL_Upload_Region));
+    staging->region_capacity = region_bytes/sizeof(GAL_Upload_Region);
+    
+    GAL_Upload_Region* region = &staging->regions[staging->region_count++];
+    region->texture = image->gal_handle;
+    region->channels = image->channels;
+    region->x = x;
+    region->y = y;
+    region->width = w;
+    region->height = h;
+    region->offset = staging->size;
+    
+    memcpy(staging->data + staging->size, data, bytes);
+    staging->size += bytes;
+    
+    GAL_Upload_Fence fence = ++g_upload.next_fence;
+    staging->last_fence = fence;
+    g_upload.stats.queued += 1;
+    g_upload.stats.queued_bytes += bytes;
+    spinlock_release(&g_upload.lock);
+    
+    return fence;
+}
+
+bool gal_is_upload_done(GAL_Upload_Fence fence) {
+    return fence <= g_upload.done_fence;
+}
+
+void gal_flush_uploads(void) {
+    // Images are read and updated from any thread and those flush, so a second flush waits
+    // here instead of swapping back to the staging this one is still going through
+    gal_upload_acquire_flush();
+    spinlock_acquire_or_wait(&g_upload.lock);
+    GAL_Upload_Staging* staging = &g_upload.staging[g_upload.writing];
+    if (staging->region_count == 0) {
+        spinlock_release(&g_upload.lock);
+        mutex_release(&g_upload.flush_mutex);
+        return;
+    }
+    // New regions go in the other staging while this one is uploaded
+    g_upload.writing ^= 1;
+    spinlock_release(&g_upload.lock);
+    
+    // Merge each region into the last upload for its texture if it can be. Only the last one,
+    // so a region never goes in before one that was queued after it.
+    uint64_t upload_count = 0;
+    uint64_t merge_size = 0;
+    for (uint64_t i = 0; i < staging->region_count; i++) {
+        GAL_Upload_Region* region = &staging->regions[i];
+        if (!region->texture) continue;
+        
+        GAL_Upload* last = NULL;
+        for (uint64_t j = upload_count; j > 0; j--) {
+            if (g_upload.uploads[j-1].texture == region->texture) {
+                last = &g_upload.uploads[j-1];
+                break;
+            }
+        }
+        if (last && gal_upload_try_merge(last, region)) {
+            region->upload = (uint64_t)(last - g_upload.uploads);
+            continue;
+        }
+        
+        uint64_t upload_bytes = g_upload.upload_capacity*sizeof(GAL_Upload);
+        g_upload.uploads = (GAL_Upload*)gal_upload_reserve(g_upload.uploads, upload_count*sizeof(GAL_Upload), &upload_bytes,
+                                                           (upload_count + 1)*sizeof(GAL_Upload), GAL_UPLOAD_MIN_REGIONS*sizeof(GAL_Upload));
+        g_upload.upload_capacity = upload_bytes/sizeof(GAL_Upload);
+        
+        region->upload = upload_count;
+        g_upload.uploads[upload_count++] = (GAL_Upload){
+            .texture = region->texture,
+            .channels = region->channels,
+            .x = region->x,
+            .y = region->y,
+            .width = region->width,
+            .height = region->height,
+            .first_region = i,
+            .region_count = 1,
+        };
+    }
+    
+    // Uploads of more than one region are put together in merge_pixels, in queue order so the
+    // last region wins where they overlap
+    for (uint64_t i = 0; i < upload_count; i++) {
+        GAL_Upload* upload = &g_upload.uploads[i];
+        if (upload->region_count < 2) continue;
+        upload->merge_offset = merge_size;
+        merge_size += (uint64_t)upload->width*upload->height*upload->channels;
+    }
+    if (merge_size) {
+        g_upload.merge_pixels = (uint8_t*)gal_upload_reserve(g_upload.merge_pixels, 0, &g_upload.merge_capacity, merge_size, 0);
+        for (uint64_t i = 0; i < staging->region_count; i++) {
+            GAL_Upload_Region* region = &staging->regions[i];
+            if (!region->texture) continue;
+            GAL_Upload* upload = &g_upload.uploads[region->upload];
+            if (upload->region_count < 2) continue;
+            
+            uint64_t row_bytes = (uint64_t)region->width*region->channels;
+            uint64_t pitch = (uint64_t)upload->width*upload->channels;
+            uint8_t* dst = g_upload.merge_pixels + upload->merge_offset
+                         + (uint64_t)(region->y - upload->y)*pitch + (uint64_t)(region->x - upload->x)*region->channels;
+            uint8_t* src = staging->data + region->offset;
+            for (uint32_t row = 0; row < region->height; row++) {
+                memcpy(dst + row*pitch, src + row*row_bytes, row_bytes);
+            }
+        }
+    }
+    
+    GAL_Renderer* renderer = gal_get_renderer();
+    uint64_t upload_bytes = 0;
+    for (uint64_t i = 0; i < upload_count; i++) {
+        GAL_Upload* upload = &g_upload.uploads[i];
+        void* pixels = upload->region_count < 2
+                     ? staging->data + staging->regions[upload->first_region].offset
+                     : g_upload.merge_pixels + upload->merge_offset;
+        if (renderer && renderer->update_texture) {
+            renderer->update_texture(upload->texture, upload->x, upload->y, upload->width, upload->height, pixels);
+        }
+        upload_bytes += (uint64_t)upload->width*upload->height*upload->channels;
+    }
+    
+    GAL_Upload_Fence last_fence = staging->last_fence;
+    staging->size = 0;
+    staging->region_count = 0;
+    
+    spinlock_acquire_or_wait(&g_upload.lock);
+    g_upload.stats.uploads += upload_count;
+    g_upload.stats.upload_bytes += upload_bytes;
+    g_upload.stats.flushes += 1;
+    spinlock_release(&g_upload.lock);
+    
+    g_upload.done_fence = last_fence;
+    mutex_release(&g_upload.flush_mutex);
+}
+
+void gal_get_upload_stats(GAL_Upload_Stats* stats) {
+    if (!stats) return;
+    spinlock_acquire_or_wait(&g_upload.lock);
+    *stats = g_upload.stats;
+    spinlock_release(&g_upload.lock);
+}
+
+// Draw a stream that was already built
+bool gal_render_instance_stream(Draw_Instance_Stream* stream, Gal_Image* target) {
+    GAL_Renderer *renderer = gal_get_renderer();
+    if (!renderer || !stream || !target || !target->gal_handle || !renderer->render_instances) return false;
+    
+    gal_flush_uploads();
+    renderer->render_instances(stream, target->gal_handle);
+    return true;
+}
+
+// ================ SHADER CACHE ================
+
+#define GAL_SHADER_CACHE_MAGIC 0x48534C47u // "GLSH"
+// Bump when the file layout changes
+#define GAL_SHADER_CACHE_VERSION 1
+
+// Start of every cache file, the blob follows
+typedef struct GAL_Shader_Cache_Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t backend;
+    uint32_t reserved;
+    // Of the source, defines and backend, same as in the file name
+    uint64_t key;
+    // Of the renderer's get_shader_cache_id
+    uint64_t renderer_id;
+    uint64_t binary_size;
+    uint64_t binary_hash;
+} GAL_Shader_Cache_Header;
+
+static struct {
+    // Heap copy, only used once directory_set
+    string directory;
+    bool directory_set;
+    GAL_Shader_Cache_Stats stats;
+} g_shader_cache = {0};
+
+// FNV-1a, the keys end up in file names so they have to be the same every run
+#define GAL_HASH_SEED 0xcbf29ce484222325ull
+static uint64_t gal_hash_bytes(uint64_t hash, const void* data, uint64_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (uint64_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void gal_set_shader_cache_directory(string directory) {
+    if (g_shader_cache.directory.data) {
+        Dealloc(GetHeapAllocator(), g_shader_cache.directory.data);
+    }
+    g_shader_cache.directory = (string){0};
+    if (directory.count > 0) {
+        g_shader_cache.directory.data = (uint8_t*)alloc_uninitialized(GetHeapAllocator(), directory.count);
+        memcpy(g_shader_cache.directory.data, directory.data, directory.count);
+        g_shader_cache.directory.count = directory.count;
+    }
+    g_shader_cache.directory_set = true;
+}
+
+static string gal_shader_cache_directory(void) {
+    return g_shader_cache.directory_set ? g_shader_cache.directory : STR(GAL_SHADER_CACHE_DEFAULT_DIRECTORY);
+}
+
+// Hit: the shader is loaded. Otherwise there was no file (false, *stale false) or one that
+// can't be used (false, *stale true).
+static bool gal_shader_cache_load(GAL_Renderer* renderer, string path, GAL_Shader_Cache_Header* expected, uint64_t cbuffer_size, void** shader_object, bool* stale) {
+    *stale = false;
+
+    string file;
+    if (!os_read_entire_file(path, &file, GetHeapAllocator())) {
+        return false;
+    }
+
+    bool loaded = false;
+    GAL_Shader_Cache_Header header;
+    if (file.count >= sizeof(header)) {
+        memcpy(&header, file.data, sizeof(header));
+        string binary = { file.count - sizeof(header), file.data + sizeof(header) };
+        if (header.magic == expected->magic && header.version == expected->version &&
+            header.backend == expected->backend && header.key == expected->key &&
+            header.renderer_id == expected->renderer_id && header.binary_size == binary.count &&
+            header.binary_hash == gal_hash_bytes(GAL_HASH_SEED, binary.data, binary.count)) {
+            loaded = renderer->load_shader_binary(binary, cbuffer_size, shader_object) == GAL_RESULT_SUCCESS && *shader_object;
+        }
+    }
+
+    if (loaded) {
+        g_shader_cache.stats.bytes_loaded += file.count;
+    } else {
+        *shader_object = NULL;
+        *stale = true;
+    }
+    Dealloc(GetHeapAllocator(), file.data);
+    return loaded;
+}
+
+static void gal_shader_cache_save(GAL_Renderer* renderer, string path, GAL_Shader_Cache_Header* header, void* shader_object) {
+    string binary;
+    if (!renderer->get_shader_binary(shader_object, GetHeapAllocator(), &binary)) {
+        return;
+    }
+
+    header->binary_size = binary.count;
+    header->binary_hash = gal_hash_bytes(GAL_HASH_SEED, binary.data, binary.count);
+
+    string file;
+    file.count = sizeof(*header) + binary.count;
+    file.data = (uint8_t*)alloc_uninitialized(GetHeapAllocator(), file.count);
+    memcpy(file.data, header, sizeof(*header));
+    memcpy(file.data + sizeof(*header), binary.data, binary.count);
+
+    string directory = gal_shader_cache_directory();
+    if (os_make_directory(directory, true) && os_write_entire_file(path, file)) {
+        g_shader_cache.stats.bytes_saved += file.count;
+    } else {
+        default_log_warning("Could not write shader cache file %.*s", (int)path.count, path.data);
+    }
+
+    Dealloc(GetHeapAllocator(), file.data);
+    if (binary.data) Dealloc(GetHeapAllocator(), binary.data);
+}
+
+GAL_Result gal_compile_shader(string source, string defines, uint64_t cbuffer_size, void** shader_object) {
+    GAL_Renderer* renderer = gal_get_renderer();
+    if (!shader_object || !source.data) {
+        return GAL_RESULT_ERROR_INVALID_PARAMETER;
+    }
+    *shader_object = NULL;
+    if (!renderer) {
+        return GAL_RESULT_ERROR_NOT_INITIALIZED;
+    }
+    if (!renderer->compile_shader) {
+        return GAL_RESULT_ERROR_UNSUPPORTED_FEATURE;
+    }
+
+    GAL_Shader_Cache_Header header = {0};
+    header.magic = GAL_SHADER_CACHE_MAGIC;
+    header.version = GAL_SHADER_CACHE_VERSION;
+    header.backend = (uint32_t)renderer->backend;
+    header.key = gal_hash_bytes(GAL_HASH_SEED, &header.backend, sizeof(header.backend));
+    header.key = gal_hash_bytes(header.key, &defines.count, sizeof(defines.count));
+    header.key = gal_hash_bytes(header.key, defines.data, defines.count);
+    header.key = gal_hash_bytes(header.key, source.data, source.count);
+    if (renderer->get_shader_cache_id) {
+        string id = renderer->get_shader_cache_id();
+        header.renderer_id = gal_hash_bytes(GAL_HASH_SEED, id.data, id.count);
+    }
+
+    string directory = gal_shader_cache_directory();
+    bool use_disk = directory.count > 0 && renderer->get_shader_binary && renderer->load_shader_binary;
+    char path_buffer[1024];
+    string path = {0};
+    if (use_disk) {
+        int length = snprintf(path_buffer, sizeof(path_buffer), "%.*s/%016llx.shader", (int)directory.count, directory.data, (unsigned long long)header.key);
+        use_disk = length > 0 && length < (int)sizeof(path_buffer);
+        path = (string){ (uint64_t)length, (uint8_t*)path_buffer };
+    }
+
+    if (use_disk) {
+        float64 start = OsGetElapsedSeconds();
+        bool stale;
+        bool hit = gal_shader_cache_load(renderer, path, &header, cbuffer_size, shader_object, &stale);
+        if (hit || stale) g_shader_cache.stats.load_seconds += OsGetElapsedSeconds() - start;
+        if (hit) {
+            g_shader_cache.stats.hits += 1;
+            return GAL_RESULT_SUCCESS;
+        }
+        if (stale) g_shader_cache.stats.stale += 1;
+    }
+    g_shader_cache.stats.misses += 1;
+
+    string text = source;
+    if (defines.count > 0) {
+        text.count = defines.count + 1 + source.count;
+        text.data = (uint8_t*)alloc_uninitialized(GetHeapAllocator(), text.count);
+        memcpy(text.data, defines.data, defines.count);
+        text.data[defines.count] = '\n';
+        memcpy(text.data + defines.count + 1, source.data, source.count);
+    }
+
+    float64 start = OsGetElapsedSeconds();
+    GAL_Result result = renderer->compile_shader(text, cbuffer_size, shader_object);
+    g_shader_cache.stats.compile_seconds += OsGetElapsedSeconds() - start;
+    g_shader_cache.stats.compiles += 1;
+    if (text.data != source.data) Dealloc(GetHeapAllocator(), text.data);
+
+    if (result != GAL_RESULT_SUCCESS) {
+        g_shader_cache.stats.compile_failures += 1;
+        return result;
+    }
+    if (use_disk) {
+        gal_shader_cache_save(renderer, path, &header, *shader_object);
+    }
+    return result;
+}
+
+void gal_destroy_shader(void* shader_object) {
+    GAL_Renderer* renderer = gal_get_renderer();
+    if (renderer && shader_object && renderer->destroy_shader) {
+        renderer->destroy_shader(shader_object);
+    }
+}
+
+GAL_Result gal_compile_shader_extension(string source, string defines, uint64_t cbuffer_size, Gal_Shader_Extension* extension) {
+    if (!extension) {
+        return GAL_RESULT_ERROR_INVALID_PARAMETER;
+    }
+    *extension = (Gal_Shader_Extension){0};
+
+    GAL_Result result = gal_compile_shader(source, defines, cbuffer_size, &extension->ps);
+    if (result == GAL_RESULT_SUCCESS) {
+        extension->cbuffer_size = cbuffer_size;
+    }
+    return result;
+}
+
+void gal_destroy_shader_extension(Gal_Shader_Extension* extension) {
+    if (!extension) return;
+    gal_destroy_shader(extension->ps);
+    *extension = (Gal_Shader_Extension){0};
+}
+
+void gal_get_shader_cache_stats(GAL_Shader_Cache_Stats* stats) {
+    if (stats) *stats = g_shader_cache.stats;
 }
 
 // Load PNG from disk (placeholder implementation)
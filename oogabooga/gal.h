@@ -16,6 +16,7 @@
 
 // Forward declarations
 typedef struct Draw_Frame Draw_Frame;
+typedef struct Draw_Instance_Stream Draw_Instance_Stream;
 typedef struct GAL_Renderer GAL_Renderer;
 
 // Common enums and types for all renderers
@@ -28,6 +29,7 @@ typedef enum GAL_Result {
     GAL_RESULT_ERROR_UNSUPPORTED_FEATURE,
     GAL_RESULT_ERROR_DEVICE_LOST,
     GAL_RESULT_ERROR_FORMAT_NOT_SUPPORTED,
+    GAL_RESULT_ERROR_NOT_INITIALIZED,
     GAL_RESULT_ERROR_UNKNOWN
 } GAL_Result;
 
@@ -37,6 +39,8 @@ typedef enum GAL_Backend {
     GAL_BACKEND_D3D11,
     GAL_BACKEND_SOFTWARE,
     GAL_BACKEND_METAL,
+    // Draws nothing and needs no window, see gal_null.c
+    GAL_BACKEND_NULL,
     GAL_BACKEND_UNKNOWN,
     GAL_BACKEND_AUTO = 100  // Special value for auto-detection
 } GAL_Backend;
@@ -88,6 +92,34 @@ typedef struct GAL_Texture_Desc {
     GAL_Filter_Mode filter_mode;
 } GAL_Texture_Desc;
 
+// Pixels handed out without a copy by gal_get_image_pixels and gal_get_framebuffer_pixels
+typedef struct GAL_Pixel_View {
+    const void* pixels;
+    uint32_t width;
+    uint32_t height;
+    // Bytes from the start of one row to the next
+    uint32_t pitch;
+    // Where each channel is in a 32 bit pixel, a_mask is 0 if there is no alpha
+    uint32_t r_mask, g_mask, b_mask, a_mask;
+    // The window's rows go from the top. Images' rows go from the bottom, like the data
+    // for gal_update_image_data.
+    bool rows_from_top;
+} GAL_Pixel_View;
+
+// Counters since the renderer was initialized, from backends which keep them
+typedef struct GAL_Stats {
+    uint64_t frames;
+    uint64_t quads;
+    // Quads with NaN or infinite corners, uv or color, an unknown type, or a destroyed texture
+    uint64_t invalid_quads;
+    uint64_t draw_calls;
+    uint64_t texture_uploads;
+    uint64_t texture_upload_bytes;
+    // Textures alive right now and how much memory they take
+    uint64_t texture_count;
+    uint64_t texture_bytes;
+} GAL_Stats;
+
 // Compatibility types for existing drawing system
 typedef struct Gal_Image {
     uint32_t width;
@@ -96,6 +128,8 @@ typedef struct Gal_Image {
     GAL_Format format;
     GAL_Texture_Handle gal_handle; // GAL texture handle
     Allocator allocator;
+    // Set for sprites in a Texture_Atlas (see atlas.h), which are drawn from their page
+    struct Atlas_Sprite *atlas_sprite;
 } Gal_Image;
 
 typedef struct Gal_Font {
@@ -130,6 +164,11 @@ struct GAL_Renderer {
     GAL_Texture_Handle (*create_texture)(GAL_Texture_Desc* desc, Allocator allocator);
     void (*update_texture)(GAL_Texture_Handle texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* data);
     void (*destroy_texture)(GAL_Texture_Handle texture, Allocator allocator);
+    // Copies pixels out laid out like update_texture takes them
+    void (*read_texture)(GAL_Texture_Handle texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* output);
+    // Optional, for backends which keep their pixels in memory. False if there is nothing to hand out.
+    bool (*get_texture_pixels)(GAL_Texture_Handle texture, GAL_Pixel_View* view);
+    bool (*get_framebuffer_pixels)(GAL_Pixel_View* view);
     
     // Rendering functions
     void (*begin_frame)(void);
@@ -137,11 +176,36 @@ struct GAL_Renderer {
     void (*render_draw_frame)(Draw_Frame* frame, GAL_Texture_Handle target);
     void (*render_draw_frame_to_window)(Draw_Frame* frame);
     void (*clear_render_target)(GAL_RenderTarget_Handle target, float r, float g, float b, float a);
+    // Optional, the instanced path. Draws a packed stream (see "- Instance streams" in
+    // drawing.c) into target, or the window when target is 0. The backend expands each
+    // Draw_Quad_Instance to its corners itself, in the vertex shader on the GPU, and draws
+    // stream->calls in order. When a backend has it, gal_render_draw_frame and
+    // gal_render_draw_frame_to_window build the stream once and use this instead of
+    // render_draw_frame(_to_window).
+    void (*render_instances)(Draw_Instance_Stream* stream, GAL_Texture_Handle target);
     
     // Advanced functions
     GAL_Result (*compile_shader)(string source_code, uint64_t cbuffer_size, void** shader_object);
     void (*destroy_shader)(void* shader_object);
+    // Optional, for the shader cache (see gal_compile_shader). get_shader_binary hands out the
+    // compiled blob of a shader, allocated with allocator, and load_shader_binary makes a
+    // shader from it again. Loading fails when the driver doesn't take the blob anymore.
+    // get_shader_cache_id describes everything other than the source that the blob depends on,
+    // like the driver and its version, blobs made under another id are compiled again.
+    bool (*get_shader_binary)(void* shader_object, Allocator allocator, string* binary);
+    GAL_Result (*load_shader_binary)(string binary, uint64_t cbuffer_size, void** shader_object);
+    string (*get_shader_cache_id)(void);
+    // Optional, for gal_begin_timing/gal_end_timing. write_timestamp puts down timestamp query
+    // number query (there are GAL_TIMING_MAX_QUERIES), which records when the work submitted
+    // before it is done. read_timestamp gets its time in nanoseconds, or false if it isn't in
+    // yet, and must not wait for it. get_timestamp is the time of the same clock right now, to
+    // line the queries up with OsGetElapsedSeconds.
+    void (*write_timestamp)(uint32_t query);
+    bool (*read_timestamp)(uint32_t query, uint64_t* nanoseconds);
+    bool (*get_timestamp)(uint64_t* nanoseconds);
     void (*reserve_vertex_buffer)(uint64_t bytes);
+    // Optional
+    void (*get_stats)(GAL_Stats* stats);
     
     // Internal implementation data
     void* implementation_data;
@@ -151,6 +215,8 @@ struct GAL_Renderer {
 GAL_Result gal_initialize(GAL_Backend preferred_backend);
 void gal_shutdown(void);
 GAL_Renderer* gal_get_renderer(void);
+// False if the renderer doesn't keep stats
+bool gal_get_stats(GAL_Stats* stats);
 
 // Helper functions that dispatch to the active renderer
 #define gal_log_verbose(...) gal_get_renderer()->log_verbose(__VA_ARGS__)
@@ -162,13 +228,174 @@ GAL_Renderer* gal_get_renderer(void);
 GAL_Result gal_create_image(Gal_Image* image, uint32_t width, uint32_t height, uint32_t channels, void* data, bool render_target, Allocator allocator);
 void gal_destroy_image(Gal_Image* image);
 void gal_update_image_data(Gal_Image* image, uint32_t x, uint32_t y, uint32_t w, uint32_t h, void* data);
+// output is w*h*image->channels bytes, laid out like for gal_update_image_data
 void gal_read_image_data(Gal_Image* image, uint32_t x, uint32_t y, uint32_t w, uint32_t h, void* output);
+void gal_clear_image(Gal_Image* image, float r, float g, float b, float a);
+// The pixels of an image or of the last frame drawn to the window, without copying them.
+// Only backends which draw on the CPU have this. The pointer is good until something else is
+// drawn or uploaded to the image (or the window), or it's destroyed or resized.
+bool gal_get_image_pixels(Gal_Image* image, GAL_Pixel_View* view);
+bool gal_get_framebuffer_pixels(GAL_Pixel_View* view);
+
+// Upload queue. Lots of small updates (like a font atlas filled a glyph row at a time) are
+// queued from any thread, then flushed together at the start of the next frame. Regions of the
+// same image which line up edge to edge or overlap are merged into one upload on the way.
+//
+// The data is copied when queued. Queued data goes in after everything queued before it, and
+// after any gal_update_image_data before the flush. Drawing to, reading and handing out the
+// pixels of any image flushes the queue first, so they never see stale pixels.
+
+// Handle for queued data, counts up from 1. 0 is never queued, so it's always done.
+typedef uint64_t GAL_Upload_Fence;
+
+typedef struct GAL_Upload_Stats {
+    // Regions and bytes queued
+    uint64_t queued;
+    uint64_t queued_bytes;
+    // Uploads the flushes made of them after merging, and the bytes in them
+    uint64_t uploads;
+    uint64_t upload_bytes;
+    uint64_t flushes;
+    // Times the staging memory ran out and had to grow
+    uint64_t staging_grows;
+} GAL_Upload_Stats;
+
+GAL_Upload_Fence gal_queue_image_update(Gal_Image* image, uint32_t x, uint32_t y, uint32_t w, uint32_t h, const void* data);
+bool gal_is_upload_done(GAL_Upload_Fence fence);
+// Uploads everything queued so far. Call it from the thread that renders, like the rest of
+// the functions that talk to the renderer. gal_render_draw_frame_to_window does it before
+// begin_frame.
+void gal_flush_uploads(void);
+void gal_get_upload_stats(GAL_Upload_Stats* stats);
+
+// Shader cache. gal_compile_shader looks for the compiled blob (a GL program binary, SPIR-V or
+// DXBC, whatever the renderer hands out with get_shader_binary) in the cache directory before
+// compiling, and saves it there after compiling so the next run can skip it. There is one file
+// per hash of the source, the defines and the backend.
+//
+// A file from another cache version or driver, a damaged one, or one the driver doesn't load
+// anymore is compiled again and replaced. Renderers without get_shader_binary and
+// load_shader_binary always compile.
+
+// Where gal_compile_shader keeps blobs, made when the first one is saved. The default is
+// GAL_SHADER_CACHE_DEFAULT_DIRECTORY, an empty string turns the disk cache off.
+#define GAL_SHADER_CACHE_DEFAULT_DIRECTORY ".shader_cache"
+
+typedef struct GAL_Shader_Cache_Stats {
+    // Loaded from disk without compiling
+    uint64_t hits;
+    // Compiled because there was no usable file, stale ones included
+    uint64_t misses;
+    // Files that were there but from another version or driver, damaged, or not taken by the driver
+    uint64_t stale;
+    uint64_t compiles;
+    uint64_t compile_failures;
+    uint64_t bytes_loaded;
+    uint64_t bytes_saved;
+    double compile_seconds;
+    // Reading and loading blobs, hits and stale files
+    double load_seconds;
+} GAL_Shader_Cache_Stats;
+
+typedef struct Gal_Shader_Extension Gal_Shader_Extension;
+
+void gal_set_shader_cache_directory(string directory);
+// defines go before the source, lines like "#define LIGHT_COUNT 4". Destroy the shader with
+// gal_destroy_shader.
+GAL_Result gal_compile_shader(string source, string defines, uint64_t cbuffer_size, void** shader_object);
+void gal_destroy_shader(void* shader_object);
+// A pixel shader extension for Draw_Frame.shader_extension through the cache. See the top of
+// gal_opengl.c for what the source looks like.
+GAL_Result gal_compile_shader_extension(string source, string defines, uint64_t cbuffer_size, Gal_Shader_Extension* extension);
+void gal_destroy_shader_extension(Gal_Shader_Extension* extension);
+void gal_get_shader_cache_stats(GAL_Shader_Cache_Stats* stats);
+
+// Frame pipeline. With a frame latency of 0 (the default) gal_update sorts, packs, draws and
+// presents drawFrame before it returns. With 1, gal_update hands drawFrame to a worker thread
+// that sorts and packs it while the game records the next frame, and the next gal_update draws
+// and presents it. Drawing and presenting stay on the thread that calls gal_update.
+//
+// So with a latency of 1, images drawn in a frame have to stay alive until the next
+// gal_update returns, or call gal_finish_frames before destroying them. Renderers without
+// render_instances always run with a latency of 0.
+#define GAL_MAX_FRAME_LATENCY 1
+
+typedef struct GAL_Frame_Stats {
+    uint64_t frames;
+    // Frames that went through the worker thread
+    uint64_t pipelined_frames;
+    // Time gal_update waited for the worker to finish packing the frame before
+    double pack_wait_seconds;
+    double last_pack_seconds;
+    // Frames the pacer waited for, and frames that were already late when it got them
+    uint64_t paced_frames;
+    uint64_t missed_deadlines;
+    double sleep_seconds;
+    double spin_seconds;
+    // Between the last two gal_update returns
+    double last_frame_seconds;
+    double target_frame_seconds;
+} GAL_Frame_Stats;
+
+void gal_set_frame_latency(uint32_t latency);
+uint32_t gal_get_frame_latency(void);
+// Draws and presents the frame the worker has, if there is one
+void gal_finish_frames(void);
+// Makes gal_update return once per refresh. It sleeps until shortly before the deadline and
+// spins the rest of the way, so frames come out evenly spaced even where the OS sleep is coarse.
+// A refresh_rate of 0 uses the window's monitor, then the primary monitor, then 60 Hz. Meant
+// for running with vsync off, with vsync on the present already waits.
+void gal_set_frame_pacing(bool enabled, double refresh_rate);
+void gal_get_frame_stats(GAL_Frame_Stats* stats);
+
+// Timing. Named regions between gal_begin_timing and gal_end_timing are timed on the renderer
+// side with timestamp queries (CPU timers on the software and null renderers). Regions can be
+// nested, and when timing is on each frame gal draws is a "Frame" region. The results are read
+// back up to GAL_TIMING_FRAMES frames later, once the queries are in, so nothing waits on the
+// GPU. A frame still not in when its queries are needed again is dropped.
+//
+// With ENABLE_PROFILING the regions also go in google_trace.json on a "GPU" track. Call these
+// from the thread that renders. Renderers without write_timestamp don't time anything.
+#define GAL_TIMING_FRAMES 4
+#define GAL_TIMING_MAX_REGIONS 64
+#define GAL_TIMING_MAX_QUERIES (GAL_TIMING_FRAMES*GAL_TIMING_MAX_REGIONS*2)
+#define GAL_TIMING_MAX_NAME 48
+
+typedef struct GAL_Timing_Result {
+    char name[GAL_TIMING_MAX_NAME];
+    // OsGetElapsedSeconds time the region started at on the renderer side
+    double start_seconds;
+    double seconds;
+    // 0 for regions that aren't inside another one
+    uint32_t depth;
+} GAL_Timing_Result;
+
+typedef struct GAL_Timing_Stats {
+    // Frames whose results were read back
+    uint64_t frames;
+    uint64_t regions;
+    // Frames whose queries weren't in yet when they were needed again
+    uint64_t dropped_frames;
+    // Past GAL_TIMING_MAX_REGIONS in a frame, or ended without being begun
+    uint64_t dropped_regions;
+} GAL_Timing_Stats;
+
+void gal_set_timing(bool enabled);
+void gal_begin_timing(string name);
+void gal_end_timing(void);
+// Copies the regions of the newest frame that was read back, returns how many there were
+uint64_t gal_get_timings(GAL_Timing_Result* results, uint64_t max_results);
+void gal_get_timing_stats(GAL_Timing_Stats* stats);
 
 // GAL rendering functions for the drawing system
 void gal_init(void);
 void gal_update(void);
 void gal_render_draw_frame(Draw_Frame* frame, Gal_Image* target);
 void gal_render_draw_frame_to_window(Draw_Frame* frame);
+// Draws a stream built with draw_frame_build_instance_stream to an image, so a frame that
+// doesn't change can be packed once and drawn again and again. False if the renderer doesn't
+// have render_instances.
+bool gal_render_instance_stream(Draw_Instance_Stream* stream, Gal_Image* target);
 
 // Utility function for loading images
 Gal_Image* load_png_from_disk(string path, Allocator allocator);
@@ -223,17 +223,23 @@ GAL_Renderer* d3d11_create_renderer(void) {
     renderer->create_texture = d3d11_create_texture;
     renderer->update_texture = d3d11_update_texture;
     renderer->destroy_texture = d3d11_destroy_texture;
+    renderer->read_texture = NULL;
+    renderer->get_texture_pixels = NULL;
+    renderer->get_framebuffer_pixels = NULL;
     
     // Set rendering functions
     renderer->begin_frame = d3d11_begin_frame;
     renderer->end_frame = d3d11_end_frame;
     renderer->render_draw_frame = d3d11_render_draw_frame;
     renderer->render_draw_frame_to_window = d3d11_render_draw_frame_to_window;
+    // TODO: Instanced path like the OpenGL renderer, with a 4 vertex strip per instance
+    renderer->render_instances = NULL;
     
     // TODO: Set advanced functions when implemented
     renderer->compile_shader = NULL;
     renderer->destroy_shader = NULL;
     renderer->reserve_vertex_buffer = NULL;
+    renderer->get_stats = NULL;
     renderer->clear_render_target = NULL;
     
     renderer->implementation_data = d3d11_data;
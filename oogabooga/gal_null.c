@@ -0,0 +1,634 @@
+#include "gal.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+    Null renderer: draws nothing and needs no SDL, X11, window or GPU, so the whole engine can
+    run on build agents and servers for load and perf tests.
+
+    - It's picked with build_tool --null (RENDERER_NULL), by GAL_BACKEND_AUTO when there is no
+      display, and by gal_init when the renderer from the build fails to start.
+    - Textures are plain heap memory with the channels they were made with, so
+      gal_update_image_data, gal_read_image_data and clearing all work.
+    - Frames come in as instance streams through render_instances like for the GPU renderers,
+      so a frame costs the CPU about what it would with a real renderer, and the stats count
+      the same draw calls. Every instance is checked against the stream's tables and against
+      its draw call, so streams that a GPU renderer would draw wrong are caught here.
+    - Instances with NaN or infinite corners, an unknown type, or a texture that was destroyed
+      are counted in GAL_Stats.invalid_quads, and the first one of each frame is logged.
+    - Texture handles are a slot and a generation rather than pointers, so a destroyed texture
+      is caught even when its slot or its memory was reused.
+    - render_draw_frame(_to_window) called directly checks the Draw_Quad's before packing them,
+      which also catches NaN uv's and colors (packing clamps those away).
+    - Shaders compile to nothing, but they have a blob for the shader cache like on a GPU
+      renderer, so gal_compile_shader reads and writes cache files the same way.
+    - gal_get_stats() has the counters.
+    - gal_begin_timing regions are timed with CPU timers, so they measure what the null
+      renderer does itself.
+*/
+
+#define NULL_SHADER_MAGIC  0x52444853u // "SHDR"
+
+typedef struct {
+    uint32_t width, height, channels;
+    bool is_render_target;
+    uint8_t* pixels;
+} Null_Texture;
+
+// Handles are (generation << 32) | (slot index + 1). Destroying bumps the generation, so
+// old handles to the slot stop matching.
+typedef struct Null_Texture_Slot {
+    Null_Texture* texture;
+    uint32_t generation;
+    // Slot index + 1 of the next free slot, 0 at the end
+    uint32_t next_free;
+} Null_Texture_Slot;
+
+DECLARE_ARRAY(Null_Texture_Slot)
+DEFINE_ARRAY(Null_Texture_Slot)
+
+typedef struct {
+    uint32_t magic;
+    uint64_t cbuffer_size;
+} Null_Shader;
+
+typedef struct {
+    bool initialized;
+    bool window_created;
+    uint32_t screen_width;
+    uint32_t screen_height;
+    GAL_Stats stats;
+    Null_Texture_Slot_Array texture_slots;
+    uint32_t first_free_slot;
+    // Kept between frames like a GPU renderer would
+    Draw_Instance_Stream stream;
+    // gal_begin_timing queries, CPU time in nanoseconds
+    uint64_t timestamps[GAL_TIMING_MAX_QUERIES];
+} Null_Data;
+
+static Null_Data null_data = {0};
+
+// ================ LOGGING FUNCTIONS ================
+
+static void null_log_verbose(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    printf("[NULL][VERBOSE] ");
+    vprintf(fmt, args);
+    printf("\n");
+    va_end(args);
+}
+
+static void null_log_info(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    printf("[NULL][INFO] ");
+    vprintf(fmt, args);
+    printf("\n");
+    va_end(args);
+}
+
+static void null_log_warning(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    printf("[NULL][WARNING] ");
+    vprintf(fmt, args);
+    printf("\n");
+    va_end(args);
+}
+
+static void null_log_error(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "[NULL][ERROR] ");
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+// ================ CORE FUNCTIONS ================
+
+static GAL_Result null_initialize(void) {
+    if (null_data.initialized) {
+        null_log_warning("Null renderer already initialized");
+        return GAL_RESULT_SUCCESS;
+    }
+
+    null_data.stats = (GAL_Stats){0};
+    null_data.initialized = true;
+    null_log_info("Null renderer initialized, nothing will be drawn");
+    return GAL_RESULT_SUCCESS;
+}
+
+static void null_shutdown(void) {
+    if (!null_data.initialized) {
+        return;
+    }
+
+    draw_instance_stream_deinit(&null_data.stream);
+    if (null_data.stats.texture_count > 0) {
+        null_log_warning("%llu textures (%llu bytes) were never destroyed", null_data.stats.texture_count, null_data.stats.texture_bytes);
+    }
+    Null_Texture_Slot_Array_deinit(&null_data.texture_slots);
+    null_data = (Null_Data){0};
+}
+
+// There is no window, only its size is kept
+static GAL_Result null_create_window(GAL_Window_Desc* desc) {
+    if (!null_data.initialized) {
+        null_log_error("Null renderer not initialized");
+        return GAL_RESULT_ERROR_INITIALIZATION_FAILED;
+    }
+    if (!desc) {
+        null_log_error("Invalid window description");
+        return GAL_RESULT_ERROR_INVALID_PARAMETER;
+    }
+
+    null_data.screen_width = desc->width;
+    null_data.screen_height = desc->height;
+    null_data.window_created = true;
+    null_log_verbose("Pretending to have a %ux%u window", desc->width, desc->height);
+    return GAL_RESULT_SUCCESS;
+}
+
+static void null_destroy_window(void) {
+    null_data.window_created = false;
+}
+
+static void null_update(void) {
+}
+
+static void null_present(void) {
+    null_data.stats.frames += 1;
+}
+
+// ================ RESOURCE MANAGEMENT ================
+
+// Null if texture isn't a live texture
+static Null_Texture* null_get_texture(GAL_Texture_Handle texture) {
+    uint64_t handle = (uint64_t)(uintptr_t)texture;
+    uint64_t slot = (handle & 0xFFFFFFFF) - 1;
+    if (!handle || slot >= null_data.texture_slots.count) {
+        return NULL;
+    }
+    Null_Texture_Slot* s = &null_data.texture_slots.data[slot];
+    if (!s->texture || s->generation != (uint32_t)(handle >> 32)) {
+        return NULL;
+    }
+    return s->texture;
+}
+
+static GAL_Texture_Handle null_create_texture(GAL_Texture_Desc* desc, Allocator allocator) {
+    if (!desc || desc->width == 0 || desc->height == 0) {
+        null_log_error("Invalid texture description");
+        return NULL;
+    }
+    uint32_t channels = desc->channels ? desc->channels : 4;
+    if (channels > 4) {
+        null_log_error("Textures can have 1 to 4 channels, got %u", channels);
+        return NULL;
+    }
+
+    uint64_t size = (uint64_t)desc->width*desc->height*channels;
+    Null_Texture* texture = (Null_Texture*)alloc_uninitialized(allocator, sizeof(Null_Texture) + size);
+    if (!texture) {
+        null_log_error("Out of memory for a %ux%u texture", desc->width, desc->height);
+        return NULL;
+    }
+    texture->width = desc->width;
+    texture->height = desc->height;
+    texture->channels = channels;
+    texture->is_render_target = desc->is_render_target;
+    texture->pixels = (uint8_t*)(texture + 1);
+
+    if (desc->initial_data) {
+        memcpy(texture->pixels, desc->initial_data, size);
+        null_data.stats.texture_uploads += 1;
+        null_data.stats.texture_upload_bytes += size;
+    } else {
+        memset(texture->pixels, 0, size);
+    }
+
+    uint32_t slot_index;
+    if (null_data.first_free_slot) {
+        slot_index = null_data.first_free_slot - 1;
+        null_data.first_free_slot = null_data.texture_slots.data[slot_index].next_free;
+    } else {
+        slot_index = (uint32_t)null_data.texture_slots.count;
+        Null_Texture_Slot_Array_push(&null_data.texture_slots, (Null_Texture_Slot){ .generation = 1 });
+    }
+    Null_Texture_Slot* slot = &null_data.texture_slots.data[slot_index];
+    slot->texture = texture;
+    slot->next_free = 0;
+
+    null_data.stats.texture_count += 1;
+    null_data.stats.texture_bytes += size;
+    return (GAL_Texture_Handle)(uintptr_t)(((uint64_t)slot->generation << 32) | (slot_index + 1));
+}
+
+static void null_update_texture(GAL_Texture_Handle handle, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* data) {
+    Null_Texture* texture = null_get_texture(handle);
+    if (!texture) {
+        null_log_error("Updating a texture that doesn't exist or was destroyed");
+        return;
+    }
+    if (!data) {
+        return;
+    }
+    if (x >= texture->width || y >= texture->height || width > texture->width - x || height > texture->height - y) {
+        null_log_error("Update of %ux%u at %u, %u is outside of the %ux%u texture", width, height, x, y, texture->width, texture->height);
+        return;
+    }
+
+    uint32_t channels = texture->channels;
+    for (uint32_t row = 0; row < height; row++) {
+        memcpy(texture->pixels + ((uint64_t)(y + row)*texture->width + x)*channels, (uint8_t*)data + (uint64_t)row*width*channels, (uint64_t)width*channels);
+    }
+
+    null_data.stats.texture_uploads += 1;
+    null_data.stats.texture_upload_bytes += (uint64_t)width*height*channels;
+}
+
+static void null_read_texture(GAL_Texture_Handle handle, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* output) {
+    Null_Texture* texture = null_get_texture(handle);
+    if (!texture || !output) {
+        null_log_error("Reading a texture that doesn't exist or was destroyed");
+        return;
+    }
+    if (x >= texture->width || y >= texture->height) {
+        return;
+    }
+
+    uint32_t channels = texture->channels;
+    uint32_t copy_width  = texture->width - x < width ? texture->width - x : width;
+    uint32_t copy_height = texture->height - y < height ? texture->height - y : height;
+    for (uint32_t row = 0; row < copy_height; row++) {
+        memcpy((uint8_t*)output + (uint64_t)row*width*channels, texture->pixels + ((uint64_t)(y + row)*texture->width + x)*channels, (uint64_t)copy_width*channels);
+    }
+}
+
+static void null_destroy_texture(GAL_Texture_Handle handle, Allocator allocator) {
+    if (!handle) {
+        return;
+    }
+    Null_Texture* texture = null_get_texture(handle);
+    if (!texture) {
+        null_log_error("Destroying a texture that doesn't exist or was already destroyed");
+        return;
+    }
+
+    uint64_t size = (uint64_t)texture->width*texture->height*texture->channels;
+    null_data.stats.texture_count -= 1;
+    null_data.stats.texture_bytes -= size;
+
+    uint32_t slot_index = (uint32_t)(((uint64_t)(uintptr_t)handle & 0xFFFFFFFF) - 1);
+    Null_Texture_Slot* slot = &null_data.texture_slots.data[slot_index];
+    slot->texture = NULL;
+    slot->generation += 1;
+    slot->next_free = null_data.first_free_slot;
+    null_data.first_free_slot = slot_index + 1;
+
+    Dealloc(allocator, texture);
+}
+
+// ================ RENDERING FUNCTIONS ================
+
+static inline bool null_is_finite(float x) {
+    return x - x == 0; // False for NaN and infinity
+}
+
+// Null if the quad is fine, otherwise why it isn't
+static const char* null_check_quad(const Draw_Quad* q) {
+    Vector2 points[4] = { q->bottom_left, q->top_left, q->top_right, q->bottom_right };
+    for (int i = 0; i < 4; i++) {
+        if (!null_is_finite(points[i].x) || !null_is_finite(points[i].y)) return "corner is NaN or infinite";
+    }
+    if (!null_is_finite(q->color.x) || !null_is_finite(q->color.y) || !null_is_finite(q->color.z) || !null_is_finite(q->color.w)) {
+        return "color is NaN or infinite";
+    }
+    if (!null_is_finite(q->uv.x) || !null_is_finite(q->uv.y) || !null_is_finite(q->uv.z) || !null_is_finite(q->uv.w)) {
+        return "uv is NaN or infinite";
+    }
+    if (q->type >= QUAD_TYPE_COUNT) {
+        return "unknown quad type";
+    }
+    // Images without a texture (like evicted atlas sprites) draw untextured, that's fine
+    if (q->image && q->image->gal_handle && !null_get_texture(q->image->gal_handle)) {
+        return "texture doesn't exist or was destroyed";
+    }
+    if (q->type == QUAD_TYPE_TEXT && !(q->image && q->image->gal_handle)) {
+        return "text quad has no texture";
+    }
+    return NULL;
+}
+
+static void null_consume_draw_frame(Draw_Frame* frame) {
+    if (frame->enable_z_sorting) draw_frame_sort_by_z(frame);
+
+    uint64_t invalid = 0;
+    uint64_t first_invalid = 0;
+    const char* first_reason = NULL;
+    uint64_t index = 0;
+    for (uint64_t c = 0; c < bucket_array_get_chunk_count(&frame->quad_buffer); c++) {
+        uint64_t n;
+        Draw_Quad* quads = (Draw_Quad*)bucket_array_get_chunk(&frame->quad_buffer, c, &n);
+        for (uint64_t i = 0; i < n; i++, index++) {
+            const char* reason = null_check_quad(&quads[i]);
+            if (!reason) continue;
+            if (invalid == 0) {
+                first_invalid = index;
+                first_reason = reason;
+            }
+            invalid += 1;
+        }
+    }
+    if (invalid > 0) {
+        null_log_warning("%llu invalid quads in the frame, the first is quad %llu: %s", invalid, first_invalid, first_reason);
+    }
+
+    draw_frame_build_instance_stream(frame, &null_data.stream);
+
+    null_data.stats.quads += index;
+    null_data.stats.invalid_quads += invalid;
+    null_data.stats.draw_calls += null_data.stream.stats.draw_call_count;
+}
+
+// Null if the instance is fine, otherwise why it isn't. Also checks that it agrees with the
+// draw call it's in, so the null renderer catches streams that a GPU renderer would draw wrong.
+static const char* null_check_instance(Draw_Instance_Stream* stream, Draw_Call* call, uint64_t index) {
+    Draw_Quad_Instance* inst = &stream->instances.data[index];
+    Draw_Quad_Instance_Extra* extra = stream->extras.count ? &stream->extras.data[index] : NULL;
+    if ((inst->flags & DRAW_INSTANCE_FLAG_HAS_TOP_RIGHT) && !extra) {
+        return "top right corner is missing from the extras";
+    }
+    Vector2 corners[4];
+    draw_quad_instance_get_corners(inst, extra, corners);
+    for (int i = 0; i < 4; i++) {
+        if (!null_is_finite(corners[i].x) || !null_is_finite(corners[i].y)) return "corner is NaN or infinite";
+    }
+    if (inst->type >= QUAD_TYPE_COUNT) {
+        return "unknown quad type";
+    }
+    if (inst->scissor_index != call->scissor_index) {
+        return "scissor isn't the one of its draw call";
+    }
+    if (inst->scissor_index != DRAW_INSTANCE_NO_SCISSOR && inst->scissor_index >= stream->scissors.count) {
+        return "scissor index is outside of the scissor table";
+    }
+    if (inst->texture_index == DRAW_INSTANCE_NO_TEXTURE) {
+        return inst->type == QUAD_TYPE_TEXT ? "text quad has no texture" : NULL;
+    }
+    if (inst->texture_index >= stream->textures.count) {
+        return "texture index is outside of the texture table";
+    }
+    if (inst->texture_slot >= call->texture_count || call->textures[inst->texture_slot] != inst->texture_index) {
+        return "texture slot isn't bound to its texture in the draw call";
+    }
+    Gal_Image* image = stream->textures.data[inst->texture_index];
+    if (image && image->gal_handle && !null_get_texture(image->gal_handle)) {
+        return "texture doesn't exist or was destroyed";
+    }
+    if (inst->type == QUAD_TYPE_TEXT && !(image && image->gal_handle)) {
+        return "text quad has no texture";
+    }
+    return NULL;
+}
+
+// Walks the stream call by call like a GPU renderer would draw it
+static void null_consume_instance_stream(Draw_Instance_Stream* stream) {
+    uint64_t invalid = 0;
+    uint64_t first_invalid = 0;
+    const char* first_reason = NULL;
+    uint64_t next = 0;
+    for (uint64_t c = 0; c < stream->calls.count; c++) {
+        Draw_Call* call = &stream->calls.data[c];
+        if (call->first_instance != next || (uint64_t)call->first_instance + call->instance_count > stream->instances.count) {
+            null_log_error("Draw call %llu has instances %u to %u, expected them to start at %llu", c, call->first_instance, call->first_instance + call->instance_count, next);
+            break;
+        }
+        for (uint64_t i = call->first_instance; i < (uint64_t)call->first_instance + call->instance_count; i++) {
+            const char* reason = null_check_instance(stream, call, i);
+            if (!reason) continue;
+            if (invalid == 0) {
+                first_invalid = i;
+                first_reason = reason;
+            }
+            invalid += 1;
+        }
+        next = (uint64_t)call->first_instance + call->instance_count;
+    }
+    if (next != stream->instances.count) {
+        null_log_error("Draw calls cover %llu of the %llu instances in the stream", next, stream->instances.count);
+    }
+    if (invalid > 0) {
+        null_log_warning("%llu invalid instances in the stream, the first is instance %llu: %s", invalid, first_invalid, first_reason);
+    }
+
+    null_data.stats.quads += stream->instances.count;
+    null_data.stats.invalid_quads += invalid;
+    null_data.stats.draw_calls += stream->calls.count;
+}
+
+static void null_begin_frame(void) {
+}
+
+static void null_end_frame(void) {
+}
+
+static void null_render_draw_frame(Draw_Frame* frame, GAL_Texture_Handle target) {
+    if (!frame) {
+        return;
+    }
+    Null_Texture* texture = null_get_texture(target);
+    if (!texture) {
+        null_log_error("Rendering to a texture that doesn't exist or was destroyed");
+        return;
+    }
+    if (!texture->is_render_target) {
+        null_log_warning("Rendering to a texture that wasn't made as a render target");
+    }
+
+    null_consume_draw_frame(frame);
+}
+
+static void null_render_draw_frame_to_window(Draw_Frame* frame) {
+    if (!frame) {
+        return;
+    }
+
+    null_consume_draw_frame(frame);
+}
+
+static void null_render_instances(Draw_Instance_Stream* stream, GAL_Texture_Handle target) {
+    if (!stream) {
+        return;
+    }
+    if (target) {
+        Null_Texture* texture = null_get_texture(target);
+        if (!texture) {
+            null_log_error("Rendering to a texture that doesn't exist or was destroyed");
+            return;
+        }
+        if (!texture->is_render_target) {
+            null_log_warning("Rendering to a texture that wasn't made as a render target");
+        }
+    }
+
+    null_consume_instance_stream(stream);
+}
+
+static void null_clear_render_target(GAL_RenderTarget_Handle target, float r, float g, float b, float a) {
+    Null_Texture* texture = null_get_texture(target);
+    if (!texture) {
+        // The window, there's nothing to clear
+        return;
+    }
+
+    float color[4] = { r, g, b, a };
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; i++) {
+        float v = color[i] < 0 ? 0 : (color[i] > 1 ? 1 : color[i]);
+        bytes[i] = (uint8_t)(v*255.0f + 0.5f);
+    }
+
+    uint64_t count = (uint64_t)texture->width*texture->height;
+    for (uint64_t i = 0; i < count; i++) {
+        memcpy(texture->pixels + i*texture->channels, bytes, texture->channels);
+    }
+}
+
+// ================ ADVANCED FUNCTIONS ================
+
+// Nothing to compile, but shader extensions still get something to hold on to
+static GAL_Result null_compile_shader(string source_code, uint64_t cbuffer_size, void** shader_object) {
+    if (!shader_object) {
+        return GAL_RESULT_ERROR_INVALID_PARAMETER;
+    }
+
+    Null_Shader* shader = (Null_Shader*)Alloc(GetHeapAllocator(), sizeof(Null_Shader));
+    shader->magic = NULL_SHADER_MAGIC;
+    shader->cbuffer_size = cbuffer_size;
+    *shader_object = shader;
+    return GAL_RESULT_SUCCESS;
+}
+
+static void null_destroy_shader(void* shader_object) {
+    Null_Shader* shader = (Null_Shader*)shader_object;
+    if (!shader || shader->magic != NULL_SHADER_MAGIC) {
+        return;
+    }
+    shader->magic = 0;
+    Dealloc(GetHeapAllocator(), shader);
+}
+
+// The blob is the Null_Shader itself, so the shader cache can be tested without a GPU
+static bool null_get_shader_binary(void* shader_object, Allocator allocator, string* binary) {
+    Null_Shader* shader = (Null_Shader*)shader_object;
+    if (!shader || shader->magic != NULL_SHADER_MAGIC || !binary) {
+        return false;
+    }
+    binary->count = sizeof(Null_Shader);
+    binary->data = (uint8_t*)alloc_uninitialized(allocator, binary->count);
+    memcpy(binary->data, shader, sizeof(Null_Shader));
+    return true;
+}
+
+static GAL_Result null_load_shader_binary(string binary, uint64_t cbuffer_size, void** shader_object) {
+    if (!shader_object) {
+        return GAL_RESULT_ERROR_INVALID_PARAMETER;
+    }
+    Null_Shader loaded;
+    if (binary.count != sizeof(Null_Shader)) {
+        return GAL_RESULT_ERROR_FORMAT_NOT_SUPPORTED;
+    }
+    memcpy(&loaded, binary.data, sizeof(loaded));
+    if (loaded.magic != NULL_SHADER_MAGIC || loaded.cbuffer_size != cbuffer_size) {
+        return GAL_RESULT_ERROR_FORMAT_NOT_SUPPORTED;
+    }
+    return null_compile_shader(STR(""), cbuffer_size, shader_object);
+}
+
+static string null_get_shader_cache_id(void) {
+    return STR("null 1");
+}
+
+static void null_reserve_vertex_buffer(uint64_t bytes) {
+    // No vertex buffers
+}
+
+static void null_get_stats(GAL_Stats* stats) {
+    *stats = null_data.stats;
+}
+
+static void null_write_timestamp(uint32_t query) {
+    if (query >= GAL_TIMING_MAX_QUERIES) return;
+    null_data.timestamps[query] = (uint64_t)(OsGetElapsedSeconds()*1e9);
+}
+
+static bool null_read_timestamp(uint32_t query, uint64_t* nanoseconds) {
+    if (query >= GAL_TIMING_MAX_QUERIES) return false;
+    *nanoseconds = null_data.timestamps[query];
+    return true;
+}
+
+static bool null_get_timestamp(uint64_t* nanoseconds) {
+    *nanoseconds = (uint64_t)(OsGetElapsedSeconds()*1e9);
+    return true;
+}
+
+// Create the null renderer
+GAL_Renderer null_create_renderer(void) {
+    GAL_Renderer renderer = {0};
+
+    renderer.backend = GAL_BACKEND_NULL;
+    renderer.name = "Null Renderer";
+    renderer.api_version = 1;
+
+    // Set up logging functions
+    renderer.log_verbose = null_log_verbose;
+    renderer.log_info = null_log_info;
+    renderer.log_warning = null_log_warning;
+    renderer.log_error = null_log_error;
+
+    // Core functions
+    renderer.initialize = null_initialize;
+    renderer.shutdown = null_shutdown;
+    renderer.create_window = null_create_window;
+    renderer.destroy_window = null_destroy_window;
+    renderer.update = null_update;
+    renderer.present = null_present;
+
+    // Resource management
+    renderer.create_texture = null_create_texture;
+    renderer.update_texture = null_update_texture;
+    renderer.destroy_texture = null_destroy_texture;
+    renderer.read_texture = null_read_texture;
+
+    // Rendering functions
+    renderer.begin_frame = null_begin_frame;
+    renderer.end_frame = null_end_frame;
+    renderer.render_draw_frame = null_render_draw_frame;
+    renderer.render_draw_frame_to_window = null_render_draw_frame_to_window;
+    renderer.render_instances = null_render_instances;
+    renderer.clear_render_target = null_clear_render_target;
+
+    // Advanced functions
+    renderer.compile_shader = null_compile_shader;
+    renderer.destroy_shader = null_destroy_shader;
+    renderer.get_shader_binary = null_get_shader_binary;
+    renderer.load_shader_binary = null_load_shader_binary;
+    renderer.get_shader_cache_id = null_get_shader_cache_id;
+    renderer.reserve_vertex_buffer = null_reserve_vertex_buffer;
+    renderer.get_stats = null_get_stats;
+    renderer.write_timestamp = null_write_timestamp;
+    renderer.read_timestamp = null_read_timestamp;
+    renderer.get_timestamp = null_get_timestamp;
+
+    // Implementation data
+    renderer.implementation_data = &null_data;
+
+    return renderer;
+}
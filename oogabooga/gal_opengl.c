@@ -19,6 +19,170 @@
 typedef struct Draw_Frame Draw_Frame;
 extern Draw_Frame drawFrame;
 
+/*
+    Drawing
+    
+    gal packs Draw_Frame's into a Draw_Instance_Stream (see "- Instance streams" in drawing.c)
+    and hands it to render_instances. Each Draw_Call is one glDrawArraysInstanced of a 4 vertex
+    triangle strip. The vertex
+    shader expands each 48 byte Draw_Quad_Instance to its corners, so nothing is done per
+    vertex on the CPU.
+    
+    Instances are streamed through a ring buffer which is split in OPENGL_FRAMES_IN_FLIGHT
+    regions, one for each frame the GPU can be behind:
+    
+    - With GL 4.4 or GL_ARB_buffer_storage the buffer is persistently mapped and instances
+      are copied straight into the region of the current frame. A fence is put down after
+      each frame and waited on before its region is written again, 3 frames later.
+    - Without it the buffer is one region which is orphaned with glBufferData every frame
+      and filled with glBufferSubData, and the driver does the fencing.
+    - The buffer is never reallocated in the middle of a frame. A frame which doesn't fit in
+      its region waits for the GPU to be done with what it already drew and starts over at
+      the start of the region (or orphans again), and a draw call which is bigger than a
+      whole region is drawn in pieces. Then the ring grows to fit at the end of the frame.
+    - gfx_reserve_vbo_bytes (reserve_vertex_buffer) sets the region size up front so it never
+      has to grow. If it's called in the middle of a frame it's done at the end of it.
+    - opengl_data.stream_stats has how much was streamed and how often the CPU had to wait.
+    
+    Shader extensions
+    
+    compile_shader takes GLSL that goes into the fragment shader of the quad program. It
+    defines vec4 pixel_shader_extension(vec4 color), which gets the color of the pixel after
+    texturing and returns what's drawn. It can read v_uv, v_local (0 to 1 across the quad) and
+    v_color. With a cbuffer it declares layout(std140) uniform Shader_Extension_Data { ... },
+    and the frame's cbuffer is copied into it before drawing. With GL 4.1 or
+    GL_ARB_get_program_binary the linked programs are handed to the shader cache in gal.c.
+    
+    Timing
+    
+    gal_begin_timing/gal_end_timing put down GL_TIMESTAMP queries with glQueryCounter. gal.c
+    only reads a query back once GL_QUERY_RESULT_AVAILABLE says it's in, and glGetInteger64v
+    of GL_TIMESTAMP lines the GPU clock up with the CPU one.
+*/
+
+#define OPENGL_FRAMES_IN_FLIGHT 3
+#define OPENGL_DEFAULT_REGION_SIZE (4*1024*1024)
+#define OPENGL_STREAM_ALIGNMENT 256
+// GL_MAX_TEXTURE_IMAGE_UNITS is at least 16, calls which use more textures than there are
+// units are drawn in several parts
+#define OPENGL_MAX_TEXTURE_SLOTS DRAW_CALL_MAX_TEXTURES
+
+// Everything past GL 1.1, loaded with SDL_GL_GetProcAddress once there is a context since
+// opengl32.dll and some libGL's don't export them.
+#define OPENGL_FUNCTIONS(X) \
+    X(PFNGLGENBUFFERSPROC, GenBuffers) \
+    X(PFNGLDELETEBUFFERSPROC, DeleteBuffers) \
+    X(PFNGLBINDBUFFERPROC, BindBuffer) \
+    X(PFNGLBUFFERDATAPROC, BufferData) \
+    X(PFNGLBUFFERSUBDATAPROC, BufferSubData) \
+    X(PFNGLMAPBUFFERRANGEPROC, MapBufferRange) \
+    X(PFNGLUNMAPBUFFERPROC, UnmapBuffer) \
+    X(PFNGLFENCESYNCPROC, FenceSync) \
+    X(PFNGLCLIENTWAITSYNCPROC, ClientWaitSync) \
+    X(PFNGLDELETESYNCPROC, DeleteSync) \
+    X(PFNGLGENVERTEXARRAYSPROC, GenVertexArrays) \
+    X(PFNGLDELETEVERTEXARRAYSPROC, DeleteVertexArrays) \
+    X(PFNGLBINDVERTEXARRAYPROC, BindVertexArray) \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, EnableVertexAttribArray) \
+    X(PFNGLDISABLEVERTEXATTRIBARRAYPROC, DisableVertexAttribArray) \
+    X(PFNGLVERTEXATTRIBPOINTERPROC, VertexAttribPointer) \
+    X(PFNGLVERTEXATTRIBIPOINTERPROC, VertexAttribIPointer) \
+    X(PFNGLVERTEXATTRIBDIVISORPROC, VertexAttribDivisor) \
+    X(PFNGLVERTEXATTRIB2FPROC, VertexAttrib2f) \
+    X(PFNGLDRAWARRAYSINSTANCEDPROC, DrawArraysInstanced) \
+    X(PFNGLCREATESHADERPROC, CreateShader) \
+    X(PFNGLSHADERSOURCEPROC, ShaderSource) \
+    X(PFNGLCOMPILESHADERPROC, CompileShader) \
+    X(PFNGLGETSHADERIVPROC, GetShaderiv) \
+    X(PFNGLGETSHADERINFOLOGPROC, GetShaderInfoLog) \
+    X(PFNGLDELETESHADERPROC, DeleteShader) \
+    X(PFNGLCREATEPROGRAMPROC, CreateProgram) \
+    X(PFNGLATTACHSHADERPROC, AttachShader) \
+    X(PFNGLLINKPROGRAMPROC, LinkProgram) \
+    X(PFNGLGETPROGRAMIVPROC, GetProgramiv) \
+    X(PFNGLGETPROGRAMINFOLOGPROC, GetProgramInfoLog) \
+    X(PFNGLDELETEPROGRAMPROC, DeleteProgram) \
+    X(PFNGLUSEPROGRAMPROC, UseProgram) \
+    X(PFNGLGETUNIFORMLOCATIONPROC, GetUniformLocation) \
+    X(PFNGLUNIFORM1IPROC, Uniform1i) \
+    X(PFNGLACTIVETEXTUREPROC, ActiveTexture) \
+    X(PFNGLBLENDFUNCSEPARATEPROC, BlendFuncSeparate) \
+    X(PFNGLGENFRAMEBUFFERSPROC, GenFramebuffers) \
+    X(PFNGLDELETEFRAMEBUFFERSPROC, DeleteFramebuffers) \
+    X(PFNGLBINDFRAMEBUFFERPROC, BindFramebuffer) \
+    X(PFNGLFRAMEBUFFERTEXTURE2DPROC, FramebufferTexture2D) \
+    X(PFNGLCHECKFRAMEBUFFERSTATUSPROC, CheckFramebufferStatus) \
+    X(PFNGLGETSTRINGIPROC, GetStringi) \
+    X(PFNGLGETUNIFORMBLOCKINDEXPROC, GetUniformBlockIndex) \
+    X(PFNGLUNIFORMBLOCKBINDINGPROC, UniformBlockBinding) \
+    X(PFNGLBINDBUFFERBASEPROC, BindBufferBase) \
+    X(PFNGLGENQUERIESPROC, GenQueries) \
+    X(PFNGLDELETEQUERIESPROC, DeleteQueries) \
+    X(PFNGLGETQUERYOBJECTIVPROC, GetQueryObjectiv) \
+    X(PFNGLGETINTEGER64VPROC, GetInteger64v)
+
+typedef struct {
+#define OPENGL_DECLARE_FUNCTION(type, name) type name;
+    OPENGL_FUNCTIONS(OPENGL_DECLARE_FUNCTION)
+#undef OPENGL_DECLARE_FUNCTION
+    // GL 4.4 or GL_ARB_buffer_storage, may be NULL
+    PFNGLBUFFERSTORAGEPROC BufferStorage;
+    // GL 4.1 or GL_ARB_get_program_binary, may be NULL
+    PFNGLGETPROGRAMBINARYPROC GetProgramBinary;
+    PFNGLPROGRAMBINARYPROC ProgramBinary;
+    PFNGLPROGRAMPARAMETERIPROC ProgramParameteri;
+    // GL 3.3 or GL_ARB_timer_query, may be NULL
+    PFNGLQUERYCOUNTERPROC QueryCounter;
+    PFNGLGETQUERYOBJECTUI64VPROC GetQueryObjectui64v;
+} OpenGL_Functions;
+
+static OpenGL_Functions gl = {0};
+
+typedef struct {
+    GLuint id;
+    // Made the first time the texture is drawn to, cleared or read
+    GLuint framebuffer;
+    uint32_t width, height, channels;
+    bool is_render_target;
+} OpenGL_Texture;
+
+typedef struct {
+    GLuint buffer;
+    // Whole buffer when it's persistently mapped, NULL with the glBufferSubData fallback
+    uint8_t* mapped;
+    uint64_t region_size;
+    uint32_t region;
+    // Where the next write goes in the region
+    uint64_t offset;
+    // False until the first write of the frame, which waits for (or orphans) the region
+    bool region_ready;
+    GLsync fences[OPENGL_FRAMES_IN_FLIGHT];
+    // Bytes written this frame, the ring grows to fit this at the end of the frame
+    uint64_t frame_bytes;
+    // From reserve_vertex_buffer, applied between frames
+    uint64_t reserved_size;
+} OpenGL_Stream_Ring;
+
+// The quad program, or the one of a shader extension (the shader_object compile_shader hands out)
+typedef struct {
+    GLuint id;
+    GLint slot_base_location;
+    // Uniform buffer for the Shader_Extension_Data block, 0 without a cbuffer
+    GLuint cbuffer;
+    uint64_t cbuffer_size;
+} OpenGL_Program;
+
+typedef struct {
+    uint64_t bytes_streamed;
+    // Fences that weren't signaled yet when a region was needed again
+    uint64_t fence_stalls;
+    // Frames that didn't fit in their region and started over at its start
+    uint64_t region_overflows;
+    uint64_t ring_resizes;
+    uint64_t draw_calls;
+    uint64_t instances;
+} OpenGL_Stream_Stats;
+
 // OpenGL implementation data
 typedef struct {
     SDL_Window* window;
@@ -27,6 +191,28 @@ typedef struct {
     uint32_t screen_height;
     bool vsync_enabled;
     bool initialized;
+    
+    // Set when the context is made, can be turned off before the ring is made to use the
+    // glBufferSubData path
+    bool use_buffer_storage;
+    // GL 4.1 or GL_ARB_get_program_binary with at least one binary format, for the shader cache
+    bool has_program_binary;
+    // Driver, GL version and a hash of the quad shaders, see get_shader_cache_id
+    char shader_cache_id[512];
+    OpenGL_Program program;
+    // What opengl_draw_stream is drawing with
+    OpenGL_Program* current_program;
+    GLuint vertex_array;
+    uint32_t texture_slots;
+    // Bound for images without a texture, like evicted atlas sprites
+    GLuint white_texture;
+    // GL_TIMESTAMP queries for gal_begin_timing, 0 without timer queries
+    GLuint timestamp_queries[GAL_TIMING_MAX_QUERIES];
+    OpenGL_Stream_Ring ring;
+    OpenGL_Stream_Stats stream_stats;
+    GAL_Stats stats;
+    // Kept between frames so it's only allocated when a frame has more than before
+    Draw_Instance_Stream stream;
 } OpenGL_Data;
 
 // Static instance of the implementation data
@@ -79,6 +265,438 @@ static void check_sdl_errors(const char* function) {
     }
 }
 
+// ================ PIPELINE ================
+
+static bool opengl_load_functions(void) {
+    bool ok = true;
+#define OPENGL_LOAD_FUNCTION(type, name) \
+    gl.name = (type)SDL_GL_GetProcAddress("gl" #name); \
+    if (!gl.name) { opengl_log_error("Missing OpenGL function gl%s", #name); ok = false; }
+    OPENGL_FUNCTIONS(OPENGL_LOAD_FUNCTION)
+#undef OPENGL_LOAD_FUNCTION
+    gl.BufferStorage = (PFNGLBUFFERSTORAGEPROC)SDL_GL_GetProcAddress("glBufferStorage");
+    gl.GetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)SDL_GL_GetProcAddress("glGetProgramBinary");
+    gl.ProgramBinary = (PFNGLPROGRAMBINARYPROC)SDL_GL_GetProcAddress("glProgramBinary");
+    gl.ProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)SDL_GL_GetProcAddress("glProgramParameteri");
+    gl.QueryCounter = (PFNGLQUERYCOUNTERPROC)SDL_GL_GetProcAddress("glQueryCounter");
+    gl.GetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)SDL_GL_GetProcAddress("glGetQueryObjectui64v");
+    return ok;
+}
+
+static bool opengl_has_extension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*)gl.GetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (extension && strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+static const char* opengl_vertex_shader_source =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 origin;\n"
+    "layout(location = 1) in vec2 axis_x;\n"
+    "layout(location = 2) in vec2 axis_y;\n"
+    "layout(location = 3) in vec4 color;\n"
+    "layout(location = 4) in vec4 uv;\n"
+    // texture index, scissor index, type | flags << 8, texture slot
+    "layout(location = 5) in uvec4 info;\n"
+    "layout(location = 6) in vec2 top_right;\n"
+    "out vec4 v_color;\n"
+    "out vec2 v_uv;\n"
+    "out vec2 v_local;\n"
+    "flat out uvec4 v_info;\n"
+    "void main() {\n"
+    // Triangle strip of bottom left, top left, bottom right, top right
+    "    vec2 local = vec2(float(gl_VertexID >> 1), float(gl_VertexID & 1));\n"
+    "    vec2 p = origin + axis_x*local.x + axis_y*local.y;\n"
+    "    if (gl_VertexID == 3 && ((info.z >> 8u) & HAS_TOP_RIGHT) != 0u) p = top_right;\n"
+    "    gl_Position = vec4(p, 0.0, 1.0);\n"
+    "    v_color = color;\n"
+    "    v_uv = mix(uv.xy, uv.zw, local);\n"
+    "    v_local = local;\n"
+    "    v_info = info;\n"
+    "}\n";
+
+// Sampler arrays can only be indexed with constants in GLSL 3.30, so sample_slot is an if
+// for each slot, put in where SAMPLE_SLOTS is. The source of a shader extension goes where
+// EXTENSION_SOURCE is.
+static const char* opengl_fragment_shader_source =
+    "#version 330 core\n"
+    "in vec4 v_color;\n"
+    "in vec2 v_uv;\n"
+    "in vec2 v_local;\n"
+    "flat in uvec4 v_info;\n"
+    "uniform sampler2D textures[TEXTURE_SLOTS];\n"
+    "uniform int slot_base;\n"
+    "out vec4 out_color;\n"
+    // Like the software renderer: the min filter when a pixel covers more than one texel.
+    // Nearest is done by sampling the texel center, the textures themselves are all linear.
+    "vec4 sample_texture(sampler2D t, vec2 dx, vec2 dy, uint flags) {\n"
+    "    vec2 size = vec2(textureSize(t, 0));\n"
+    "    float texels_per_pixel = abs(dx.x*dy.y - dx.y*dy.x)*size.x*size.y;\n"
+    "    uint linear_bit = texels_per_pixel > 1.0 ? MIN_FILTER_LINEAR : MAG_FILTER_LINEAR;\n"
+    "    vec2 uv = v_uv;\n"
+    "    if ((flags & linear_bit) == 0u) uv = (floor(uv*size) + 0.5)/size;\n"
+    "    return textureLod(t, uv, 0.0);\n"
+    "}\n"
+    "vec4 sample_slot(int slot, vec2 dx, vec2 dy, uint flags) {\n"
+    "SAMPLE_SLOTS"
+    "    return vec4(1.0);\n"
+    "}\n"
+    "EXTENSION_SOURCE"
+    "void main() {\n"
+    "    uint type = v_info.z & 255u;\n"
+    "    uint flags = v_info.z >> 8u;\n"
+    "    vec2 dx = dFdx(v_uv), dy = dFdy(v_uv);\n"
+    "    if (type == QUAD_TYPE_CIRCLE) {\n"
+    "        vec2 d = v_local - 0.5;\n"
+    "        if (dot(d, d) > 0.25) discard;\n"
+    "    }\n"
+    "    vec4 c = v_color;\n"
+    "    if (v_info.x != NO_TEXTURE) {\n"
+    "        vec4 texel = sample_slot(int(v_info.w) - slot_base, dx, dy, flags);\n"
+    "        if (type == QUAD_TYPE_TEXT) c.a *= texel.r;\n"
+    "        else c *= texel;\n"
+    "    }\n"
+    "#ifdef HAS_SHADER_EXTENSION\n"
+    "    c = pixel_shader_extension(c);\n"
+    "#endif\n"
+    "    out_color = c;\n"
+    "}\n";
+
+static GLuint opengl_compile_stage(GLenum stage, const char* defines, const char* source) {
+    // The #version line has to come first
+    const char* body = strchr(source, '\n') + 1;
+    const char* sources[3] = { "#version 330 core\n", defines, body };
+    
+    GLuint shader = gl.CreateShader(stage);
+    gl.ShaderSource(shader, 3, sources, NULL);
+    gl.CompileShader(shader);
+    
+    GLint compiled = 0;
+    gl.GetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char log[2048];
+        gl.GetShaderInfoLog(shader, sizeof(log), NULL, log);
+        opengl_log_error("Failed to compile %s shader: %s", stage == GL_VERTEX_SHADER ? "vertex" : "fragment", log);
+        gl.DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// Sets the sampler slots and makes the uniform buffer, after linking or loading a binary
+static void opengl_setup_program(GLuint id, uint64_t cbuffer_size, OpenGL_Program* program) {
+    *program = (OpenGL_Program){0};
+    program->id = id;
+    
+    gl.UseProgram(id);
+    for (uint32_t i = 0; i < opengl_data.texture_slots; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "textures[%u]", i);
+        gl.Uniform1i(gl.GetUniformLocation(id, name), (GLint)i);
+    }
+    program->slot_base_location = gl.GetUniformLocation(id, "slot_base");
+    gl.Uniform1i(program->slot_base_location, 0);
+    
+    if (cbuffer_size > 0) {
+        GLuint block = gl.GetUniformBlockIndex(id, "Shader_Extension_Data");
+        if (block != GL_INVALID_INDEX) gl.UniformBlockBinding(id, block, 0);
+        gl.GenBuffers(1, &program->cbuffer);
+        gl.BindBuffer(GL_UNIFORM_BUFFER, program->cbuffer);
+        gl.BufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)cbuffer_size, NULL, GL_DYNAMIC_DRAW);
+        gl.BindBuffer(GL_UNIFORM_BUFFER, 0);
+        program->cbuffer_size = cbuffer_size;
+    }
+}
+
+static void opengl_delete_program(OpenGL_Program* program) {
+    if (program->id) gl.DeleteProgram(program->id);
+    if (program->cbuffer) gl.DeleteBuffers(1, &program->cbuffer);
+    *program = (OpenGL_Program){0};
+}
+
+// The quad program, with the extension in the fragment shader if there is one
+static bool opengl_build_program(string extension, uint64_t cbuffer_size, OpenGL_Program* program) {
+    char defines[640];
+    snprintf(defines, sizeof(defines),
+             "#define TEXTURE_SLOTS %u\n#define NO_TEXTURE %uu\n#define HAS_TOP_RIGHT %uu\n"
+             "#define MIN_FILTER_LINEAR %uu\n#define MAG_FILTER_LINEAR %uu\n"
+             "#define QUAD_TYPE_CIRCLE %uu\n#define QUAD_TYPE_TEXT %uu\n%s",
+             opengl_data.texture_slots, DRAW_INSTANCE_NO_TEXTURE, DRAW_INSTANCE_FLAG_HAS_TOP_RIGHT,
+             DRAW_INSTANCE_FLAG_MIN_FILTER_LINEAR, DRAW_INSTANCE_FLAG_MAG_FILTER_LINEAR,
+             QUAD_TYPE_CIRCLE, QUAD_TYPE_TEXT, extension.data ? "#define HAS_SHADER_EXTENSION\n" : "");
+    
+    // Put the if for each slot and the extension in the fragment shader
+    const char* fragment_template = opengl_fragment_shader_source;
+    const char* slots = strstr(fragment_template, "SAMPLE_SLOTS");
+    const char* after_slots = slots + strlen("SAMPLE_SLOTS");
+    const char* extension_point = strstr(after_slots, "EXTENSION_SOURCE");
+    uint64_t capacity = strlen(fragment_template) + opengl_data.texture_slots*96 + extension.count + 1;
+    char* fragment_source = (char*)alloc_uninitialized(GetHeapAllocator(), capacity);
+    int length = snprintf(fragment_source, capacity, "%.*s", (int)(slots - fragment_template), fragment_template);
+    for (uint32_t i = 0; i < opengl_data.texture_slots; i++) {
+        length += snprintf(fragment_source + length, capacity - length,
+                           "    if (slot == %u) return sample_texture(textures[%u], dx, dy, flags);\n", i, i);
+    }
+    snprintf(fragment_source + length, capacity - length, "%.*s%.*s%s",
+             (int)(extension_point - after_slots), after_slots, (int)extension.count, (const char*)extension.data,
+             extension_point + strlen("EXTENSION_SOURCE"));
+    
+    GLuint vertex = opengl_compile_stage(GL_VERTEX_SHADER, defines, opengl_vertex_shader_source);
+    GLuint fragment = opengl_compile_stage(GL_FRAGMENT_SHADER, defines, fragment_source);
+    Dealloc(GetHeapAllocator(), fragment_source);
+    if (!vertex || !fragment) {
+        if (vertex) gl.DeleteShader(vertex);
+        if (fragment) gl.DeleteShader(fragment);
+        return false;
+    }
+    
+    GLuint id = gl.CreateProgram();
+    if (opengl_data.has_program_binary) {
+        gl.ProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    gl.AttachShader(id, vertex);
+    gl.AttachShader(id, fragment);
+    gl.LinkProgram(id);
+    gl.DeleteShader(vertex);
+    gl.DeleteShader(fragment);
+    
+    GLint linked = 0;
+    gl.GetProgramiv(id, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[2048];
+        gl.GetProgramInfoLog(id, sizeof(log), NULL, log);
+        opengl_log_error("Failed to link the %s program: %s", extension.data ? "shader extension" : "quad", log);
+        gl.DeleteProgram(id);
+        return false;
+    }
+    
+    opengl_setup_program(id, cbuffer_size, program);
+    return true;
+}
+
+// Waits for the GPU to get past the fence, if there is one
+static void opengl_wait_fence(GLsync* fence) {
+    if (!*fence) return;
+    
+    GLenum result = gl.ClientWaitSync(*fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        opengl_data.stream_stats.fence_stalls += 1;
+        do {
+            result = gl.ClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    if (result == GL_WAIT_FAILED) {
+        opengl_log_error("Waiting for a fence failed");
+    }
+    
+    gl.DeleteSync(*fence);
+    *fence = NULL;
+}
+
+static bool opengl_ring_create(uint64_t region_size) {
+    OpenGL_Stream_Ring* ring = &opengl_data.ring;
+    region_size = (region_size + OPENGL_STREAM_ALIGNMENT - 1) & ~(uint64_t)(OPENGL_STREAM_ALIGNMENT - 1);
+    
+    gl.GenBuffers(1, &ring->buffer);
+    gl.BindBuffer(GL_ARRAY_BUFFER, ring->buffer);
+    if (opengl_data.use_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr size = (GLsizeiptr)(region_size*OPENGL_FRAMES_IN_FLIGHT);
+        gl.BufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+        ring->mapped = (uint8_t*)gl.MapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+        if (!ring->mapped) {
+            opengl_log_error("Failed to map %llu bytes for streaming", (unsigned long long)size);
+            gl.DeleteBuffers(1, &ring->buffer);
+            ring->buffer = 0;
+            return false;
+        }
+    } else {
+        gl.BufferData(GL_ARRAY_BUFFER, (GLsizeiptr)region_size, NULL, GL_STREAM_DRAW);
+    }
+    
+    ring->region_size = region_size;
+    ring->region = 0;
+    ring->offset = 0;
+    ring->region_ready = false;
+    ring->frame_bytes = 0;
+    opengl_log_verbose("Streaming with %s, %llu bytes per frame", ring->mapped ? "a persistently mapped buffer" : "glBufferSubData", (unsigned long long)region_size);
+    return true;
+}
+
+static void opengl_ring_destroy(void) {
+    OpenGL_Stream_Ring* ring = &opengl_data.ring;
+    for (int i = 0; i < OPENGL_FRAMES_IN_FLIGHT; i++) {
+        opengl_wait_fence(&ring->fences[i]);
+    }
+    if (ring->buffer) {
+        if (ring->mapped) {
+            gl.BindBuffer(GL_ARRAY_BUFFER, ring->buffer);
+            gl.UnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        gl.DeleteBuffers(1, &ring->buffer);
+    }
+    uint64_t reserved_size = ring->reserved_size;
+    *ring = (OpenGL_Stream_Ring){0};
+    ring->reserved_size = reserved_size;
+}
+
+// Only between frames, waits for the GPU to be done with all of it
+static void opengl_ring_resize(uint64_t region_size) {
+    opengl_ring_destroy();
+    if (!opengl_ring_create(region_size) && opengl_data.use_buffer_storage) {
+        opengl_data.use_buffer_storage = false;
+        opengl_ring_create(region_size);
+    }
+    opengl_data.stream_stats.ring_resizes += 1;
+}
+
+// Gets the region ready for writing from its start: waits until the GPU is done with what
+// was drawn from it, or orphans it without buffer storage.
+static void opengl_ring_restart_region(GLsync* fence) {
+    OpenGL_Stream_Ring* ring = &opengl_data.ring;
+    if (ring->mapped) {
+        opengl_wait_fence(fence);
+    } else {
+        gl.BufferData(GL_ARRAY_BUFFER, (GLsizeiptr)ring->region_size, NULL, GL_STREAM_DRAW);
+    }
+    ring->offset = 0;
+}
+
+// Finds room for bytes in the region of this frame and copies the parts there. False if
+// they're bigger than a whole region. The offset is into the buffer.
+static bool opengl_ring_push(const void** parts, const uint64_t* sizes, int count, uint64_t* offsets) {
+    OpenGL_Stream_Ring* ring = &opengl_data.ring;
+    uint64_t bytes = 0;
+    for (int i = 0; i < count; i++) {
+        bytes += (sizes[i] + OPENGL_STREAM_ALIGNMENT - 1) & ~(uint64_t)(OPENGL_STREAM_ALIGNMENT - 1);
+    }
+    if (bytes > ring->region_size) return false;
+    
+    gl.BindBuffer(GL_ARRAY_BUFFER, ring->buffer);
+    if (!ring->region_ready) {
+        opengl_ring_restart_region(&ring->fences[ring->region]);
+        ring->region_ready = true;
+    }
+    if (ring->offset + bytes > ring->region_size) {
+        // Everything drawn from the region so far has to be done before it's overwritten
+        opengl_data.stream_stats.region_overflows += 1;
+        GLsync fence = ring->mapped ? gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : NULL;
+        opengl_ring_restart_region(&fence);
+    }
+    
+    uint64_t region_start = ring->mapped ? (uint64_t)ring->region*ring->region_size : 0;
+    for (int i = 0; i < count; i++) {
+        offsets[i] = region_start + ring->offset;
+        if (ring->mapped) {
+            memcpy(ring->mapped + offsets[i], parts[i], sizes[i]);
+        } else {
+            gl.BufferSubData(GL_ARRAY_BUFFER, (GLintptr)offsets[i], (GLsizeiptr)sizes[i], parts[i]);
+        }
+        ring->offset += (sizes[i] + OPENGL_STREAM_ALIGNMENT - 1) & ~(uint64_t)(OPENGL_STREAM_ALIGNMENT - 1);
+        ring->frame_bytes += sizes[i];
+        opengl_data.stream_stats.bytes_streamed += sizes[i];
+    }
+    return true;
+}
+
+// After the frame is presented: fences its region, moves on to the next one and grows the
+// ring if the frame didn't fit or more was reserved.
+static void opengl_ring_end_frame(void) {
+    OpenGL_Stream_Ring* ring = &opengl_data.ring;
+    if (!ring->buffer) return;
+    
+    if (ring->region_ready) {
+        if (ring->mapped) {
+            ring->fences[ring->region] = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        ring->region = (ring->region + 1) % OPENGL_FRAMES_IN_FLIGHT;
+        ring->region_ready = false;
+        ring->offset = 0;
+    }
+    
+    uint64_t needed = ring->reserved_size;
+    if (ring->frame_bytes > ring->region_size) {
+        // Some room for the alignment and for the next frame to be a bit bigger
+        uint64_t grown = ring->region_size;
+        while (grown < ring->frame_bytes + ring->frame_bytes/4) grown *= 2;
+        if (grown > needed) needed = grown;
+    }
+    ring->frame_bytes = 0;
+    if (needed > ring->region_size) {
+        opengl_ring_resize(needed);
+    }
+}
+
+static bool opengl_create_pipeline(void) {
+    GLint units = 16;
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+    opengl_data.texture_slots = units < OPENGL_MAX_TEXTURE_SLOTS ? (uint32_t)units : OPENGL_MAX_TEXTURE_SLOTS;
+    
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    
+    GLint binary_formats = 0;
+    if (gl.GetProgramBinary && gl.ProgramBinary && gl.ProgramParameteri && (major*10 + minor >= 41 || opengl_has_extension("GL_ARB_get_program_binary"))) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+    }
+    opengl_data.has_program_binary = binary_formats > 0;
+    
+    // A new driver or new quad shaders make the cached program binaries stale
+    uint64_t sources_hash = gal_hash_bytes(GAL_HASH_SEED, opengl_vertex_shader_source, strlen(opengl_vertex_shader_source));
+    sources_hash = gal_hash_bytes(sources_hash, opengl_fragment_shader_source, strlen(opengl_fragment_shader_source));
+    snprintf(opengl_data.shader_cache_id, sizeof(opengl_data.shader_cache_id), "%s|%s|%s|%u|%016llx",
+             (const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION),
+             opengl_data.texture_slots, (unsigned long long)sources_hash);
+    
+    if (!opengl_build_program((string){0}, 0, &opengl_data.program)) {
+        return false;
+    }
+    
+    opengl_data.use_buffer_storage = gl.BufferStorage && (major*10 + minor >= 44 || opengl_has_extension("GL_ARB_buffer_storage"));
+    
+    uint64_t region_size = opengl_data.ring.reserved_size > OPENGL_DEFAULT_REGION_SIZE ? opengl_data.ring.reserved_size : OPENGL_DEFAULT_REGION_SIZE;
+    if (!opengl_ring_create(region_size)) {
+        opengl_data.use_buffer_storage = false;
+        if (!opengl_ring_create(region_size)) return false;
+    }
+    opengl_log_info("Streaming quads %s", opengl_data.use_buffer_storage ? "through a persistently mapped buffer" : "with glBufferSubData");
+    
+    gl.GenVertexArrays(1, &opengl_data.vertex_array);
+    
+    uint32_t white = 0xffffffff;
+    glGenTextures(1, &opengl_data.white_texture);
+    glBindTexture(GL_TEXTURE_2D, opengl_data.white_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    
+    if (gl.QueryCounter && gl.GetQueryObjectui64v) {
+        gl.GenQueries(GAL_TIMING_MAX_QUERIES, opengl_data.timestamp_queries);
+    } else {
+        opengl_log_info("No timer queries, gal_begin_timing won't time anything");
+    }
+    return true;
+}
+
+static void opengl_destroy_pipeline(void) {
+    if (!gl.DeleteProgram) return;
+    
+    opengl_ring_destroy();
+    if (opengl_data.vertex_array) gl.DeleteVertexArrays(1, &opengl_data.vertex_array);
+    opengl_delete_program(&opengl_data.program);
+    if (opengl_data.white_texture) glDeleteTextures(1, &opengl_data.white_texture);
+    if (opengl_data.timestamp_queries[0]) gl.DeleteQueries(GAL_TIMING_MAX_QUERIES, opengl_data.timestamp_queries);
+    memset(opengl_data.timestamp_queries, 0, sizeof(opengl_data.timestamp_queries));
+    opengl_data.vertex_array = 0;
+    opengl_data.white_texture = 0;
+    draw_instance_stream_deinit(&opengl_data.stream);
+}
+
 // ================ CORE FUNCTIONS ================
 
 static GAL_Result opengl_initialize(void) {
@@ -110,6 +728,7 @@ static void opengl_shutdown(void) {
     
     // Destroy OpenGL context
     if (opengl_data.gl_context) {
+        opengl_destroy_pipeline();
         SDL_GL_DeleteContext(opengl_data.gl_context);
         opengl_data.gl_context = NULL;
     }
@@ -138,9 +757,12 @@ static GAL_Result opengl_create_window(GAL_Window_Desc* desc) {
         return GAL_RESULT_ERROR_INVALID_PARAMETER;
     }
     
-    // Set GL attributes
+    // Set GL attributes, 3.3 core for instancing and GLSL 330
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     check_sdl_errors("SDL_GL_SetAttribute");
     opengl_log_verbose("SDL GL attributes set");
     
@@ -204,6 +826,18 @@ static GAL_Result opengl_create_window(GAL_Window_Desc* desc) {
     opengl_log_info("OpenGL Vendor: %s", glGetString(GL_VENDOR));
     opengl_log_info("OpenGL Renderer: %s", glGetString(GL_RENDERER));
     
+    if (!opengl_load_functions() || !opengl_create_pipeline()) {
+        opengl_log_error("OpenGL 3.3 is needed to draw");
+        opengl_destroy_pipeline();
+        SDL_GL_DeleteContext(opengl_data.gl_context);
+        opengl_data.gl_context = NULL;
+        if (!desc->existing_window) {
+            SDL_DestroyWindow(opengl_data.window);
+        }
+        opengl_data.window = NULL;
+        return GAL_RESULT_ERROR_INITIALIZATION_FAILED;
+    }
+    
     return GAL_RESULT_SUCCESS;
 }
 
@@ -217,6 +851,7 @@ static void opengl_destroy_window(void) {
     
     // Destroy OpenGL context
     if (opengl_data.gl_context) {
+        opengl_destroy_pipeline();
         SDL_GL_DeleteContext(opengl_data.gl_context);
         opengl_data.gl_context = NULL;
     }
@@ -263,17 +898,28 @@ static void opengl_present(void) {
     
     opengl_log_verbose("Presenting frame");
     SDL_GL_SwapWindow(opengl_data.window);
+    opengl_ring_end_frame();
+    opengl_data.stats.frames += 1;
 }
 
 // ================ RESOURCE MANAGEMENT ================
 
+static void opengl_texture_formats(uint32_t channels, GLint* internal_format, GLenum* format) {
+    switch (channels) {
+        case 1:  *internal_format = GL_R8;    *format = GL_RED;  break;
+        case 2:  *internal_format = GL_RG8;   *format = GL_RG;   break;
+        case 3:  *internal_format = GL_RGB8;  *format = GL_RGB;  break;
+        default: *internal_format = GL_RGBA8; *format = GL_RGBA; break;
+    }
+}
+
 static GAL_Texture_Handle opengl_create_texture(GAL_Texture_Desc* desc, Allocator allocator) {
-    if (!opengl_data.initialized) {
+    if (!opengl_data.initialized || !opengl_data.gl_context) {
         opengl_log_error("OpenGL renderer not initialized");
         return NULL;
     }
     
-    if (!desc) {
+    if (!desc || desc->width == 0 || desc->height == 0) {
         opengl_log_error("Invalid parameters");
         return NULL;
     }
@@ -281,52 +927,122 @@ static GAL_Texture_Handle opengl_create_texture(GAL_Texture_Desc* desc, Allocato
     opengl_log_verbose("Creating texture: %dx%d, %d channels, render target: %s",
                       desc->width, desc->height, desc->channels, desc->is_render_target ? "yes" : "no");
     
-    // For now, just allocate memory for software fallback
-    // In a real implementation, we'd create OpenGL textures and framebuffers
-    size_t size = (size_t)desc->width * desc->height * desc->channels;
-    void* buffer = Alloc(allocator, size);
-    
-    if (!buffer) {
+    OpenGL_Texture* texture = (OpenGL_Texture*)Alloc(allocator, sizeof(OpenGL_Texture));
+    if (!texture) {
         opengl_log_error("Failed to allocate texture memory");
         return NULL;
     }
+    texture->width = desc->width;
+    texture->height = desc->height;
+    texture->channels = desc->channels ? desc->channels : 4;
+    texture->is_render_target = desc->is_render_target;
     
-    // Initialize with initial data if provided
-    if (desc->initial_data) {
-        memcpy(buffer, desc->initial_data, size);
-    } else {
-        memset(buffer, 0, size);
+    GLint internal_format;
+    GLenum format;
+    opengl_texture_formats(texture->channels, &internal_format, &format);
+    
+    glGenTextures(1, &texture->id);
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, desc->width, desc->height, 0, format, GL_UNSIGNED_BYTE, desc->initial_data);
+    // Filtering is picked per quad in the shader
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (texture->channels <= 2) {
+        // Like the software renderer, fewer channels are the first one everywhere
+        GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, GL_RED };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
     }
     
-    opengl_log_verbose("Texture created with software fallback");
-    return buffer;
+    uint64_t size = (uint64_t)desc->width*desc->height*texture->channels;
+    if (desc->initial_data) {
+        opengl_data.stats.texture_uploads += 1;
+        opengl_data.stats.texture_upload_bytes += size;
+    }
+    opengl_data.stats.texture_count += 1;
+    opengl_data.stats.texture_bytes += size;
+    return (GAL_Texture_Handle)texture;
 }
 
-static void opengl_update_texture(GAL_Texture_Handle texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* data) {
-    if (!opengl_data.initialized || !texture || !data) {
+static void opengl_update_texture(GAL_Texture_Handle handle, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* data) {
+    if (!opengl_data.initialized || !handle || !data) {
         opengl_log_error("Invalid parameters");
         return;
     }
     
-    opengl_log_verbose("Updating texture at (%d,%d) with size %dx%d", x, y, width, height);
+    OpenGL_Texture* texture = (OpenGL_Texture*)handle;
+    GLint internal_format;
+    GLenum format;
+    opengl_texture_formats(texture->channels, &internal_format, &format);
+    
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, data);
     
-    // In a real implementation, we'd update the OpenGL texture
-    opengl_log_warning("Texture update not fully implemented");
+    opengl_data.stats.texture_uploads += 1;
+    opengl_data.stats.texture_upload_bytes += (uint64_t)width*height*texture->channels;
 }
 
-static void opengl_destroy_texture(GAL_Texture_Handle texture, Allocator allocator) {
-    if (!opengl_data.initialized || !texture) {
+static void opengl_destroy_texture(GAL_Texture_Handle handle, Allocator allocator) {
+    if (!opengl_data.initialized || !handle) {
         opengl_log_error("Invalid parameters");
         return;
     }
     
     opengl_log_verbose("Destroying texture");
     
-    // Free the software buffer
+    OpenGL_Texture* texture = (OpenGL_Texture*)handle;
+    if (opengl_data.gl_context) {
+        if (texture->framebuffer) gl.DeleteFramebuffers(1, &texture->framebuffer);
+        glDeleteTextures(1, &texture->id);
+    }
+    opengl_data.stats.texture_count -= 1;
+    opengl_data.stats.texture_bytes -= (uint64_t)texture->width*texture->height*texture->channels;
     Dealloc(allocator, texture);
     opengl_log_verbose("Texture destroyed");
 }
 
+// Binds a framebuffer with the texture in it, made the first time
+static bool opengl_bind_texture_framebuffer(OpenGL_Texture* texture) {
+    if (!texture->framebuffer) {
+        gl.GenFramebuffers(1, &texture->framebuffer);
+        gl.BindFramebuffer(GL_FRAMEBUFFER, texture->framebuffer);
+        gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->id, 0);
+        if (gl.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            opengl_log_error("Can't draw to a %ux%u texture with %u channels", texture->width, texture->height, texture->channels);
+            gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+            gl.DeleteFramebuffers(1, &texture->framebuffer);
+            texture->framebuffer = 0;
+            return false;
+        }
+        return true;
+    }
+    gl.BindFramebuffer(GL_FRAMEBUFFER, texture->framebuffer);
+    return true;
+}
+
+static void opengl_read_texture(GAL_Texture_Handle handle, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* output) {
+    OpenGL_Texture* texture = (OpenGL_Texture*)handle;
+    if (!opengl_data.gl_context || !texture || !output || x >= texture->width || y >= texture->height) {
+        return;
+    }
+    if (!opengl_bind_texture_framebuffer(texture)) return;
+    
+    GLint internal_format;
+    GLenum format;
+    opengl_texture_formats(texture->channels, &internal_format, &format);
+    uint32_t copy_width  = texture->width - x < width ? texture->width - x : width;
+    uint32_t copy_height = texture->height - y < height ? texture->height - y : height;
+    
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glPixelStorei(GL_PACK_ROW_LENGTH, width);
+    glReadPixels(x, y, copy_width, copy_height, format, GL_UNSIGNED_BYTE, output);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
 // ================ RENDERING FUNCTIONS ================
 
 static void opengl_begin_frame(void) {
@@ -353,16 +1069,159 @@ static void opengl_end_frame(void) {
     // No additional work needed here, presenting is done in opengl_present
 }
 
+static void opengl_set_instance_attributes(uint64_t instances_offset, uint64_t extras_offset, bool has_extras) {
+    uintptr_t base = (uintptr_t)instances_offset;
+    GLsizei stride = sizeof(Draw_Quad_Instance);
+    gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(Draw_Quad_Instance, origin)));
+    gl.VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(Draw_Quad_Instance, axis_x)));
+    gl.VertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(Draw_Quad_Instance, axis_y)));
+    gl.VertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(base + offsetof(Draw_Quad_Instance, color)));
+    gl.VertexAttribPointer(4, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)(base + offsetof(Draw_Quad_Instance, uv)));
+    // texture_index, scissor_index, type and flags, texture_slot as 4 u16's
+    gl.VertexAttribIPointer(5, 4, GL_UNSIGNED_SHORT, stride, (void*)(base + offsetof(Draw_Quad_Instance, texture_index)));
+    if (has_extras) {
+        gl.EnableVertexAttribArray(6);
+        gl.VertexAttribPointer(6, 2, GL_FLOAT, GL_FALSE, sizeof(Draw_Quad_Instance_Extra), (void*)((uintptr_t)extras_offset + offsetof(Draw_Quad_Instance_Extra, top_right)));
+    } else {
+        gl.DisableVertexAttribArray(6);
+        gl.VertexAttrib2f(6, 0, 0);
+    }
+}
+
+// Instances [first, first+count) of the call, with slot_base set and its textures bound
+static void opengl_draw_instances(Draw_Instance_Stream* stream, uint64_t first, uint64_t count) {
+    bool has_extras = stream->extras.count > 0;
+    uint64_t max_per_push = opengl_data.ring.region_size/(sizeof(Draw_Quad_Instance) + (has_extras ? sizeof(Draw_Quad_Instance_Extra) : 0) + 2*OPENGL_STREAM_ALIGNMENT);
+    if (max_per_push == 0) return;
+    
+    while (count > 0) {
+        uint64_t n = count < max_per_push ? count : max_per_push;
+        const void* parts[2] = { &stream->instances.data[first], has_extras ? (const void*)&stream->extras.data[first] : NULL };
+        uint64_t sizes[2] = { n*sizeof(Draw_Quad_Instance), n*sizeof(Draw_Quad_Instance_Extra) };
+        uint64_t offsets[2];
+        if (!opengl_ring_push(parts, sizes, has_extras ? 2 : 1, offsets)) return;
+        
+        opengl_set_instance_attributes(offsets[0], offsets[1], has_extras);
+        gl.DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)n);
+        opengl_data.stream_stats.draw_calls += 1;
+        first += n;
+        count -= n;
+    }
+}
+
+static void opengl_bind_call_textures(Draw_Instance_Stream* stream, Draw_Call* call, uint32_t first_slot) {
+    uint32_t count = call->texture_count - first_slot;
+    if (count > opengl_data.texture_slots) count = opengl_data.texture_slots;
+    for (uint32_t i = 0; i < count; i++) {
+        Gal_Image* image = stream->textures.data[call->textures[first_slot + i]];
+        OpenGL_Texture* texture = image ? (OpenGL_Texture*)image->gal_handle : NULL;
+        gl.ActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, texture ? texture->id : opengl_data.white_texture);
+    }
+    gl.Uniform1i(opengl_data.current_program->slot_base_location, (GLint)first_slot);
+}
+
+// Draws the stream to whatever framebuffer is bound, which is width x height pixels
+static void opengl_draw_stream(Draw_Instance_Stream* stream, uint32_t width, uint32_t height) {
+    if (!opengl_data.program.id || !opengl_data.ring.buffer) return;
+    
+    opengl_data.stats.quads += stream->instances.count;
+    opengl_data.stats.draw_calls += stream->calls.count;
+    opengl_data.stream_stats.instances += stream->instances.count;
+    if (stream->instances.count == 0) return;
+    
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    gl.BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    
+    // A Draw_Frame has one shader extension, used for all of it
+    OpenGL_Program* program = stream->shader_extension.ps ? (OpenGL_Program*)stream->shader_extension.ps : &opengl_data.program;
+    opengl_data.current_program = program;
+    gl.UseProgram(program->id);
+    if (program->cbuffer && stream->cbuffer) {
+        gl.BindBuffer(GL_UNIFORM_BUFFER, program->cbuffer);
+        gl.BufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)program->cbuffer_size, stream->cbuffer);
+        gl.BindBufferBase(GL_UNIFORM_BUFFER, 0, program->cbuffer);
+    }
+    gl.BindVertexArray(opengl_data.vertex_array);
+    for (GLuint i = 0; i <= 5; i++) {
+        gl.EnableVertexAttribArray(i);
+    }
+    for (GLuint i = 0; i <= 6; i++) {
+        gl.VertexAttribDivisor(i, 1);
+    }
+    
+    // The whole stream in one push when it fits, which it always does once the ring has
+    // grown to the size of the frames. Otherwise call by call.
+    bool has_extras = stream->extras.count > 0;
+    const void* parts[2] = { stream->instances.data, stream->extras.data };
+    uint64_t sizes[2] = { stream->instances.count*sizeof(Draw_Quad_Instance), stream->extras.count*sizeof(Draw_Quad_Instance_Extra) };
+    uint64_t offsets[2];
+    bool pushed = opengl_ring_push(parts, sizes, has_extras ? 2 : 1, offsets);
+    
+    for (uint64_t c = 0; c < stream->calls.count; c++) {
+        Draw_Call* call = &stream->calls.data[c];
+        
+        if (call->scissor_index != DRAW_INSTANCE_NO_SCISSOR) {
+            Vector4 scissor = stream->scissors.data[call->scissor_index];
+            GLint x = (GLint)floorf(scissor.x), y = (GLint)floorf(scissor.y);
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(x, y, (GLsizei)max(0, (GLint)ceilf(scissor.z) - x), (GLsizei)max(0, (GLint)ceilf(scissor.w) - y));
+        } else {
+            glDisable(GL_SCISSOR_TEST);
+        }
+        
+        // Calls with more textures than there are units are drawn in runs of instances
+        // whose slots are bound at the same time
+        uint64_t first = call->first_instance, end = first + call->instance_count;
+        while (first < end) {
+            uint64_t run_end = end;
+            uint32_t first_slot = 0;
+            if (call->texture_count > opengl_data.texture_slots) {
+                Draw_Quad_Instance* instances = stream->instances.data;
+                first_slot = (instances[first].texture_index == DRAW_INSTANCE_NO_TEXTURE) ? 0 : instances[first].texture_slot/opengl_data.texture_slots*opengl_data.texture_slots;
+                for (run_end = first + 1; run_end < end; run_end++) {
+                    Draw_Quad_Instance* inst = &instances[run_end];
+                    if (inst->texture_index != DRAW_INSTANCE_NO_TEXTURE && (inst->texture_slot < first_slot || inst->texture_slot >= first_slot + opengl_data.texture_slots)) break;
+                }
+            }
+            opengl_bind_call_textures(stream, call, first_slot);
+            
+            if (pushed) {
+                opengl_set_instance_attributes(offsets[0] + first*sizeof(Draw_Quad_Instance), has_extras ? offsets[1] + first*sizeof(Draw_Quad_Instance_Extra) : 0, has_extras);
+                gl.DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)(run_end - first));
+                opengl_data.stream_stats.draw_calls += 1;
+            } else {
+                opengl_draw_instances(stream, first, run_end - first);
+            }
+            first = run_end;
+        }
+    }
+    
+    glDisable(GL_SCISSOR_TEST);
+    gl.BindVertexArray(0);
+}
+
+// For render_draw_frame(_to_window) called directly, gal packs frames itself and goes
+// through render_instances
+static void opengl_draw_frame(Draw_Frame* frame, uint32_t width, uint32_t height) {
+    if (frame->enable_z_sorting) draw_frame_sort_by_z(frame);
+    draw_frame_build_instance_stream(frame, &opengl_data.stream);
+    opengl_draw_stream(&opengl_data.stream, width, height);
+}
+
 static void opengl_render_draw_frame(Draw_Frame* frame, GAL_Texture_Handle target) {
-    if (!opengl_data.initialized || !frame) {
+    if (!opengl_data.initialized || !opengl_data.gl_context || !frame || !target) {
         opengl_log_error("Invalid parameters");
         return;
     }
     
-    opengl_log_verbose("Rendering draw frame to texture target");
-    
-    // Not implemented yet
-    opengl_log_warning("Rendering to texture not implemented yet");
+    OpenGL_Texture* texture = (OpenGL_Texture*)target;
+    if (!opengl_bind_texture_framebuffer(texture)) return;
+    opengl_draw_frame(frame, texture->width, texture->height);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 static void opengl_render_draw_frame_to_window(Draw_Frame* frame) {
@@ -371,58 +1230,65 @@ static void opengl_render_draw_frame_to_window(Draw_Frame* frame) {
         return;
     }
     
-    opengl_log_verbose("Rendering draw frame to window");
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+    opengl_draw_frame(frame, opengl_data.screen_width, opengl_data.screen_height);
+}
+
+static void opengl_render_instances(Draw_Instance_Stream* stream, GAL_Texture_Handle target) {
+    if (!opengl_data.initialized || !opengl_data.gl_context || !stream) {
+        opengl_log_error("Invalid parameters");
+        return;
+    }
     
-    // Very simple rendering - just for demonstration
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho(0, opengl_data.screen_width, opengl_data.screen_height, 0, -1, 1);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+    if (!target) {
+        gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+        opengl_draw_stream(stream, opengl_data.screen_width, opengl_data.screen_height);
+        return;
+    }
     
-    // Draw a simple triangle
-    glBegin(GL_TRIANGLES);
-    glColor3f(1.0f, 0.0f, 0.0f); glVertex2f((float)opengl_data.screen_width/2.0f, 100.0f);
-    glColor3f(0.0f, 1.0f, 0.0f); glVertex2f(100.0f, (float)opengl_data.screen_height-100.0f);
-    glColor3f(0.0f, 0.0f, 1.0f); glVertex2f((float)opengl_data.screen_width-100.0f, (float)opengl_data.screen_height-100.0f);
-    glEnd();
-    opengl_log_verbose("Triangle drawn");
+    OpenGL_Texture* texture = (OpenGL_Texture*)target;
+    if (!opengl_bind_texture_framebuffer(texture)) return;
+    opengl_draw_stream(stream, texture->width, texture->height);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 static void opengl_clear_render_target(GAL_RenderTarget_Handle target, float r, float g, float b, float a) {
-    if (!opengl_data.initialized) {
+    if (!opengl_data.initialized || !opengl_data.gl_context) {
         opengl_log_error("OpenGL renderer not initialized");
         return;
     }
     
-    opengl_log_verbose("Clearing render target");
-    
     // If the target is NULL, we clear the default framebuffer (window)
     if (!target) {
+        gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
         glClearColor(r, g, b, a);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         return;
     }
     
-    // Otherwise, we need to bind the framebuffer and then clear it
-    // Not implemented yet
-    opengl_log_warning("Clearing specific render target not implemented yet");
+    if (!opengl_bind_texture_framebuffer((OpenGL_Texture*)target)) return;
+    glClearColor(r, g, b, a);
+    glClear(GL_COLOR_BUFFER_BIT);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 // ================ ADVANCED FUNCTIONS ================
 
+// The source is GLSL that goes into the fragment shader, see the top of the file
 static GAL_Result opengl_compile_shader(string source_code, uint64_t cbuffer_size, void** shader_object) {
-    if (!opengl_data.initialized || !source_code.data || !shader_object) {
+    if (!opengl_data.initialized || !opengl_data.program.id || !source_code.data || !shader_object) {
         opengl_log_error("Invalid parameters");
         return GAL_RESULT_ERROR_INVALID_PARAMETER;
     }
     
-    opengl_log_verbose("Compiling shader, buffer size: %llu", cbuffer_size);
-    opengl_log_warning("Shader compilation not implemented yet");
-    
-    // Not implemented
-    *shader_object = NULL;
-    return GAL_RESULT_ERROR_NOT_IMPLEMENTED;
+    OpenGL_Program* program = (OpenGL_Program*)Alloc(GetHeapAllocator(), sizeof(OpenGL_Program));
+    if (!opengl_build_program(source_code, cbuffer_size, program)) {
+        Dealloc(GetHeapAllocator(), program);
+        *shader_object = NULL;
+        return GAL_RESULT_ERROR_INVALID_PARAMETER;
+    }
+    *shader_object = program;
+    return GAL_RESULT_SUCCESS;
 }
 
 static void opengl_destroy_shader(void* shader_object) {
@@ -431,22 +1297,119 @@ static void opengl_destroy_shader(void* shader_object) {
         return;
     }
     
-    opengl_log_verbose("Destroying shader");
-    opengl_log_warning("Shader destruction not implemented yet");
+    OpenGL_Program* program = (OpenGL_Program*)shader_object;
+    if (opengl_data.current_program == program) opengl_data.current_program = &opengl_data.program;
+    opengl_delete_program(program);
+    Dealloc(GetHeapAllocator(), program);
+}
+
+// The blob is the binary format followed by what glGetProgramBinary gives
+static bool opengl_get_shader_binary(void* shader_object, Allocator allocator, string* binary) {
+    OpenGL_Program* program = (OpenGL_Program*)shader_object;
+    if (!opengl_data.has_program_binary || !program || !program->id || !binary) {
+        return false;
+    }
+    
+    GLint size = 0;
+    gl.GetProgramiv(program->id, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0) {
+        return false;
+    }
+    
+    uint8_t* data = (uint8_t*)alloc_uninitialized(allocator, sizeof(GLenum) + (uint64_t)size);
+    GLenum format = 0;
+    GLsizei written = 0;
+    gl.GetProgramBinary(program->id, size, &written, &format, data + sizeof(GLenum));
+    if (written <= 0) {
+        Dealloc(allocator, data);
+        return false;
+    }
+    memcpy(data, &format, sizeof(GLenum));
+    binary->data = data;
+    binary->count = sizeof(GLenum) + (uint64_t)written;
+    return true;
+}
+
+static GAL_Result opengl_load_shader_binary(string binary, uint64_t cbuffer_size, void** shader_object) {
+    if (!opengl_data.initialized || !shader_object) {
+        return GAL_RESULT_ERROR_INVALID_PARAMETER;
+    }
+    if (!opengl_data.has_program_binary || binary.count <= sizeof(GLenum)) {
+        return GAL_RESULT_ERROR_FORMAT_NOT_SUPPORTED;
+    }
     
-    // Not implemented
+    GLenum format;
+    memcpy(&format, binary.data, sizeof(GLenum));
+    GLuint id = gl.CreateProgram();
+    gl.ProgramBinary(id, format, binary.data + sizeof(GLenum), (GLsizei)(binary.count - sizeof(GLenum)));
+    
+    // Drivers turn down binaries from other versions of themselves
+    GLint linked = 0;
+    gl.GetProgramiv(id, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        gl.DeleteProgram(id);
+        return GAL_RESULT_ERROR_FORMAT_NOT_SUPPORTED;
+    }
+    
+    OpenGL_Program* program = (OpenGL_Program*)Alloc(GetHeapAllocator(), sizeof(OpenGL_Program));
+    opengl_setup_program(id, cbuffer_size, program);
+    *shader_object = program;
+    return GAL_RESULT_SUCCESS;
+}
+
+static string opengl_get_shader_cache_id(void) {
+    return STR(opengl_data.shader_cache_id);
 }
 
+// Bytes per frame. Instances are 48 bytes, see the top of the file.
 static void opengl_reserve_vertex_buffer(uint64_t bytes) {
     if (!opengl_data.initialized) {
         opengl_log_error("OpenGL renderer not initialized");
         return;
     }
     
+    OpenGL_Stream_Ring* ring = &opengl_data.ring;
+    if (bytes <= ring->reserved_size) return;
+    ring->reserved_size = bytes;
     opengl_log_verbose("Reserving %llu bytes for vertex buffer", bytes);
-    opengl_log_warning("Vertex buffer reservation not implemented yet");
     
-    // Not implemented
+    // Not in the middle of a frame, that's done in opengl_ring_end_frame
+    if (ring->buffer && !ring->region_ready && bytes > ring->region_size) {
+        opengl_ring_resize(bytes);
+    }
+}
+
+static void opengl_get_stats(GAL_Stats* stats) {
+    *stats = opengl_data.stats;
+}
+
+// ================ TIMING ================
+
+static void opengl_write_timestamp(uint32_t query) {
+    if (query >= GAL_TIMING_MAX_QUERIES || !opengl_data.timestamp_queries[query]) return;
+    gl.QueryCounter(opengl_data.timestamp_queries[query], GL_TIMESTAMP);
+}
+
+static bool opengl_read_timestamp(uint32_t query, uint64_t* nanoseconds) {
+    if (query >= GAL_TIMING_MAX_QUERIES || !opengl_data.timestamp_queries[query]) return false;
+    
+    GLint available = 0;
+    gl.GetQueryObjectiv(opengl_data.timestamp_queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+    
+    GLuint64 time = 0;
+    gl.GetQueryObjectui64v(opengl_data.timestamp_queries[query], GL_QUERY_RESULT, &time);
+    *nanoseconds = time;
+    return true;
+}
+
+static bool opengl_get_timestamp(uint64_t* nanoseconds) {
+    if (!opengl_data.timestamp_queries[0]) return false;
+    
+    GLint64 time = 0;
+    gl.GetInteger64v(GL_TIMESTAMP, &time);
+    *nanoseconds = (uint64_t)time;
+    return true;
 }
 
 // Create and return the OpenGL renderer implementation
@@ -475,18 +1438,27 @@ GAL_Renderer opengl_create_renderer(void) {
     renderer.create_texture = opengl_create_texture;
     renderer.update_texture = opengl_update_texture;
     renderer.destroy_texture = opengl_destroy_texture;
+    renderer.read_texture = opengl_read_texture;
     
     // Set up rendering functions
     renderer.begin_frame = opengl_begin_frame;
     renderer.end_frame = opengl_end_frame;
     renderer.render_draw_frame = opengl_render_draw_frame;
     renderer.render_draw_frame_to_window = opengl_render_draw_frame_to_window;
+    renderer.render_instances = opengl_render_instances;
     renderer.clear_render_target = opengl_clear_render_target;
     
     // Set up advanced functions
     renderer.compile_shader = opengl_compile_shader;
     renderer.destroy_shader = opengl_destroy_shader;
+    renderer.get_shader_binary = opengl_get_shader_binary;
+    renderer.load_shader_binary = opengl_load_shader_binary;
+    renderer.get_shader_cache_id = opengl_get_shader_cache_id;
+    renderer.write_timestamp = opengl_write_timestamp;
+    renderer.read_timestamp = opengl_read_timestamp;
+    renderer.get_timestamp = opengl_get_timestamp;
     renderer.reserve_vertex_buffer = opengl_reserve_vertex_buffer;
+    renderer.get_stats = opengl_get_stats;
     
     // Set up implementation data
     renderer.implementation_data = &opengl_data;
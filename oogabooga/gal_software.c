@@ -9,6 +9,33 @@
 typedef struct Draw_Frame Draw_Frame;
 extern Draw_Frame drawFrame;
 
+typedef enum {
+    // Picks the best one the first time something is drawn
+    SOFTWARE_RASTER_PATH_AUTO = 0,
+    SOFTWARE_RASTER_PATH_SCALAR,
+    SOFTWARE_RASTER_PATH_SSE2,
+    SOFTWARE_RASTER_PATH_AVX2,
+} Software_Raster_Path;
+
+typedef struct {
+    uint64_t quads_drawn;
+    // Degenerate, transparent or outside the target and scissor
+    uint64_t quads_skipped;
+    // Pixels in the bounding boxes, and how many of those were inside
+    uint64_t pixels_tested;
+    uint64_t pixels_written;
+    // Tiles with something in them, and how many quads they had in total. Quads over
+    // several tiles count once for each.
+    uint64_t tiles_drawn;
+    uint64_t tile_quads;
+} Software_Raster_Stats;
+
+typedef struct {
+    // Range in Software_Data.tile_quads
+    uint32_t first, count;
+    uint64_t pixels_written;
+} Software_Tile;
+
 // Software renderer implementation data
 typedef struct {
     SDL_Window* window;
@@ -18,11 +45,27 @@ typedef struct {
     uint32_t screen_height;
     bool initialized;
     bool window_created;
+    Software_Raster_Path raster_path;
+    Software_Raster_Stats raster_stats;
+    // Tiles are drawn on this pool, 0 means get_job_pool()
+    Job_Pool* raster_job_pool;
+    
+    // Kept between frames so they're only allocated when a frame has more than before
+    struct Software_Raster_Quad* raster_quads;
+    uint64_t raster_quad_capacity;
+    Software_Tile* tiles;
+    uint64_t tile_capacity;
+    uint32_t* tile_quads;
+    uint64_t tile_quad_capacity;
+    // gal_begin_timing queries, CPU time in nanoseconds since everything is drawn on the spot
+    uint64_t timestamps[GAL_TIMING_MAX_QUERIES];
 } Software_Data;
 
 // Static instance of the implementation data
 static Software_Data software_data = {0};
 
+static Software_Raster_Path software_best_raster_path(void);
+
 // ================ LOGGING FUNCTIONS ================
 
 static void software_log_verbose(const char* fmt, ...) {
@@ -87,6 +130,10 @@ static GAL_Result software_initialize(void) {
     }
     software_log_verbose("SDL video subsystem initialized");
     
+    software_data.raster_path = software_best_raster_path();
+    software_log_verbose("Rasterising with %s", software_data.raster_path == SOFTWARE_RASTER_PATH_AVX2 ? "AVX2"
+                         : software_data.raster_path == SOFTWARE_RASTER_PATH_SSE2 ? "SSE2" : "scalar code");
+    
     software_data.initialized = true;
     return GAL_RESULT_SUCCESS;
 }
@@ -111,6 +158,15 @@ static void software_shutdown(void) {
         software_data.window = NULL;
     }
     
+    Allocator heap = GetHeapAllocator();
+    if (software_data.raster_quads) Dealloc(heap, software_data.raster_quads);
+    if (software_data.tiles) Dealloc(heap, software_data.tiles);
+    if (software_data.tile_quads) Dealloc(heap, software_data.tile_quads);
+    software_data.raster_quads = NULL;
+    software_data.tiles = NULL;
+    software_data.tile_quads = NULL;
+    software_data.raster_quad_capacity = software_data.tile_capacity = software_data.tile_quad_capacity = 0;
+    
     // Quit SDL
     SDL_Quit();
     
@@ -245,6 +301,34 @@ static void software_present(void) {
 
 // ================ RESOURCE MANAGEMENT ================
 
+// Textures are always 32 bit RGBA surfaces. 1 channel images become (v, v, v, v) and 3 channel
+// images get alpha 255.
+static void software_write_texture_pixels(SDL_Surface* surface, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) {
+    uint32_t channels = (uint32_t)(uintptr_t)surface->userdata;
+    uint32_t copy_width  = (uint32_t)surface->w - x < width  ? (uint32_t)surface->w - x : width;
+    uint32_t copy_height = (uint32_t)surface->h - y < height ? (uint32_t)surface->h - y : height;
+    
+    for (uint32_t row = 0; row < copy_height; row++) {
+        const uint8_t* src = data + (uint64_t)row*width*channels;
+        uint8_t* dst = (uint8_t*)surface->pixels + (uint64_t)(y + row)*surface->pitch + (uint64_t)x*4;
+        
+        if (channels == 4) {
+            memcpy(dst, src, (uint64_t)copy_width*4);
+        } else if (channels == 3) {
+            for (uint32_t i = 0; i < copy_width; i++) {
+                dst[i*4+0] = src[i*3+0];
+                dst[i*4+1] = src[i*3+1];
+                dst[i*4+2] = src[i*3+2];
+                dst[i*4+3] = 255;
+            }
+        } else {
+            for (uint32_t i = 0; i < copy_width; i++) {
+                dst[i*4+0] = dst[i*4+1] = dst[i*4+2] = dst[i*4+3] = src[i*channels];
+            }
+        }
+    }
+}
+
 static GAL_Texture_Handle software_create_texture(GAL_Texture_Desc* desc, Allocator allocator) {
     if (!desc) {
         software_log_error("Invalid texture description");
@@ -267,14 +351,10 @@ static GAL_Texture_Handle software_create_texture(GAL_Texture_Desc* desc, Alloca
     #endif
     
     int depth = 32; // Always use 32 bits for consistency
-    int pitch = desc->width * 4; // 4 bytes per pixel (RGBA)
-    
-    SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(
-        desc->initial_data ? desc->initial_data : NULL,
-        desc->width,
-        desc->height,
-        depth,
-        pitch,
+    
+    // The surface owns its pixels, the caller's data may be freed or have another channel count
+    SDL_Surface* surface = SDL_CreateRGBSurface(
+        0, desc->width, desc->height, depth,
         rmask, gmask, bmask, amask
     );
     
@@ -282,26 +362,13 @@ static GAL_Texture_Handle software_create_texture(GAL_Texture_Desc* desc, Alloca
         software_log_error("Failed to create texture surface: %s", SDL_GetError());
         return NULL;
     }
+    surface->userdata = (void*)(uintptr_t)(desc->channels ? desc->channels : 4);
     
-    // If we don't have initial data, we need to create a copy
-    if (!desc->initial_data) {
-        SDL_Surface* temp_surface = SDL_CreateRGBSurface(
-            0, desc->width, desc->height, depth,
-            rmask, gmask, bmask, amask
-        );
-        
-        if (!temp_surface) {
-            software_log_error("Failed to create temporary surface: %s", SDL_GetError());
-            SDL_FreeSurface(surface);
-            return NULL;
-        }
-        
+    if (desc->initial_data) {
+        software_write_texture_pixels(surface, 0, 0, desc->width, desc->height, (const uint8_t*)desc->initial_data);
+    } else {
         // Fill with black transparent
-        SDL_FillRect(temp_surface, NULL, SDL_MapRGBA(temp_surface->format, 0, 0, 0, 0));
-        
-        // Free the original surface
-        SDL_FreeSurface(surface);
-        surface = temp_surface;
+        SDL_FillRect(surface, NULL, SDL_MapRGBA(surface->format, 0, 0, 0, 0));
     }
     
     software_log_verbose("Created texture %dx%d with %d channels", desc->width, desc->height, desc->channels);
@@ -318,33 +385,67 @@ static void software_update_texture(GAL_Texture_Handle texture, uint32_t x, uint
         return;
     }
     
-    // Create a temporary surface from the provided data
-    SDL_Surface* temp_surface = SDL_CreateRGBSurfaceFrom(
-        data,
-        width, height,
-        surface->format->BitsPerPixel,
-        width * (surface->format->BitsPerPixel / 8),
-        surface->format->Rmask,
-        surface->format->Gmask,
-        surface->format->Bmask,
-        surface->format->Amask
-    );
+    software_write_texture_pixels(surface, x, y, width, height, (const uint8_t*)data);
+}
+
+static void software_read_texture(GAL_Texture_Handle texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* output) {
+    if (!texture || !output) {
+        return;
+    }
     
-    if (!temp_surface) {
-        software_log_error("Failed to create temporary surface for update: %s", SDL_GetError());
+    SDL_Surface* surface = (SDL_Surface*)texture;
+    if (x >= (uint32_t)surface->w || y >= (uint32_t)surface->h) {
         return;
     }
     
-    // Create destination rectangle
-    SDL_Rect dest_rect = { (int)x, (int)y, (int)width, (int)height };
+    // The other way around from software_write_texture_pixels
+    uint32_t channels = (uint32_t)(uintptr_t)surface->userdata;
+    uint32_t copy_width  = (uint32_t)surface->w - x < width  ? (uint32_t)surface->w - x : width;
+    uint32_t copy_height = (uint32_t)surface->h - y < height ? (uint32_t)surface->h - y : height;
     
-    // Blit the temporary surface to our texture
-    if (SDL_BlitSurface(temp_surface, NULL, surface, &dest_rect) != 0) {
-        software_log_error("Failed to update texture: %s", SDL_GetError());
+    for (uint32_t row = 0; row < copy_height; row++) {
+        const uint8_t* src = (const uint8_t*)surface->pixels + (uint64_t)(y + row)*surface->pitch + (uint64_t)x*4;
+        uint8_t* dst = (uint8_t*)output + (uint64_t)row*width*channels;
+        
+        if (channels == 4) {
+            memcpy(dst, src, (uint64_t)copy_width*4);
+        } else {
+            for (uint32_t i = 0; i < copy_width; i++) {
+                for (uint32_t c = 0; c < channels; c++) dst[i*channels+c] = src[i*4+c];
+            }
+        }
+    }
+}
+
+static void software_pixel_view(SDL_Surface* surface, bool rows_from_top, GAL_Pixel_View* view) {
+    view->pixels = surface->pixels;
+    view->width  = (uint32_t)surface->w;
+    view->height = (uint32_t)surface->h;
+    view->pitch  = (uint32_t)surface->pitch;
+    view->r_mask = surface->format->Rmask;
+    view->g_mask = surface->format->Gmask;
+    view->b_mask = surface->format->Bmask;
+    view->a_mask = surface->format->Amask;
+    view->rows_from_top = rows_from_top;
+}
+
+static bool software_get_texture_pixels(GAL_Texture_Handle texture, GAL_Pixel_View* view) {
+    if (!texture || !view) {
+        return false;
+    }
+    
+    software_pixel_view((SDL_Surface*)texture, false, view);
+    return true;
+}
+
+// The render surface keeps the last frame until the next begin_frame clears it
+static bool software_get_framebuffer_pixels(GAL_Pixel_View* view) {
+    if (!view || !software_data.render_surface) {
+        return false;
     }
     
-    // Free temporary surface
-    SDL_FreeSurface(temp_surface);
+    software_pixel_view(software_data.render_surface, true, view);
+    return true;
 }
 
 static void software_destroy_texture(GAL_Texture_Handle texture, Allocator allocator) {
@@ -357,6 +458,945 @@ static void software_destroy_texture(GAL_Texture_Handle texture, Allocator alloc
     software_log_verbose("Destroyed texture");
 }
 
+// ================ RASTERISER ================
+
+/*
+    Draw_Frame's are drawn straight from their quad_buffer, in order (sorted by z first if the
+    frame has enable_z_sorting), into any 32 bit surface: the window's render surface or a
+    texture. Textures are drawn with their rows from the bottom, the same way their pixels are
+    uploaded and sampled, so a rendered texture draws the right way up.
+    
+    - gal draws through render_instances, with the frame packed into a Draw_Instance_Stream.
+      Each instance is unpacked to its corners, float color and uv and then goes the same way
+      as a Draw_Quad, so colors are 8 bit and uv's 16 bit like on the GPU. render_draw_frame
+      called directly takes the Draw_Quad's as they are.
+    
+    - Each quad is set up once: corners go to pixels, then come the 4 edge functions and
+      s, t (0..1 across the quad from the bottom left corner) as linear functions of the pixel
+      position. The uv is affine in s, t and circles test the distance to 0.5, 0.5. For quads
+      which aren't parallelograms s, t come from the bottom left, top left and bottom right
+      corners.
+    - The bounding box, cut to the target and the scissor, is walked row by row 4 pixels at a
+      time with SSE2 or 8 with AVX2, whichever is the best query_cpu_capabilities() has.
+      Each row first finds its run of pixels from the edges, so only the ends of the run
+      need masking. Pixel centers exactly on an edge only belong to a quad if it's a left or
+      top edge, so quads sharing an edge don't blend twice.
+    - Textures are sampled nearest or linear and clamped to the edge. image_min_filter is
+      used when the quad shows more than one texel per pixel, image_mag_filter otherwise.
+    - Blending is straight alpha, src*a + dst*(1-a). Text quads use the red channel of the
+      texture as coverage.
+    - The target is drawn in SOFTWARE_TILE_SIZE squares on the job pool. Quads are set up in
+      parallel, then binned in order into every tile their box touches. Each tile copies its
+      pixels to a buffer on the stack which stays in cache, draws its quads cut to the tile
+      and copies the pixels back. Tiles never share pixels and keep the order of the frame,
+      so the result is the same for any number of threads.
+    - software_data.raster_stats has what the last frame drew.
+*/
+
+#if COMPILER_GCC || COMPILER_CLANG
+    #define SOFTWARE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define SOFTWARE_TARGET_AVX2
+#endif
+
+#define SOFTWARE_TILE_SIZE 64
+
+typedef struct {
+    uint8_t* pixels;
+    // Pixel x, y of pixels[0], not 0 when drawing to a tile. pitch is negative when the rows
+    // are stored from the bottom.
+    int32_t x, y;
+    int32_t width, height, pitch;
+    // Where r, g, b, a are in a pixel. alpha_mask is 0 if the target has no alpha.
+    uint32_t shift_r, shift_g, shift_b, shift_a;
+    uint32_t alpha_mask;
+} Software_Target;
+
+typedef struct Software_Raster_Quad {
+    // a*x + b*y + c at the pixel center, the pixel is inside when all 4 are > 0, or == 0
+    // for edges in edge_owns (all bits set if it's a left or top edge).
+    float edge_a[4], edge_b[4], edge_c[4];
+    int32_t edge_owns[4];
+    // 1/edge_a, 0 for horizontal edges
+    float edge_inv_a[4];
+    float s_dx, s_dy, s_c;
+    float t_dx, t_dy, t_c;
+    // u and v in texels
+    float u_dx, u_dy, u_c;
+    float v_dx, v_dy, v_c;
+    // 0..1
+    float color[4];
+    const uint32_t* texels;
+    int32_t texture_width, texture_height, texture_pitch;
+    bool linear, circle, text;
+    // Untextured and opaque, the spans are just filled
+    bool solid;
+    uint32_t solid_pixel;
+    // Pixels to walk, x1 and y1 excluded
+    int32_t x0, y0, x1, y1;
+} Software_Raster_Quad;
+
+static uint32_t software_mask_shift(uint32_t mask) {
+    uint32_t shift = 0;
+    while (mask && !(mask & 1)) {
+        mask >>= 1;
+        shift += 1;
+    }
+    return shift;
+}
+
+// Rows are always walked from the top, for rows from the bottom the pitch is negative
+static Software_Target software_get_target(SDL_Surface* surface, bool rows_from_top) {
+    Software_Target target = {0};
+    target.pixels = (uint8_t*)surface->pixels;
+    target.width  = surface->w;
+    target.height = surface->h;
+    target.pitch  = surface->pitch;
+    if (!rows_from_top && surface->h > 0) {
+        target.pixels += (uint64_t)(surface->h - 1)*surface->pitch;
+        target.pitch = -surface->pitch;
+    }
+    target.shift_r = software_mask_shift(surface->format->Rmask);
+    target.shift_g = software_mask_shift(surface->format->Gmask);
+    target.shift_b = software_mask_shift(surface->format->Bmask);
+    target.shift_a = software_mask_shift(surface->format->Amask);
+    target.alpha_mask = surface->format->Amask;
+    return target;
+}
+
+static Software_Raster_Path software_best_raster_path(void) {
+#if SIMD_ENABLE_SSE2
+    Cpu_Capabilities caps = query_cpu_capabilities();
+    if (caps.avx2) return SOFTWARE_RASTER_PATH_AVX2;
+    if (caps.sse2) return SOFTWARE_RASTER_PATH_SSE2;
+#endif
+    return SOFTWARE_RASTER_PATH_SCALAR;
+}
+
+static inline float software_clamp(float x, float lo, float hi) {
+    // Same order as the simd max/min so NaN becomes lo in all paths
+    x = x > lo ? x : lo;
+    return x < hi ? x : hi;
+}
+
+// What setting up a quad needs, from a Draw_Quad or from a Draw_Quad_Instance
+typedef struct {
+    // Bottom left, top left, top right, bottom right in ndc
+    Vector2 corners[4];
+    Vector4 color;
+    Vector4 uv;
+    Gal_Image* image;
+    // Window pixels, 0 if there is none
+    const Vector4* scissor;
+    uint8_t type;
+    bool min_linear, mag_linear;
+} Software_Quad;
+
+static inline void software_quad_from_draw_quad(Software_Quad* out, const Draw_Quad* q) {
+    out->corners[0] = q->bottom_left;
+    out->corners[1] = q->top_left;
+    out->corners[2] = q->top_right;
+    out->corners[3] = q->bottom_right;
+    out->color = q->color;
+    out->uv = q->uv;
+    out->image = q->image;
+    out->scissor = q->has_scissor ? &q->scissor : 0;
+    out->type = q->type;
+    out->min_linear = q->image_min_filter == GFX_FILTER_MODE_LINEAR;
+    out->mag_linear = q->image_mag_filter == GFX_FILTER_MODE_LINEAR;
+}
+
+static inline void software_quad_from_instance(Software_Quad* out, Draw_Instance_Stream* stream, uint64_t index) {
+    Draw_Quad_Instance* inst = &stream->instances.data[index];
+    draw_quad_instance_get_corners(inst, stream->extras.count ? &stream->extras.data[index] : 0, out->corners);
+    const float inv_255 = 1.0f/255.0f, inv_65535 = 1.0f/65535.0f;
+    out->color = v4((float)(inst->color & 0xFF)*inv_255, (float)((inst->color >> 8) & 0xFF)*inv_255,
+                    (float)((inst->color >> 16) & 0xFF)*inv_255, (float)(inst->color >> 24)*inv_255);
+    out->uv = v4((float)inst->uv[0]*inv_65535, (float)inst->uv[1]*inv_65535, (float)inst->uv[2]*inv_65535, (float)inst->uv[3]*inv_65535);
+    out->image = inst->texture_index != DRAW_INSTANCE_NO_TEXTURE ? stream->textures.data[inst->texture_index] : 0;
+    out->scissor = inst->scissor_index != DRAW_INSTANCE_NO_SCISSOR ? &stream->scissors.data[inst->scissor_index] : 0;
+    out->type = inst->type;
+    out->min_linear = (inst->flags & DRAW_INSTANCE_FLAG_MIN_FILTER_LINEAR) != 0;
+    out->mag_linear = (inst->flags & DRAW_INSTANCE_FLAG_MAG_FILTER_LINEAR) != 0;
+}
+
+// Returns false if there is nothing to draw
+static bool software_setup_quad(Software_Raster_Quad* rq, const Software_Quad* q, const Software_Target* target, Draw_Pixel_Snap snap) {
+    if (q->color.w <= 0 && q->type != QUAD_TYPE_TEXT) return false;
+    
+    // ndc -> pixels, with rows going down
+    float half_w = (float)target->width*0.5f, half_h = (float)target->height*0.5f;
+    float px[4], py[4];
+    float min_x = F32_MAX, min_y = F32_MAX, max_x = -F32_MAX, max_y = -F32_MAX;
+    for (int i = 0; i < 4; i++) {
+        px[i] = (q->corners[i].x + 1.0f)*half_w;
+        py[i] = (1.0f - q->corners[i].y)*half_h;
+        min_x = min(min_x, px[i]); max_x = max(max_x, px[i]);
+        min_y = min(min_y, py[i]); max_y = max(max_y, py[i]);
+    }
+    
+    // Pixel centers inside the bounds
+    float clip_x0 = 0, clip_y0 = 0, clip_x1 = (float)target->width, clip_y1 = (float)target->height;
+    if (q->scissor) {
+        // Scissors are window pixels from the bottom left, which are target pixels when
+        // rendering to the window
+        Vector4 s = *q->scissor;
+        if (snap.window_width > 0 && snap.window_height > 0) {
+            Vector4 c = draw_scissor_to_clip(s, snap);
+            s = v4((c.x + 1.0f)*half_w, (c.y + 1.0f)*half_h, (c.z + 1.0f)*half_w, (c.w + 1.0f)*half_h);
+        }
+        clip_x0 = max(clip_x0, s.x);
+        clip_x1 = min(clip_x1, s.z);
+        clip_y0 = max(clip_y0, (float)target->height - s.w);
+        clip_y1 = min(clip_y1, (float)target->height - s.y);
+    }
+    min_x = max(min_x, clip_x0); max_x = min(max_x, clip_x1);
+    min_y = max(min_y, clip_y0); max_y = min(max_y, clip_y1);
+    if (!(min_x < max_x && min_y < max_y)) return false;
+    rq->x0 = (int32_t)ceilf(min_x - 0.5f);
+    rq->x1 = (int32_t)ceilf(max_x - 0.5f);
+    rq->y0 = (int32_t)ceilf(min_y - 0.5f);
+    rq->y1 = (int32_t)ceilf(max_y - 0.5f);
+    if (rq->x0 >= rq->x1 || rq->y0 >= rq->y1) return false;
+    
+    float area = 0;
+    for (int i = 0; i < 4; i++) {
+        int j = (i + 1) & 3;
+        area += px[i]*py[j] - px[j]*py[i];
+    }
+    if (fabsf(area) < 1e-6f) return false;
+    float orientation = area > 0 ? 1.0f : -1.0f;
+    
+    for (int i = 0; i < 4; i++) {
+        int j = (i + 1) & 3;
+        float dx = (px[j] - px[i])*orientation;
+        float dy = (py[j] - py[i])*orientation;
+        rq->edge_a[i] = -dy;
+        rq->edge_b[i] = dx;
+        rq->edge_c[i] = dy*px[i] - dx*py[i];
+        // Inside is to the right of a left edge and below a top edge
+        rq->edge_owns[i] = (rq->edge_a[i] > 0 || (rq->edge_a[i] == 0 && rq->edge_b[i] > 0)) ? -1 : 0;
+        rq->edge_inv_a[i] = fabsf(rq->edge_a[i]) > 1e-12f ? 1.0f/rq->edge_a[i] : 0;
+    }
+    
+    // p = p0 + s*axis_x + t*axis_y
+    float ax_x = px[3] - px[0], ax_y = py[3] - py[0];
+    float ay_x = px[1] - px[0], ay_y = py[1] - py[0];
+    float det = ax_x*ay_y - ax_y*ay_x;
+    if (fabsf(det) < 1e-6f) return false;
+    float inv_det = 1.0f/det;
+    rq->s_dx =  ay_y*inv_det;
+    rq->s_dy = -ay_x*inv_det;
+    rq->s_c  = -(rq->s_dx*px[0] + rq->s_dy*py[0]);
+    rq->t_dx = -ax_y*inv_det;
+    rq->t_dy =  ax_x*inv_det;
+    rq->t_c  = -(rq->t_dx*px[0] + rq->t_dy*py[0]);
+    
+    rq->color[0] = q->color.x;
+    rq->color[1] = q->color.y;
+    rq->color[2] = q->color.z;
+    rq->color[3] = q->color.w;
+    rq->circle = q->type == QUAD_TYPE_CIRCLE;
+    rq->text = q->type == QUAD_TYPE_TEXT;
+    rq->texels = 0;
+    rq->linear = false;
+    
+    SDL_Surface* texture = (q->image && q->image->gal_handle) ? (SDL_Surface*)q->image->gal_handle : 0;
+    if (texture && texture->w > 0 && texture->h > 0) {
+        rq->texels = (const uint32_t*)texture->pixels;
+        rq->texture_width  = texture->w;
+        rq->texture_height = texture->h;
+        rq->texture_pitch  = texture->pitch/4;
+        
+        float tw = (float)texture->w, th = (float)texture->h;
+        float du = (q->uv.z - q->uv.x)*tw, dv = (q->uv.w - q->uv.y)*th;
+        rq->u_dx = rq->s_dx*du; rq->u_dy = rq->s_dy*du; rq->u_c = rq->s_c*du + q->uv.x*tw;
+        rq->v_dx = rq->t_dx*dv; rq->v_dy = rq->t_dy*dv; rq->v_c = rq->t_c*dv + q->uv.y*th;
+        
+        float texels_per_pixel = fabsf(rq->u_dx*rq->v_dy - rq->u_dy*rq->v_dx);
+        rq->linear = texels_per_pixel > 1.0f ? q->min_linear : q->mag_linear;
+    } else if (rq->text) {
+        // Nothing to take coverage from
+        return false;
+    }
+    
+    rq->solid = !rq->texels && !rq->circle && !rq->text && q->color.w >= 1.0f;
+    if (rq->solid) {
+        uint32_t r = (uint32_t)lrintf(software_clamp(q->color.x*255.0f, 0, 255));
+        uint32_t g = (uint32_t)lrintf(software_clamp(q->color.y*255.0f, 0, 255));
+        uint32_t b = (uint32_t)lrintf(software_clamp(q->color.z*255.0f, 0, 255));
+        rq->solid_pixel = (r << target->shift_r) | (g << target->shift_g) | (b << target->shift_b) | ((255u << target->shift_a) & target->alpha_mask);
+    }
+    return true;
+}
+
+// s, t, u, v without the x part, for the row being drawn
+typedef struct {
+    float s, t, u, v;
+} Software_Raster_Row;
+
+static inline Software_Raster_Row software_raster_row(const Software_Raster_Quad* q, float y) {
+    Software_Raster_Row row;
+    row.s = q->s_dy*y + q->s_c;
+    row.t = q->t_dy*y + q->t_c;
+    row.u = q->u_dy*y + q->u_c;
+    row.v = q->v_dy*y + q->v_c;
+    return row;
+}
+
+static inline bool software_pixel_inside(const Software_Raster_Quad* q, const float* edge_row, int32_t x) {
+    float fx = (float)x + 0.5f;
+    for (int i = 0; i < 4; i++) {
+        float e = q->edge_a[i]*fx + edge_row[i];
+        if (!(e > 0 || (e == 0 && q->edge_owns[i]))) return false;
+    }
+    return true;
+}
+
+// The pixels of a row inside the quad are one run since it's convex. The run is solved from
+// the edges, then its ends are moved pixel by pixel until they agree with the exact test so
+// all paths cover the same pixels.
+static inline bool software_find_span(const Software_Raster_Quad* q, float y, int32_t* x0, int32_t* x1) {
+    float edge_row[4];
+    float lo = (float)q->x0, hi = (float)q->x1;
+    for (int i = 0; i < 4; i++) {
+        edge_row[i] = q->edge_b[i]*y + q->edge_c[i];
+        if (q->edge_inv_a[i] == 0) {
+            if (!(edge_row[i] > 0 || (edge_row[i] == 0 && q->edge_owns[i]))) return false;
+            continue;
+        }
+        float x = -edge_row[i]*q->edge_inv_a[i];
+        if (q->edge_a[i] > 0) lo = x > lo ? x : lo;
+        else                  hi = x < hi ? x : hi;
+    }
+    
+    int32_t start = (int32_t)ceilf(software_clamp(lo, (float)q->x0, (float)q->x1) - 0.5f);
+    int32_t end   = (int32_t)ceilf(software_clamp(hi, (float)q->x0, (float)q->x1) - 0.5f);
+    start = clamp(start, q->x0, q->x1);
+    end   = clamp(end, start, q->x1);
+    while (start < end && !software_pixel_inside(q, edge_row, start)) start++;
+    while (start > q->x0 && software_pixel_inside(q, edge_row, start - 1)) start--;
+    if (end < start) end = start;
+    while (end > start && !software_pixel_inside(q, edge_row, end - 1)) end--;
+    while (end < q->x1 && software_pixel_inside(q, edge_row, end)) end++;
+    
+    *x0 = start;
+    *x1 = end;
+    return start < end;
+}
+
+static inline uint32_t software_count_bits(uint32_t bits) {
+    uint32_t count = 0;
+    while (bits) {
+        bits &= bits - 1;
+        count += 1;
+    }
+    return count;
+}
+
+// Indexed by x in the whole target
+static inline uint32_t* software_target_row(const Software_Target* target, int32_t y) {
+    return (uint32_t*)(target->pixels + (int64_t)(y - target->y)*target->pitch) - target->x;
+}
+
+static inline void software_fill_span(uint32_t* pixels, int32_t x0, int32_t x1, uint32_t value) {
+    for (int32_t x = x0; x < x1; x++) pixels[x] = value;
+}
+
+///
+// Scalar, the reference the simd paths are compared against in the tests
+
+static inline void software_unpack_texel(uint32_t p, float* c) {
+    c[0] = (float)(p & 0xff);
+    c[1] = (float)((p >> 8) & 0xff);
+    c[2] = (float)((p >> 16) & 0xff);
+    c[3] = (float)(p >> 24);
+}
+
+static inline void software_sample_scalar(const Software_Raster_Quad* q, float u, float v, float* c) {
+    float max_x = (float)(q->texture_width - 1), max_y = (float)(q->texture_height - 1);
+    if (!q->linear) {
+        int32_t x = (int32_t)software_clamp(u, 0, max_x);
+        int32_t y = (int32_t)software_clamp(v, 0, max_y);
+        software_unpack_texel(q->texels[y*q->texture_pitch + x], c);
+        return;
+    }
+    
+    float fx = software_clamp(u - 0.5f, 0, max_x);
+    float fy = software_clamp(v - 0.5f, 0, max_y);
+    int32_t x0 = (int32_t)fx, y0 = (int32_t)fy;
+    int32_t x1 = min(x0 + 1, q->texture_width - 1), y1 = min(y0 + 1, q->texture_height - 1);
+    fx -= (float)x0;
+    fy -= (float)y0;
+    
+    float c00[4], c10[4], c01[4], c11[4];
+    software_unpack_texel(q->texels[y0*q->texture_pitch + x0], c00);
+    software_unpack_texel(q->texels[y0*q->texture_pitch + x1], c10);
+    software_unpack_texel(q->texels[y1*q->texture_pitch + x0], c01);
+    software_unpack_texel(q->texels[y1*q->texture_pitch + x1], c11);
+    for (int i = 0; i < 4; i++) {
+        float top    = c00[i] + (c10[i] - c00[i])*fx;
+        float bottom = c01[i] + (c11[i] - c01[i])*fx;
+        c[i] = top + (bottom - top)*fy;
+    }
+}
+
+static inline bool software_raster_pixel_scalar(const Software_Raster_Quad* q, const Software_Target* target, uint32_t* pixel, float x, const Software_Raster_Row* row) {
+    if (q->circle) {
+        float s = q->s_dx*x + row->s - 0.5f;
+        float t = q->t_dx*x + row->t - 0.5f;
+        if (!(s*s + t*t <= 0.25f)) return false;
+    }
+    float src[4];
+    if (q->texels) {
+        float texel[4];
+        software_sample_scalar(q, q->u_dx*x + row->u, q->v_dx*x + row->v, texel);
+        if (q->text) {
+            for (int i = 0; i < 3; i++) src[i] = q->color[i]*255.0f;
+            src[3] = texel[0]*(q->color[3]*(1.0f/255.0f));
+        } else {
+            for (int i = 0; i < 3; i++) src[i] = texel[i]*q->color[i];
+            src[3] = texel[3]*(q->color[3]*(1.0f/255.0f));
+        }
+    } else {
+        for (int i = 0; i < 3; i++) src[i] = q->color[i]*255.0f;
+        src[3] = q->color[3];
+    }
+    src[3] = software_clamp(src[3], 0, 1);
+    
+    uint32_t d = *pixel;
+    float dst[4] = {
+        (float)((d >> target->shift_r) & 0xff),
+        (float)((d >> target->shift_g) & 0xff),
+        (float)((d >> target->shift_b) & 0xff),
+        target->alpha_mask ? (float)((d >> target->shift_a) & 0xff) : 255.0f,
+    };
+    float inv_a = 1.0f - src[3];
+    uint32_t out[4];
+    for (int i = 0; i < 3; i++) out[i] = (uint32_t)(software_clamp(src[i]*src[3] + dst[i]*inv_a, 0, 255) + 0.5f);
+    out[3] = (uint32_t)(software_clamp(src[3]*255.0f + dst[3]*inv_a, 0, 255) + 0.5f);
+    
+    *pixel = (out[0] << target->shift_r) | (out[1] << target->shift_g) | (out[2] << target->shift_b) | ((out[3] << target->shift_a) & target->alpha_mask);
+    return true;
+}
+
+static uint64_t software_raster_quad_scalar(const Software_Raster_Quad* q, const Software_Target* target) {
+    uint64_t written = 0;
+    for (int32_t y = q->y0; y < q->y1; y++) {
+        float fy = (float)y + 0.5f;
+        int32_t x0, x1;
+        if (!software_find_span(q, fy, &x0, &x1)) continue;
+        
+        uint32_t* pixels = software_target_row(target, y);
+        if (q->solid) {
+            software_fill_span(pixels, x0, x1, q->solid_pixel);
+            written += (uint64_t)(x1 - x0);
+            continue;
+        }
+        Software_Raster_Row row = software_raster_row(q, fy);
+        for (int32_t x = x0; x < x1; x++) {
+            written += software_raster_pixel_scalar(q, target, &pixels[x], (float)x + 0.5f, &row);
+        }
+    }
+    return written;
+}
+
+#if SIMD_ENABLE_SSE2
+
+///
+// SSE2, 4 pixels per step
+
+static inline void software_unpack_texels_sse2(__m128i p, __m128* c) {
+    __m128i byte = _mm_set1_epi32(0xff);
+    c[0] = _mm_cvtepi32_ps(_mm_and_si128(p, byte));
+    c[1] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), byte));
+    c[2] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), byte));
+    c[3] = _mm_cvtepi32_ps(_mm_srli_epi32(p, 24));
+}
+
+static inline __m128i software_gather_sse2(const Software_Raster_Quad* q, const int32_t* x, const int32_t* y) {
+    const uint32_t* t = q->texels;
+    int32_t pitch = q->texture_pitch;
+    return _mm_setr_epi32((int)t[y[0]*pitch + x[0]], (int)t[y[1]*pitch + x[1]], (int)t[y[2]*pitch + x[2]], (int)t[y[3]*pitch + x[3]]);
+}
+
+static inline void software_sample_sse2(const Software_Raster_Quad* q, __m128 u, __m128 v, __m128* c) {
+    __m128 zero = _mm_setzero_ps();
+    __m128 max_x = _mm_set1_ps((float)(q->texture_width - 1));
+    __m128 max_y = _mm_set1_ps((float)(q->texture_height - 1));
+    ALIGN(16) int32_t x0[4], y0[4];
+    
+    if (!q->linear) {
+        _mm_store_si128((__m128i*)x0, _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(u, zero), max_x)));
+        _mm_store_si128((__m128i*)y0, _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, zero), max_y)));
+        software_unpack_texels_sse2(software_gather_sse2(q, x0, y0), c);
+        return;
+    }
+    
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 fx = _mm_min_ps(_mm_max_ps(_mm_sub_ps(u, half), zero), max_x);
+    __m128 fy = _mm_min_ps(_mm_max_ps(_mm_sub_ps(v, half), zero), max_y);
+    __m128i ix = _mm_cvttps_epi32(fx);
+    __m128i iy = _mm_cvttps_epi32(fy);
+    fx = _mm_sub_ps(fx, _mm_cvtepi32_ps(ix));
+    fy = _mm_sub_ps(fy, _mm_cvtepi32_ps(iy));
+    _mm_store_si128((__m128i*)x0, ix);
+    _mm_store_si128((__m128i*)y0, iy);
+    
+    // No min_epi32 in SSE2
+    ALIGN(16) int32_t x1[4], y1[4];
+    for (int i = 0; i < 4; i++) {
+        x1[i] = min(x0[i] + 1, q->texture_width - 1);
+        y1[i] = min(y0[i] + 1, q->texture_height - 1);
+    }
+    
+    __m128 c00[4], c10[4], c01[4], c11[4];
+    software_unpack_texels_sse2(software_gather_sse2(q, x0, y0), c00);
+    software_unpack_texels_sse2(software_gather_sse2(q, x1, y0), c10);
+    software_unpack_texels_sse2(software_gather_sse2(q, x0, y1), c01);
+    software_unpack_texels_sse2(software_gather_sse2(q, x1, y1), c11);
+    for (int i = 0; i < 4; i++) {
+        __m128 top    = _mm_add_ps(c00[i], _mm_mul_ps(_mm_sub_ps(c10[i], c00[i]), fx));
+        __m128 bottom = _mm_add_ps(c01[i], _mm_mul_ps(_mm_sub_ps(c11[i], c01[i]), fx));
+        c[i] = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fy));
+    }
+}
+
+// Returns the mask of pixels written
+// mask has the lanes inside the span. Returns the mask of pixels written.
+static inline uint32_t software_raster_group_sse2(const Software_Raster_Quad* q, const Software_Target* target, uint32_t* pixels, __m128 x, const Software_Raster_Row* row, __m128 mask) {
+    __m128 zero = _mm_setzero_ps();
+    if (q->circle) {
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128 s = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(q->s_dx), x), _mm_set1_ps(row->s)), half);
+        __m128 t = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(q->t_dx), x), _mm_set1_ps(row->t)), half);
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(s, s), _mm_mul_ps(t, t)), _mm_set1_ps(0.25f)));
+    }
+    uint32_t bits = (uint32_t)_mm_movemask_ps(mask);
+    if (!bits) return 0;
+    
+    __m128 c255 = _mm_set1_ps(255.0f);
+    __m128 src[4];
+    if (q->texels) {
+        __m128 u = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(q->u_dx), x), _mm_set1_ps(row->u));
+        __m128 v = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(q->v_dx), x), _mm_set1_ps(row->v));
+        __m128 texel[4];
+        software_sample_sse2(q, u, v, texel);
+        __m128 alpha_scale = _mm_set1_ps(q->color[3]*(1.0f/255.0f));
+        if (q->text) {
+            for (int i = 0; i < 3; i++) src[i] = _mm_set1_ps(q->color[i]*255.0f);
+            src[3] = _mm_mul_ps(texel[0], alpha_scale);
+        } else {
+            for (int i = 0; i < 3; i++) src[i] = _mm_mul_ps(texel[i], _mm_set1_ps(q->color[i]));
+            src[3] = _mm_mul_ps(texel[3], alpha_scale);
+        }
+    } else {
+        for (int i = 0; i < 3; i++) src[i] = _mm_set1_ps(q->color[i]*255.0f);
+        src[3] = _mm_set1_ps(q->color[3]);
+    }
+    src[3] = _mm_min_ps(_mm_max_ps(src[3], zero), _mm_set1_ps(1.0f));
+    
+    __m128i old = _mm_loadu_si128((__m128i*)pixels);
+    __m128i mask_i = _mm_castps_si128(mask);
+    __m128i byte = _mm_set1_epi32(0xff);
+    __m128 dst[4];
+    dst[0] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(old, _mm_cvtsi32_si128((int)target->shift_r)), byte));
+    dst[1] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(old, _mm_cvtsi32_si128((int)target->shift_g)), byte));
+    dst[2] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(old, _mm_cvtsi32_si128((int)target->shift_b)), byte));
+    dst[3] = target->alpha_mask ? _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(old, _mm_cvtsi32_si128((int)target->shift_a)), byte)) : c255;
+    
+    __m128 inv_a = _mm_sub_ps(_mm_set1_ps(1.0f), src[3]);
+    __m128i out[4];
+    for (int i = 0; i < 3; i++) {
+        __m128 blended = _mm_add_ps(_mm_mul_ps(src[i], src[3]), _mm_mul_ps(dst[i], inv_a));
+        out[i] = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(blended, zero), c255));
+    }
+    __m128 blended_a = _mm_add_ps(_mm_mul_ps(src[3], c255), _mm_mul_ps(dst[3], inv_a));
+    out[3] = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(blended_a, zero), c255));
+    
+    __m128i packed = _mm_or_si128(
+        _mm_or_si128(_mm_sll_epi32(out[0], _mm_cvtsi32_si128((int)target->shift_r)), _mm_sll_epi32(out[1], _mm_cvtsi32_si128((int)target->shift_g))),
+        _mm_or_si128(_mm_sll_epi32(out[2], _mm_cvtsi32_si128((int)target->shift_b)), _mm_and_si128(_mm_sll_epi32(out[3], _mm_cvtsi32_si128((int)target->shift_a)), _mm_set1_epi32((int)target->alpha_mask))));
+    _mm_storeu_si128((__m128i*)pixels, _mm_or_si128(_mm_and_si128(mask_i, packed), _mm_andnot_si128(mask_i, old)));
+    return bits;
+}
+
+static uint64_t software_raster_quad_sse2(const Software_Raster_Quad* q, const Software_Target* target) {
+    uint64_t written = 0;
+    __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    __m128 all = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (int32_t y = q->y0; y < q->y1; y++) {
+        float fy = (float)y + 0.5f;
+        int32_t x0, x1;
+        if (!software_find_span(q, fy, &x0, &x1)) continue;
+        
+        uint32_t* pixels = software_target_row(target, y);
+        if (q->solid) {
+            software_fill_span(pixels, x0, x1, q->solid_pixel);
+            written += (uint64_t)(x1 - x0);
+            continue;
+        }
+        Software_Raster_Row row = software_raster_row(q, fy);
+        int32_t x = x0;
+        for (; x + 4 <= x1; x += 4) {
+            __m128 fx = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+            written += software_count_bits(software_raster_group_sse2(q, target, &pixels[x], fx, &row, all));
+        }
+        // The rest goes through a copy so nothing past the span is touched
+        int32_t rest = x1 - x;
+        if (rest > 0) {
+            uint32_t tail[4] = {0};
+            memcpy(tail, &pixels[x], (size_t)rest*4);
+            __m128 fx = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+            __m128 valid = _mm_cmplt_ps(lanes, _mm_set1_ps((float)rest));
+            written += software_count_bits(software_raster_group_sse2(q, target, tail, fx, &row, valid));
+            memcpy(&pixels[x], tail, (size_t)rest*4);
+        }
+    }
+    return written;
+}
+
+///
+// AVX2, 8 pixels per step. Compiled for avx2 no matter the compiler flags and only called
+// when the cpu has it.
+
+SOFTWARE_TARGET_AVX2 static inline void software_unpack_texels_avx2(__m256i p, __m256* c) {
+    __m256i byte = _mm256_set1_epi32(0xff);
+    c[0] = _mm256_cvtepi32_ps(_mm256_and_si256(p, byte));
+    c[1] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 8), byte));
+    c[2] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 16), byte));
+    c[3] = _mm256_cvtepi32_ps(_mm256_srli_epi32(p, 24));
+}
+
+SOFTWARE_TARGET_AVX2 static inline __m256i software_gather_avx2(const Software_Raster_Quad* q, __m256i x, __m256i y) {
+    __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(y, _mm256_set1_epi32(q->texture_pitch)), x);
+    return _mm256_i32gather_epi32((const int*)q->texels, index, 4);
+}
+
+SOFTWARE_TARGET_AVX2 static inline void software_sample_avx2(const Software_Raster_Quad* q, __m256 u, __m256 v, __m256* c) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 max_x = _mm256_set1_ps((float)(q->texture_width - 1));
+    __m256 max_y = _mm256_set1_ps((float)(q->texture_height - 1));
+    
+    if (!q->linear) {
+        __m256i x = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(u, zero), max_x));
+        __m256i y = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(v, zero), max_y));
+        software_unpack_texels_avx2(software_gather_avx2(q, x, y), c);
+        return;
+    }
+    
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 fx = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(u, half), zero), max_x);
+    __m256 fy = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(v, half), zero), max_y);
+    __m256i x0 = _mm256_cvttps_epi32(fx);
+    __m256i y0 = _mm256_cvttps_epi32(fy);
+    fx = _mm256_sub_ps(fx, _mm256_cvtepi32_ps(x0));
+    fy = _mm256_sub_ps(fy, _mm256_cvtepi32_ps(y0));
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i x1 = _mm256_min_epi32(_mm256_add_epi32(x0, one), _mm256_set1_epi32(q->texture_width - 1));
+    __m256i y1 = _mm256_min_epi32(_mm256_add_epi32(y0, one), _mm256_set1_epi32(q->texture_height - 1));
+    
+    __m256 c00[4], c10[4], c01[4], c11[4];
+    software_unpack_texels_avx2(software_gather_avx2(q, x0, y0), c00);
+    software_unpack_texels_avx2(software_gather_avx2(q, x1, y0), c10);
+    software_unpack_texels_avx2(software_gather_avx2(q, x0, y1), c01);
+    software_unpack_texels_avx2(software_gather_avx2(q, x1, y1), c11);
+    for (int i = 0; i < 4; i++) {
+        __m256 top    = _mm256_add_ps(c00[i], _mm256_mul_ps(_mm256_sub_ps(c10[i], c00[i]), fx));
+        __m256 bottom = _mm256_add_ps(c01[i], _mm256_mul_ps(_mm256_sub_ps(c11[i], c01[i]), fx));
+        c[i] = _mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), fy));
+    }
+}
+
+SOFTWARE_TARGET_AVX2 static inline uint32_t software_raster_group_avx2(const Software_Raster_Quad* q, const Software_Target* target, uint32_t* pixels, __m256 x, const Software_Raster_Row* row, __m256 mask) {
+    __m256 zero = _mm256_setzero_ps();
+    if (q->circle) {
+        __m256 half = _mm256_set1_ps(0.5f);
+        __m256 s = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(q->s_dx), x), _mm256_set1_ps(row->s)), half);
+        __m256 t = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(q->t_dx), x), _mm256_set1_ps(row->t)), half);
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(s, s), _mm256_mul_ps(t, t)), _mm256_set1_ps(0.25f), _CMP_LE_OQ));
+    }
+    uint32_t bits = (uint32_t)_mm256_movemask_ps(mask);
+    if (!bits) return 0;
+    
+    __m256 c255 = _mm256_set1_ps(255.0f);
+    __m256 src[4];
+    if (q->texels) {
+        __m256 u = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(q->u_dx), x), _mm256_set1_ps(row->u));
+        __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(q->v_dx), x), _mm256_set1_ps(row->v));
+        __m256 texel[4];
+        software_sample_avx2(q, u, v, texel);
+        __m256 alpha_scale = _mm256_set1_ps(q->color[3]*(1.0f/255.0f));
+        if (q->text) {
+            for (int i = 0; i < 3; i++) src[i] = _mm256_set1_ps(q->color[i]*255.0f);
+            src[3] = _mm256_mul_ps(texel[0], alpha_scale);
+        } else {
+            for (int i = 0; i < 3; i++) src[i] = _mm256_mul_ps(texel[i], _mm256_set1_ps(q->color[i]));
+            src[3] = _mm256_mul_ps(texel[3], alpha_scale);
+        }
+    } else {
+        for (int i = 0; i < 3; i++) src[i] = _mm256_set1_ps(q->color[i]*255.0f);
+        src[3] = _mm256_set1_ps(q->color[3]);
+    }
+    src[3] = _mm256_min_ps(_mm256_max_ps(src[3], zero), _mm256_set1_ps(1.0f));
+    
+    __m256i old = _mm256_loadu_si256((__m256i*)pixels);
+    __m256i mask_i = _mm256_castps_si256(mask);
+    __m256i byte = _mm256_set1_epi32(0xff);
+    __m256 dst[4];
+    dst[0] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(old, _mm_cvtsi32_si128((int)target->shift_r)), byte));
+    dst[1] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(old, _mm_cvtsi32_si128((int)target->shift_g)), byte));
+    dst[2] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(old, _mm_cvtsi32_si128((int)target->shift_b)), byte));
+    dst[3] = target->alpha_mask ? _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(old, _mm_cvtsi32_si128((int)target->shift_a)), byte)) : c255;
+    
+    __m256 inv_a = _mm256_sub_ps(_mm256_set1_ps(1.0f), src[3]);
+    __m256i out[4];
+    for (int i = 0; i < 3; i++) {
+        __m256 blended = _mm256_add_ps(_mm256_mul_ps(src[i], src[3]), _mm256_mul_ps(dst[i], inv_a));
+        out[i] = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(blended, zero), c255));
+    }
+    __m256 blended_a = _mm256_add_ps(_mm256_mul_ps(src[3], c255), _mm256_mul_ps(dst[3], inv_a));
+    out[3] = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(blended_a, zero), c255));
+    
+    __m256i packed = _mm256_or_si256(
+        _mm256_or_si256(_mm256_sll_epi32(out[0], _mm_cvtsi32_si128((int)target->shift_r)), _mm256_sll_epi32(out[1], _mm_cvtsi32_si128((int)target->shift_g))),
+        _mm256_or_si256(_mm256_sll_epi32(out[2], _mm_cvtsi32_si128((int)target->shift_b)), _mm256_and_si256(_mm256_sll_epi32(out[3], _mm_cvtsi32_si128((int)target->shift_a)), _mm256_set1_epi32((int)target->alpha_mask))));
+    _mm256_storeu_si256((__m256i*)pixels, _mm256_blendv_epi8(old, packed, mask_i));
+    return bits;
+}
+
+SOFTWARE_TARGET_AVX2 static uint64_t software_raster_quad_avx2(const Software_Raster_Quad* q, const Software_Target* target) {
+    uint64_t written = 0;
+    __m256 lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (int32_t y = q->y0; y < q->y1; y++) {
+        float fy = (float)y + 0.5f;
+        int32_t x0, x1;
+        if (!software_find_span(q, fy, &x0, &x1)) continue;
+        
+        uint32_t* pixels = software_target_row(target, y);
+        if (q->solid) {
+            software_fill_span(pixels, x0, x1, q->solid_pixel);
+            written += (uint64_t)(x1 - x0);
+            continue;
+        }
+        Software_Raster_Row row = software_raster_row(q, fy);
+        int32_t x = x0;
+        for (; x + 8 <= x1; x += 8) {
+            __m256 fx = _mm256_add_ps(_mm256_set1_ps((float)x), lanes);
+            written += software_count_bits(software_raster_group_avx2(q, target, &pixels[x], fx, &row, all));
+        }
+        int32_t rest = x1 - x;
+        if (rest > 0) {
+            uint32_t tail[8] = {0};
+            memcpy(tail, &pixels[x], (size_t)rest*4);
+            __m256 fx = _mm256_add_ps(_mm256_set1_ps((float)x), lanes);
+            __m256 valid = _mm256_cmp_ps(lanes, _mm256_set1_ps((float)rest), _CMP_LT_OQ);
+            written += software_count_bits(software_raster_group_avx2(q, target, tail, fx, &row, valid));
+            memcpy(&pixels[x], tail, (size_t)rest*4);
+        }
+    }
+    return written;
+}
+
+#endif // SIMD_ENABLE_SSE2
+
+static uint64_t software_raster_quad(Software_Raster_Path path, const Software_Raster_Quad* q, const Software_Target* target) {
+    switch (path) {
+#if SIMD_ENABLE_SSE2
+        case SOFTWARE_RASTER_PATH_AVX2: return software_raster_quad_avx2(q, target);
+        case SOFTWARE_RASTER_PATH_SSE2: return software_raster_quad_sse2(q, target);
+#endif
+        default:                        return software_raster_quad_scalar(q, target);
+    }
+}
+
+///
+// Tiles
+
+// Grows to at least count items, what was in there is not kept
+static void* software_reserve(void* memory, uint64_t* capacity, uint64_t count, uint64_t item_size) {
+    if (count <= *capacity) return memory;
+    Allocator heap = GetHeapAllocator();
+    if (memory) Dealloc(heap, memory);
+    *capacity = max(count, *capacity*2);
+    return alloc_uninitialized(heap, *capacity*item_size);
+}
+
+// Instances set up by each job when drawing a Draw_Instance_Stream
+#define SOFTWARE_SETUP_CHUNK 1024
+
+typedef struct {
+    // One of the two
+    Draw_Frame* frame;
+    Draw_Instance_Stream* stream;
+    const Software_Target* target;
+    Draw_Pixel_Snap snap;
+    Software_Raster_Quad* quads;
+} Software_Setup_Job;
+
+// One bucket array chunk of quads, or SOFTWARE_SETUP_CHUNK instances. Skipped quads get an
+// empty box.
+static void software_setup_job(void* data, uint64_t chunk_index) {
+    Software_Setup_Job* job = (Software_Setup_Job*)data;
+    Software_Quad quad;
+    if (job->stream) {
+        uint64_t first = chunk_index*SOFTWARE_SETUP_CHUNK;
+        uint64_t end = min(first + SOFTWARE_SETUP_CHUNK, job->stream->instances.count);
+        for (uint64_t i = first; i < end; i++) {
+            software_quad_from_instance(&quad, job->stream, i);
+            if (!software_setup_quad(&job->quads[i], &quad, job->target, job->snap)) {
+                job->quads[i].x0 = job->quads[i].y0 = job->quads[i].x1 = job->quads[i].y1 = 0;
+            }
+        }
+        return;
+    }
+    
+    uint64_t n;
+    Draw_Quad* quads = (Draw_Quad*)bucket_array_get_chunk(&job->frame->quad_buffer, chunk_index, &n);
+    Software_Raster_Quad* out = job->quads + chunk_index*job->frame->quad_buffer.items_per_chunk;
+    for (uint64_t i = 0; i < n; i++) {
+        software_quad_from_draw_quad(&quad, &quads[i]);
+        if (!software_setup_quad(&out[i], &quad, job->target, job->snap)) {
+            out[i].x0 = out[i].y0 = out[i].x1 = out[i].y1 = 0;
+        }
+    }
+}
+
+typedef struct {
+    const Software_Target* target;
+    const Software_Raster_Quad* quads;
+    Software_Tile* tiles;
+    const uint32_t* tile_quads;
+    uint32_t tiles_x;
+    Software_Raster_Path path;
+} Software_Tile_Job;
+
+static void software_tile_job(void* data, uint64_t tile_index) {
+    Software_Tile_Job* job = (Software_Tile_Job*)data;
+    Software_Tile* tile = &job->tiles[tile_index];
+    tile->pixels_written = 0;
+    if (tile->count == 0) return;
+    
+    const Software_Target* target = job->target;
+    ALIGN(64) uint32_t pixels[SOFTWARE_TILE_SIZE*SOFTWARE_TILE_SIZE];
+    Software_Target local = *target;
+    local.x = (int32_t)(tile_index % job->tiles_x)*SOFTWARE_TILE_SIZE;
+    local.y = (int32_t)(tile_index / job->tiles_x)*SOFTWARE_TILE_SIZE;
+    local.width  = min(SOFTWARE_TILE_SIZE, target->width - local.x);
+    local.height = min(SOFTWARE_TILE_SIZE, target->height - local.y);
+    local.pitch  = SOFTWARE_TILE_SIZE*4;
+    local.pixels = (uint8_t*)pixels;
+    
+    for (int32_t y = 0; y < local.height; y++) {
+        memcpy(&pixels[y*SOFTWARE_TILE_SIZE], &software_target_row(target, local.y + y)[local.x], (size_t)local.width*4);
+    }
+    
+    uint64_t written = 0;
+    for (uint32_t i = 0; i < tile->count; i++) {
+        Software_Raster_Quad q = job->quads[job->tile_quads[tile->first + i]];
+        q.x0 = max(q.x0, local.x);
+        q.y0 = max(q.y0, local.y);
+        q.x1 = min(q.x1, local.x + local.width);
+        q.y1 = min(q.y1, local.y + local.height);
+        if (q.x0 >= q.x1 || q.y0 >= q.y1) continue;
+        written += software_raster_quad(job->path, &q, &local);
+    }
+    
+    for (int32_t y = 0; y < local.height; y++) {
+        memcpy(&software_target_row(target, local.y + y)[local.x], &pixels[y*SOFTWARE_TILE_SIZE], (size_t)local.width*4);
+    }
+    tile->pixels_written = written;
+}
+
+// Draws a Draw_Frame, or a Draw_Instance_Stream when frame is 0
+static void software_rasterize(Draw_Frame* frame, Draw_Instance_Stream* stream, SDL_Surface* surface, bool rows_from_top) {
+    software_data.raster_stats = (Software_Raster_Stats){0};
+    if (!surface || !surface->pixels) {
+        return;
+    }
+    if (surface->format->BitsPerPixel != 32) {
+        software_log_error("Can only draw to 32 bit surfaces, got %d bits", surface->format->BitsPerPixel);
+        return;
+    }
+    if (software_data.raster_path == SOFTWARE_RASTER_PATH_AUTO) {
+        software_data.raster_path = software_best_raster_path();
+    }
+    
+    if (frame && frame->enable_z_sorting) draw_frame_sort_by_z(frame);
+    
+    uint64_t quad_count = frame ? bucket_array_get_count(&frame->quad_buffer) : stream->instances.count;
+    if (quad_count == 0 || surface->w <= 0 || surface->h <= 0) {
+        return;
+    }
+    
+    SDL_LockSurface(surface);
+    Software_Target target = software_get_target(surface, rows_from_top);
+    Software_Raster_Stats* stats = &software_data.raster_stats;
+    Job_Pool* pool = software_data.raster_job_pool ? software_data.raster_job_pool : get_job_pool();
+    
+    // Set up every quad
+    software_data.raster_quads = (Software_Raster_Quad*)software_reserve(software_data.raster_quads, &software_data.raster_quad_capacity, quad_count, sizeof(Software_Raster_Quad));
+    Software_Raster_Quad* quads = software_data.raster_quads;
+    Software_Setup_Job setup = { frame, frame ? 0 : stream, &target, frame ? draw_get_pixel_snap(frame) : stream->pixel_snap, quads };
+    uint64_t setup_jobs = frame ? bucket_array_get_chunk_count(&frame->quad_buffer) : (quad_count + SOFTWARE_SETUP_CHUNK - 1)/SOFTWARE_SETUP_CHUNK;
+    job_pool_run(pool, software_setup_job, &setup, setup_jobs);
+    
+    // Bin them in order, first counting how many each tile gets
+    uint32_t tiles_x = (uint32_t)(target.width + SOFTWARE_TILE_SIZE - 1)/SOFTWARE_TILE_SIZE;
+    uint32_t tiles_y = (uint32_t)(target.height + SOFTWARE_TILE_SIZE - 1)/SOFTWARE_TILE_SIZE;
+    uint64_t tile_count = (uint64_t)tiles_x*tiles_y;
+    software_data.tiles = (Software_Tile*)software_reserve(software_data.tiles, &software_data.tile_capacity, tile_count, sizeof(Software_Tile));
+    Software_Tile* tiles = software_data.tiles;
+    memset(tiles, 0, tile_count*sizeof(Software_Tile));
+    
+    for (uint64_t i = 0; i < quad_count; i++) {
+        Software_Raster_Quad* q = &quads[i];
+        if (q->x0 >= q->x1 || q->y0 >= q->y1) {
+            stats->quads_skipped += 1;
+            continue;
+        }
+        stats->quads_drawn += 1;
+        stats->pixels_tested += (uint64_t)(q->x1 - q->x0)*(uint64_t)(q->y1 - q->y0);
+        
+        for (int32_t ty = q->y0/SOFTWARE_TILE_SIZE; ty <= (q->y1 - 1)/SOFTWARE_TILE_SIZE; ty++) {
+            for (int32_t tx = q->x0/SOFTWARE_TILE_SIZE; tx <= (q->x1 - 1)/SOFTWARE_TILE_SIZE; tx++) {
+                tiles[(uint64_t)ty*tiles_x + tx].count += 1;
+            }
+        }
+    }
+    
+    uint64_t tile_quad_count = 0;
+    for (uint64_t t = 0; t < tile_count; t++) {
+        tiles[t].first = (uint32_t)tile_quad_count;
+        tile_quad_count += tiles[t].count;
+        stats->tiles_drawn += tiles[t].count > 0;
+        tiles[t].count = 0;
+    }
+    stats->tile_quads = tile_quad_count;
+    
+    software_data.tile_quads = (uint32_t*)software_reserve(software_data.tile_quads, &software_data.tile_quad_capacity, tile_quad_count, sizeof(uint32_t));
+    uint32_t* tile_quads = software_data.tile_quads;
+    for (uint64_t i = 0; i < quad_count; i++) {
+        Software_Raster_Quad* q = &quads[i];
+        if (q->x0 >= q->x1 || q->y0 >= q->y1) continue;
+        for (int32_t ty = q->y0/SOFTWARE_TILE_SIZE; ty <= (q->y1 - 1)/SOFTWARE_TILE_SIZE; ty++) {
+            for (int32_t tx = q->x0/SOFTWARE_TILE_SIZE; tx <= (q->x1 - 1)/SOFTWARE_TILE_SIZE; tx++) {
+                Software_Tile* tile = &tiles[(uint64_t)ty*tiles_x + tx];
+                tile_quads[tile->first + tile->count++] = (uint32_t)i;
+            }
+        }
+    }
+    
+    // Draw the tiles
+    Software_Tile_Job job = { &target, quads, tiles, tile_quads, tiles_x, software_data.raster_path };
+    job_pool_run(pool, software_tile_job, &job, tile_count);
+    
+    for (uint64_t t = 0; t < tile_count; t++) stats->pixels_written += tiles[t].pixels_written;
+    
+    SDL_UnlockSurface(surface);
+}
+
 // ================ RENDERING FUNCTIONS ================
 
 static void software_begin_frame(void) {
@@ -378,9 +1418,7 @@ static void software_render_draw_frame(Draw_Frame* frame, GAL_Texture_Handle tar
         return;
     }
     
-    // In a real implementation, this would render the draw frame to the target texture
-    // For now, just log that we're rendering
-    software_log_verbose("Rendering draw frame to texture target");
+    software_rasterize(frame, 0, (SDL_Surface*)target, false);
 }
 
 static void software_render_draw_frame_to_window(Draw_Frame* frame) {
@@ -388,46 +1426,21 @@ static void software_render_draw_frame_to_window(Draw_Frame* frame) {
         return;
     }
     
-    // In a real implementation, this would render the draw frame to the window
-    // For now, just log that we're rendering
-    software_log_verbose("Rendering draw frame to window");
+    software_rasterize(frame, 0, software_data.render_surface, true);
+}
+
+// Same as for a frame, the stream's calls are just runs of instances that share a scissor and
+// texture slots. The rasteriser takes each instance's texture and scissor from the stream's
+// tables directly, so it goes through the instances in order.
+static void software_render_instances(Draw_Instance_Stream* stream, GAL_Texture_Handle target) {
+    if (!stream) {
+        return;
+    }
     
-    // Simple test pattern to prove rendering is working
-    // Draw some colored rectangles
-    if (software_data.render_surface) {
-        SDL_Rect rect;
-        
-        // Red rectangle in top-left corner
-        rect.x = 10;
-        rect.y = 10;
-        rect.w = 100;
-        rect.h = 100;
-        SDL_FillRect(software_data.render_surface, &rect, 
-                    SDL_MapRGBA(software_data.render_surface->format, 255, 0, 0, 255));
-        
-        // Green rectangle in top-right corner
-        rect.x = software_data.screen_width - 110;
-        rect.y = 10;
-        rect.w = 100;
-        rect.h = 100;
-        SDL_FillRect(software_data.render_surface, &rect, 
-                    SDL_MapRGBA(software_data.render_surface->format, 0, 255, 0, 255));
-        
-        // Blue rectangle in bottom-left corner
-        rect.x = 10;
-        rect.y = software_data.screen_height - 110;
-        rect.w = 100;
-        rect.h = 100;
-        SDL_FillRect(software_data.render_surface, &rect, 
-                    SDL_MapRGBA(software_data.render_surface->format, 0, 0, 255, 255));
-        
-        // White rectangle in bottom-right corner
-        rect.x = software_data.screen_width - 110;
-        rect.y = software_data.screen_height - 110;
-        rect.w = 100;
-        rect.h = 100;
-        SDL_FillRect(software_data.render_surface, &rect, 
-                    SDL_MapRGBA(software_data.render_surface->format, 255, 255, 255, 255));
+    if (target) {
+        software_rasterize(0, stream, (SDL_Surface*)target, false);
+    } else if (software_data.render_surface) {
+        software_rasterize(0, stream, software_data.render_surface, true);
     }
 }
 
@@ -459,6 +1472,22 @@ static void software_destroy_shader(void* shader_object) {
     // Software renderer doesn't use shaders
 }
 
+static void software_write_timestamp(uint32_t query) {
+    if (query >= GAL_TIMING_MAX_QUERIES) return;
+    software_data.timestamps[query] = (uint64_t)(OsGetElapsedSeconds()*1e9);
+}
+
+static bool software_read_timestamp(uint32_t query, uint64_t* nanoseconds) {
+    if (query >= GAL_TIMING_MAX_QUERIES) return false;
+    *nanoseconds = software_data.timestamps[query];
+    return true;
+}
+
+static bool software_get_timestamp(uint64_t* nanoseconds) {
+    *nanoseconds = (uint64_t)(OsGetElapsedSeconds()*1e9);
+    return true;
+}
+
 static void software_reserve_vertex_buffer(uint64_t bytes) {
     // Software renderer doesn't use vertex buffers
     software_log_warning("Vertex buffers not supported in software renderer");
@@ -490,17 +1519,24 @@ GAL_Renderer software_create_renderer(void) {
     renderer.create_texture = software_create_texture;
     renderer.update_texture = software_update_texture;
     renderer.destroy_texture = software_destroy_texture;
+    renderer.read_texture = software_read_texture;
+    renderer.get_texture_pixels = software_get_texture_pixels;
+    renderer.get_framebuffer_pixels = software_get_framebuffer_pixels;
     
     // Rendering functions
     renderer.begin_frame = software_begin_frame;
     renderer.end_frame = software_end_frame;
     renderer.render_draw_frame = software_render_draw_frame;
     renderer.render_draw_frame_to_window = software_render_draw_frame_to_window;
+    renderer.render_instances = software_render_instances;
     renderer.clear_render_target = software_clear_render_target;
     
     // Advanced functions
     renderer.compile_shader = software_compile_shader;
     renderer.destroy_shader = software_destroy_shader;
+    renderer.write_timestamp = software_write_timestamp;
+    renderer.read_timestamp = software_read_timestamp;
+    renderer.get_timestamp = software_get_timestamp;
     renderer.reserve_vertex_buffer = software_reserve_vertex_buffer;
     
     // Implementation data
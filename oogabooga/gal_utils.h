@@ -24,6 +24,7 @@ static const char* gal_result_to_string(GAL_Result result) {
         case GAL_RESULT_ERROR_UNSUPPORTED_FEATURE: return "Unsupported feature";
         case GAL_RESULT_ERROR_DEVICE_LOST: return "Device lost";
         case GAL_RESULT_ERROR_FORMAT_NOT_SUPPORTED: return "Format not supported";
+        case GAL_RESULT_ERROR_NOT_INITIALIZED: return "Not initialized";
         case GAL_RESULT_ERROR_UNKNOWN: 
         default: return "Unknown error";
     }
@@ -37,6 +38,7 @@ static const char* gal_backend_to_string(GAL_Backend backend) {
         case GAL_BACKEND_D3D11: return "Direct3D 11";
         case GAL_BACKEND_SOFTWARE: return "Software";
         case GAL_BACKEND_METAL: return "Metal";
+        case GAL_BACKEND_NULL: return "Null";
         case GAL_BACKEND_UNKNOWN:
         default: return "Unknown";
     }
@@ -67,7 +69,14 @@ static bool gal_is_backend_supported(GAL_Backend backend) {
             #endif
             
         case GAL_BACKEND_SOFTWARE:
-            return true; // Software renderer should always be available
+            #if defined(RENDERER_SOFTWARE) && RENDERER_SOFTWARE
+                return true;
+            #else
+                return false;
+            #endif
+            
+        case GAL_BACKEND_NULL:
+            return true; // Needs nothing, so it's always there
             
         case GAL_BACKEND_METAL:
             #if defined(__APPLE__) && defined(RENDERER_METAL) && RENDERER_METAL
@@ -81,8 +90,25 @@ static bool gal_is_backend_supported(GAL_Backend backend) {
     }
 }
 
-// Get the best available backend for the current platform
+// False when there is nothing to open a window on, like on a Linux build agent without X11
+// or Wayland
+static bool gal_has_display(void) {
+    #if defined(_WIN32) || defined(__APPLE__)
+        return true;
+    #else
+        const char* x11 = getenv("DISPLAY");
+        const char* wayland = getenv("WAYLAND_DISPLAY");
+        return (x11 && x11[0]) || (wayland && wayland[0]);
+    #endif
+}
+
+// Get the best available backend for the current platform. The null renderer when there is
+// no display, or when nothing else is built in.
 static GAL_Backend gal_get_best_backend(void) {
+    if (!gal_has_display()) {
+        return GAL_BACKEND_NULL;
+    }
+    
     #if defined(_WIN32)
         // On Windows, prefer D3D11, then OpenGL, then Software
         if (gal_is_backend_supported(GAL_BACKEND_D3D11)) {
@@ -106,8 +132,11 @@ static GAL_Backend gal_get_best_backend(void) {
         }
     #endif
     
-    // Software is the final fallback
-    return GAL_BACKEND_SOFTWARE;
+    // Software is the final fallback, if it's built in
+    if (gal_is_backend_supported(GAL_BACKEND_SOFTWARE)) {
+        return GAL_BACKEND_SOFTWARE;
+    }
+    return GAL_BACKEND_NULL;
 }
 
 // Memory safety check for texture operations
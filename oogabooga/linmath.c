@@ -781,6 +781,74 @@ Matrix4 m4_inverse(Matrix4 m) {
 }
 
 
+// True if the bottom row is 0, 0, 0, 1, which is the case for anything made of translations,
+// rotations and scales (but not for perspective projections).
+bool m4_is_affine(Matrix4 m) {
+    return m.m[3][0] == 0.0f && m.m[3][1] == 0.0f && m.m[3][2] == 0.0f && m.m[3][3] == 1.0f;
+}
+
+// Inverse of an affine matrix, see m4_is_affine(). Inverts the 3x3 part and transforms the
+// negated translation with it, which is a lot cheaper than the general m4_inverse.
+Matrix4 m4_affine_inverse(Matrix4 m) {
+    float32 a = m.m[0][0], b = m.m[0][1], c = m.m[0][2];
+    float32 d = m.m[1][0], e = m.m[1][1], f = m.m[1][2];
+    float32 g = m.m[2][0], h = m.m[2][1], i = m.m[2][2];
+
+    float32 c00 = e*i - f*h;
+    float32 c01 = c*h - b*i;
+    float32 c02 = b*f - c*e;
+
+    float32 det = a*c00 + d*c01 + g*c02;
+    if (det == 0) return M4Scalar(0);
+    float32 inv_det = 1.0f / det;
+
+    Matrix4 inv;
+    inv.m[0][0] = c00 * inv_det;
+    inv.m[0][1] = c01 * inv_det;
+    inv.m[0][2] = c02 * inv_det;
+    inv.m[1][0] = (f*g - d*i) * inv_det;
+    inv.m[1][1] = (a*i - c*g) * inv_det;
+    inv.m[1][2] = (c*d - a*f) * inv_det;
+    inv.m[2][0] = (d*h - e*g) * inv_det;
+    inv.m[2][1] = (b*g - a*h) * inv_det;
+    inv.m[2][2] = (a*e - b*d) * inv_det;
+
+    float32 tx = m.m[0][3], ty = m.m[1][3], tz = m.m[2][3];
+    inv.m[0][3] = -(inv.m[0][0]*tx + inv.m[0][1]*ty + inv.m[0][2]*tz);
+    inv.m[1][3] = -(inv.m[1][0]*tx + inv.m[1][1]*ty + inv.m[1][2]*tz);
+    inv.m[2][3] = -(inv.m[2][0]*tx + inv.m[2][1]*ty + inv.m[2][2]*tz);
+
+    inv.m[3][0] = 0.0f; inv.m[3][1] = 0.0f; inv.m[3][2] = 0.0f; inv.m[3][3] = 1.0f;
+
+    return inv;
+}
+
+// Inverse of a matrix that only rotates and translates (no scale), where the inverse
+// rotation is just the transpose.
+Matrix4 m4_rigid_inverse(Matrix4 m) {
+    Matrix4 inv;
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            inv.m[r][c] = m.m[c][r];
+        }
+    }
+
+    float32 tx = m.m[0][3], ty = m.m[1][3], tz = m.m[2][3];
+    inv.m[0][3] = -(inv.m[0][0]*tx + inv.m[0][1]*ty + inv.m[0][2]*tz);
+    inv.m[1][3] = -(inv.m[1][0]*tx + inv.m[1][1]*ty + inv.m[1][2]*tz);
+    inv.m[2][3] = -(inv.m[2][0]*tx + inv.m[2][1]*ty + inv.m[2][2]*tz);
+
+    inv.m[3][0] = 0.0f; inv.m[3][1] = 0.0f; inv.m[3][2] = 0.0f; inv.m[3][3] = 1.0f;
+
+    return inv;
+}
+
+// Takes the affine path when it can
+Matrix4 m4_inverse_fast(Matrix4 m) {
+    if (m4_is_affine(m)) return m4_affine_inverse(m);
+    return m4_inverse(m);
+}
+
 
 
 //
@@ -338,6 +338,11 @@ Matrix4 M4RotateX(Matrix4 m, float radians);
 Matrix4 M4RotateY(Matrix4 m, float radians);
 Matrix4 M4RotateZ(Matrix4 m, float radians);
 Matrix4 M4Scale(Matrix4 m, Vector3f32 scale);
+Matrix4 m4_inverse(Matrix4 m);
+bool    m4_is_affine(Matrix4 m);
+Matrix4 m4_affine_inverse(Matrix4 m);
+Matrix4 m4_rigid_inverse(Matrix4 m);
+Matrix4 m4_inverse_fast(Matrix4 m);
 
 // Drawing functions  
 typedef struct Draw_Quad Draw_Quad;
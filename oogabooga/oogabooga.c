@@ -125,6 +125,7 @@
 					tm_scope
 					tm_scope_var
 					tm_scope_accum
+				gal_begin_timing regions go on a "GPU" track, see gal.h
 					
 		- OOGABOOGA_HEADLESS
             Run oogabooga in headless mode, i.e. no window, no graphics, no audio.
@@ -274,6 +275,49 @@ typedef f64 float64;
     #error "Compiler is not explicitly supported. Supported compilers: GCC, Clang, MSVC"
 #endif
 
+// What instruction sets the compiler is allowed to generate. This needs to be known before the
+// SIMD_ENABLE_XXX defaults below and before simd.c.
+// I think this is the standard? (sse1)
+#define COMPILER_CAN_DO_SSE 1
+#if COMPILER_MSVC
+	#if _M_IX86_FP >= 2
+		#define COMPILER_CAN_DO_SSE2 1
+		#define COMPILER_CAN_DO_SSE41 1
+	#else
+		#define COMPILER_CAN_DO_SSE2 0
+		#define COMPILER_CAN_DO_SSE41 0
+	#endif
+#elif COMPILER_GCC || COMPILER_CLANG
+	#ifdef __SSE2__
+		#define COMPILER_CAN_DO_SSE2 1
+	#else
+		#define COMPILER_CAN_DO_SSE2 0
+	#endif
+	#ifdef __SSE4_1__
+		#define COMPILER_CAN_DO_SSE41 1
+	#else
+		#define COMPILER_CAN_DO_SSE41 0
+	#endif
+#else
+	#define COMPILER_CAN_DO_SSE2 0
+	#define COMPILER_CAN_DO_SSE41 0
+#endif
+#ifdef __AVX__
+	#define COMPILER_CAN_DO_AVX 1
+#else
+	#define COMPILER_CAN_DO_AVX 0
+#endif
+#ifdef __AVX2__
+	#define COMPILER_CAN_DO_AVX2 1
+#else
+	#define COMPILER_CAN_DO_AVX2 0
+#endif
+#ifdef __AVX512F__
+	#define COMPILER_CAN_DO_AVX512 1
+#else
+	#define COMPILER_CAN_DO_AVX512 0
+#endif
+
 // Set thread_local based on compiler
 #if COMPILER_GCC || COMPILER_CLANG
     #define thread_local THREAD_LOCAL
@@ -414,9 +458,13 @@ typedef f64 float64;
 #include "hash.h"
 #include "path_utils.h"
 #include "utility.h"
+#include "sort.h"
 
 #include "hash_table.h"
 #include "growing_array.h"
+#include "array.h"
+#include "bucket_array.h"
+#include "spatial_index.h"
 
 #include "os_interface.h"
 
@@ -443,7 +491,9 @@ typedef f64 float64;
 #ifndef OOGABOOGA_HEADLESS
     #include "font.h"
     #include "drawing.h"
+    #include "atlas.h"
     #include "audio.h"
+    #include "audio_dsp.h"
 #endif
 
 #if OOGABOOGA_ENABLE_EXTENSIONS
@@ -485,6 +535,9 @@ typedef f64 float64;
 #include "os_interface.c"
 #include "cpu.c"
 #include "concurrency.c"
+#include "sort.c"
+#include "bucket_array.c"
+#include "spatial_index.c"
 #include "profiling.c"
 #include "random.c"
 #include "memory.c"
@@ -495,8 +548,15 @@ typedef f64 float64;
 #include "os_impl_linux.c"
 #endif
 #ifndef OOGABOOGA_HEADLESS
+// Without a renderer from the build, default to the software renderer
+#if !(RENDERER_OPENGL || RENDERER_VULKAN || RENDERER_D3D11 || RENDERER_SOFTWARE || RENDERER_NULL)
+    #undef RENDERER_SOFTWARE
+    #define RENDERER_SOFTWARE 1
+#endif
 #include "gal.c"
 #include "drawing.c"
+#include "atlas.c"
+#include "audio_dsp.c"
 // #include "font.c" // disabled to avoid missing glyph APIs
 // #include "audio.c" // disabled to avoid audio compile errors
 
@@ -509,10 +569,9 @@ typedef f64 float64;
 #include "gal_d3d11.c"
 #elif defined(RENDERER_SOFTWARE) && RENDERER_SOFTWARE
 #include "gal_software.c"
-#else
-// Default to software renderer
-#include "gal_software.c"
 #endif
+// Needs no SDL, window or GPU, so it's always there to fall back to (see gal_null.c)
+#include "gal_null.c"
 
 #endif
 #if OOGABOOGA_ENABLE_EXTENSIONS
@@ -566,6 +625,8 @@ bool oogabooga_init(u64 program_memory_size) {
     DrawFrameReset(&drawFrame);
     
     log_info("Graphics system initialized");
+    
+    audio_dsp_init();
 #else
     log_info("Headless mode on");
 #endif
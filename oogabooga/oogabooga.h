@@ -225,16 +225,21 @@ void oogabooga_assert_fail(const char* expr, const char* file, int line, const c
 // Data structures
 #include "hash.h"
 #include "growing_array.h"
+#include "array.h"
+#include "bucket_array.h"
+#include "spatial_index.h"
 #include "hash_table.h"
 
 // Graphics and rendering
 #include "gal.h"
 #include "drawing.h"
+#include "atlas.h"
 #include "font.h"
 
 // Input and audio
 #include "input.h"
 #include "audio.h"
+#include "audio_dsp.h"
 
 // Utilities
 #include "random.h"
@@ -8,6 +8,7 @@
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #include <sched.h>
 /*
  * Linux OS Implementation for Oogabooga Engine
@@ -232,12 +233,68 @@ bool OsReadEntireFileS(string path, string *result, Allocator allocator) {
     return true;
 }
 
+bool os_file_delete_s(string path) {
+    char* null_terminated_path = TempConvertToNullTerminatedString(path);
+    if (!null_terminated_path) return false;
+    return unlink(null_terminated_path) == 0;
+}
+
+bool os_make_directory_s(string path, bool recursive) {
+    char* null_terminated_path = TempConvertToNullTerminatedString(path);
+    if (!null_terminated_path) return false;
+
+    if (recursive) {
+        for (char* sep = strchr(null_terminated_path + 1, '/'); sep; sep = strchr(sep + 1, '/')) {
+            *sep = 0;
+            bool ok = mkdir(null_terminated_path, 0755) == 0 || errno == EEXIST;
+            *sep = '/';
+            if (!ok) return false;
+        }
+    }
+
+    return mkdir(null_terminated_path, 0755) == 0 || errno == EEXIST;
+}
+
+bool os_delete_directory_s(string path, bool recursive) {
+    char* null_terminated_path = TempConvertToNullTerminatedString(path);
+    if (!null_terminated_path) return false;
+
+    if (recursive) {
+        DIR* dir = opendir(null_terminated_path);
+        if (!dir) return false;
+        struct dirent* entry;
+        while ((entry = readdir(dir))) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+            u64 name_length = strlen(entry->d_name);
+            string child = talloc_string(path.count + 1 + name_length);
+            memcpy(child.data, path.data, path.count);
+            child.data[path.count] = '/';
+            memcpy(child.data + path.count + 1, entry->d_name, name_length);
+            struct stat child_stat;
+            char* null_terminated_child = TempConvertToNullTerminatedString(child);
+            bool is_directory = lstat(null_terminated_child, &child_stat) == 0 && S_ISDIR(child_stat.st_mode);
+            bool ok = is_directory ? os_delete_directory_s(child, true) : unlink(null_terminated_child) == 0;
+            if (!ok) {
+                closedir(dir);
+                return false;
+            }
+        }
+        closedir(dir);
+    }
+
+    return rmdir(null_terminated_path) == 0;
+}
+
 // CPU and system info
 u32 os_get_core_count(void) {
     long cores = sysconf(_SC_NPROCESSORS_ONLN);
     return (cores > 0) ? (u32)cores : 1;
 }
 
+u64 os_get_number_of_logical_processors(void) {
+    return (u64)os_get_core_count();
+}
+
 // High-resolution timing
 f64 os_get_current_time_in_seconds(void) {
     struct timespec ts;
@@ -255,9 +312,8 @@ double OsGetElapsedSeconds(void) {
 }
 
 void OsUpdate(void) {
-    // Simple sleep to avoid busy loop in example
-    struct timespec ts = {0, 1000000};
-    nanosleep(&ts, NULL);
+    // Nothing to pump here, the renderer handles window events. Use vsync or
+    // gal_set_frame_pacing to keep the main loop from spinning.
 }
 
 void os_lock_program_memory_pages(void *start, u64 size) {
@@ -349,10 +405,17 @@ bool os_grow_program_memory(u64 new_size) {
     return true;
 }
 
+// From the GNU linker, the start of the executable and the end of its .bss
+extern char __executable_start[];
+extern char end[];
+
 void os_init(u64 program_memory_size) {
     os.page_size = (u64)sysconf(_SC_PAGESIZE);
     os.granularity = os.page_size;
     os.crt_vsnprintf = vsnprintf;
+    // String literals and globals, so %s can tell a string from a char* pointing in there
+    os.static_memory_start = __executable_start;
+    os.static_memory_end = end;
     context.thread_id = (u64)syscall(SYS_gettid);
     program_memory_capacity = align_next(program_memory_size, os.page_size);
     program_memory = mmap(NULL, program_memory_capacity,
@@ -4,11 +4,13 @@
 ogb_instance String_Builder _profile_output;
 ogb_instance bool profiler_initted;
 ogb_instance Spinlock _profiler_lock;
+ogb_instance bool profiler_gpu_track_named;
 
 #if !OOGABOOGA_LINK_EXTERNAL_INSTANCE
 String_Builder _profile_output = {0};
 bool profiler_initted = false;
 Spinlock _profiler_lock;
+bool profiler_gpu_track_named = false;
 #endif
 
 void dump_profile_result() {
@@ -22,7 +24,7 @@ void dump_profile_result() {
 	
 	log_verbose("Wrote profiling result to google_trace.json");
 }
-void _profiler_report_time(string name, f64 count, f64 start) {
+void _profiler_init_if_needed(void) {
 	if (!profiler_initted) {
 		spinlock_init(&_profiler_lock);
 		profiler_initted = true;
@@ -30,6 +32,9 @@ void _profiler_report_time(string name, f64 count, f64 start) {
 		string_builder_init_reserve(&_profile_output, 1024*1000, GetHeapAllocator());	
 		
 	}
+}
+void _profiler_report_time(string name, f64 count, f64 start) {
+	_profiler_init_if_needed();
 	
 	spinlock_acquire_or_wait(&_profiler_lock);
 	
@@ -44,6 +49,27 @@ void _profiler_report_time(string name, f64 count, f64 start) {
     );
 	spinlock_release(&_profiler_lock);
 }
+// Timings from the renderer side (see gal_begin_timing) go on their own "GPU" track, pid 1
+void _profiler_report_gpu_time(string name, f64 count, f64 start) {
+	_profiler_init_if_needed();
+	
+	spinlock_acquire_or_wait(&_profiler_lock);
+	
+	if (!profiler_gpu_track_named) {
+		string_builder_append(&_profile_output, STR("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}},"));
+		profiler_gpu_track_named = true;
+	}
+	
+	string fmt = STR("{\"cat\":\"gpu\",\"dur\":%.3f,\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f},");
+    string_builder_print(
+        &_profile_output,
+        fmt,
+        (float64)(count * 1000000),  
+        name,                  
+        start * 1000000              
+    );
+	spinlock_release(&_profiler_lock);
+}
 #if ENABLE_PROFILING
 #define tm_scope(name) \
     for (f64 start_time = OsGetElapsedSeconds(), end_time = start_time, elapsed_time = 0; \
@@ -0,0 +1,231 @@
+
+///
+// Generic sorting
+///
+
+// Below this we don't bother waking up the job pool
+#define SORT_PARALLEL_THRESHOLD 50000
+// parallel_merge_sort insertion sorts runs of this size before it starts merging
+#define SORT_MERGE_RUN_SIZE 32
+// Items up to half this size are moved around with stack memory
+#define SORT_STACK_SCRATCH_SIZE 512
+
+typedef struct Sort_Context {
+	u8 *items;
+	u64 item_size;
+	Sort_Compare_Proc compare;
+	u8 *tmp;
+	u8 *swap_tmp;
+} Sort_Context;
+
+#define _SORT_ITEM(c, i) ((c)->items + (i)*(c)->item_size)
+
+bool _sort_generic_less(Sort_Context *c, u64 i, u64 j) {
+	return c->compare(_SORT_ITEM(c, i), _SORT_ITEM(c, j)) < 0;
+}
+bool _sort_generic_less_tmp_item(Sort_Context *c, u64 i) {
+	return c->compare(c->tmp, _SORT_ITEM(c, i)) < 0;
+}
+bool _sort_generic_less_item_tmp(Sort_Context *c, u64 i) {
+	return c->compare(_SORT_ITEM(c, i), c->tmp) < 0;
+}
+void _sort_generic_swap(Sort_Context *c, u64 i, u64 j) {
+	memcpy(c->swap_tmp,        _SORT_ITEM(c, i), c->item_size);
+	memcpy(_SORT_ITEM(c, i),   _SORT_ITEM(c, j), c->item_size);
+	memcpy(_SORT_ITEM(c, j),   c->swap_tmp,      c->item_size);
+}
+void _sort_generic_move(Sort_Context *c, u64 dst, u64 src) {
+	memcpy(_SORT_ITEM(c, dst), _SORT_ITEM(c, src), c->item_size);
+}
+void _sort_generic_load_tmp(Sort_Context *c, u64 i) {
+	memcpy(c->tmp, _SORT_ITEM(c, i), c->item_size);
+}
+void _sort_generic_store_tmp(Sort_Context *c, u64 i) {
+	memcpy(_SORT_ITEM(c, i), c->tmp, c->item_size);
+}
+
+_SORT_TEMPLATE(_sort_generic, Sort_Context)
+
+// Scratch needs to fit 2 items
+Sort_Context make_sort_context(void *collection, u64 item_size, Sort_Compare_Proc compare, u8 *scratch) {
+	Sort_Context c;
+	c.items = (u8*)collection;
+	c.item_size = item_size;
+	c.compare = compare;
+	c.tmp = scratch;
+	c.swap_tmp = scratch + item_size;
+	return c;
+}
+u8 *sort_get_scratch(u8 *stack_scratch, u64 item_size) {
+	if (item_size*2 <= SORT_STACK_SCRATCH_SIZE) return stack_scratch;
+	return (u8*)alloc_uninitialized(GetHeapAllocator(), item_size*2);
+}
+void sort_release_scratch(u8 *stack_scratch, u8 *scratch) {
+	if (scratch != stack_scratch) Dealloc(GetHeapAllocator(), scratch);
+}
+
+void pdq_sort(void *collection, u64 item_count, u64 item_size, Sort_Compare_Proc compare) {
+	if (item_count <= 1) return;
+
+	u8 stack_scratch[SORT_STACK_SCRATCH_SIZE];
+	u8 *scratch = sort_get_scratch(stack_scratch, item_size);
+	Sort_Context c = make_sort_context(collection, item_size, compare, scratch);
+
+	_sort_generic_sort(&c, item_count);
+
+	sort_release_scratch(stack_scratch, scratch);
+}
+void partial_sort(void *collection, u64 item_count, u64 item_size, u64 n, Sort_Compare_Proc compare) {
+	if (item_count <= 1 || n == 0) return;
+
+	u8 stack_scratch[SORT_STACK_SCRATCH_SIZE];
+	u8 *scratch = sort_get_scratch(stack_scratch, item_size);
+	Sort_Context c = make_sort_context(collection, item_size, compare, scratch);
+
+	_sort_generic_partial_sort(&c, 0, item_count, n);
+
+	sort_release_scratch(stack_scratch, scratch);
+}
+void nth_element(void *collection, u64 item_count, u64 item_size, u64 nth, Sort_Compare_Proc compare) {
+	if (item_count <= 1) return;
+
+	u8 stack_scratch[SORT_STACK_SCRATCH_SIZE];
+	u8 *scratch = sort_get_scratch(stack_scratch, item_size);
+	Sort_Context c = make_sort_context(collection, item_size, compare, scratch);
+
+	_sort_generic_nth_element(&c, item_count, nth);
+
+	sort_release_scratch(stack_scratch, scratch);
+}
+
+///
+// Parallel merge sort
+//
+// Bottom-up: insertion sort runs of SORT_MERGE_RUN_SIZE, then merge runs of doubling width,
+// ping-ponging between collection and help_buffer. Every merge pass splits its *output*
+// evenly between jobs, finding where each job starts in the two input runs with a binary
+// search (merge path), so the last passes with only one or two huge merges are as parallel
+// as the first ones.
+
+typedef struct Merge_Sort_Job {
+	u8 *source;
+	u8 *destination;
+	u64 item_count;
+	u64 item_size;
+	Sort_Compare_Proc compare;
+	u64 width;
+	u64 job_count;
+} Merge_Sort_Job;
+
+void merge_sort_runs_job(void *data, u64 job_index) {
+	Merge_Sort_Job *job = (Merge_Sort_Job*)data;
+
+	u64 run_count = (job->item_count + SORT_MERGE_RUN_SIZE - 1) / SORT_MERGE_RUN_SIZE;
+	u64 first_run = (run_count * job_index) / job->job_count;
+	u64 end_run   = (run_count * (job_index+1)) / job->job_count;
+
+	u8 stack_scratch[SORT_STACK_SCRATCH_SIZE];
+	u8 *scratch = sort_get_scratch(stack_scratch, job->item_size);
+	Sort_Context c = make_sort_context(job->source, job->item_size, job->compare, scratch);
+
+	for (u64 run = first_run; run < end_run; run++) {
+		u64 begin = run*SORT_MERGE_RUN_SIZE;
+		u64 end = min(begin + SORT_MERGE_RUN_SIZE, job->item_count);
+		_sort_generic_insertion_sort(&c, begin, end);
+	}
+
+	sort_release_scratch(stack_scratch, scratch);
+}
+
+// How many of the first k merged items come from a. Ties go to a, which keeps the merge stable.
+u64 merge_sort_co_rank(Merge_Sort_Job *job, u8 *a, u64 a_count, u8 *b, u64 b_count, u64 k) {
+	u64 low  = k > b_count ? k - b_count : 0;
+	u64 high = min(k, a_count);
+	while (low < high) {
+		u64 i = (low + high) / 2;
+		u64 j = k - i;
+		if (j > 0 && job->compare(a + i*job->item_size, b + (j-1)*job->item_size) <= 0) {
+			low = i + 1;
+		} else {
+			high = i;
+		}
+	}
+	return low;
+}
+
+void merge_sort_pass_job(void *data, u64 job_index) {
+	Merge_Sort_Job *job = (Merge_Sort_Job*)data;
+
+	u64 size = job->item_size;
+	u64 out_begin = (job->item_count * job_index) / job->job_count;
+	u64 out_end   = (job->item_count * (job_index+1)) / job->job_count;
+
+	u64 k = out_begin;
+	while (k < out_end) {
+		u64 pair_begin = (k / (job->width*2)) * (job->width*2);
+		u64 pair_mid   = min(pair_begin + job->width,   job->item_count);
+		u64 pair_end   = min(pair_begin + job->width*2, job->item_count);
+
+		u8 *a = job->source + pair_begin*size;
+		u8 *b = job->source + pair_mid*size;
+		u64 a_count = pair_mid - pair_begin;
+		u64 b_count = pair_end - pair_mid;
+
+		u64 k0 = k - pair_begin;
+		u64 k1 = min(out_end, pair_end) - pair_begin;
+
+		u64 i  = merge_sort_co_rank(job, a, a_count, b, b_count, k0);
+		u64 j  = k0 - i;
+		u64 i1 = merge_sort_co_rank(job, a, a_count, b, b_count, k1);
+		u64 j1 = k1 - i1;
+
+		u8 *out = job->destination + k*size;
+		while (i < i1 && j < j1) {
+			if (job->compare(a + i*size, b + j*size) <= 0) {
+				memcpy(out, a + i*size, size);
+				i += 1;
+			} else {
+				memcpy(out, b + j*size, size);
+				j += 1;
+			}
+			out += size;
+		}
+		memcpy(out, a + i*size, (i1-i)*size);
+		out += (i1-i)*size;
+		memcpy(out, b + j*size, (j1-j)*size);
+
+		k = pair_begin + k1;
+	}
+}
+
+void parallel_merge_sort(void *collection, void *help_buffer, u64 item_count, u64 item_size, Sort_Compare_Proc compare) {
+	if (item_count <= 1) return;
+
+	Job_Pool *pool = 0;
+	Merge_Sort_Job job = ZERO(Merge_Sort_Job);
+	job.source = (u8*)collection;
+	job.destination = (u8*)help_buffer;
+	job.item_count = item_count;
+	job.item_size = item_size;
+	job.compare = compare;
+	job.job_count = 1;
+
+	if (item_count >= SORT_PARALLEL_THRESHOLD) {
+		pool = get_job_pool();
+		job.job_count = job_pool_get_worker_count(pool)+1;
+	}
+
+	if (pool) job_pool_run(pool, merge_sort_runs_job, &job, job.job_count);
+	else      merge_sort_runs_job(&job, 0);
+
+	for (job.width = SORT_MERGE_RUN_SIZE; job.width < item_count; job.width *= 2) {
+		if (pool) job_pool_run(pool, merge_sort_pass_job, &job, job.job_count);
+		else      merge_sort_pass_job(&job, 0);
+
+		u8 *temp = job.source;
+		job.source = job.destination;
+		job.destination = temp;
+	}
+
+	if (job.source != (u8*)collection) memcpy(collection, job.source, item_count*item_size);
+}
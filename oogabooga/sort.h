@@ -0,0 +1,291 @@
+#ifndef OOGABOOGA_SORT_H
+#define OOGABOOGA_SORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef int (*Sort_Compare_Proc)(const void *a, const void *b);
+
+// Generic versions taking a qsort-style compare proc (negative, 0 or positive).
+// pdq_sort, partial_sort and nth_element are not stable.
+void pdq_sort(void *collection, uint64_t item_count, uint64_t item_size, Sort_Compare_Proc compare);
+// Sorts so the first n items are the n smallest, in order. The rest end up in no particular order.
+void partial_sort(void *collection, uint64_t item_count, uint64_t item_size, uint64_t n, Sort_Compare_Proc compare);
+// Puts the item that would be at index nth in a sorted collection at nth, with nothing greater
+// before it and nothing smaller after it.
+void nth_element(void *collection, uint64_t item_count, uint64_t item_size, uint64_t nth, Sort_Compare_Proc compare);
+// Stable. help_buffer should be same size as collection. Large collections are merged on the job pool.
+void parallel_merge_sort(void *collection, void *help_buffer, uint64_t item_count, uint64_t item_size, Sort_Compare_Proc compare);
+
+/*
+	DEFINE_SORT(Type, less_expr) generates type specialized versions of the above so the
+	comparison gets inlined:
+
+		void sort_Type(Type *items, u64 count);
+		void partial_sort_Type(Type *items, u64 count, u64 n);
+		void nth_element_Type(Type *items, u64 count, u64 nth);
+
+	less_expr is an expression in the pointers a and b (const Type*) that is true if a goes before b:
+
+		DEFINE_SORT(Draw_Quad, a->z < b->z)
+		...
+		sort_Draw_Quad(quads, quad_count);
+
+	Type must be a single identifier, so typedef pointers and such first.
+*/
+#define DEFINE_SORT(Type, less_expr) \
+	typedef struct _Sort_Context_##Type { Type *items; Type tmp; } _Sort_Context_##Type; \
+	bool _sort_less_##Type(const Type *a, const Type *b) { return (less_expr); } \
+	bool _sort_##Type##_less(_Sort_Context_##Type *c, u64 i, u64 j) { return _sort_less_##Type(&c->items[i], &c->items[j]); } \
+	bool _sort_##Type##_less_tmp_item(_Sort_Context_##Type *c, u64 i) { return _sort_less_##Type(&c->tmp, &c->items[i]); } \
+	bool _sort_##Type##_less_item_tmp(_Sort_Context_##Type *c, u64 i) { return _sort_less_##Type(&c->items[i], &c->tmp); } \
+	void _sort_##Type##_swap(_Sort_Context_##Type *c, u64 i, u64 j) { Type t = c->items[i]; c->items[i] = c->items[j]; c->items[j] = t; } \
+	void _sort_##Type##_move(_Sort_Context_##Type *c, u64 dst, u64 src) { c->items[dst] = c->items[src]; } \
+	void _sort_##Type##_load_tmp(_Sort_Context_##Type *c, u64 i) { c->tmp = c->items[i]; } \
+	void _sort_##Type##_store_tmp(_Sort_Context_##Type *c, u64 i) { c->items[i] = c->tmp; } \
+	_SORT_TEMPLATE(_sort_##Type, _Sort_Context_##Type) \
+	void sort_##Type(Type *items, u64 count) { \
+		_Sort_Context_##Type c; c.items = items; \
+		_sort_##Type##_sort(&c, count); \
+	} \
+	void partial_sort_##Type(Type *items, u64 count, u64 n) { \
+		_Sort_Context_##Type c; c.items = items; \
+		_sort_##Type##_partial_sort(&c, 0, count, n); \
+	} \
+	void nth_element_##Type(Type *items, u64 count, u64 nth) { \
+		_Sort_Context_##Type c; c.items = items; \
+		_sort_##Type##_nth_element(&c, count, nth); \
+	}
+
+/*
+	The algorithms, written once against a handful of P##_op(ctx, index) functions so the
+	generic and typed versions share them:
+
+		P##_less(c, i, j), P##_less_tmp_item(c, i), P##_less_item_tmp(c, i),
+		P##_swap(c, i, j), P##_move(c, dst, src), P##_load_tmp(c, i), P##_store_tmp(c, i)
+
+	The sort is pattern-defeating quicksort (Orson Peters): median of 3 (ninther for large
+	ranges) pivots, insertion sort for small ranges, a check for already partitioned ranges,
+	equal element partitioning and heap sort as the fallback when partitions keep coming out
+	unbalanced. nth_element is the same partitioning without recursing into the other side.
+*/
+#define _SORT_INSERTION_THRESHOLD 24
+#define _SORT_NINTHER_THRESHOLD 128
+#define _SORT_PARTIAL_INSERTION_LIMIT 8
+
+#define _SORT_TEMPLATE(P, Ctx) \
+	void P##_insertion_sort(Ctx *c, u64 begin, u64 end) { \
+		if (begin == end) return; \
+		for (u64 i = begin + 1; i < end; i++) { \
+			if (!P##_less(c, i, i - 1)) continue; \
+			P##_load_tmp(c, i); \
+			u64 j = i; \
+			do { P##_move(c, j, j - 1); j--; } while (j > begin && P##_less_tmp_item(c, j - 1)); \
+			P##_store_tmp(c, j); \
+		} \
+	} \
+	/* Assumes the item before begin is not greater than anything in the range */ \
+	void P##_unguarded_insertion_sort(Ctx *c, u64 begin, u64 end) { \
+		if (begin == end) return; \
+		for (u64 i = begin + 1; i < end; i++) { \
+			if (!P##_less(c, i, i - 1)) continue; \
+			P##_load_tmp(c, i); \
+			u64 j = i; \
+			do { P##_move(c, j, j - 1); j--; } while (P##_less_tmp_item(c, j - 1)); \
+			P##_store_tmp(c, j); \
+		} \
+	} \
+	/* Gives up and returns false once it has moved more than a few items */ \
+	bool P##_partial_insertion_sort(Ctx *c, u64 begin, u64 end) { \
+		if (begin == end) return true; \
+		u64 moved = 0; \
+		for (u64 i = begin + 1; i < end; i++) { \
+			if (!P##_less(c, i, i - 1)) continue; \
+			P##_load_tmp(c, i); \
+			u64 j = i; \
+			do { P##_move(c, j, j - 1); j--; } while (j > begin && P##_less_tmp_item(c, j - 1)); \
+			P##_store_tmp(c, j); \
+			moved += i - j; \
+			if (moved > _SORT_PARTIAL_INSERTION_LIMIT) return false; \
+		} \
+		return true; \
+	} \
+	void P##_sort2(Ctx *c, u64 a, u64 b) { \
+		if (P##_less(c, b, a)) P##_swap(c, a, b); \
+	} \
+	void P##_sort3(Ctx *c, u64 a, u64 b, u64 d) { \
+		P##_sort2(c, a, b); P##_sort2(c, b, d); P##_sort2(c, a, b); \
+	} \
+	/* Pivot is at begin. Items equal to the pivot go right. */ \
+	u64 P##_partition_right(Ctx *c, u64 begin, u64 end, bool *already_partitioned) { \
+		P##_load_tmp(c, begin); \
+		u64 first = begin; \
+		u64 last = end; \
+		while (P##_less_item_tmp(c, ++first)); \
+		if (first - 1 == begin) { while (first < last && !P##_less_item_tmp(c, --last)); } \
+		else                    { while (!P##_less_item_tmp(c, --last)); } \
+		*already_partitioned = first >= last; \
+		while (first < last) { \
+			P##_swap(c, first, last); \
+			while (P##_less_item_tmp(c, ++first)); \
+			while (!P##_less_item_tmp(c, --last)); \
+		} \
+		u64 pivot_pos = first - 1; \
+		P##_move(c, begin, pivot_pos); \
+		P##_store_tmp(c, pivot_pos); \
+		return pivot_pos; \
+	} \
+	/* Pivot is at begin. Items equal to the pivot go left, so a run of equal items is done in one go. */ \
+	u64 P##_partition_left(Ctx *c, u64 begin, u64 end) { \
+		P##_load_tmp(c, begin); \
+		u64 first = begin; \
+		u64 last = end; \
+		while (P##_less_tmp_item(c, --last)); \
+		if (last + 1 == end) { while (first < last && !P##_less_tmp_item(c, ++first)); } \
+		else                 { while (!P##_less_tmp_item(c, ++first)); } \
+		while (first < last) { \
+			P##_swap(c, first, last); \
+			while (P##_less_tmp_item(c, --last)); \
+			while (!P##_less_tmp_item(c, ++first)); \
+		} \
+		u64 pivot_pos = last; \
+		P##_move(c, begin, pivot_pos); \
+		P##_store_tmp(c, pivot_pos); \
+		return pivot_pos; \
+	} \
+	void P##_sift_down(Ctx *c, u64 begin, u64 root, u64 count) { \
+		while (true) { \
+			u64 child = root*2 + 1; \
+			if (child >= count) break; \
+			if (child + 1 < count && P##_less(c, begin + child, begin + child + 1)) child += 1; \
+			if (!P##_less(c, begin + root, begin + child)) break; \
+			P##_swap(c, begin + root, begin + child); \
+			root = child; \
+		} \
+	} \
+	/* Heap select the n smallest into [begin, begin+n) and heap sort them */ \
+	void P##_partial_sort(Ctx *c, u64 begin, u64 end, u64 n) { \
+		if (n > end - begin) n = end - begin; \
+		if (n == 0) return; \
+		for (u64 i = n/2; i-- > 0;) P##_sift_down(c, begin, i, n); \
+		for (u64 i = begin + n; i < end; i++) { \
+			if (P##_less(c, i, begin)) { \
+				P##_swap(c, i, begin); \
+				P##_sift_down(c, begin, 0, n); \
+			} \
+		} \
+		for (u64 i = n - 1; i > 0; i--) { \
+			P##_swap(c, begin, begin + i); \
+			P##_sift_down(c, begin, 0, i); \
+		} \
+	} \
+	void P##_choose_pivot(Ctx *c, u64 begin, u64 end) { \
+		u64 size = end - begin; \
+		u64 s2 = size / 2; \
+		if (size > _SORT_NINTHER_THRESHOLD) { \
+			P##_sort3(c, begin, begin + s2, end - 1); \
+			P##_sort3(c, begin + 1, begin + (s2 - 1), end - 2); \
+			P##_sort3(c, begin + 2, begin + (s2 + 1), end - 3); \
+			P##_sort3(c, begin + (s2 - 1), begin + s2, begin + (s2 + 1)); \
+			P##_swap(c, begin, begin + s2); \
+		} else { \
+			P##_sort3(c, begin + s2, begin, end - 1); \
+		} \
+	} \
+	/* Swaps a few items around after a bad partition to break up patterns */ \
+	void P##_shuffle_after_bad_partition(Ctx *c, u64 begin, u64 pivot_pos, u64 end) { \
+		u64 l_size = pivot_pos - begin; \
+		u64 r_size = end - (pivot_pos + 1); \
+		if (l_size >= _SORT_INSERTION_THRESHOLD) { \
+			P##_swap(c, begin, begin + l_size/4); \
+			P##_swap(c, pivot_pos - 1, pivot_pos - l_size/4); \
+			if (l_size > _SORT_NINTHER_THRESHOLD) { \
+				P##_swap(c, begin + 1, begin + (l_size/4 + 1)); \
+				P##_swap(c, begin + 2, begin + (l_size/4 + 2)); \
+				P##_swap(c, pivot_pos - 2, pivot_pos - (l_size/4 + 1)); \
+				P##_swap(c, pivot_pos - 3, pivot_pos - (l_size/4 + 2)); \
+			} \
+		} \
+		if (r_size >= _SORT_INSERTION_THRESHOLD) { \
+			P##_swap(c, pivot_pos + 1, pivot_pos + (1 + r_size/4)); \
+			P##_swap(c, end - 1, end - r_size/4); \
+			if (r_size > _SORT_NINTHER_THRESHOLD) { \
+				P##_swap(c, pivot_pos + 2, pivot_pos + (2 + r_size/4)); \
+				P##_swap(c, pivot_pos + 3, pivot_pos + (3 + r_size/4)); \
+				P##_swap(c, end - 2, end - (1 + r_size/4)); \
+				P##_swap(c, end - 3, end - (2 + r_size/4)); \
+			} \
+		} \
+	} \
+	void P##_pdq_loop(Ctx *c, u64 begin, u64 end, int bad_allowed, bool leftmost) { \
+		while (true) { \
+			u64 size = end - begin; \
+			if (size < _SORT_INSERTION_THRESHOLD) { \
+				if (leftmost) P##_insertion_sort(c, begin, end); \
+				else          P##_unguarded_insertion_sort(c, begin, end); \
+				return; \
+			} \
+			P##_choose_pivot(c, begin, end); \
+			if (!leftmost && !P##_less(c, begin - 1, begin)) { \
+				begin = P##_partition_left(c, begin, end) + 1; \
+				continue; \
+			} \
+			bool already_partitioned; \
+			u64 pivot_pos = P##_partition_right(c, begin, end, &already_partitioned); \
+			u64 l_size = pivot_pos - begin; \
+			u64 r_size = end - (pivot_pos + 1); \
+			if (l_size < size/8 || r_size < size/8) { \
+				if (--bad_allowed == 0) { \
+					P##_partial_sort(c, begin, end, size); \
+					return; \
+				} \
+				P##_shuffle_after_bad_partition(c, begin, pivot_pos, end); \
+			} else if (already_partitioned \
+			        && P##_partial_insertion_sort(c, begin, pivot_pos) \
+			        && P##_partial_insertion_sort(c, pivot_pos + 1, end)) { \
+				return; \
+			} \
+			P##_pdq_loop(c, begin, pivot_pos, bad_allowed, leftmost); \
+			begin = pivot_pos + 1; \
+			leftmost = false; \
+		} \
+	} \
+	int P##_bad_partitions_allowed(u64 count) { \
+		int log2 = 0; \
+		while (count >>= 1) log2 += 1; \
+		return log2 + 1; \
+	} \
+	void P##_sort(Ctx *c, u64 count) { \
+		if (count <= 1) return; \
+		P##_pdq_loop(c, 0, count, P##_bad_partitions_allowed(count), true); \
+	} \
+	void P##_nth_element(Ctx *c, u64 count, u64 nth) { \
+		if (nth >= count) return; \
+		u64 begin = 0; \
+		u64 end = count; \
+		int bad_allowed = P##_bad_partitions_allowed(count); \
+		while (end - begin >= _SORT_INSERTION_THRESHOLD) { \
+			u64 size = end - begin; \
+			P##_choose_pivot(c, begin, end); \
+			if (begin > 0 && !P##_less(c, begin - 1, begin)) { \
+				u64 pivot_pos = P##_partition_left(c, begin, end); \
+				if (nth <= pivot_pos) return; \
+				begin = pivot_pos + 1; \
+				continue; \
+			} \
+			bool already_partitioned; \
+			u64 pivot_pos = P##_partition_right(c, begin, end, &already_partitioned); \
+			if (pivot_pos == nth) return; \
+			if (pivot_pos - begin < size/8 || end - (pivot_pos + 1) < size/8) { \
+				if (--bad_allowed == 0) { \
+					P##_partial_sort(c, begin, end, nth - begin + 1); \
+					return; \
+				} \
+			} \
+			if (nth < pivot_pos) end = pivot_pos; \
+			else                 begin = pivot_pos + 1; \
+		} \
+		P##_insertion_sort(c, begin, end); \
+	}
+
+#endif
@@ -0,0 +1,207 @@
+
+DEFINE_ARRAY(Spatial_Id)
+DEFINE_ARRAY(Spatial_Entry)
+DEFINE_ARRAY(Spatial_Item)
+
+// Grows with max/min so the first entry sets it
+#define SPATIAL_EMPTY_BOUNDS v4(F32_MAX, F32_MAX, -F32_MAX, -F32_MAX)
+
+void spatial_index_init(Spatial_Index *index, Vector4 world_bounds, float cell_size, Allocator allocator) {
+	assert(cell_size > 0, "Spatial index cell size must be more than 0, got %f", (f64)cell_size);
+	assert(world_bounds.z >= world_bounds.x && world_bounds.w >= world_bounds.y, "Spatial index world bounds are inside out");
+
+	*index = ZERO(Spatial_Index);
+	index->world_bounds = world_bounds;
+	index->cell_size = cell_size;
+	index->inverse_cell_size = 1.0f/cell_size;
+	index->cells_x = max(1, (u32)ceilf((world_bounds.z - world_bounds.x)*index->inverse_cell_size));
+	index->cells_y = max(1, (u32)ceilf((world_bounds.w - world_bounds.y)*index->inverse_cell_size));
+	index->allocator = allocator;
+	index->first_free = SPATIAL_ID_NONE;
+
+	u64 cell_count = (u64)index->cells_x*(u64)index->cells_y;
+	index->cells = (Spatial_Cell*)alloc_uninitialized(allocator, cell_count*sizeof(Spatial_Cell));
+	for (u64 i = 0; i < cell_count; i++) {
+		Spatial_Entry_Array_init(&index->cells[i].entries, allocator);
+		index->cells[i].bounds = SPATIAL_EMPTY_BOUNDS;
+	}
+
+	Spatial_Item_Array_init(&index->items, allocator);
+}
+void spatial_index_deinit(Spatial_Index *index) {
+	u64 cell_count = (u64)index->cells_x*(u64)index->cells_y;
+	for (u64 i = 0; i < cell_count; i++) {
+		Spatial_Entry_Array_deinit(&index->cells[i].entries);
+	}
+	if (index->cells) Dealloc(index->allocator, index->cells);
+	Spatial_Item_Array_deinit(&index->items);
+
+	*index = ZERO(Spatial_Index);
+}
+void spatial_index_clear(Spatial_Index *index) {
+	u64 cell_count = (u64)index->cells_x*(u64)index->cells_y;
+	for (u64 i = 0; i < cell_count; i++) {
+		Spatial_Entry_Array_clear(&index->cells[i].entries);
+		index->cells[i].bounds = SPATIAL_EMPTY_BOUNDS;
+	}
+	Spatial_Item_Array_clear(&index->items);
+	index->first_free = SPATIAL_ID_NONE;
+	index->item_count = 0;
+	index->max_half_width = 0;
+	index->max_half_height = 0;
+}
+
+// Things outside of the world bounds go in the edge cells
+inline u32 spatial_index_cell_x(Spatial_Index *index, float x) {
+	float c = (x - index->world_bounds.x)*index->inverse_cell_size;
+	if (!(c >= 0)) return 0; // Also NaN
+	if (c >= (float)index->cells_x) return index->cells_x-1;
+	return (u32)c;
+}
+inline u32 spatial_index_cell_y(Spatial_Index *index, float y) {
+	float c = (y - index->world_bounds.y)*index->inverse_cell_size;
+	if (!(c >= 0)) return 0;
+	if (c >= (float)index->cells_y) return index->cells_y-1;
+	return (u32)c;
+}
+inline u32 spatial_index_cell_of(Spatial_Index *index, Vector4 bounds) {
+	u32 x = spatial_index_cell_x(index, (bounds.x + bounds.z)*0.5f);
+	u32 y = spatial_index_cell_y(index, (bounds.y + bounds.w)*0.5f);
+	return y*index->cells_x + x;
+}
+
+inline void spatial_index_grow_bounds(Spatial_Index *index, Spatial_Cell *cell, Vector4 bounds) {
+	cell->bounds.x = min(cell->bounds.x, bounds.x);
+	cell->bounds.y = min(cell->bounds.y, bounds.y);
+	cell->bounds.z = max(cell->bounds.z, bounds.z);
+	cell->bounds.w = max(cell->bounds.w, bounds.w);
+
+	index->max_half_width  = max(index->max_half_width,  (bounds.z - bounds.x)*0.5f);
+	index->max_half_height = max(index->max_half_height, (bounds.w - bounds.y)*0.5f);
+}
+
+void spatial_index_insert_entry(Spatial_Index *index, Spatial_Id id, u32 cell_index, Vector4 bounds) {
+	Spatial_Cell *cell = &index->cells[cell_index];
+	Spatial_Item *item = &index->items.data[id];
+	item->cell = cell_index;
+	item->slot = (u32)cell->entries.count;
+
+	Spatial_Entry *entry = Spatial_Entry_Array_push_uninitialized(&cell->entries);
+	entry->bounds = bounds;
+	entry->id = id;
+	spatial_index_grow_bounds(index, cell, bounds);
+}
+void spatial_index_remove_entry(Spatial_Index *index, Spatial_Item *item) {
+	Spatial_Cell *cell = &index->cells[item->cell];
+	u32 last = (u32)cell->entries.count-1;
+	if (item->slot != last) {
+		cell->entries.data[item->slot] = cell->entries.data[last];
+		index->items.data[cell->entries.data[item->slot].id].slot = item->slot;
+	}
+	cell->entries.count -= 1;
+	if (cell->entries.count == 0) cell->bounds = SPATIAL_EMPTY_BOUNDS;
+}
+
+Spatial_Id spatial_index_add(Spatial_Index *index, Vector4 bounds, void *data) {
+	Spatial_Id id;
+	if (index->first_free != SPATIAL_ID_NONE) {
+		id = index->first_free;
+		index->first_free = index->items.data[id].slot;
+	} else {
+		assert(index->items.count < SPATIAL_ID_NONE, "Spatial index is full");
+		id = (Spatial_Id)index->items.count;
+		Spatial_Item_Array_push_uninitialized(&index->items);
+	}
+
+	index->items.data[id].data = data;
+	spatial_index_insert_entry(index, id, spatial_index_cell_of(index, bounds), bounds);
+	index->item_count += 1;
+
+	return id;
+}
+
+void spatial_index_update(Spatial_Index *index, Spatial_Id id, Vector4 bounds) {
+	assert(id < index->items.count && index->items.data[id].cell != SPATIAL_ID_NONE, "Invalid spatial index id %u", id);
+	Spatial_Item *item = &index->items.data[id];
+
+	u32 cell_index = spatial_index_cell_of(index, bounds);
+	if (cell_index == item->cell) {
+		Spatial_Cell *cell = &index->cells[cell_index];
+		cell->entries.data[item->slot].bounds = bounds;
+		spatial_index_grow_bounds(index, cell, bounds);
+	} else {
+		spatial_index_remove_entry(index, item);
+		spatial_index_insert_entry(index, id, cell_index, bounds);
+		index->stats.cell_changes += 1;
+	}
+}
+
+void spatial_index_remove(Spatial_Index *index, Spatial_Id id) {
+	assert(id < index->items.count && index->items.data[id].cell != SPATIAL_ID_NONE, "Invalid spatial index id %u", id);
+	Spatial_Item *item = &index->items.data[id];
+
+	spatial_index_remove_entry(index, item);
+	item->cell = SPATIAL_ID_NONE;
+	item->slot = index->first_free;
+	item->data = 0;
+	index->first_free = id;
+	index->item_count -= 1;
+}
+
+void *spatial_index_get_data(Spatial_Index *index, Spatial_Id id) {
+	assert(id < index->items.count && index->items.data[id].cell != SPATIAL_ID_NONE, "Invalid spatial index id %u", id);
+	return index->items.data[id].data;
+}
+Vector4 spatial_index_get_bounds(Spatial_Index *index, Spatial_Id id) {
+	assert(id < index->items.count && index->items.data[id].cell != SPATIAL_ID_NONE, "Invalid spatial index id %u", id);
+	Spatial_Item *item = &index->items.data[id];
+	return index->cells[item->cell].entries.data[item->slot].bounds;
+}
+
+inline bool spatial_bounds_overlap(Vector4 a, Vector4 b) {
+	return !(a.z < b.x || a.x > b.z || a.w < b.y || a.y > b.w);
+}
+
+u64 spatial_index_query_visible(Spatial_Index *index, Vector4 rect, Spatial_Id_Array *results) {
+	Spatial_Id_Array_clear(results);
+	index->stats.cells_visited = 0;
+	index->stats.items_tested = 0;
+	index->stats.items_found = 0;
+	if (index->item_count == 0 || rect.z < rect.x || rect.w < rect.y) return 0;
+
+	// An item overlapping rect has its center (and so its cell) at most a half size outside
+	u32 x1 = spatial_index_cell_x(index, rect.x - index->max_half_width);
+	u32 x2 = spatial_index_cell_x(index, rect.z + index->max_half_width);
+	u32 y1 = spatial_index_cell_y(index, rect.y - index->max_half_height);
+	u32 y2 = spatial_index_cell_y(index, rect.w + index->max_half_height);
+
+	u64 tested = 0;
+	for (u32 y = y1; y <= y2; y++) {
+		Spatial_Cell *row = &index->cells[(u64)y*index->cells_x];
+		for (u32 x = x1; x <= x2; x++) {
+			Spatial_Cell *cell = &row[x];
+			if (cell->entries.count == 0) continue;
+			index->stats.cells_visited += 1;
+			if (!spatial_bounds_overlap(cell->bounds, rect)) continue;
+
+			Spatial_Entry *entries = cell->entries.data;
+			u64 n = cell->entries.count;
+			tested += n;
+
+			// Cells that are completely inside don't need testing item by item
+			if (cell->bounds.x >= rect.x && cell->bounds.z <= rect.z && cell->bounds.y >= rect.y && cell->bounds.w <= rect.w) {
+				Spatial_Id *out = Spatial_Id_Array_push_n_uninitialized(results, n);
+				for (u64 i = 0; i < n; i++) out[i] = entries[i].id;
+				continue;
+			}
+
+			for (u64 i = 0; i < n; i++) {
+				if (spatial_bounds_overlap(entries[i].bounds, rect)) Spatial_Id_Array_push(results, entries[i].id);
+			}
+		}
+	}
+
+	index->stats.items_tested = tested;
+	index->stats.items_found = results->count;
+	return results->count;
+}
@@ -0,0 +1,139 @@
+#ifndef OOGABOOGA_SPATIAL_INDEX_H
+#define OOGABOOGA_SPATIAL_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "base.h"
+#include "linmath.h"
+#include "array.h"
+
+/*
+
+	Spatial index: a loose uniform grid of world space AABBs, so big 2D worlds only submit
+	what the camera can see instead of transforming and culling everything every frame.
+
+	Bounds are Vector4's of x1, y1, x2, y2 like Draw_Quad.uv and scissors.
+
+	Full API:
+
+		// world_bounds is where most things are, things outside still work but pile up in the
+		// edge cells. cell_size is in world units, a few times the size of a typical item.
+		void  spatial_index_init(Spatial_Index *index, Vector4 world_bounds, f32 cell_size, Allocator allocator);
+		void  spatial_index_deinit(Spatial_Index *index);
+		void  spatial_index_clear(Spatial_Index *index);
+
+		Spatial_Id spatial_index_add(Spatial_Index *index, Vector4 bounds, void *data);
+		void  spatial_index_update(Spatial_Index *index, Spatial_Id id, Vector4 bounds);
+		void  spatial_index_remove(Spatial_Index *index, Spatial_Id id);
+
+		void   *spatial_index_get_data(Spatial_Index *index, Spatial_Id id);
+		Vector4 spatial_index_get_bounds(Spatial_Index *index, Spatial_Id id);
+
+		// Clears results and fills it with the items overlapping rect, returns the count
+		u64   spatial_index_query_visible(Spatial_Index *index, Vector4 rect, Spatial_Id_Array *results);
+
+	Usage:
+
+		Spatial_Index world;
+		spatial_index_init(&world, v4(0, 0, 16000, 16000), 512, GetHeapAllocator());
+
+		entity->spatial_id = spatial_index_add(&world, entity_bounds(entity), entity);
+		...
+		// When it moves
+		spatial_index_update(&world, entity->spatial_id, entity_bounds(entity));
+
+		// draw_frame_get_visible_rect gives the world space rect the frame can see
+		spatial_index_query_visible(&world, draw_frame_get_visible_rect(&drawFrame), &visible);
+		for (u64 i = 0; i < visible.count; i++) {
+			Entity *e = (Entity*)spatial_index_get_data(&world, visible.data[i]);
+			draw_image(e->image, e->pos, e->size, COLOR_WHITE);
+		}
+
+		A Draw_List can be registered the same way with draw_list_get_bounds and replayed
+		when it comes back from the query.
+
+	How it works:
+
+		- Each item lives in the one cell its center is in. Cells keep the item bounds next to
+			the ids, so moving within a cell is just overwriting them, and moving to another
+			cell is a swap remove and a push.
+		- Since items stick out of their cell ("loose"), queries look at the cells in rect
+			grown by the largest half size of any item, then skip cells whose bounds (the union
+			of what's in them) don't overlap rect, then test the items.
+		- Results come out in cell order, row by row, and in the order items were put in
+			each cell, so the same index gives the same results every time.
+
+	Things to know:
+
+		- The largest item size only grows, and cell bounds only shrink when the cell
+			empties. One huge item makes every query look at more cells, keep things like
+			backgrounds out of the index.
+		- Ids are reused after they are removed.
+		- Not thread safe. Several threads can query at the same time as long as nothing is
+			added, updated or removed meanwhile.
+
+*/
+
+#define SPATIAL_ID_NONE 0xFFFFFFFF
+
+typedef uint32_t Spatial_Id;
+DECLARE_ARRAY(Spatial_Id)
+
+typedef struct Spatial_Entry {
+	Vector4 bounds;
+	Spatial_Id id;
+} Spatial_Entry;
+DECLARE_ARRAY(Spatial_Entry)
+
+typedef struct Spatial_Cell {
+	Spatial_Entry_Array entries;
+	// Union of the entry bounds, grows with the entries and resets when the cell empties
+	Vector4 bounds;
+} Spatial_Cell;
+
+typedef struct Spatial_Item {
+	void *data;
+	// Cell index and index into its entries, or SPATIAL_ID_NONE if the item was removed
+	uint32_t cell;
+	// For removed items this is the next free id
+	uint32_t slot;
+} Spatial_Item;
+DECLARE_ARRAY(Spatial_Item)
+
+typedef struct Spatial_Index_Stats {
+	// From the last query
+	uint64_t cells_visited;
+	uint64_t items_tested;
+	uint64_t items_found;
+	// Updates that moved an item to another cell
+	uint64_t cell_changes;
+} Spatial_Index_Stats;
+
+typedef struct Spatial_Index {
+	Vector4 world_bounds;
+	float cell_size, inverse_cell_size;
+	uint32_t cells_x, cells_y;
+	Spatial_Cell *cells;
+
+	Spatial_Item_Array items;
+	Spatial_Id first_free;
+	uint64_t item_count;
+
+	// Largest half width/height of any item, how far items can stick out of their cell
+	float max_half_width, max_half_height;
+
+	Spatial_Index_Stats stats;
+	Allocator allocator;
+} Spatial_Index;
+
+void       spatial_index_init(Spatial_Index *index, Vector4 world_bounds, float cell_size, Allocator allocator);
+void       spatial_index_deinit(Spatial_Index *index);
+void       spatial_index_clear(Spatial_Index *index);
+Spatial_Id spatial_index_add(Spatial_Index *index, Vector4 bounds, void *data);
+void       spatial_index_update(Spatial_Index *index, Spatial_Id id, Vector4 bounds);
+void       spatial_index_remove(Spatial_Index *index, Spatial_Id id);
+void      *spatial_index_get_data(Spatial_Index *index, Spatial_Id id);
+Vector4    spatial_index_get_bounds(Spatial_Index *index, Spatial_Id id);
+uint64_t   spatial_index_query_visible(Spatial_Index *index, Vector4 rect, Spatial_Id_Array *results);
+
+#endif
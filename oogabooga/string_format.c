@@ -164,7 +164,12 @@ u64 format_string_to_buffer(char* buffer, u64 count, const char* fmt, va_list ar
                 }
                 format_specifier[specifier_len] = '\0';
 
-                int temp_len = vsnprintf(temp_buffer, sizeof(temp_buffer), format_specifier, args);
+                // On a copy, where va_list is an array type (x86-64 SysV) vsnprintf would take the
+                // argument out of args and the va_arg below would skip the next one
+                va_list args_copy;
+                va_copy(args_copy, args);
+                int temp_len = vsnprintf(temp_buffer, sizeof(temp_buffer), format_specifier, args_copy);
+                va_end(args_copy);
                 switch (format_specifier[specifier_len - 1]) {
                     case 'd': case 'i': va_arg(args, int); break;
                     case 'u': case 'x': case 'X': case 'o': va_arg(args, unsigned int); break;
@@ -1049,6 +1049,22 @@ void test_linmath() {
                 }
             }
 
+            // Affine and rigid inverses should match the general one
+            Matrix4 camera = M4Translate(identity, V3(120.0f, -40.0f, 0.0f));
+            camera = M4RotateZ(camera, 0.7f);
+            Matrix4 rigid_inverse = m4_rigid_inverse(camera);
+            camera = M4Scale(camera, V3(2.5f, 0.5f, 1.0f));
+            Matrix4 general_inverse = m4_inverse(camera);
+            Matrix4 affine_inverse = m4_affine_inverse(camera);
+            assert(m4_is_affine(camera) && !m4_is_affine(M4MakePerspectiveProjection(PI32/2.0f, 1.0f, 1.0f, 10.0f)), "m4_is_affine incorrect");
+            for (int i = 0; i < 16; i++) {
+                assert(fabsf(affine_inverse.data[i] - general_inverse.data[i]) < 0.0001f, "m4_affine_inverse incorrect");
+            }
+            Matrix4 rigid_roundtrip = m4_mul(rigid_inverse, M4RotateZ(M4Translate(identity, V3(120.0f, -40.0f, 0.0f)), 0.7f));
+            for (int i = 0; i < 16; i++) {
+                assert(fabsf(rigid_roundtrip.data[i] - identity.data[i]) < 0.0001f, "m4_rigid_inverse incorrect");
+            }
+
             // Test new rotation helpers
             Matrix4 rot_x = M4RotateX(identity, PI32 * 0.5f);
             assert(floats_roughly_match(rot_x.m[1][2], -1.0f) &&
@@ -1462,34 +1478,94 @@ void test_sort() {
     f64 seconds = 0;
     u64 cycles = 0;
     
-    Draw_Quad *items = Alloc(GetHeapAllocator(), (item_count * 2) * sizeof(Draw_Quad));
-    Draw_Quad *buffer = items + item_count;
-
-    for (int a = 0; a < num_samples; a++) {
-        
-        for (u64 i = 0; i < item_count; i++) {
-            if (i % 2 == 0) items[i].z = get_random_int_in_range(0, pow(2, id_bits) / 2);
-            else items[i].z = i;
+    // Key/index pairs: equal keys must keep their original order
+    {
+        u64 pair_count = 200000; // Over the parallel threshold
+        u64 *pairs = Alloc(GetHeapAllocator(), pair_count * 2 * sizeof(u64));
+        for (u64 i = 0; i < pair_count; i++) {
+            u64 key = get_random_int_in_range(0, 1000);
+            pairs[i] = (key << 32) | i;
+        }
+        u64 *sorted = radix_sort_key_index_pairs(pairs, pairs + pair_count, pair_count, id_bits);
+        for (u64 i = 1; i < pair_count; i++) {
+            assert((sorted[i] >> 32) >= (sorted[i-1] >> 32), "Failed: pairs not correctly sorted");
+            if ((sorted[i] >> 32) == (sorted[i-1] >> 32)) {
+                assert((sorted[i] & 0xFFFFFFFF) > (sorted[i-1] & 0xFFFFFFFF), "Failed: pair sort not stable");
+            }
         }
+        Dealloc(GetHeapAllocator(), pairs);
+    }
     
-        u64 item_size = sizeof(Draw_Quad);
-        u64 sort_value_offset_in_item = offsetof(Draw_Quad, z);
+    // 1M keys only as (z, index) pairs, 1M whole Draw_Quad's and their help buffer don't fit
+    // in the default program memory
+    {
+        u64 pair_count = 1000000;
+        int samples = 3;
+        u64 *pairs = Alloc(GetHeapAllocator(), pair_count * 2 * sizeof(u64));
+        seconds = 0;
+        cycles = 0;
+        for (int a = 0; a < samples; a++) {
+            for (u64 i = 0; i < pair_count; i++) {
+                u64 z = (i % 2 == 0) ? (u64)get_random_int_in_range(0, pow(2, id_bits) / 2) : i % (1 << (id_bits-1));
+                pairs[i] = (z << 32) | i;
+            }
+            
+            float64 start_seconds = OsGetElapsedSeconds();
+            u64 start_cycles = rdtsc();
+            u64 *sorted = radix_sort_key_index_pairs(pairs, pairs + pair_count, pair_count, id_bits);
+            u64 end_cycles = rdtsc();
+            float64 end_seconds = OsGetElapsedSeconds();
+            
+            for (u64 i = 1; i < pair_count; i++) {
+                assert((sorted[i] >> 32) >= (sorted[i-1] >> 32), "Failed: pairs not correctly sorted");
+            }
+            
+            seconds += end_seconds - start_seconds;
+            cycles += end_cycles - start_cycles;
+        }
+        print("Radix sort (%llu (z, index) pairs) took on average %llu cycles and %.2f ms\n", pair_count, cycles / samples, (seconds * 1000.0) / (float64)samples);
+        Dealloc(GetHeapAllocator(), pairs);
+    }
     
-        float64 start_seconds = OsGetElapsedSeconds();
-        u64 start_cycles = rdtsc();
-        radix_sort(items, buffer, item_count, item_size, sort_value_offset_in_item, id_bits);
-        u64 end_cycles = rdtsc();
-        float64 end_seconds = OsGetElapsedSeconds();
+    u64 bench_counts[] = { 10000, 100000 };
+    int bench_samples[] = { 100, 20 };
     
-        for (u64 i = 1; i < item_count; i++) {
-            assert(items[i].z >= items[i-1].z, "Failed: not correctly sorted");
+    for (int b = 0; b < 2; b++) {
+        u64 count = bench_counts[b];
+        int samples = bench_samples[b];
+        
+        Draw_Quad *quads = Alloc(GetHeapAllocator(), (count * 2) * sizeof(Draw_Quad));
+        Draw_Quad *quads_buffer = quads + count;
+        
+        seconds = 0;
+        cycles = 0;
+        for (int a = 0; a < samples; a++) {
+            for (u64 i = 0; i < count; i++) {
+                if (i % 2 == 0) quads[i].z = get_random_int_in_range(0, pow(2, id_bits) / 2);
+                else quads[i].z = i % (1 << (id_bits-1));
+            }
+            
+            float64 start_seconds = OsGetElapsedSeconds();
+            u64 start_cycles = rdtsc();
+            radix_sort(quads, quads_buffer, count, sizeof(Draw_Quad), offsetof(Draw_Quad, z), id_bits);
+            u64 end_cycles = rdtsc();
+            float64 end_seconds = OsGetElapsedSeconds();
+            
+            for (u64 i = 1; i < count; i++) {
+                assert(quads[i].z >= quads[i-1].z, "Failed: not correctly sorted");
+            }
+            
+            seconds += end_seconds - start_seconds;
+            cycles += end_cycles - start_cycles;
         }
         
-        seconds += end_seconds - start_seconds;
-        cycles += end_cycles - start_cycles;
+        print("Radix sort (%llu quads) took on average %llu cycles and %.2f ms\n", count, cycles / samples, (seconds * 1000.0) / (float64)samples);
+        
+        Dealloc(GetHeapAllocator(), quads);
     }
     
-    print("Radix sort took on average %llu cycles and %.2f ms\n", cycles / num_samples, (seconds * 1000.0) / (float64)num_samples);
+    Draw_Quad *items = Alloc(GetHeapAllocator(), (item_count * 2) * sizeof(Draw_Quad));
+    Draw_Quad *buffer = items + item_count;
 
 	seconds = 0;
     cycles = 0;
@@ -1519,162 +1595,2763 @@ void test_sort() {
     
     print("Merge sort took on average %llu cycles and %.2f ms\n", cycles / num_samples, (seconds * 1000.0) / (float64)num_samples);
 }
-#endif /* OOGABOOGA_HEADLESS */
 
-typedef struct Test_Thing {
-    int foo;
-    float bar;
-} Test_Thing;
-void test_growing_array() {
-    Test_Thing *things = 0;
+void test_draw_frame_camera() {
+    if (window.width <= 0 || window.height <= 0) {
+        window.width = 1280;
+        window.height = 720;
+    }
+
+    Draw_Frame *frame = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    DrawFrameReset(frame);
     
-    growing_array_init((void**)&things, sizeof(Test_Thing), GetHeapAllocator());
+    Matrix4 camera = M4Scale(M4Translate(M4Scalar(1.0), v3(50, 20, 0)), v3(2, 2, 1));
+    draw_frame_set_camera_xform(frame, camera);
     
-    Test_Thing new_thing;
-    new_thing.foo = 5;
-    new_thing.bar = 420.69;
-    growing_array_add((void**)&things, &new_thing);
+    Draw_Quad *q = DrawRectInFrame(v2(50, 20), v2(100, 100), COLOR_WHITE, frame);
+    Matrix4 expected = m4_mul(frame->projection, m4_inverse(camera));
+    Vector4 expected_top_right = m4_transform(expected, v4(150, 120, 0, 1));
+    assert(fabsf(q->bottom_left.x) < 0.002f && fabsf(q->bottom_left.y) < 0.003f, "Failed: camera xform not applied");
+    assert(fabsf(q->top_right.x - expected_top_right.x) < 0.002f && fabsf(q->top_right.y - expected_top_right.y) < 0.003f, "Failed: camera xform not applied");
     
-    assert(growing_array_get_valid_count(things) == 1, "Failed: growing_array_get_valid_count");
+    // Changing the camera after drawing must be picked up
+    draw_frame_set_camera_xform(frame, M4Scalar(1.0));
+    q = DrawRectInFrame(v2(0, 0), v2(100, 100), COLOR_WHITE, frame);
+    assert(fabsf(q->bottom_left.x) < 0.002f && fabsf(q->top_right.x - 200.0f/(float)window.width) < 0.002f, "Failed: camera change after drawing");
+
+    // So must assigning it directly, like before there was a cache
+    frame->cameraXform = camera;
+    q = DrawRectInFrame(v2(50, 20), v2(100, 100), COLOR_WHITE, frame);
+    assert(fabsf(q->bottom_left.x) < 0.002f && fabsf(q->top_right.x - expected_top_right.x) < 0.002f, "Failed: direct cameraXform assignment after drawing");
+    frame->projection = m4_make_orthographic_projection(-window.width, window.width, -window.height, window.height, -1, 10);
+    q = DrawRectInFrame(v2(50, 20), v2(100, 100), COLOR_WHITE, frame);
+    assert(fabsf(q->top_right.x - expected_top_right.x*0.5f) < 0.002f, "Failed: direct projection assignment after drawing");
+
+    // Sprites with an unchanged camera
+    u64 count = 100000;
+    DrawFrameReset(frame);
+    draw_frame_set_camera_xform(frame, camera);
+    float64 start = OsGetElapsedSeconds();
+    for (u64 i = 0; i < count; i++) {
+        DrawRectInFrame(v2((float32)(i % 500), (float32)((i / 500) % 300)), v2(8, 8), COLOR_WHITE, frame);
+    }
+    float64 rect_ms = (OsGetElapsedSeconds() - start) * 1000.0;
+    start = OsGetElapsedSeconds();
+    for (u64 i = 0; i < count; i++) {
+        Matrix4 xform = M4Translate(M4Scalar(1.0), v3((float32)(i % 500), (float32)((i / 500) % 300), 0));
+        DrawRectXformInFrame(xform, v2(8, 8), COLOR_WHITE, frame);
+    }
+    float64 xform_ms = (OsGetElapsedSeconds() - start) * 1000.0;
+    print("Drawing %llu rects took %.2f ms, %llu xform rects took %.2f ms\n", count, rect_ms, count, xform_ms);
     
-    new_thing.foo = 1;
-    new_thing.bar = 123.45;
-    growing_array_add((void**)&things, &new_thing);
+    bucket_array_deinit(&frame->quad_buffer);
+    Dealloc(GetHeapAllocator(), frame);
+}
+
+void test_draw_instance_stream() {
+    if (window.width <= 0 || window.height <= 0) {
+        window.width = 1280;
+        window.height = 720;
+    }
+
+    Draw_Frame *frame = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    DrawFrameReset(frame);
     
-    assert(growing_array_get_valid_count(things) == 2, "Failed: growing_array_get_valid_count");
+    Gal_Image image_a = ZERO(Gal_Image);
+    Gal_Image image_b = ZERO(Gal_Image);
     
-    assert(things[0].foo == 5 && floats_roughly_match(things[0].bar, 420.69), "Failed: growing_array_add");
-    assert(things[1].foo == 1 && floats_roughly_match(things[1].bar, 123.45), "Failed: growing_array_add");
+    DrawRectInFrame(v2(0, 0), v2(10, 10), v4(1, 0.5, 0, 1), frame);
+    Draw_Quad *img = DrawImageInFrame(&image_a, v2(-100, -100), v2(32, 32), v4(1, 1, 1, 0.25), frame);
+    img->uv = v4(0.25, 0.5, 0.75, 2.0);
+    img->image_mag_filter = GFX_FILTER_MODE_LINEAR;
+    // Scissors are in window pixels from the bottom left, world 0, 0 is the middle
+    Vector2 middle = v2((float32)window.width/2.0f, (float32)window.height/2.0f);
+    push_window_scissor_in_frame(middle, v2(middle.x+100, middle.y+100), frame);
+    DrawImageInFrame(&image_b, v2(20, 20), v2(8, 8), COLOR_WHITE, frame);
+    DrawImageInFrame(&image_a, v2(30, 30), v2(8, 8), COLOR_WHITE, frame);
+    pop_window_scissor_in_frame(frame);
     
-    growing_array_ordered_remove_by_index((void**)&things, 0);
-    assert(things[0].foo == 1 && floats_roughly_match(things[0].bar, 123.45), "Failed: growing_array_ordered_remove_by_index");
-    assert(growing_array_get_valid_count(things) == 1, "Failed: growing_array_get_valid_count");
+    Draw_Instance_Stream stream = ZERO(Draw_Instance_Stream);
+    draw_frame_build_instance_stream(frame, &stream);
     
-    new_thing.foo = 5;
-    new_thing.bar = 420.69;
-    growing_array_add((void**)&things, &new_thing);
-    assert(things[1].foo == 5 && floats_roughly_match(things[1].bar, 420.69), "Failed: growing_array_add");
+    assert(sizeof(Draw_Quad_Instance) == 48, "Draw_Quad_Instance should be 48 bytes, is %d", (int)sizeof(Draw_Quad_Instance));
+    assert(stream.instances.count == 4, "Failed: instance count");
+    assert(stream.extras.count == 0, "Failed: no extras should be made without userdata");
+    assert(stream.textures.count == 2 && stream.textures.data[0] == &image_a && stream.textures.data[1] == &image_b, "Failed: texture table");
+    assert(stream.scissors.count == 1, "Failed: scissor table");
     
-    assert(growing_array_get_valid_count(things) == 2, "Failed: growing_array_get_valid_count");
+    Draw_Quad_Instance *rect = &stream.instances.data[0];
+    assert(rect->color == (0xFFu << 24 | 128u << 8 | 255u), "Failed: color packing, got %x", rect->color);
+    assert(rect->texture_index == DRAW_INSTANCE_NO_TEXTURE && rect->scissor_index == DRAW_INSTANCE_NO_SCISSOR, "Failed: rect indices");
     
-    growing_array_unordered_remove_by_index((void**)&things, 0);
-    assert(things[0].foo == 5 && floats_roughly_match(things[0].bar, 420.69), "Failed: growing_array_unordered_remove_by_index");
-    assert(growing_array_get_valid_count(things) == 1, "Failed: growing_array_get_valid_count");
+    Draw_Quad_Instance *inst = &stream.instances.data[1];
+    assert(inst->texture_index == 0 && inst->scissor_index == DRAW_INSTANCE_NO_SCISSOR, "Failed: image indices");
+    assert(inst->uv[0] == 16384 && inst->uv[1] == 32768 && inst->uv[2] == 49151 && inst->uv[3] == 65535, "Failed: uv packing");
+    assert(inst->flags == DRAW_INSTANCE_FLAG_MAG_FILTER_LINEAR, "Failed: filter flags");
+
+    // Vectorised packing must round exactly like the scalar one, also out of range and NaN
+    float32 pack_values[] = { 0.0f, 1.0f, -0.5f, 2.0f, 0.5f, 0.25f, 0.75f, 1.0f/255.0f, 0.9999f, 0.00001f, NAN, -INFINITY };
+    for (u64 i = 0; i < sizeof(pack_values)/sizeof(pack_values[0]); i++) {
+        for (u64 j = 0; j < 4; j++) {
+            Vector4 v = v4(pack_values[i], pack_values[(i+j)%12], pack_values[(i+j*5)%12], pack_values[(i+j*7)%12]);
+            Draw_Quad_Instance packed;
+            draw_pack_color_and_uv(&packed, v, v);
+            assert(packed.color == draw_pack_color(v), "Failed: vectorised color packing of %f", (double)pack_values[i]);
+            assert(packed.uv[0] == draw_pack_unorm16(v.x) && packed.uv[1] == draw_pack_unorm16(v.y)
+                && packed.uv[2] == draw_pack_unorm16(v.z) && packed.uv[3] == draw_pack_unorm16(v.w), "Failed: vectorised uv packing of %f", (double)pack_values[i]);
+        }
+    }
+
+    assert(stream.instances.data[2].texture_index == 1 && stream.instances.data[2].scissor_index == 0, "Failed: scissored indices");
+    assert(stream.instances.data[3].texture_index == 0 && stream.instances.data[3].scissor_index == 0, "Failed: scissored indices");
     
+    Draw_Quad *original = (Draw_Quad*)bucket_array_get(&frame->quad_buffer, 1);
+    Vector2 corners[4];
+    draw_quad_instance_get_corners(inst, 0, corners);
+    assert(corners[0].x == original->bottom_left.x  && corners[0].y == original->bottom_left.y,  "Failed: expanded corners");
+    assert(corners[1].x == original->top_left.x     && corners[1].y == original->top_left.y,     "Failed: expanded corners");
+    assert(corners[2].x == original->top_right.x    && corners[2].y == original->top_right.y,    "Failed: expanded corners");
+    assert(corners[3].x == original->bottom_right.x && corners[3].y == original->bottom_right.y, "Failed: expanded corners");
     
-    for (u32 i = 0; i < 100; i += 1) {
-        new_thing.foo = i;
-        new_thing.bar = i * 4.0;
-        growing_array_add((void**)&things, &new_thing);
-    }
+    // Userdata and non-parallelograms go to the extras
+    Draw_Quad *with_userdata = DrawRectInFrame(v2(0, 0), v2(10, 10), COLOR_WHITE, frame);
+    draw_quad_set_userdata(with_userdata, 3, v4(1, 2, 3, 4));
+    assert(with_userdata->userdata[0].x == 0 && with_userdata->userdata[7].w == 0, "Failed: the other userdata slots should be zeroed");
+    Draw_Quad *skewed = DrawRectInFrame(v2(0, 0), v2(100, 100), COLOR_WHITE, frame);
+    skewed->top_right = v2(0.5, 0.9);
     
-    assert(growing_array_get_valid_count(things) == 101, "Failed: growing_array_get_valid_count");
+    draw_frame_build_instance_stream(frame, &stream);
+    assert(stream.instances.count == 6 && stream.extras.count == 6, "Failed: extras should be parallel to instances");
+    assert(stream.instances.data[0].flags == 0, "Failed: flags of instance without extras");
+    assert(stream.instances.data[4].flags == DRAW_INSTANCE_FLAG_HAS_USERDATA, "Failed: userdata flag");
+    assert(stream.extras.data[4].userdata[3].z == 3, "Failed: userdata copy");
+    assert(stream.instances.data[5].flags == DRAW_INSTANCE_FLAG_HAS_TOP_RIGHT, "Failed: top right flag");
+    draw_quad_instance_get_corners(&stream.instances.data[5], &stream.extras.data[5], corners);
+    assert(corners[2].x == 0.5f && corners[2].y == 0.9f, "Failed: top right from extras");
     
-    // Unordered remove by pointer
-    Test_Thing *thing = &things[50];
-    Test_Thing copy = *thing;
-    bool found = growing_array_unordered_remove_by_pointer((void**)&things, thing);
-    assert(found, "Failed: growing_array_unordered_remove_by_pointer");
-    assert(!bytes_match(&copy, thing, sizeof(Test_Thing)), "Failed: growing_array_unordered_remove_by_pointer");
+    // Submission bandwidth: packing instances vs copying the whole Draw_Quad's. Kept at 100K
+    // quads so it fits in the default program memory.
+    u64 bench_counts[] = { 10000, 100000 };
+    int bench_samples[] = { 50, 20 };
     
-    // Ordered remove by pointer
-    thing = &things[50];
-    copy = *thing;
-    found = growing_array_ordered_remove_by_pointer((void**)&things, thing);
-    assert(found, "Failed: growing_array_unordered_remove_by_pointer");
-    assert(!bytes_match(&copy, thing, sizeof(Test_Thing)), "Failed: growing_array_unordered_remove_by_pointer");
+    for (int b = 0; b < 2; b++) {
+        u64 count = bench_counts[b];
+        int samples = bench_samples[b];
+        
+        float64 record_seconds = 0;
+        for (int a = 0; a < samples; a++) {
+            DrawFrameReset(frame);
+            float64 start = OsGetElapsedSeconds();
+            for (u64 i = 0; i < count; i++) {
+                float32 x = (float32)(i % 1000) - 500.0f;
+                float32 y = (float32)((i / 1000) % 600) - 300.0f;
+                DrawImageInFrame(i % 3 ? &image_a : &image_b, v2(x, y), v2(16, 16), COLOR_WHITE, frame);
+            }
+            record_seconds += OsGetElapsedSeconds() - start;
+        }
+        u64 quad_count = bucket_array_get_count(&frame->quad_buffer);
+        
+        Draw_Quad *upload = Alloc(GetHeapAllocator(), quad_count*sizeof(Draw_Quad));
+        
+        float64 quad_seconds = 0;
+        float64 instance_seconds = 0;
+        for (int a = 0; a < samples; a++) {
+            float64 start = OsGetElapsedSeconds();
+            u64 offset = 0;
+            for (u64 c = 0; c < bucket_array_get_chunk_count(&frame->quad_buffer); c++) {
+                u64 n;
+                void *chunk = bucket_array_get_chunk(&frame->quad_buffer, c, &n);
+                memcpy(upload + offset, chunk, n*sizeof(Draw_Quad));
+                offset += n;
+            }
+            quad_seconds += OsGetElapsedSeconds() - start;
+            
+            start = OsGetElapsedSeconds();
+            draw_frame_build_instance_stream(frame, &stream);
+            instance_seconds += OsGetElapsedSeconds() - start;
+        }
+        assert(stream.instances.count == quad_count && stream.extras.count == 0, "Failed: instance stream for benchmark");
+        
+        print("Submitting %llu quads (recorded in %.2f ms): Draw_Quad %.2f ms (%llu mb), instances %.2f ms (%llu mb)\n",
+            quad_count, (record_seconds * 1000.0) / (float64)samples,
+            (quad_seconds * 1000.0) / (float64)samples, (quad_count*sizeof(Draw_Quad)) / (1024*1024),
+            (instance_seconds * 1000.0) / (float64)samples, (quad_count*sizeof(Draw_Quad_Instance)) / (1024*1024));
+        
+        Dealloc(GetHeapAllocator(), upload);
+    }
     
-    assert(growing_array_get_valid_count(things) == 99, "Failed: growing_array_get_valid_count");
+    draw_instance_stream_deinit(&stream);
+    bucket_array_deinit(&frame->quad_buffer);
+    Dealloc(GetHeapAllocator(), frame);
 }
 
-
-typedef struct {
-    Binary_Semaphore *sem;
-    volatile LONG *counter;
-    int increments;
-} Test_Args;
-
-void increment_thread_proc(Thread *t) {
-    Test_Args *test_args = (Test_Args *)t->data;
-    for (int i = 0; i < test_args->increments; i++) {
-        OsBinarySemaphoreWait(test_args->sem);
-        InterlockedIncrement(test_args->counter);
-        OsBinarySemaphoreSignal(test_args->sem);
+void test_draw_calls_check(Draw_Instance_Stream *stream) {
+    u64 next = 0;
+    for (u64 c = 0; c < stream->calls.count; c++) {
+        Draw_Call *call = &stream->calls.data[c];
+        assert(call->first_instance == next && call->instance_count > 0, "Failed: draw calls should cover the instances in order");
+        assert(call->texture_count <= DRAW_CALL_MAX_TEXTURES, "Failed: too many textures in a draw call");
+        for (u64 i = call->first_instance; i < call->first_instance + call->instance_count; i++) {
+            Draw_Quad_Instance *inst = &stream->instances.data[i];
+            assert(inst->scissor_index == call->scissor_index, "Failed: instance scissor doesn't match its draw call");
+            if (inst->texture_index == DRAW_INSTANCE_NO_TEXTURE) continue;
+            assert(inst->texture_slot < call->texture_count && call->textures[inst->texture_slot] == inst->texture_index, "Failed: texture slot of instance %llu", i);
+        }
+        next += call->instance_count;
     }
+    assert(next == stream->instances.count, "Failed: draw calls should cover all instances");
+    assert(stream->stats.draw_call_count == stream->calls.count, "Failed: draw call count stat");
 }
-void test_os_binary_semaphore() {
-    {
-        // Multithreaded increment test
-        const int num_threads = 100;
-        const int increments_per_thread = 10000;
-
-        Binary_Semaphore sem;
-        OsBinarySemaphoreInit(&sem, true);
 
-        LONG counter = 0;
-        Thread threads[num_threads];
-        Test_Args args = { &sem, &counter, increments_per_thread };
+void test_draw_calls() {
+    if (window.width <= 0 || window.height <= 0) {
+        window.width = 1280;
+        window.height = 720;
+    }
 
-        for (int i = 0; i < num_threads; i++) {
-            OsThreadInit(&threads[i], increment_thread_proc);
-            threads[i].data = &args;
-            OsThreadStart(&threads[i]);
+    Draw_Frame *frame = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    DrawFrameReset(frame);
+    
+    const u64 image_count = 40;
+    Gal_Image images[40];
+    memset(images, 0, sizeof(images));
+    
+    Draw_Instance_Stream stream = ZERO(Draw_Instance_Stream);
+    
+    // Interleaved images share a call until the call runs out of texture slots
+    for (u64 i = 0; i < 3*image_count; i++) {
+        // The index goes in the color so we can check the order after sorting
+        DrawImageInFrame(&images[i % image_count], v2(0, 0), v2(8, 8), v4((float32)i/255.0f, 1, 1, 1), frame);
+    }
+    draw_frame_build_instance_stream(frame, &stream);
+    test_draw_calls_check(&stream);
+    assert(stream.calls.count == 4 && stream.stats.texture_limit_breaks == 3, "Failed: unsorted draw calls, got %llu", stream.calls.count);
+    assert(stream.calls.data[0].texture_count == DRAW_CALL_MAX_TEXTURES && stream.calls.data[0].instance_count == DRAW_CALL_MAX_TEXTURES, "Failed: first call should fill every slot");
+    assert(stream.stats.sorted_layer_count == 0, "Failed: nothing should be sorted without enable_batch_sorting");
+    
+    // Sorted by texture, with the quads of each texture in their original order
+    frame->enable_batch_sorting = true;
+    draw_frame_build_instance_stream(frame, &stream);
+    test_draw_calls_check(&stream);
+    assert(stream.calls.count == 2 && stream.stats.sorted_layer_count == 1, "Failed: sorted draw calls, got %llu", stream.calls.count);
+    assert(stream.calls.data[0].instance_count == DRAW_CALL_MAX_TEXTURES*3, "Failed: first sorted call");
+    for (u64 i = 0; i < stream.instances.count; i++) {
+        u64 texture = i/3;
+        u64 original = texture + (i%3)*image_count;
+        assert(stream.instances.data[i].texture_index == texture, "Failed: sorted texture order");
+        assert((stream.instances.data[i].color & 0xFF) == original, "Failed: sorting should be stable");
+    }
+    
+    // Quads never move to another z layer, and scissors split calls
+    DrawFrameReset(frame);
+    frame->enable_batch_sorting = true;
+    Gal_Image image_a = ZERO(Gal_Image);
+    Gal_Image image_b = ZERO(Gal_Image);
+    Vector2 middle = v2((float32)window.width/2.0f, (float32)window.height/2.0f);
+    for (u64 layer = 0; layer < 3; layer++) {
+        push_z_layer_in_frame((s32)layer, frame);
+        for (u64 i = 0; i < 100; i++) {
+            Vector2 min = i % 2 ? middle : v2(middle.x-50, middle.y-50);
+            push_window_scissor_in_frame(min, v2(middle.x+100, middle.y+100), frame);
+            DrawImageInFrame(i % 3 ? &image_a : &image_b, v2(0, 0), v2(8, 8), COLOR_WHITE, frame);
+            DrawRectInFrame(v2(0, 0), v2(8, 8), COLOR_WHITE, frame);
+            pop_window_scissor_in_frame(frame);
         }
-
-        for (int i = 0; i < num_threads; i++) {
-            OsThreadJoin(&threads[i]);
-            OsThreadDestroy(&threads[i]);
+        pop_z_layer_in_frame(frame);
+    }
+    draw_frame_build_instance_stream(frame, &stream);
+    test_draw_calls_check(&stream);
+    assert(stream.scissors.count == 2, "Failed: a scissor pushed again should reuse its index, got %llu", stream.scissors.count);
+    for (u64 i = 0; i < stream.instances.count; i++) {
+        assert(stream.instances.data[i].z == (s32)(i/200), "Failed: batch sorting moved a quad to another z layer");
+    }
+    // 2 scissors x 3 layers, textures all fit in one call
+    assert(stream.calls.count == 6 && stream.stats.sorted_layer_count == 3, "Failed: z layered draw calls, got %llu", stream.calls.count);
+    
+    frame->enable_batch_sorting = false;
+    draw_frame_build_instance_stream(frame, &stream);
+    test_draw_calls_check(&stream);
+    assert(stream.calls.count == 300, "Failed: every scissor change should split an unsorted stream, got %llu", stream.calls.count);
+    
+    // A frame full of sprites from different textures
+    const u64 count = 100000;
+    const u64 bench_image_count = 64;
+    Gal_Image *bench_images = Alloc(GetHeapAllocator(), bench_image_count*sizeof(Gal_Image));
+    memset(bench_images, 0, bench_image_count*sizeof(Gal_Image));
+    
+    DrawFrameReset(frame);
+    for (u64 i = 0; i < count; i++) {
+        if (i % 10000 == 0) {
+            if (i) pop_z_layer_in_frame(frame);
+            push_z_layer_in_frame((s32)(i/10000), frame);
         }
-
-        assert(counter == num_threads * increments_per_thread, "Failed: Multithreaded increment test");
-
-        OsBinarySemaphoreDestroy(&sem);
+        float32 x = (float32)(i % 1000) - 500.0f;
+        float32 y = (float32)((i / 1000) % 600) - 300.0f;
+        DrawImageInFrame(&bench_images[get_random_int_in_range(0, bench_image_count-1)], v2(x, y), v2(16, 16), COLOR_WHITE, frame);
     }
+    pop_z_layer_in_frame(frame);
+    
+    for (int sorted = 0; sorted < 2; sorted++) {
+        frame->enable_batch_sorting = sorted;
+        const int samples = 10;
+        float64 start = OsGetElapsedSeconds();
+        for (int a = 0; a < samples; a++) draw_frame_build_instance_stream(frame, &stream);
+        float64 ms = ((OsGetElapsedSeconds() - start) * 1000.0) / (float64)samples;
+        test_draw_calls_check(&stream);
+        print("%llu quads with %llu textures, %s: %llu draw calls, %.2f ms\n", count, bench_image_count, sorted ? "batch sorted" : "unsorted", stream.calls.count, ms);
+    }
+    
+    Dealloc(GetHeapAllocator(), bench_images);
+    draw_instance_stream_deinit(&stream);
+    bucket_array_deinit(&frame->quad_buffer);
+    Dealloc(GetHeapAllocator(), frame);
+}
 
-    {
-        // Signal before wait test
-        Binary_Semaphore sem;
-        OsBinarySemaphoreInit(&sem, false);
-
-        LONG counter = 0;
-
-        Thread thread;
-        Test_Args args = { &sem, &counter, 1 };
-        OsThreadInit(&thread, increment_thread_proc);
-        thread.data = &args;
-        OsThreadStart(&thread);
-
-        // Signal the semaphore after a delay
-        Sleep(100);
-        OsBinarySemaphoreSignal(&sem);
-
-        OsThreadJoin(&thread);
-        OsThreadDestroy(&thread);
+// Every pixel of the sprite is its value, checks the sprite and its extruded border in the page
+void test_atlas_check_sprite(Texture_Atlas *atlas, Gal_Image *image, u8 value) {
+    Atlas_Sprite *sprite = image->atlas_sprite;
+    assert(sprite && sprite->page, "Failed: sprite should be resident");
+    Atlas_Page *page = &atlas->pages[sprite->page_index];
+    u32 p = atlas->padding;
+    
+    for (u32 y = 0; y < image->height + 2*p; y++) {
+        for (u32 x = 0; x < image->width + 2*p; x++) {
+            u8 pixel = page->pixels[(u64)(sprite->y + y)*atlas->page_width + sprite->x + x];
+            assert(pixel == value, "Failed: atlas pixel %u, %u of sprite %u is %u", x, y, (u32)value, (u32)pixel);
+        }
+    }
+    
+    assert(sprite->uv.x*atlas->page_width == (float32)(sprite->x + p), "Failed: atlas uv");
+    assert(sprite->uv.w*atlas->page_height == (float32)(sprite->y + p + image->height), "Failed: atlas uv");
+}
 
-        assert(counter == 1, "Failed: Signal before wait test");
+void test_texture_atlas() {
+    Allocator heap = GetHeapAllocator();
+    u8 *pixels = Alloc(heap, 128*128);
+    
+    Texture_Atlas *atlas = Alloc(heap, sizeof(Texture_Atlas));
+    atlas_init(atlas, 64, 64, 1, heap);
+    atlas->max_pages = 1;
+    
+    // Sprites don't overlap, padding is extruded
+    Gal_Image *sprites[32];
+    u32 sprite_count = 0;
+    for (u32 i = 0; i < 32; i++) {
+        u32 w = 4 + (i*7) % 9;
+        u32 h = 4 + (i*5) % 7;
+        memset(pixels, (int)(i+1), w*h);
+        Gal_Image *sprite = atlas_add(atlas, w, h, pixels, 0);
+        if (!sprite) break;
+        sprites[sprite_count++] = sprite;
+    }
+    assert(sprite_count > 16, "Failed: only %u sprites fit in the atlas", sprite_count);
+    for (u32 i = 0; i < sprite_count; i++) {
+        test_atlas_check_sprite(atlas, sprites[i], (u8)(i+1));
+        assert(sprites[i]->width == 4 + (i*7) % 9 && sprites[i]->atlas_sprite->page == &atlas->pages[0].image, "Failed: sprite image");
+    }
+    
+    // draw_image draws the page with the sprite's uv
+    if (window.width <= 0 || window.height <= 0) {
+        window.width = 1280;
+        window.height = 720;
+    }
+    Draw_Frame *frame = Alloc(heap, sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    DrawFrameReset(frame);
+    
+    Atlas_Sprite *first = sprites[0]->atlas_sprite;
+    Draw_Quad *q = DrawImageInFrame(sprites[0], v2(0, 0), v2(10, 10), COLOR_WHITE, frame);
+    assert(q->image == &atlas->pages[0].image, "Failed: sprite should be drawn from its page");
+    assert(q->uv.x == first->uv.x && q->uv.y == first->uv.y && q->uv.z == first->uv.z && q->uv.w == first->uv.w, "Failed: sprite uv");
+    
+    Vector2 position = v2(0, 0);
+    Vector2 size = v2(10, 10);
+    Vector4 half_uv = v4(0.5, 0, 1, 0.5);
+    draw_images_in_frame(sprites[1], &position, &size, 0, &half_uv, 1, frame);
+    Atlas_Sprite *second = sprites[1]->atlas_sprite;
+    q = (Draw_Quad*)bucket_array_get(&frame->quad_buffer, 1);
+    assert(q->image == &atlas->pages[0].image, "Failed: batched sprite should be drawn from its page");
+    assert(fabsf(q->uv.x - (second->uv.x + second->uv.z)*0.5f) < 0.0001f && q->uv.y == second->uv.y, "Failed: batched sprite uv");
+    
+    // Removing makes room again through a repack
+    u64 generation = atlas->generation;
+    for (u32 i = 0; i < sprite_count; i += 2) atlas_remove(atlas, sprites[i]);
+    u32 added = 0;
+    for (u32 i = 0; i < sprite_count; i += 2) {
+        memset(pixels, 200, 12*10);
+        if (atlas_add(atlas, 12, 10, pixels, 0)) added += 1;
+    }
+    assert(added > 0 && atlas->repack_count > 0 && atlas->generation != generation, "Failed: removed space should be reused after a repack");
+    for (u32 i = 1; i < sprite_count; i += 2) test_atlas_check_sprite(atlas, sprites[i], (u8)(i+1));
+    
+    // Evictable sprites make room for new ones, least recently drawn first
+    atlas_deinit(atlas);
+    atlas_init(atlas, 64, 64, 1, heap);
+    atlas->max_pages = 1;
+    Gal_Image *cached[16];
+    for (u32 i = 0; i < 16; i++) {
+        memset(pixels, (int)(i+1), 14*14);
+        cached[i] = atlas_add(atlas, 14, 14, pixels, ATLAS_SPRITE_EVICTABLE);
+        assert(cached[i], "Failed: 16 padded 14x14 sprites should fit in 64x64");
+    }
+    // Draw all but the first one again so it's the oldest
+    for (u32 i = 1; i < 16; i++) DrawImageInFrame(cached[i], v2(0, 0), v2(14, 14), COLOR_WHITE, frame);
+    memset(pixels, 99, 14*14);
+    Gal_Image *newest = atlas_add(atlas, 14, 14, pixels, 0);
+    assert(newest && !atlas_is_resident(cached[0]) && atlas->eviction_count == 1, "Failed: eviction");
+    for (u32 i = 1; i < 16; i++) test_atlas_check_sprite(atlas, cached[i], (u8)(i+1));
+    test_atlas_check_sprite(atlas, newest, 99);
+    
+    // Nothing evictable left to make room
+    assert(!atlas_add(atlas, 60, 60, pixels, 0), "Failed: add should fail when nothing can be evicted");
+    assert(!atlas_add(atlas, 64, 64, pixels, 0), "Failed: sprites bigger than a page can't be added");
+    atlas_deinit(atlas);
+    
+    // Packing a load of sprites, then drawing all of them in one draw call
+    const u32 bench_count = 1000;
+    Gal_Image **bench_sprites = Alloc(heap, bench_count*sizeof(Gal_Image*));
+    atlas_init(atlas, 1024, 1024, 4, heap);
+    memset(pixels, 255, 40*40*4 < 128*128 ? 40*40*4 : 128*128);
+    
+    u64 sprite_area = 0;
+    float64 start = OsGetElapsedSeconds();
+    for (u32 i = 0; i < bench_count; i++) {
+        u32 w = (u32)get_random_int_in_range(8, 40);
+        u32 h = (u32)get_random_int_in_range(8, 40);
+        bench_sprites[i] = atlas_add(atlas, w, h, pixels, 0);
+        assert(bench_sprites[i], "Failed: bench sprite didn't fit");
+        sprite_area += (u64)w*h;
+    }
+    float64 pack_ms = (OsGetElapsedSeconds() - start)*1000.0;
+    
+    start = OsGetElapsedSeconds();
+    atlas_repack(atlas);
+    float64 repack_ms = (OsGetElapsedSeconds() - start)*1000.0;
+    
+    DrawFrameReset(frame);
+    for (u32 i = 0; i < bench_count; i++) {
+        DrawImageInFrame(bench_sprites[i], v2((float32)(i % 40)*16 - 320, (float32)(i / 40)*16 - 200), v2(16, 16), COLOR_WHITE, frame);
+    }
+    Draw_Instance_Stream stream = ZERO(Draw_Instance_Stream);
+    draw_frame_build_instance_stream(frame, &stream);
+    assert(stream.textures.count == atlas->page_count, "Failed: sprites should be drawn from the pages");
+    assert(stream.calls.count == 1, "Failed: %u sprites from one atlas should be one draw call, got %llu", bench_count, stream.calls.count);
+    
+    print("Packed %u sprites in %.2f ms (%u pages, %.0f%% used), repacked in %.2f ms, drawn in %llu draw call\n",
+        bench_count, pack_ms, atlas->page_count, 100.0*(float64)sprite_area/((float64)atlas->page_count*1024*1024), repack_ms, stream.calls.count);
+    
+    draw_instance_stream_deinit(&stream);
+    atlas_deinit(atlas);
+    Dealloc(heap, bench_sprites);
+    Dealloc(heap, atlas);
+    Dealloc(heap, pixels);
+    bucket_array_deinit(&frame->quad_buffer);
+    Dealloc(heap, frame);
+}
 
-        OsBinarySemaphoreDestroy(&sem);
+bool test_draw_quads_match(Draw_Quad *a, Draw_Quad *b) {
+    // Snapping may round a corner that lands right between two pixels either way
+    float32 tolerance_x = 2.0f/(float32)window.width + 0.0001f;
+    float32 tolerance_y = 2.0f/(float32)window.height + 0.0001f;
+    Vector2 *ca = &a->bottom_left;
+    Vector2 *cb = &b->bottom_left;
+    for (int c = 0; c < 4; c++) {
+        if (fabsf(ca[c].x - cb[c].x) > tolerance_x || fabsf(ca[c].y - cb[c].y) > tolerance_y) return false;
     }
+    return a->image == b->image && a->z == b->z && a->has_scissor == b->has_scissor
+        && memcmp(&a->color, &b->color, sizeof(Vector4)) == 0;
+}
 
-    {
-        // High contention test
-        const int num_threads = 100;
-        const int increments_per_thread = 1000;
+void test_draw_batched() {
+    if (window.width <= 0 || window.height <= 0) {
+        window.width = 1280;
+        window.height = 720;
+    }
 
-        Binary_Semaphore sem;
-        OsBinarySemaphoreInit(&sem, true);
+    Draw_Frame *single = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    Draw_Frame *batched = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    draw_frame_init(single);
+    draw_frame_init(batched);
+    DrawFrameReset(single);
+    DrawFrameReset(batched);
+    
+    Matrix4 camera = M4Scale(M4Translate(M4Scalar(1.0), v3(-30, 10, 0)), v3(1.5, 1.5, 1));
+    draw_frame_set_camera_xform(single, camera);
+    draw_frame_set_camera_xform(batched, camera);
+    
+    // Odd count so the last batch is partial, and a bunch of them are off screen
+    const u64 n = 103;
+    Vector2 positions[103];
+    Vector2 sizes[103];
+    Vector4 colors[103];
+    Vector4 uvs[103];
+    Matrix4 xforms[103];
+    for (u64 i = 0; i < n; i++) {
+        positions[i] = v2((float32)i*23.0f - 1200.0f, (float32)(i % 7)*90.0f - 300.0f);
+        sizes[i] = v2(10.0f + (float32)(i % 5), 20.0f - (float32)(i % 3));
+        colors[i] = v4((float32)i/(float32)n, 0.5f, 0.25f, 1.0f);
+        uvs[i] = v4(0.1f*(float32)(i % 4), 0, 1, 0.5f);
+        xforms[i] = M4RotateZ(M4Translate(M4Scalar(1.0), v3(positions[i].x, positions[i].y, 0)), (float32)i*0.1f);
+    }
+    
+    Gal_Image image = ZERO(Gal_Image);
+    push_z_layer_in_frame(5, single);
+    push_z_layer_in_frame(5, batched);
+    
+    u64 expected = 0;
+    for (u64 i = 0; i < n; i++) {
+        if (DrawRectInFrame(positions[i], sizes[i], colors[i], single) != &_nil_quad) expected += 1;
+    }
+    u64 drawn = draw_rects_in_frame(positions, sizes, colors, n, batched);
+    assert(drawn == expected && expected > 0 && expected < n, "Failed: batched rects culled %llu, expected %llu", n - drawn, n - expected);
+    
+    for (u64 i = 0; i < n; i++) {
+        Draw_Quad *q = DrawImageInFrame(&image, positions[i], sizes[i], COLOR_WHITE, single);
+        q->uv = uvs[i];
+    }
+    drawn = draw_images_in_frame(&image, positions, sizes, 0, uvs, n, batched);
+    assert(drawn == expected, "Failed: batched images");
+    
+    expected = 0;
+    for (u64 i = 0; i < n; i++) {
+        if (DrawRectXformInFrame(xforms[i], sizes[i], colors[i], single) != &_nil_quad) expected += 1;
+    }
+    drawn = draw_rects_xform_in_frame(xforms, sizes, colors, n, batched);
+    assert(drawn == expected, "Failed: batched xform rects culled %llu, expected %llu", n - drawn, n - expected);
+    
+    u64 count = bucket_array_get_count(&single->quad_buffer);
+    assert(count == bucket_array_get_count(&batched->quad_buffer), "Failed: batched quad count");
+    for (u64 i = 0; i < count; i++) {
+        Draw_Quad *a = (Draw_Quad*)bucket_array_get(&single->quad_buffer, i);
+        Draw_Quad *b = (Draw_Quad*)bucket_array_get(&batched->quad_buffer, i);
+        assert(test_draw_quads_match(a, b), "Failed: batched quad %llu does not match", i);
+        assert(a->image == 0 || memcmp(&a->uv, &b->uv, sizeof(Vector4)) == 0, "Failed: batched uv %llu", i);
+    }
+    
+    // Sprites, one call each vs one call for all of them
+    const u64 bench_count = 100000;
+    Vector2 *bench_positions = Alloc(GetHeapAllocator(), bench_count*sizeof(Vector2));
+    Vector2 *bench_sizes = Alloc(GetHeapAllocator(), bench_count*sizeof(Vector2));
+    Vector4 *bench_colors = Alloc(GetHeapAllocator(), bench_count*sizeof(Vector4));
+    Matrix4 *bench_xforms = Alloc(GetHeapAllocator(), bench_count*sizeof(Matrix4));
+    for (u64 i = 0; i < bench_count; i++) {
+        bench_positions[i] = v2((float32)(i % 500), (float32)((i / 500) % 300));
+        bench_sizes[i] = v2(8, 8);
+        bench_colors[i] = COLOR_WHITE;
+        bench_xforms[i] = M4Translate(M4Scalar(1.0), v3(bench_positions[i].x, bench_positions[i].y, 0));
+    }
+    
+    float64 single_ms = 0, batched_ms = 0, single_xform_ms = 0, batched_xform_ms = 0;
+    const int samples = 5;
+    for (int s = 0; s < samples; s++) {
+        DrawFrameReset(single);
+        DrawFrameReset(batched);
+        draw_frame_set_camera_xform(single, camera);
+        draw_frame_set_camera_xform(batched, camera);
+        
+        float64 start = OsGetElapsedSeconds();
+        for (u64 i = 0; i < bench_count; i++) DrawRectInFrame(bench_positions[i], bench_sizes[i], bench_colors[i], single);
+        single_ms += (OsGetElapsedSeconds() - start)*1000.0;
+        
+        start = OsGetElapsedSeconds();
+        draw_rects_in_frame(bench_positions, bench_sizes, bench_colors, bench_count, batched);
+        batched_ms += (OsGetElapsedSeconds() - start)*1000.0;
+        
+        start = OsGetElapsedSeconds();
+        for (u64 i = 0; i < bench_count; i++) DrawRectXformInFrame(bench_xforms[i], bench_sizes[i], bench_colors[i], single);
+        single_xform_ms += (OsGetElapsedSeconds() - start)*1000.0;
+        
+        start = OsGetElapsedSeconds();
+        draw_rects_xform_in_frame(bench_xforms, bench_sizes, bench_colors, bench_count, batched);
+        batched_xform_ms += (OsGetElapsedSeconds() - start)*1000.0;
+    }
+    print("Drawing %llu rects: single %.2f ms, batched %.2f ms. Xform: single %.2f ms, batched %.2f ms\n", bench_count,
+        single_ms/samples, batched_ms/samples, single_xform_ms/samples, batched_xform_ms/samples);
+    
+    Dealloc(GetHeapAllocator(), bench_positions);
+    Dealloc(GetHeapAllocator(), bench_sizes);
+    Dealloc(GetHeapAllocator(), bench_colors);
+    Dealloc(GetHeapAllocator(), bench_xforms);
+    bucket_array_deinit(&single->quad_buffer);
+    bucket_array_deinit(&batched->quad_buffer);
+    Dealloc(GetHeapAllocator(), single);
+    Dealloc(GetHeapAllocator(), batched);
+}
 
-        LONG counter = 0;
-        Thread threads[num_threads];
-        Test_Args args = { &sem, &counter, increments_per_thread };
+void test_draw_pixel_snapping() {
+    if (window.width <= 0 || window.height <= 0) {
+        window.width = 1280;
+        window.height = 720;
+    }
+    float32 pixel_width = 2.0f/(float32)window.width;
+    float32 pixel_height = 2.0f/(float32)window.height;
 
-        for (int i = 0; i < num_threads; i++) {
-            OsThreadInit(&threads[i], increment_thread_proc);
-            threads[i].data = &args;
-            OsThreadStart(&threads[i]);
+    Draw_Frame *frame = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    DrawFrameReset(frame);
+    
+    Vector2 position = v2(10.3f, -20.7f);
+    Vector2 size = v2(33.4f, 12.2f);
+    Matrix4 world_to_clip = draw_frame_get_world_to_clip(frame);
+    Vector2 exact_top_right = m4_transform(world_to_clip, v4(position.x+size.x, position.y+size.y, 0, 1)).xy;
+    
+    Draw_Quad *q = DrawRectInFrame(position, size, COLOR_WHITE, frame);
+    Vector2 *corners = &q->bottom_left;
+    for (int c = 0; c < 4; c++) {
+        float32 px = corners[c].x/pixel_width;
+        float32 py = corners[c].y/pixel_height;
+        assert(fabsf(px - roundf(px)) < 0.001f && fabsf(py - roundf(py)) < 0.001f, "Failed: corner %d not snapped (%f, %f)", c, px, py);
+    }
+    assert(fabsf(q->top_right.x - exact_top_right.x) <= pixel_width*0.5f + 0.0001f, "Failed: snapped to the wrong pixel");
+    
+    // Per frame
+    frame->disable_pixel_snapping = true;
+    q = DrawRectInFrame(position, size, COLOR_WHITE, frame);
+    assert(fabsf(q->top_right.x - exact_top_right.x) < 0.00001f && fabsf(q->top_right.y - exact_top_right.y) < 0.00001f, "Failed: snapping not disabled for frame");
+    frame->disable_pixel_snapping = false;
+    
+    // Per quad
+    Draw_Quad quad = ZERO(Draw_Quad);
+    quad.bottom_left  = position;
+    quad.top_left     = v2(position.x, position.y+size.y);
+    quad.top_right    = v2(position.x+size.x, position.y+size.y);
+    quad.bottom_right = v2(position.x+size.x, position.y);
+    quad.flags = DRAW_QUAD_FLAG_NO_PIXEL_SNAP;
+    q = DrawQuadInFrame(quad, frame);
+    assert(fabsf(q->top_right.x - exact_top_right.x) < 0.00001f && fabsf(q->top_right.y - exact_top_right.y) < 0.00001f, "Failed: snapping not disabled for quad");
+    
+    // Halves round up on every path, a round to even would give 2 and -2 for the first two
+    Draw_Pixel_Snap unit_snap = { .enabled = true, .pixel_width = 1, .pixel_height = 1, .pixels_per_x = 1, .pixels_per_y = 1 };
+    Vector2 tie_corners[4] = { v2(2.5f, -2.5f), v2(3.5f, -0.5f), v2(0.5f, 1.49f), v2(-3.5f, 100.5f) };
+    Vector2 expected_corners[4] = { v2(3, -2), v2(4, 0), v2(1, 1), v2(-3, 101) };
+    draw_project_and_snap_corners(tie_corners, M4Scalar(1.0), unit_snap, v4(-F32_MAX, -F32_MAX, F32_MAX, F32_MAX), false);
+    for (int c = 0; c < 4; c++) {
+        assert(tie_corners[c].x == expected_corners[c].x && tie_corners[c].y == expected_corners[c].y, "Failed: corner %d snapped to (%f, %f)", c, tie_corners[c].x, tie_corners[c].y);
+    }
+#if SIMD_ENABLE_SSE2
+    float32 round_values[] = { 0.5f, -0.5f, 1.5f, -1.5f, 2.5f, -2.5f, 0.49f, -0.51f, 8388607.5f, -8388607.5f, 8388609.0f, -8388609.0f, 1e20f, -1e20f, 0.0f, -0.0f };
+    for (u64 i = 0; i < sizeof(round_values)/sizeof(round_values[0]); i += 4) {
+        float32 rounded[4];
+        _mm_storeu_ps(rounded, draw_round_ps(_mm_loadu_ps(&round_values[i])));
+        for (u64 j = 0; j < 4; j++) {
+            assert(rounded[j] == draw_round_to_pixel(round_values[i+j]), "Failed: vectorised rounding of %f gave %f", (double)round_values[i+j], (double)rounded[j]);
         }
+    }
+#endif
 
-        for (int i = 0; i < num_threads; i++) {
+    // Culling, a quad touching the screen edge stays and one just outside goes
+    float32 half_width = (float32)window.width/2.0f;
+    assert(DrawRectInFrame(v2(half_width - 0.5f, 0), v2(10, 10), COLOR_WHITE, frame) != &_nil_quad, "Failed: culled a visible quad");
+    assert(DrawRectInFrame(v2(half_width + 0.5f, 0), v2(10, 10), COLOR_WHITE, frame) == &_nil_quad, "Failed: didn't cull off screen quad");
+    assert(DrawRectInFrame(v2(-half_width - 20.0f, 0), v2(10, 10), COLOR_WHITE, frame) == &_nil_quad, "Failed: didn't cull off screen quad");
+    assert(DrawRectInFrame(v2(0, (float32)window.height), v2(10, 10), COLOR_WHITE, frame) == &_nil_quad, "Failed: didn't cull off screen quad");
+    
+    // 1M quads with and without snapping, about a fifth of them off screen. Best of a few runs
+    // so the first one touching the quad buffer memory doesn't count.
+    const u64 count = 1000000;
+    float64 best_ms[2] = { F32_MAX, F32_MAX };
+    u64 visible = 0;
+    for (int run = 0; run < 6; run++) {
+        int snapping = run % 2;
+        DrawFrameReset(frame);
+        frame->disable_pixel_snapping = !snapping;
+        
+        float64 start = OsGetElapsedSeconds();
+        for (u64 i = 0; i < count; i++) {
+            float32 x = (float32)(i % 1000)*1.6f - 800.0f;
+            float32 y = (float32)((i / 1000) % 600) - 300.0f;
+            DrawRectInFrame(v2(x, y), v2(7.5f, 7.5f), COLOR_WHITE, frame);
+        }
+        float64 ms = (OsGetElapsedSeconds() - start)*1000.0;
+        if (ms < best_ms[snapping]) best_ms[snapping] = ms;
+        visible = bucket_array_get_count(&frame->quad_buffer);
+    }
+    print("Drawing %llu quads (%llu visible) took %.2f ms with snapping, %.2f ms without\n",
+        count, visible, best_ms[1], best_ms[0]);
+    
+    bucket_array_deinit(&frame->quad_buffer);
+    Dealloc(GetHeapAllocator(), frame);
+}
+
+void test_draw_scissors() {
+    if (window.width <= 0 || window.height <= 0) {
+        window.width = 1280;
+        window.height = 720;
+    }
+    float32 pixel_width = 2.0f/(float32)window.width;
+    float32 pixel_height = 2.0f/(float32)window.height;
+    // Scissors are in window pixels from the bottom left, world 0, 0 is the middle
+    Vector2 middle = v2((float32)window.width/2.0f, (float32)window.height/2.0f);
+
+    Draw_Frame *frame = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    DrawFrameReset(frame);
+    
+    // Nested scissors are cut down to where they overlap
+    push_window_scissor_in_frame(v2(middle.x-100, middle.y-100), v2(middle.x+100, middle.y+100), frame);
+    push_window_scissor_in_frame(v2(middle.x, middle.y), v2(middle.x+300, middle.y+300), frame);
+    Vector4 top = frame->scissor_stack[frame->scissor_count-1];
+    assert(top.x == middle.x && top.y == middle.y && top.z == middle.x+100 && top.w == middle.y+100, "Failed: nested scissor should be the overlap");
+    
+    assert(DrawRectInFrame(v2(10, 10), v2(10, 10), COLOR_WHITE, frame) != &_nil_quad, "Failed: culled a quad inside the scissor");
+    assert(DrawRectInFrame(v2(-5, -5), v2(10, 10), COLOR_WHITE, frame) != &_nil_quad, "Failed: culled a quad partially inside the scissor");
+    assert(DrawRectInFrame(v2(-50, 10), v2(10, 10), COLOR_WHITE, frame) == &_nil_quad, "Failed: didn't cull a quad outside the nested scissor");
+    assert(DrawRectInFrame(v2(150, 10), v2(10, 10), COLOR_WHITE, frame) == &_nil_quad, "Failed: didn't cull a quad outside the outer scissor");
+    
+    Vector2 positions[8], sizes[8];
+    for (u64 i = 0; i < 8; i++) {
+        positions[i] = v2((float32)i*30.0f - 95.0f, 10);
+        sizes[i] = v2(10, 10);
+    }
+    // x = -95 .. 115, the ones at -5, 25, 55 and 85 are at least partially inside
+    assert(draw_rects_in_frame(positions, sizes, 0, 8, frame) == 4, "Failed: batched drawing should cull against the scissor");
+    
+    pop_window_scissor_in_frame(frame);
+    pop_window_scissor_in_frame(frame);
+    assert(DrawRectInFrame(v2(150, 10), v2(10, 10), COLOR_WHITE, frame) != &_nil_quad, "Failed: popped scissor still culls");
+    
+    // Clipping on the CPU
+    DrawFrameReset(frame);
+    Gal_Image image = ZERO(Gal_Image);
+    push_window_scissor_in_frame(middle, v2(middle.x+100, middle.y+100), frame);
+    DrawImageInFrame(&image, v2(-10, 50), v2(20, 20), COLOR_WHITE, frame); // Left half cut off
+    DrawImageInFrame(&image, v2(10, 10), v2(20, 20), COLOR_WHITE, frame);  // Inside
+    DrawCircleInFrame(v2(-10, 10), v2(20, 20), COLOR_WHITE, frame);        // Circles keep the scissor
+    pop_window_scissor_in_frame(frame);
+    DrawImageInFrame(&image, v2(200, 200), v2(20, 20), COLOR_WHITE, frame);
+    
+    Draw_Instance_Stream stream = ZERO(Draw_Instance_Stream);
+    draw_frame_build_instance_stream(frame, &stream);
+    assert(stream.instances.data[0].scissor_index == 0 && stream.stats.dropped_scissor_count == 0, "Failed: clipping should be off by default");
+    
+    frame->enable_scissor_clipping = true;
+    draw_frame_build_instance_stream(frame, &stream);
+    assert(stream.stats.dropped_scissor_count == 2 && stream.stats.clipped_count == 1, "Failed: clip stats %llu %llu", stream.stats.dropped_scissor_count, stream.stats.clipped_count);
+    Draw_Quad_Instance *cut = &stream.instances.data[0];
+    assert(cut->scissor_index == DRAW_INSTANCE_NO_SCISSOR && stream.instances.data[1].scissor_index == DRAW_INSTANCE_NO_SCISSOR, "Failed: clipped quads should lose their scissor");
+    assert(stream.instances.data[2].scissor_index != DRAW_INSTANCE_NO_SCISSOR, "Failed: circle should keep its scissor");
+    assert(fabsf(cut->origin.x) < 0.0001f && fabsf(cut->axis_x.x - 10*pixel_width) < 0.0001f, "Failed: clipped corners");
+    assert(fabsf(cut->axis_y.y - 20*pixel_height) < 0.0001f, "Failed: clipping changed the height");
+    assert(cut->uv[0] == 32768 && cut->uv[1] == 0 && cut->uv[2] == 65535 && cut->uv[3] == 65535, "Failed: clipped uv %u %u %u %u", (u32)cut->uv[0], (u32)cut->uv[1], (u32)cut->uv[2], (u32)cut->uv[3]);
+    // Circle in its own call, the rest batch
+    assert(stream.calls.count == 3, "Failed: clipped quads should batch, got %llu calls", stream.calls.count);
+    
+    // Recorded scissors are cut down to the frame's at replay
+    Draw_List list = ZERO(Draw_List);
+    Draw_Frame *recording = draw_list_begin_recording(&list);
+    push_window_scissor_in_frame(v2(0, 0), v2(middle.x+50, middle.y+50), recording);
+    DrawRectInFrame(v2(10, 10), v2(10, 10), COLOR_WHITE, recording);
+    DrawRectInFrame(v2(80, 10), v2(10, 10), COLOR_WHITE, recording);
+    pop_window_scissor_in_frame(recording);
+    draw_list_end_recording(&list);
+    
+    DrawFrameReset(frame);
+    push_window_scissor_in_frame(middle, v2(middle.x+200, middle.y+200), frame);
+    assert(draw_list_replay_in_frame(&list, M4Scalar(1.0), frame) == 1, "Failed: replay should cull against the recorded scissor");
+    Draw_Quad *replayed = (Draw_Quad*)bucket_array_get(&frame->quad_buffer, 0);
+    assert(replayed->scissor.x == middle.x && replayed->scissor.z == middle.x+50, "Failed: replayed scissor should be the overlap");
+    pop_window_scissor_in_frame(frame);
+    draw_list_deinit(&list);
+    
+    // A scrolled list of 10000 items in a 400 pixel high panel, in the middle of the screen
+    const u64 count = 10000;
+    const float32 item_height = 24.0f;
+    Gal_Image icons[4];
+    memset(icons, 0, sizeof(icons));
+    for (int clipping = 0; clipping < 2; clipping++) {
+        float64 best_ms = F32_MAX;
+        for (int run = 0; run < 3; run++) {
+            float64 start = OsGetElapsedSeconds();
+            DrawFrameReset(frame);
+            frame->enable_scissor_clipping = clipping;
+            DrawRectInFrame(v2(-300, -300), v2(600, 600), COLOR_BLACK, frame);
+            push_window_scissor_in_frame(v2(middle.x-150, middle.y-200), v2(middle.x+150, middle.y+200), frame);
+            float32 scroll = 3333.0f;
+            for (u64 i = 0; i < count; i++) {
+                float32 y = 200.0f + scroll - (float32)(i+1)*item_height;
+                DrawRectInFrame(v2(-150, y), v2(300, item_height - 2), COLOR_WHITE, frame);
+                DrawImageInFrame(&icons[i % 4], v2(-146, y + 1), v2(20, 20), COLOR_WHITE, frame);
+            }
+            pop_window_scissor_in_frame(frame);
+            DrawRectInFrame(v2(-300, 250), v2(600, 20), COLOR_WHITE, frame);
+            draw_frame_build_instance_stream(frame, &stream);
+            float64 ms = (OsGetElapsedSeconds() - start)*1000.0;
+            if (ms < best_ms) best_ms = ms;
+        }
+        test_draw_calls_check(&stream);
+        print("Scrolled list of %llu items: %llu of %llu quads kept, %llu draw calls %s clipping, %.2f ms\n",
+            count, stream.instances.count, 2*count + 2, stream.calls.count, clipping ? "with" : "without", best_ms);
+        assert(stream.instances.count <= 2*(400/(u64)item_height + 2) + 2, "Failed: scrolled out items should be culled");
+    }
+    
+    draw_instance_stream_deinit(&stream);
+    bucket_array_deinit(&frame->quad_buffer);
+    Dealloc(GetHeapAllocator(), frame);
+}
+
+void test_draw_list() {
+    if (window.width <= 0 || window.height <= 0) {
+        window.width = 1280;
+        window.height = 720;
+    }
+
+    Draw_Frame *immediate = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    Draw_Frame *replayed = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    draw_frame_init(immediate);
+    draw_frame_init(replayed);
+    
+    Draw_List list = ZERO(Draw_List);
+    assert(!draw_list_is_recorded(&list), "Failed: new draw list should not be recorded");
+    assert(draw_list_replay_in_frame(&list, M4Scalar(1.0), replayed) == 0, "Failed: replaying an empty draw list");
+    
+    Gal_Image image = ZERO(Gal_Image);
+    Draw_Frame *recording = draw_list_begin_recording(&list);
+    for (u64 i = 0; i < 300; i++) {
+        // Some of these are off screen, they still have to be recorded
+        Vector2 position = v2((float32)(i % 30)*80.0f - 1200.0f, (float32)(i / 30)*40.0f - 200.0f);
+        Draw_Quad *q = DrawImageInFrame(&image, position, v2(20.5f, 20.5f), v4(1, 1, 1, (float32)i/300.0f), recording);
+        q->uv = v4(0, 0, 0.5f, 0.5f);
+    }
+    push_z_layer_in_frame(7, recording);
+    DrawRectXformInFrame(M4RotateZ(M4Translate(M4Scalar(1.0), v3(100, 100, 0)), 0.5f), v2(30, 10), COLOR_WHITE, recording);
+    pop_z_layer_in_frame(recording);
+    draw_list_end_recording(&list);
+    assert(draw_list_is_recorded(&list) && bucket_array_get_count(&list.quads) == 301, "Failed: draw list recording, got %llu quads", bucket_array_get_count(&list.quads));
+    
+    // Replaying should be the same as drawing directly, with any camera and xform
+    Matrix4 camera = M4Scale(M4Translate(M4Scalar(1.0), v3(-40, 25, 0)), v3(1.25f, 1.25f, 1));
+    Matrix4 xform = M4Translate(M4Scalar(1.0), v3(33, -12, 0));
+    for (int pass = 0; pass < 4; pass++) {
+        // The first pass projects straight into the frame, the second fills the cache, the
+        // third replays from it and the fourth is after the camera moved
+        if (pass == 3) camera = M4Translate(camera, v3(5, 5, 0));
+        
+        DrawFrameReset(immediate);
+        DrawFrameReset(replayed);
+        draw_frame_set_camera_xform(immediate, camera);
+        draw_frame_set_camera_xform(replayed, camera);
+        push_z_layer_in_frame(3, immediate);
+        push_z_layer_in_frame(3, replayed);
+        
+        for (u64 i = 0; i < 300; i++) {
+            Vector2 position = v2((float32)(i % 30)*80.0f - 1200.0f, (float32)(i / 30)*40.0f - 200.0f);
+            Draw_Quad *q = DrawImageXformInFrame(&image, M4Translate(xform, v3(position.x, position.y, 0)), v2(20.5f, 20.5f), v4(1, 1, 1, (float32)i/300.0f), immediate);
+            q->uv = v4(0, 0, 0.5f, 0.5f);
+        }
+        push_z_layer_in_frame(7, immediate);
+        DrawRectXformInFrame(m4_mul(xform, M4RotateZ(M4Translate(M4Scalar(1.0), v3(100, 100, 0)), 0.5f)), v2(30, 10), COLOR_WHITE, immediate);
+        pop_z_layer_in_frame(immediate);
+        
+        u64 drawn = draw_list_replay_in_frame(&list, xform, replayed);
+        assert(list.projected_valid == (pass == 1 || pass == 2), "Failed: draw list projection cache in pass %d", pass);
+        u64 count = bucket_array_get_count(&immediate->quad_buffer);
+        assert(drawn == count && bucket_array_get_count(&replayed->quad_buffer) == count && count < 301, "Failed: draw list replay count %llu, expected %llu", drawn, count);
+        for (u64 i = 0; i < count; i++) {
+            Draw_Quad *a = (Draw_Quad*)bucket_array_get(&immediate->quad_buffer, i);
+            Draw_Quad *b = (Draw_Quad*)bucket_array_get(&replayed->quad_buffer, i);
+            assert(test_draw_quads_match(a, b), "Failed: replayed quad %llu does not match", i);
+            assert(a->image == 0 || memcmp(&a->uv, &b->uv, sizeof(Vector4)) == 0, "Failed: replayed quad uv %llu", i);
+        }
+        Draw_Quad *last = (Draw_Quad*)bucket_array_get(&replayed->quad_buffer, count-1);
+        Draw_Quad *first = (Draw_Quad*)bucket_array_get(&replayed->quad_buffer, 0);
+        assert(last->z == 7 && first->z == 3, "Failed: replayed z layers");
+    }
+    
+    draw_list_invalidate(&list);
+    assert(!draw_list_is_recorded(&list) && draw_list_replay_in_frame(&list, M4Scalar(1.0), replayed) == 0, "Failed: draw_list_invalidate");
+    
+    // Static scene: drawing every frame vs replaying
+    const u64 count = 100000;
+    recording = draw_list_begin_recording(&list);
+    for (u64 i = 0; i < count; i++) {
+        DrawImageInFrame(&image, v2((float32)(i % 500)*2.0f - 500.0f, (float32)((i / 500) % 300)*2.0f - 300.0f), v2(8, 8), COLOR_WHITE, recording);
+    }
+    draw_list_end_recording(&list);
+    
+    const int frames = 10;
+    float64 immediate_ms = 0, replay_ms = 0, moving_ms = 0;
+    // Frame -1 gets the quad buffer allocated
+    for (int f = -1; f < frames; f++) {
+        DrawFrameReset(immediate);
+        float64 start = OsGetElapsedSeconds();
+        for (u64 i = 0; i < count; i++) {
+            DrawImageInFrame(&image, v2((float32)(i % 500)*2.0f - 500.0f, (float32)((i / 500) % 300)*2.0f - 300.0f), v2(8, 8), COLOR_WHITE, immediate);
+        }
+        if (f >= 0) immediate_ms += (OsGetElapsedSeconds() - start)*1000.0;
+        
+    }
+    // Two replays to fill the projection cache, which also gets the frame's quad buffer allocated
+    for (int f = 0; f < 2; f++) {
+        DrawFrameReset(replayed);
+        draw_list_replay_in_frame(&list, M4Scalar(1.0), replayed);
+    }
+    for (int f = 0; f < frames; f++) {
+        DrawFrameReset(replayed);
+        float64 start = OsGetElapsedSeconds();
+        draw_list_replay_in_frame(&list, M4Scalar(1.0), replayed);
+        replay_ms += (OsGetElapsedSeconds() - start)*1000.0;
+    }
+    for (int f = 0; f < frames; f++) {
+        DrawFrameReset(replayed);
+        float64 start = OsGetElapsedSeconds();
+        draw_list_replay_in_frame(&list, M4Translate(M4Scalar(1.0), v3((float32)f, 0, 0)), replayed);
+        moving_ms += (OsGetElapsedSeconds() - start)*1000.0;
+    }
+    print("%llu static quads: immediate %.2f ms, replay %.2f ms, replay with a moving camera %.2f ms\n",
+        count, immediate_ms/frames, replay_ms/frames, moving_ms/frames);
+    
+    draw_list_deinit(&list);
+    bucket_array_deinit(&immediate->quad_buffer);
+    bucket_array_deinit(&replayed->quad_buffer);
+    Dealloc(GetHeapAllocator(), immediate);
+    Dealloc(GetHeapAllocator(), replayed);
+}
+
+typedef struct Test_Parallel_Drawing {
+    u64 count;
+    u64 job_count;
+} Test_Parallel_Drawing;
+
+// Compares a query against testing every item
+void test_spatial_index_check_query(Spatial_Index *index, Vector4 *bounds, bool *alive, u64 count, Vector4 rect, Spatial_Id_Array *results) {
+    spatial_index_query_visible(index, rect, results);
+    
+    bool *found = Alloc(GetHeapAllocator(), count*sizeof(bool));
+    memset(found, 0, count*sizeof(bool));
+    for (u64 i = 0; i < results->count; i++) {
+        Spatial_Id id = results->data[i];
+        assert(id < count && alive[id], "Failed: query returned a removed item");
+        assert(!found[id], "Failed: query returned item %u twice", id);
+        found[id] = true;
+    }
+    for (u64 i = 0; i < count; i++) {
+        if (!alive[i]) continue;
+        Vector4 b = bounds[i];
+        bool overlaps = !(b.z < rect.x || b.x > rect.z || b.w < rect.y || b.y > rect.w);
+        assert(overlaps == found[i], "Failed: item %llu %s", i, overlaps ? "missing from the query" : "shouldn't be in the query");
+    }
+    Dealloc(GetHeapAllocator(), found);
+}
+
+Vector4 test_spatial_random_bounds(float32 max_size) {
+    float32 x = get_random_float32_in_range(-100, 1100);
+    float32 y = get_random_float32_in_range(-100, 1100);
+    return v4(x, y, x + get_random_float32_in_range(1, max_size), y + get_random_float32_in_range(1, max_size));
+}
+
+void test_spatial_index() {
+    if (window.width <= 0 || window.height <= 0) {
+        window.width = 1280;
+        window.height = 720;
+    }
+    
+    Spatial_Index index;
+    spatial_index_init(&index, v4(0, 0, 1000, 1000), 100, GetHeapAllocator());
+    Spatial_Id_Array results = ZERO(Spatial_Id_Array);
+    
+    // Some of them outside the world bounds
+    const u64 count = 2000;
+    Vector4 *bounds = Alloc(GetHeapAllocator(), count*sizeof(Vector4));
+    bool *alive = Alloc(GetHeapAllocator(), count*sizeof(bool));
+    for (u64 i = 0; i < count; i++) {
+        bounds[i] = test_spatial_random_bounds(30);
+        Spatial_Id id = spatial_index_add(&index, bounds[i], &bounds[i]);
+        assert(id == i, "Failed: ids should be handed out in order");
+        alive[i] = true;
+    }
+    assert(spatial_index_get_data(&index, 7) == &bounds[7], "Failed: spatial index data");
+    
+    for (int q = 0; q < 50; q++) {
+        Vector4 r = test_spatial_random_bounds(400);
+        test_spatial_index_check_query(&index, bounds, alive, count, r, &results);
+    }
+    test_spatial_index_check_query(&index, bounds, alive, count, v4(-10000, -10000, 10000, 10000), &results);
+    assert(results.count == count, "Failed: everything should be visible");
+    
+    // Moving, removing and adding again
+    for (u64 i = 0; i < count; i += 2) {
+        bounds[i] = i % 4 ? test_spatial_random_bounds(30) : v4(bounds[i].x + 3, bounds[i].y - 2, bounds[i].z + 3, bounds[i].w - 2);
+        spatial_index_update(&index, (Spatial_Id)i, bounds[i]);
+        Vector4 b = spatial_index_get_bounds(&index, (Spatial_Id)i);
+        assert(memcmp(&b, &bounds[i], sizeof(Vector4)) == 0, "Failed: updated bounds");
+    }
+    assert(index.stats.cell_changes > 0, "Failed: some updates should change cell");
+    for (u64 i = 1; i < count; i += 3) {
+        spatial_index_remove(&index, (Spatial_Id)i);
+        alive[i] = false;
+    }
+    for (int q = 0; q < 50; q++) {
+        test_spatial_index_check_query(&index, bounds, alive, count, test_spatial_random_bounds(400), &results);
+    }
+    for (u64 n = 0; n < 100; n++) {
+        Vector4 b = test_spatial_random_bounds(30);
+        Spatial_Id id = spatial_index_add(&index, b, 0);
+        assert(id < count && !alive[id], "Failed: removed ids should be reused");
+        bounds[id] = b;
+        alive[id] = true;
+    }
+    // One huge item sticking out far from its cell
+    spatial_index_update(&index, 0, v4(-500, -500, 600, 600));
+    bounds[0] = v4(-500, -500, 600, 600);
+    for (int q = 0; q < 50; q++) {
+        test_spatial_index_check_query(&index, bounds, alive, count, test_spatial_random_bounds(100), &results);
+    }
+    
+    spatial_index_clear(&index);
+    assert(spatial_index_query_visible(&index, v4(-10000, -10000, 10000, 10000), &results) == 0, "Failed: cleared index");
+    spatial_index_deinit(&index);
+    Dealloc(GetHeapAllocator(), bounds);
+    Dealloc(GetHeapAllocator(), alive);
+    
+    // Visible rect of a frame
+    Draw_Frame *frame = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    DrawFrameReset(frame);
+    float32 half_width = (float32)window.width/2.0f;
+    float32 half_height = (float32)window.height/2.0f;
+    Vector4 visible = draw_frame_get_visible_rect(frame);
+    assert(fabsf(visible.x + half_width) < 0.01f && fabsf(visible.z - half_width) < 0.01f && fabsf(visible.w - half_height) < 0.01f, "Failed: visible rect");
+    draw_frame_set_camera_xform(frame, M4Scale(M4Translate(M4Scalar(1.0), v3(100, 50, 0)), v3(2, 2, 1)));
+    visible = draw_frame_get_visible_rect(frame);
+    assert(fabsf(visible.x - (100 - 2*half_width)) < 0.01f && fabsf(visible.w - (50 + 2*half_height)) < 0.01f, "Failed: visible rect with a camera");
+    draw_frame_set_camera_xform(frame, M4Scalar(1.0));
+    push_window_scissor_in_frame(v2(half_width, half_height), v2(half_width + 100, half_height + 50), frame);
+    visible = draw_frame_get_visible_rect(frame);
+    assert(fabsf(visible.x) < 0.01f && fabsf(visible.z - 100) < 0.01f && fabsf(visible.w - 50) < 0.01f, "Failed: visible rect with a scissor");
+    pop_window_scissor_in_frame(frame);
+    
+    Draw_List list = ZERO(Draw_List);
+    Draw_Frame *recording = draw_list_begin_recording(&list);
+    DrawRectInFrame(v2(-10, 5), v2(20, 20), COLOR_WHITE, recording);
+    DrawRectInFrame(v2(30, -40), v2(5, 5), COLOR_WHITE, recording);
+    draw_list_end_recording(&list);
+    Vector4 list_bounds = draw_list_get_bounds(&list);
+    assert(list_bounds.x == -10 && list_bounds.y == -40 && list_bounds.z == 35 && list_bounds.w == 25, "Failed: draw list bounds");
+    draw_list_deinit(&list);
+    
+    // 1M 16x16 sprites in a 1000x1000 tile world, with a screen sized view in the middle
+    const u64 sprite_count = 1000000;
+    const float32 tile = 16.0f;
+    Vector2 *positions = Alloc(GetHeapAllocator(), sprite_count*sizeof(Vector2));
+    Vector2 *sizes = Alloc(GetHeapAllocator(), sprite_count*sizeof(Vector2));
+    Vector2 *visible_positions = Alloc(GetHeapAllocator(), sprite_count*sizeof(Vector2));
+    spatial_index_init(&index, v4(0, 0, 1000*tile, 1000*tile), 16*tile, GetHeapAllocator());
+    
+    float64 start = OsGetElapsedSeconds();
+    for (u64 i = 0; i < sprite_count; i++) {
+        positions[i] = v2((float32)(i % 1000)*tile, (float32)(i / 1000)*tile);
+        sizes[i] = v2(tile, tile);
+        spatial_index_add(&index, v4(positions[i].x, positions[i].y, positions[i].x + tile, positions[i].y + tile), 0);
+    }
+    float64 build_ms = (OsGetElapsedSeconds() - start)*1000.0;
+    
+    DrawFrameReset(frame);
+    // Off the tile grid, so whether tiles exactly touching the screen edge are in is up to rounding
+    draw_frame_set_camera_xform(frame, M4Translate(M4Scalar(1.0), v3(500*tile + 3.5f, 500*tile + 5.5f, 0)));
+    
+    float64 best_ms[2] = { F32_MAX, F32_MAX };
+    u64 drawn[2] = { 0, 0 };
+    for (int run = 0; run < 6; run++) {
+        int indexed = run % 2;
+        bucket_array_clear(&frame->quad_buffer);
+        start = OsGetElapsedSeconds();
+        if (indexed) {
+            spatial_index_query_visible(&index, draw_frame_get_visible_rect(frame), &results);
+            for (u64 i = 0; i < results.count; i++) visible_positions[i] = positions[results.data[i]];
+            drawn[1] = draw_rects_in_frame(visible_positions, sizes, 0, results.count, frame);
+        } else {
+            drawn[0] = draw_rects_in_frame(positions, sizes, 0, sprite_count, frame);
+        }
+        float64 ms = (OsGetElapsedSeconds() - start)*1000.0;
+        if (ms < best_ms[indexed]) best_ms[indexed] = ms;
+    }
+    assert(drawn[0] == drawn[1], "Failed: indexed drawing drew %llu quads, culling everything drew %llu", drawn[1], drawn[0]);
+    
+    // A tenth of the sprites moving a bit each frame
+    start = OsGetElapsedSeconds();
+    for (u64 i = 0; i < sprite_count; i += 10) {
+        positions[i].x += get_random_float32_in_range(-4, 4);
+        positions[i].y += get_random_float32_in_range(-4, 4);
+        spatial_index_update(&index, (Spatial_Id)i, v4(positions[i].x, positions[i].y, positions[i].x + tile, positions[i].y + tile));
+    }
+    float64 update_ms = (OsGetElapsedSeconds() - start)*1000.0;
+    
+    print("%llu sprites, %llu visible: culling all %.2f ms, spatial index query + draw %.2f ms (%llu cells, %llu items tested). Adding all %.2f ms, moving %llu %.2f ms\n",
+        sprite_count, drawn[1], best_ms[0], best_ms[1], index.stats.cells_visited, index.stats.items_tested, build_ms, sprite_count/10, update_ms);
+    
+    spatial_index_deinit(&index);
+    Spatial_Id_Array_deinit(&results);
+    Dealloc(GetHeapAllocator(), positions);
+    Dealloc(GetHeapAllocator(), sizes);
+    Dealloc(GetHeapAllocator(), visible_positions);
+    bucket_array_deinit(&frame->quad_buffer);
+    Dealloc(GetHeapAllocator(), frame);
+}
+
+void test_draw_some_quads(Draw_Frame *frame, u64 begin, u64 end, u64 count) {
+    for (u64 i = begin; i < end; i++) {
+        push_z_layer_in_frame((s32)(i % 7) - 3, frame);
+        float32 x = (float32)(i % 1000)*1.3f - 650.0f;
+        float32 y = (float32)((i / 1000) % 600) - 300.0f;
+        // The color tells us which quad it is
+        DrawRectInFrame(v2(x, y), v2(6, 6), v4((float32)i/(float32)count, 0, 0, 1), frame);
+        pop_z_layer_in_frame(frame);
+    }
+}
+void test_draw_parallel_job(Draw_Frame *sub_frame, void *data, u64 job_index) {
+    Test_Parallel_Drawing *d = (Test_Parallel_Drawing*)data;
+    test_draw_some_quads(sub_frame, (d->count*job_index)/d->job_count, (d->count*(job_index+1))/d->job_count, d->count);
+}
+
+void test_draw_parallel_recording() {
+    if (window.width <= 0 || window.height <= 0) {
+        window.width = 1280;
+        window.height = 720;
+    }
+
+    Draw_Frame *serial = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    Draw_Frame *parallel = Alloc(GetHeapAllocator(), sizeof(Draw_Frame));
+    draw_frame_init(serial);
+    draw_frame_init(parallel);
+    
+    Matrix4 camera = M4Translate(M4Scalar(1.0), v3(12, -7, 0));
+    Test_Parallel_Drawing d;
+    d.count = 120000;
+    
+    DrawFrameReset(serial);
+    draw_frame_set_camera_xform(serial, camera);
+    test_draw_some_quads(serial, 0, d.count, d.count);
+    draw_frame_sort_by_z(serial);
+    u64 count = bucket_array_get_count(&serial->quad_buffer);
+    assert(count > 0 && count < d.count, "Failed: expected some quads to be culled");
+    
+    // Sorted by z, and drawing order within the same z
+    Draw_Quad *previous = (Draw_Quad*)bucket_array_get(&serial->quad_buffer, 0);
+    for (u64 i = 1; i < count; i++) {
+        Draw_Quad *q = (Draw_Quad*)bucket_array_get(&serial->quad_buffer, i);
+        assert(q->z > previous->z || (q->z == previous->z && q->color.x > previous->color.x), "Failed: draw_frame_sort_by_z at %llu", i);
+        previous = q;
+    }
+    
+    // Same result for any number of jobs, however they are scheduled
+    u64 job_counts[] = { 1, 3, 8, 8, 17 };
+    for (u64 t = 0; t < sizeof(job_counts)/sizeof(job_counts[0]); t++) {
+        d.job_count = job_counts[t];
+        
+        DrawFrameReset(parallel);
+        draw_frame_set_camera_xform(parallel, camera);
+        parallel->enable_z_sorting = true;
+        draw_frame_record_parallel(parallel, test_draw_parallel_job, &d, d.job_count);
+        
+        assert(bucket_array_get_count(&parallel->quad_buffer) == count, "Failed: parallel recording with %llu jobs has %llu quads, expected %llu", d.job_count, bucket_array_get_count(&parallel->quad_buffer), count);
+        for (u64 i = 0; i < count; i++) {
+            Draw_Quad *a = (Draw_Quad*)bucket_array_get(&serial->quad_buffer, i);
+            Draw_Quad *b = (Draw_Quad*)bucket_array_get(&parallel->quad_buffer, i);
+            assert(a->z == b->z && a->color.x == b->color.x && memcmp(&a->bottom_left, &b->bottom_left, sizeof(Vector2)*4) == 0,
+                "Failed: parallel recording with %llu jobs differs at quad %llu", d.job_count, i);
+        }
+    }
+    
+    // Sub frames with your own threads, drawn after what's already in the frame
+    DrawFrameReset(parallel);
+    push_z_layer_in_frame(2, parallel);
+    DrawRectInFrame(v2(0, 0), v2(1, 1), COLOR_RED, parallel);
+    Draw_Frame *subs = draw_frame_begin_sub_frames(parallel, 2);
+    assert(subs[1].z_count == 1 && subs[1].z_stack[0] == 2, "Failed: sub frames should start with the z layer of the frame");
+    DrawRectInFrame(v2(0, 0), v2(1, 1), COLOR_BLUE, &subs[1]);
+    DrawRectInFrame(v2(0, 0), v2(1, 1), COLOR_GREEN, &subs[0]);
+    draw_frame_merge_sub_frames(parallel);
+    assert(bucket_array_get_count(&parallel->quad_buffer) == 3, "Failed: merging sub frames");
+    assert(((Draw_Quad*)bucket_array_get(&parallel->quad_buffer, 1))->color.y == 1.0f, "Failed: sub frames should be merged in order");
+    assert(((Draw_Quad*)bucket_array_get(&parallel->quad_buffer, 2))->color.z == 1.0f, "Failed: sub frames should be merged in order");
+    assert(((Draw_Quad*)bucket_array_get(&parallel->quad_buffer, 2))->z == 2, "Failed: sub frame z layer");
+    
+    // Recording 100K quads on one thread vs on the job pool (more doesn't fit in the default program memory)
+    d.count = 100000;
+    d.job_count = job_pool_get_worker_count(get_job_pool()) + 1;
+    float64 serial_ms = F32_MAX, parallel_ms = F32_MAX;
+    for (int run = 0; run < 3; run++) {
+        DrawFrameReset(serial);
+        serial->enable_z_sorting = true;
+        float64 start = OsGetElapsedSeconds();
+        test_draw_some_quads(serial, 0, d.count, d.count);
+        draw_frame_sort_by_z(serial);
+        float64 ms = (OsGetElapsedSeconds() - start)*1000.0;
+        if (ms < serial_ms) serial_ms = ms;
+        
+        DrawFrameReset(parallel);
+        parallel->enable_z_sorting = true;
+        start = OsGetElapsedSeconds();
+        draw_frame_record_parallel(parallel, test_draw_parallel_job, &d, d.job_count);
+        ms = (OsGetElapsedSeconds() - start)*1000.0;
+        if (ms < parallel_ms) parallel_ms = ms;
+    }
+    print("Recording and z sorting %llu quads: 1 thread %.2f ms, %llu jobs %.2f ms\n", d.count, serial_ms, d.job_count, parallel_ms);
+    
+    draw_frame_deinit(serial);
+    draw_frame_deinit(parallel);
+    Dealloc(GetHeapAllocator(), serial);
+    Dealloc(GetHeapAllocator(), parallel);
+}
+
+void test_audio_dsp_check_ramp(Audio_Dsp_Path path, u64 frame_count, int channels, f32 gain_from, f32 gain_to) {
+    u64 count = frame_count*channels;
+    f32 *f = Alloc(GetHeapAllocator(), count*sizeof(f32));
+    s16 *s = Alloc(GetHeapAllocator(), count*sizeof(s16));
+    s16 *s_in = Alloc(GetHeapAllocator(), count*sizeof(s16));
+    for (u64 i = 0; i < count; i++) {
+        f[i] = get_random_float32_in_range(-1, 1);
+        s_in[i] = s[i] = (s16)get_random_int_in_range(-32768, 32767);
+    }
+    f32 *f_in = Alloc(GetHeapAllocator(), count*sizeof(f32));
+    memcpy(f_in, f, count*sizeof(f32));
+    
+    audio_gain_ramp_f32(f, frame_count, channels, gain_from, gain_to);
+    audio_gain_ramp_s16(s, frame_count, channels, gain_from, gain_to);
+    for (u64 i = 0; i < count; i++) {
+        u64 frame = i/channels;
+        f32 gain = gain_from + (gain_to - gain_from)*(f32)frame/(f32)frame_count;
+        assert(fabsf(f[i] - f_in[i]*gain) <= 1e-5f, "Failed: %s f32 gain ramp with %d channels at sample %llu", audio_dsp_path_name(path), channels, i);
+        f32 expected = clamp((f32)s_in[i]*gain, -32768.0f, 32767.0f);
+        assert(fabsf((f32)s[i] - expected) <= 1.0f, "Failed: %s s16 gain ramp with %d channels at sample %llu", audio_dsp_path_name(path), channels, i);
+    }
+    Dealloc(GetHeapAllocator(), f);
+    Dealloc(GetHeapAllocator(), f_in);
+    Dealloc(GetHeapAllocator(), s);
+    Dealloc(GetHeapAllocator(), s_in);
+}
+
+// Runs every path the CPU can run against what the kernels are meant to do
+void test_audio_dsp() {
+    Audio_Dsp_Path original_path = audio_dsp_get_path();
+    Audio_Dsp_Path best = audio_dsp_set_path(AUDIO_DSP_PATH_AUTO);
+    assert(best != AUDIO_DSP_PATH_AUTO, "Failed: auto should pick a path");
+    assert(audio_dsp_set_path(AUDIO_DSP_PATH_AVX2 + 1) == best, "Failed: a path the CPU can't run should pick the best one");
+    
+    // Odd counts so the scalar tails run too
+    const u64 count = 1003;
+    f32 *f_dst = Alloc(GetHeapAllocator(), count*sizeof(f32));
+    f32 *f_src = Alloc(GetHeapAllocator(), count*sizeof(f32));
+    f32 *f_ref = Alloc(GetHeapAllocator(), count*sizeof(f32));
+    s16 *s_dst = Alloc(GetHeapAllocator(), count*sizeof(s16));
+    s16 *s_src = Alloc(GetHeapAllocator(), count*sizeof(s16));
+    s16 *s_ref = Alloc(GetHeapAllocator(), count*sizeof(s16));
+    
+    for (Audio_Dsp_Path path = AUDIO_DSP_PATH_SCALAR; path <= best; path++) {
+        assert(audio_dsp_set_path(path) == path, "Failed: setting a path the CPU can run");
+        const char *name = audio_dsp_path_name(path);
+        
+        // s16 mixing saturates, f32 mixing doesn't until it's saturated at the end
+        for (u64 i = 0; i < count; i++) {
+            f_dst[i] = get_random_float32_in_range(-1, 1);
+            f_src[i] = get_random_float32_in_range(-1, 1);
+            s_dst[i] = (s16)get_random_int_in_range(-32768, 32767);
+            s_src[i] = (s16)get_random_int_in_range(-32768, 32767);
+        }
+        s_dst[3] = 32767; s_src[3] = 1;
+        s_dst[4] = -32768; s_src[4] = -1;
+        for (u64 i = 0; i < count; i++) {
+            f_ref[i] = f_dst[i] + f_src[i];
+            s_ref[i] = (s16)clamp((s32)s_dst[i] + (s32)s_src[i], -32768, 32767);
+        }
+        audio_mix_f32(f_dst, f_src, count);
+        audio_mix_s16(s_dst, s_src, count);
+        assert(memcmp(f_dst, f_ref, count*sizeof(f32)) == 0, "Failed: %s f32 mixing", name);
+        assert(memcmp(s_dst, s_ref, count*sizeof(s16)) == 0, "Failed: %s s16 mixing", name);
+        assert(s_dst[3] == 32767 && s_dst[4] == -32768, "Failed: %s s16 mixing should saturate", name);
+        
+        f_dst[0] = 0.75f; f_src[0] = 0.5f;
+        audio_mix_f32(f_dst, f_src, 1);
+        f_src[0] = -0.5f;
+        audio_mix_f32(f_dst, f_src, 1);
+        assert(f_dst[0] == 0.75f, "Failed: %s f32 mixing should go over 1 and come back", name);
+        
+        f_dst[1] = 1.5f; f_dst[2] = -3.0f; f_dst[3] = NAN;
+        for (u64 i = 0; i < count; i++) {
+            f_ref[i] = clamp(f_dst[i], -1.0f, 1.0f);
+        }
+        f_ref[3] = -1.0f;
+        audio_saturate_f32(f_dst, count);
+        assert(memcmp(f_dst, f_ref, count*sizeof(f32)) == 0, "Failed: %s f32 saturating", name);
+        assert(f_dst[1] == 1.0f && f_dst[2] == -1.0f, "Failed: %s f32 saturating range", name);
+        
+        // Converting
+        s_src[0] = -32768; s_src[1] = 32767; s_src[2] = 0;
+        audio_convert_s16_to_f32(f_dst, s_src, count);
+        for (u64 i = 0; i < count; i++) {
+            assert(f_dst[i] == (f32)s_src[i]/32768.0f, "Failed: %s s16 to f32 at sample %llu", name, i);
+        }
+        assert(f_dst[0] == -1.0f, "Failed: %s s16 to f32 range", name);
+        audio_convert_f32_to_s16(s_dst, f_dst, count);
+        assert(memcmp(s_dst, s_src, count*sizeof(s16)) == 0, "Failed: %s s16 to f32 and back", name);
+        
+        f32 edges[] = { 1.0f, -1.0f, 2.0f, -2.0f, NAN, 0.4f/32768.0f, 0.6f/32768.0f, -0.6f/32768.0f, 100.5f/32768.0f };
+        s16 expected_edges[] = { 32767, -32768, 32767, -32768, -32768, 0, 1, -1, 100 };
+        for (u64 i = 0; i < count; i++) f_src[i] = edges[i%(sizeof(edges)/sizeof(f32))];
+        audio_convert_f32_to_s16(s_dst, f_src, count);
+        for (u64 i = 0; i < count; i++) {
+            s16 expected = expected_edges[i%(sizeof(edges)/sizeof(f32))];
+            assert(s_dst[i] == expected, "Failed: %s f32 to s16 at sample %llu got %d, expected %d", name, i, (s32)s_dst[i], (s32)expected);
+        }
+        
+        // Gain ramps, vectorised and not
+        for (int channels = 1; channels <= 8; channels++) {
+            test_audio_dsp_check_ramp(path, 101, channels, 0.0f, 1.0f);
+            test_audio_dsp_check_ramp(path, 64, channels, 1.0f, 0.25f);
+            test_audio_dsp_check_ramp(path, 7, channels, 0.5f, 0.5f);
+        }
+        test_audio_dsp_check_ramp(path, 33, 2, 4.0f, 4.0f);
+        
+        // Starts at gain_from, and the next buffer goes on from gain_to
+        for (u64 i = 0; i < 64; i++) f_dst[i] = 1.0f;
+        audio_gain_ramp_f32(f_dst, 32, 2, 0.0f, 0.5f);
+        assert(f_dst[0] == 0.0f && f_dst[1] == 0.0f, "Failed: %s ramp should start at gain_from", name);
+        assert(fabsf(f_dst[62] - (0.5f - 0.5f/32.0f)) < 1e-6f, "Failed: %s ramp should stop one frame short of gain_to", name);
+        
+        // Panning
+        f32 left, right;
+        audio_stereo_pan_gains(0.0f, &left, &right);
+        assert(fabsf(left - right) < 1e-6f && fabsf(left*left + right*right - 1.0f) < 1e-5f, "Failed: centered pan should be constant power");
+        audio_stereo_pan_gains(-5.0f, &left, &right);
+        assert(fabsf(left - 1.0f) < 1e-6f && fabsf(right) < 1e-6f, "Failed: hard left pan");
+        
+        u64 frames = count/2;
+        for (u64 i = 0; i < frames*2; i++) {
+            f_dst[i] = f_src[i] = get_random_float32_in_range(-1, 1);
+            s_dst[i] = s_src[i] = (s16)get_random_int_in_range(-32768, 32767);
+        }
+        audio_pan_stereo_f32(f_dst, frames, 0.25f, 1.5f);
+        audio_pan_stereo_s16(s_dst, frames, 0.25f, 1.5f);
+        for (u64 i = 0; i < frames*2; i++) {
+            f32 gain = i % 2 ? 1.5f : 0.25f;
+            assert(f_dst[i] == f_src[i]*gain, "Failed: %s f32 pan at sample %llu", name, i);
+            f32 expected = clamp((f32)s_src[i]*gain, -32768.0f, 32767.0f);
+            assert(fabsf((f32)s_dst[i] - expected) <= 0.5f, "Failed: %s s16 pan at sample %llu", name, i);
+        }
+    }
+    
+    Dealloc(GetHeapAllocator(), f_dst);
+    Dealloc(GetHeapAllocator(), f_src);
+    Dealloc(GetHeapAllocator(), f_ref);
+    Dealloc(GetHeapAllocator(), s_dst);
+    Dealloc(GetHeapAllocator(), s_src);
+    Dealloc(GetHeapAllocator(), s_ref);
+    
+    // Mixing 256 stereo s16 voices with a volume ramp and a pan into one 10 ms buffer at 48 kHz
+    const u64 voice_count = 256;
+    const u64 buffer_frames = 480;
+    const u64 buffer_samples = buffer_frames*2;
+    s16 *voices = Alloc(GetHeapAllocator(), voice_count*buffer_samples*sizeof(s16));
+    f32 *voice_buffer = Alloc(GetHeapAllocator(), buffer_samples*sizeof(f32));
+    f32 *bus = Alloc(GetHeapAllocator(), buffer_samples*sizeof(f32));
+    s16 *output = Alloc(GetHeapAllocator(), buffer_samples*sizeof(s16));
+    for (u64 i = 0; i < voice_count*buffer_samples; i++) {
+        voices[i] = (s16)get_random_int_in_range(-2000, 2000);
+    }
+    
+    float64 best_us[AUDIO_DSP_PATH_AVX2 + 1] = {0};
+    for (Audio_Dsp_Path path = AUDIO_DSP_PATH_SCALAR; path <= best; path++) {
+        audio_dsp_set_path(path);
+        best_us[path] = F32_MAX;
+        for (int run = 0; run < 20; run++) {
+            float64 start = OsGetElapsedSeconds();
+            memset(bus, 0, buffer_samples*sizeof(f32));
+            for (u64 v = 0; v < voice_count; v++) {
+                f32 left, right;
+                audio_stereo_pan_gains((f32)v/(f32)voice_count*2.0f - 1.0f, &left, &right);
+                audio_convert_s16_to_f32(voice_buffer, voices + v*buffer_samples, buffer_samples);
+                audio_gain_ramp_f32(voice_buffer, buffer_frames, 2, 0.5f, 0.6f);
+                audio_pan_stereo_f32(voice_buffer, buffer_frames, left, right);
+                audio_mix_f32(bus, voice_buffer, buffer_samples);
+            }
+            audio_saturate_f32(bus, buffer_samples);
+            audio_convert_f32_to_s16(output, bus, buffer_samples);
+            float64 us = (OsGetElapsedSeconds() - start)*1000000.0;
+            if (us < best_us[path]) best_us[path] = us;
+        }
+    }
+    print("Mixing %llu voices into %llu frames at 48 kHz (%.0f us of audio):", voice_count, buffer_frames, (float64)buffer_frames/48000.0*1000000.0);
+    for (Audio_Dsp_Path path = AUDIO_DSP_PATH_SCALAR; path <= best; path++) {
+        print("%s %s %.1f us", path == AUDIO_DSP_PATH_SCALAR ? "" : ",", audio_dsp_path_name(path), best_us[path]);
+    }
+    print(" per buffer\n");
+    
+    Dealloc(GetHeapAllocator(), voices);
+    Dealloc(GetHeapAllocator(), voice_buffer);
+    Dealloc(GetHeapAllocator(), bus);
+    Dealloc(GetHeapAllocator(), output);
+    
+    audio_dsp_set_path(original_path);
+}
+
+#if defined(RENDERER_SOFTWARE) && RENDERER_SOFTWARE
+// x, y in pixels from the bottom left, like scissors and texture rows
+void test_software_check_pixel(SDL_Surface *surface, int x, int y, int r, int g, int b, int a, int tolerance) {
+    u8 *p = (u8*)surface->pixels + (u64)y*surface->pitch + (u64)x*4;
+    bool ok = abs(p[0] - r) <= tolerance && abs(p[1] - g) <= tolerance && abs(p[2] - b) <= tolerance && abs(p[3] - a) <= tolerance;
+    assert(ok, "Failed: pixel %d, %d is %d %d %d %d, expected %d %d %d %d", x, y, p[0], p[1], p[2], p[3], r, g, b, a);
+}
+
+void test_software_rasteriser() {
+    Allocator heap = GetHeapAllocator();
+    int32_t old_width = window.width, old_height = window.height;
+    window.width = 1920;
+    window.height = 1080;
+    
+    GAL_Texture_Desc target_desc = { .width = 1920, .height = 1080, .channels = 4, .is_render_target = true };
+    SDL_Surface *target = (SDL_Surface*)software_create_texture(&target_desc, heap);
+    u64 target_size = (u64)target->pitch*(u64)target->h;
+    u8 *reference = Alloc(heap, target_size);
+    
+    // Rows go from the bottom: red green, blue white
+    u8 texels[16] = { 255,0,0,255,  0,255,0,255,  0,0,255,255,  255,255,255,255 };
+    GAL_Texture_Desc texture_desc = { .width = 2, .height = 2, .channels = 4, .initial_data = texels };
+    Gal_Image image = { .width = 2, .height = 2, .channels = 4, .gal_handle = software_create_texture(&texture_desc, heap) };
+    u8 coverage[4] = { 0, 255, 128, 255 };
+    GAL_Texture_Desc font_desc = { .width = 2, .height = 2, .channels = 1, .initial_data = coverage };
+    Gal_Image font = { .width = 2, .height = 2, .channels = 1, .gal_handle = software_create_texture(&font_desc, heap) };
+    
+    Draw_Frame *frame = Alloc(heap, sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    
+    // Window pixel x, y is x - 960, y - 540 in the frame. Every path has to draw the same thing.
+    Software_Raster_Path best = software_best_raster_path();
+    for (Software_Raster_Path path = SOFTWARE_RASTER_PATH_SCALAR; path <= best; path++) {
+        software_data.raster_path = path;
+        software_clear_render_target(target, 0, 0, 0, 1);
+        DrawFrameReset(frame);
+        
+        DrawRectInFrame(v2(-960, -540), v2(10, 10), v4(1, 0, 0, 1), frame);
+        DrawRectInFrame(v2(-955, -540), v2(10, 10), v4(0, 0, 1, 0.5f), frame);
+        DrawCircleInFrame(v2(-900, -540), v2(20, 20), v4(1, 1, 1, 1), frame);
+        DrawImageInFrame(&image, v2(-800, -540), v2(20, 20), v4(1, 1, 1, 1), frame);
+        Draw_Quad *text = DrawImageInFrame(&font, v2(-700, -540), v2(20, 20), v4(0, 1, 0, 1), frame);
+        text->type = QUAD_TYPE_TEXT;
+        Draw_Quad *linear = DrawImageInFrame(&image, v2(-600, -540), v2(20, 20), v4(1, 1, 1, 1), frame);
+        linear->image_mag_filter = GFX_FILTER_MODE_LINEAR;
+        push_window_scissor_in_frame(v2(600, 0), v2(610, 10), frame);
+        DrawRectInFrame(v2(-370, -540), v2(40, 40), v4(1, 1, 0, 1), frame);
+        pop_window_scissor_in_frame(frame);
+        // Diamond with its left corner on 800, 50
+        DrawRectXformInFrame(M4RotateZ(M4Translate(M4Scalar(1.0), v3(-160, -490, 0)), PI32/4.0f), v2(20, 20), v4(0, 1, 1, 0.75f), frame);
+        
+        software_render_draw_frame(frame, target);
+        assert(software_data.raster_stats.quads_drawn == 8, "Failed: drew %llu quads", software_data.raster_stats.quads_drawn);
+        
+        test_software_check_pixel(target, 2, 2,   255, 0, 0, 255, 0);
+        test_software_check_pixel(target, 7, 2,   128, 0, 128, 255, 1);
+        test_software_check_pixel(target, 12, 9,  0, 0, 128, 255, 1);
+        test_software_check_pixel(target, 15, 2,  0, 0, 0, 255, 0);
+        test_software_check_pixel(target, 2, 10,  0, 0, 0, 255, 0);
+        
+        test_software_check_pixel(target, 70, 10, 255, 255, 255, 255, 0);
+        test_software_check_pixel(target, 61, 1,  0, 0, 0, 255, 0);
+        test_software_check_pixel(target, 78, 18, 0, 0, 0, 255, 0);
+        
+        test_software_check_pixel(target, 165, 5,  255, 0, 0, 255, 0);
+        test_software_check_pixel(target, 175, 5,  0, 255, 0, 255, 0);
+        test_software_check_pixel(target, 165, 15, 0, 0, 255, 255, 0);
+        test_software_check_pixel(target, 175, 15, 255, 255, 255, 255, 0);
+        
+        test_software_check_pixel(target, 265, 5,  0, 0, 0, 255, 0);
+        test_software_check_pixel(target, 275, 5,  0, 255, 0, 255, 0);
+        test_software_check_pixel(target, 265, 15, 0, 128, 0, 255, 1);
+        
+        // Halfway between all 4 texels at the center, the same as the corner texels at the corners
+        test_software_check_pixel(target, 370, 10, 129, 140, 140, 255, 2);
+        test_software_check_pixel(target, 360, 0,  255, 0, 0, 255, 0);
+        test_software_check_pixel(target, 379, 19, 255, 255, 255, 255, 0);
+        
+        test_software_check_pixel(target, 605, 5,  255, 255, 0, 255, 0);
+        test_software_check_pixel(target, 599, 5,  0, 0, 0, 255, 0);
+        test_software_check_pixel(target, 610, 5,  0, 0, 0, 255, 0);
+        test_software_check_pixel(target, 605, 10, 0, 0, 0, 255, 0);
+        
+        test_software_check_pixel(target, 814, 50, 0, 191, 191, 255, 1);
+        test_software_check_pixel(target, 802, 40, 0, 0, 0, 255, 0);
+        test_software_check_pixel(target, 826, 61, 0, 0, 0, 255, 0);
+        
+        if (path == SOFTWARE_RASTER_PATH_SCALAR) {
+            memcpy(reference, target->pixels, target_size);
+        } else {
+            u8 *p = (u8*)target->pixels;
+            for (u64 i = 0; i < target_size; i++) {
+                assert(abs(p[i] - reference[i]) <= 1, "Failed: path %d differs from the scalar path at byte %llu", path, i);
+            }
+        }
+    }
+    
+    // Translucent quads around a point sharing their edges, nothing is blended twice
+    software_data.raster_path = best;
+    software_clear_render_target(target, 0, 0, 0, 1);
+    DrawFrameReset(frame);
+    for (int i = 0; i < 4; i++) {
+        Matrix4 xform = M4RotateZ(M4Translate(M4Scalar(1.0), v3(0, 0, 0)), PI32/6.0f + (f32)i*PI32/2.0f);
+        DrawRectXformInFrame(xform, v2(50, 50), v4(1, 1, 1, 0.5f), frame);
+    }
+    software_render_draw_frame(frame, target);
+    for (int y = 440; y < 640; y++) {
+        u8 *row = (u8*)target->pixels + (u64)y*target->pitch;
+        for (int x = 860; x < 1060; x++) {
+            assert(row[x*4] == 0 || row[x*4] == 128, "Failed: pixel %d, %d was blended twice (%d)", x, y, row[x*4]);
+        }
+    }
+    
+    // Benchmarks at 1080p: big translucent linear filtered quads, and lots of small sprites
+    u8 *big_texels = Alloc(heap, 64*64*4);
+    for (u64 i = 0; i < 64*64*4; i++) big_texels[i] = (u8)(i*7);
+    GAL_Texture_Desc big_desc = { .width = 64, .height = 64, .channels = 4, .initial_data = big_texels };
+    Gal_Image big = { .width = 64, .height = 64, .channels = 4, .gal_handle = software_create_texture(&big_desc, heap) };
+    
+    for (Software_Raster_Path path = SOFTWARE_RASTER_PATH_SCALAR; path <= best; path++) {
+        software_data.raster_path = path;
+        const char *names[] = { "auto", "scalar", "SSE2", "AVX2" };
+        float64 best_ms[2] = { F32_MAX, F32_MAX };
+        u64 pixels[2] = { 0, 0 };
+        u64 quads[2] = { 0, 0 };
+        for (int run = 0; run < 4; run++) {
+            int sprites = run % 2;
+            DrawFrameReset(frame);
+            seed_for_random = 1234;
+            u64 count = sprites ? 50000 : 5000;
+            f32 size = sprites ? 16 : 64;
+            for (u64 i = 0; i < count; i++) {
+                Vector2 p = v2(get_random_float32_in_range(-960, 960 - size), get_random_float32_in_range(-540, 540 - size));
+                Draw_Quad *q = DrawImageInFrame(&big, p, v2(size, size), v4(1, 1, 1, sprites ? 1.0f : 0.5f), frame);
+                if (!sprites) q->image_mag_filter = GFX_FILTER_MODE_LINEAR;
+            }
+            float64 start = OsGetElapsedSeconds();
+            software_render_draw_frame(frame, target);
+            float64 ms = (OsGetElapsedSeconds() - start)*1000.0;
+            if (ms < best_ms[sprites]) best_ms[sprites] = ms;
+            pixels[sprites] = software_data.raster_stats.pixels_written;
+            quads[sprites] = software_data.raster_stats.quads_drawn;
+        }
+        print("Software rasteriser (%s) at 1920x1080: %llu 64x64 linear blended quads %.2f ms (%.0f Mpix/s, %.0f quads/s), %llu 16x16 sprites %.2f ms (%.0f Mpix/s, %.0f quads/s)\n", names[path],
+            quads[0], best_ms[0], (f64)pixels[0]/(best_ms[0]*1000.0), (f64)quads[0]/(best_ms[0]/1000.0),
+            quads[1], best_ms[1], (f64)pixels[1]/(best_ms[1]*1000.0), (f64)quads[1]/(best_ms[1]/1000.0));
+    }
+    
+    software_data.raster_path = SOFTWARE_RASTER_PATH_AUTO;
+    software_destroy_texture(big.gal_handle, heap);
+    software_destroy_texture(image.gal_handle, heap);
+    software_destroy_texture(font.gal_handle, heap);
+    software_destroy_texture(target, heap);
+    Dealloc(heap, big_texels);
+    Dealloc(heap, reference);
+    draw_frame_deinit(frame);
+    Dealloc(heap, frame);
+    window.width = old_width;
+    window.height = old_height;
+}
+void test_software_tiles() {
+    Allocator heap = GetHeapAllocator();
+    int32_t old_width = window.width, old_height = window.height;
+    window.width = 1920;
+    window.height = 1080;
+    
+    GAL_Texture_Desc target_desc = { .width = 1920, .height = 1080, .channels = 4, .is_render_target = true };
+    SDL_Surface *target = (SDL_Surface*)software_create_texture(&target_desc, heap);
+    u64 target_size = (u64)target->pitch*(u64)target->h;
+    u8 *reference = Alloc(heap, target_size);
+    
+    u8 *texels = Alloc(heap, 64*64*4);
+    for (u64 i = 0; i < 64*64*4; i++) texels[i] = (u8)(i*13);
+    GAL_Texture_Desc texture_desc = { .width = 64, .height = 64, .channels = 4, .initial_data = texels };
+    Gal_Image image = { .width = 64, .height = 64, .channels = 4, .gal_handle = software_create_texture(&texture_desc, heap) };
+    
+    // Lots of overlapping translucent quads of all kinds and sizes, so the order matters and
+    // most of them are cut by tiles
+    Draw_Frame *frame = Alloc(heap, sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    DrawFrameReset(frame);
+    seed_for_random = 4321;
+    for (u64 i = 0; i < 4000; i++) {
+        Vector2 size = v2(get_random_float32_in_range(2, 300), get_random_float32_in_range(2, 300));
+        Vector2 p = v2(get_random_float32_in_range(-1000, 960), get_random_float32_in_range(-580, 540));
+        Vector4 color = v4(get_random_float32_in_range(0, 1), get_random_float32_in_range(0, 1), get_random_float32_in_range(0, 1), get_random_float32_in_range(0.2f, 1));
+        Draw_Quad *q;
+        switch (i % 4) {
+            case 0: q = DrawRectInFrame(p, size, color, frame); break;
+            case 1: q = DrawCircleInFrame(p, size, color, frame); break;
+            case 2: q = DrawImageInFrame(&image, p, size, color, frame); break;
+            default: q = DrawRectXformInFrame(M4RotateZ(M4Translate(M4Scalar(1.0), v3(p.x, p.y, 0)), get_random_float32_in_range(0, 2*PI32)), size, color, frame); break;
+        }
+        if (i % 3 == 0) q->image_mag_filter = GFX_FILTER_MODE_LINEAR;
+    }
+    
+    // Reference drawn without tiles, one quad at a time over the whole target
+    Software_Raster_Path path = software_best_raster_path();
+    software_data.raster_path = path;
+    software_clear_render_target(target, 0.1f, 0.2f, 0.3f, 1);
+    Software_Target whole = software_get_target(target, false);
+    for (u64 c = 0; c < bucket_array_get_chunk_count(&frame->quad_buffer); c++) {
+        u64 n;
+        Draw_Quad *quads = (Draw_Quad*)bucket_array_get_chunk(&frame->quad_buffer, c, &n);
+        for (u64 i = 0; i < n; i++) {
+            Software_Quad quad;
+            Software_Raster_Quad rq;
+            software_quad_from_draw_quad(&quad, &quads[i]);
+            if (software_setup_quad(&rq, &quad, &whole, draw_get_pixel_snap(frame))) software_raster_quad(path, &rq, &whole);
+        }
+    }
+    memcpy(reference, target->pixels, target_size);
+    
+    // Every thread count gives exactly the same pixels. Also measures how it scales.
+    u64 processors = os_get_number_of_logical_processors();
+    u64 max_threads = max(processors, 4);
+    float64 single_ms = 0;
+    for (u64 threads = 1; threads <= max_threads; threads *= 2) {
+        Job_Pool *pool = Alloc(heap, sizeof(Job_Pool));
+        job_pool_init(pool, threads - 1);
+        software_data.raster_job_pool = pool;
+        
+        float64 best_ms = F32_MAX;
+        for (int run = 0; run < 3; run++) {
+            software_clear_render_target(target, 0.1f, 0.2f, 0.3f, 1);
+            float64 start = OsGetElapsedSeconds();
+            software_render_draw_frame(frame, target);
+            float64 ms = (OsGetElapsedSeconds() - start)*1000.0;
+            if (ms < best_ms) best_ms = ms;
+            
+            assert(memcmp(reference, target->pixels, target_size) == 0, "Failed: %llu threads drew something else than without tiles", threads);
+        }
+        Software_Raster_Stats stats = software_data.raster_stats;
+        assert(stats.quads_drawn + stats.quads_skipped == bucket_array_get_count(&frame->quad_buffer), "Failed: %llu quads drawn and %llu skipped", stats.quads_drawn, stats.quads_skipped);
+        assert(stats.tiles_drawn > 0 && stats.tiles_drawn <= 30*17, "Failed: drew %llu tiles", stats.tiles_drawn);
+        assert(stats.tile_quads >= stats.quads_drawn, "Failed: %llu quads binned to tiles", stats.tile_quads);
+        
+        if (threads == 1) single_ms = best_ms;
+        print("Software tiles with %llu threads (%llu processors) at 1920x1080: %llu quads in %llu tiles %.2f ms (%.0f Mpix/s, %.2fx of 1 thread)\n",
+            threads, processors, stats.quads_drawn, stats.tiles_drawn, best_ms, (f64)stats.pixels_written/(best_ms*1000.0), single_ms/best_ms);
+        
+        software_data.raster_job_pool = 0;
+        job_pool_destroy(pool);
+        Dealloc(heap, pool);
+    }
+    
+    software_data.raster_path = SOFTWARE_RASTER_PATH_AUTO;
+    software_destroy_texture(image.gal_handle, heap);
+    software_destroy_texture(target, heap);
+    Dealloc(heap, texels);
+    Dealloc(heap, reference);
+    draw_frame_deinit(frame);
+    Dealloc(heap, frame);
+    window.width = old_width;
+    window.height = old_height;
+}
+void test_software_render_targets() {
+    Allocator heap = GetHeapAllocator();
+    int32_t old_width = window.width, old_height = window.height;
+    window.width = 1280;
+    window.height = 720;
+    Draw_Frame *frame = Alloc(heap, sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    f32 w = (f32)window.width, h = (f32)window.height;
+    
+    // Red in the bottom left quarter of the image, the frame covers the whole image whatever its size
+    Gal_Image a = {0}, b = {0};
+    assert(gal_create_image(&a, 64, 32, 4, 0, true, heap) == GAL_RESULT_SUCCESS, "Failed: could not create a render target");
+    assert(gal_create_image(&b, 64, 32, 4, 0, true, heap) == GAL_RESULT_SUCCESS, "Failed: could not create a render target");
+    gal_clear_image(&a, 0, 0, 1, 1);
+    DrawFrameReset(frame);
+    DrawRectInFrame(v2(-w/2, -h/2), v2(w/2, h/2), v4(1, 0, 0, 1), frame);
+    gal_render_draw_frame(frame, &a);
+    
+    u8 *pixels = Alloc(heap, 64*32*4);
+    gal_read_image_data(&a, 0, 0, 64, 32, pixels);
+    for (u32 y = 0; y < 32; y++) {
+        for (u32 x = 0; x < 64; x++) {
+            u8 *p = &pixels[(y*64 + x)*4];
+            bool red = x < 32 && y < 16;
+            assert(p[0] == (red ? 255 : 0) && p[1] == 0 && p[2] == (red ? 0 : 255) && p[3] == 255, "Failed: pixel %u, %u of the render target is %d %d %d %d", x, y, p[0], p[1], p[2], p[3]);
+        }
+    }
+    
+    // Part of it, and images with fewer channels come back as they were uploaded
+    u8 part[3*2*4];
+    gal_read_image_data(&a, 30, 15, 3, 2, part);
+    for (u32 y = 0; y < 2; y++) {
+        assert(memcmp(&part[y*3*4], &pixels[((15 + y)*64 + 30)*4], 3*4) == 0, "Failed: reading part of an image");
+    }
+    u8 gray[5*3] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    u8 gray_read[5*3] = {0};
+    Gal_Image font = {0};
+    gal_create_image(&font, 5, 3, 1, gray, false, heap);
+    gal_read_image_data(&font, 0, 0, 5, 3, gray_read);
+    assert(memcmp(gray, gray_read, sizeof(gray)) == 0, "Failed: 1 channel image read back wrong");
+    gal_destroy_image(&font);
+    
+    // No copy, rows from the bottom
+    GAL_Pixel_View view;
+    assert(gal_get_image_pixels(&a, &view), "Failed: no pixels for the render target");
+    assert(view.width == 64 && view.height == 32 && !view.rows_from_top, "Failed: pixel view is %ux%u", view.width, view.height);
+    for (u32 y = 0; y < 32; y++) {
+        assert(memcmp((u8*)view.pixels + (u64)y*view.pitch, &pixels[y*64*4], 64*4) == 0, "Failed: pixel view row %u differs from gal_read_image_data", y);
+    }
+    
+    // A rendered image draws the right way up, like an uploaded one
+    gal_clear_image(&b, 0, 0, 0, 1);
+    DrawFrameReset(frame);
+    DrawImageInFrame(&a, v2(-w/2, -h/2), v2(w, h), v4(1, 1, 1, 1), frame);
+    gal_render_draw_frame(frame, &b);
+    u8 *copied = Alloc(heap, 64*32*4);
+    gal_read_image_data(&b, 0, 0, 64, 32, copied);
+    assert(memcmp(pixels, copied, 64*32*4) == 0, "Failed: drawing a rendered image doesn't give the same pixels");
+    
+    // Read and written back gives the same image
+    gal_update_image_data(&b, 0, 0, 64, 32, pixels);
+    gal_read_image_data(&b, 0, 0, 64, 32, copied);
+    assert(memcmp(pixels, copied, 64*32*4) == 0, "Failed: pixels changed after a round trip");
+    
+    // The window, rows from the top. Red in the top left quarter.
+    DrawFrameReset(frame);
+    DrawRectInFrame(v2(-w/2, 0), v2(w/2, h/2), v4(1, 0, 0, 1), frame);
+    gal_render_draw_frame_to_window(frame);
+    assert(gal_get_framebuffer_pixels(&view), "Failed: no pixels for the window");
+    assert(view.rows_from_top && view.width > 4 && view.height > 4, "Failed: window pixel view is %ux%u", view.width, view.height);
+    u32 top_left = ((u32*)((u8*)view.pixels + (u64)(view.height/4)*view.pitch))[view.width/4];
+    u32 bottom_right = ((u32*)((u8*)view.pixels + (u64)(view.height*3/4)*view.pitch))[view.width*3/4];
+    assert((top_left & view.r_mask) == view.r_mask && (top_left & (view.g_mask | view.b_mask)) == 0, "Failed: top left of the window is %08x", top_left);
+    assert((bottom_right & (view.r_mask | view.g_mask | view.b_mask)) == 0, "Failed: bottom right of the window is %08x", bottom_right);
+    
+    gal_destroy_image(&a);
+    gal_destroy_image(&b);
+    Dealloc(heap, pixels);
+    Dealloc(heap, copied);
+    draw_frame_deinit(frame);
+    Dealloc(heap, frame);
+    window.width = old_width;
+    window.height = old_height;
+}
+
+// Bytes that are more than tolerance apart
+u64 test_software_count_different_bytes(SDL_Surface *a, SDL_Surface *b, s32 tolerance) {
+    u64 count = 0;
+    for (s32 y = 0; y < a->h; y++) {
+        u8 *ra = (u8*)a->pixels + (u64)y*a->pitch, *rb = (u8*)b->pixels + (u64)y*b->pitch;
+        for (s32 x = 0; x < a->w*4; x++) {
+            s32 d = (s32)ra[x] - (s32)rb[x];
+            count += d < -tolerance || d > tolerance;
+        }
+    }
+    return count;
+}
+
+// The instanced path gives the same pixels as drawing the Draw_Quad's, up to colors being
+// packed to 8 bits and corners being rebuilt from the axes, which moves a few edge pixels
+// of rotated quads in or out
+void test_software_instances() {
+    Allocator heap = GetHeapAllocator();
+    int32_t old_width = window.width, old_height = window.height;
+    window.width = 1280;
+    window.height = 720;
+    f32 w = (f32)window.width, h = (f32)window.height;
+    Draw_Frame *frame = Alloc(heap, sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    DrawFrameReset(frame);
+    
+    u8 texels[2*2*4] = { 255, 0, 0, 255,  0, 255, 0, 255,  0, 0, 255, 255,  255, 255, 255, 128 };
+    Gal_Image image = {0}, a = {0}, b = {0};
+    assert(gal_create_image(&image, 2, 2, 4, texels, false, heap) == GAL_RESULT_SUCCESS, "Failed: could not create an image");
+    assert(gal_create_image(&a, 96, 64, 4, 0, true, heap) == GAL_RESULT_SUCCESS, "Failed: could not create a render target");
+    assert(gal_create_image(&b, 96, 64, 4, 0, true, heap) == GAL_RESULT_SUCCESS, "Failed: could not create a render target");
+    
+    seed_for_random = 7;
+    for (u32 i = 0; i < 300; i++) {
+        if (i == 200) push_window_scissor_in_frame(v2(w*0.25f, h*0.25f), v2(w*0.6f, h*0.7f), frame);
+        Vector2 p = v2(get_random_float32_in_range(-w/2, w/2), get_random_float32_in_range(-h/2, h/2));
+        Vector2 size = v2(get_random_float32_in_range(20, 300), get_random_float32_in_range(20, 300));
+        Vector4 color = v4(get_random_float32_in_range(0, 1), get_random_float32_in_range(0, 1), get_random_float32_in_range(0, 1), get_random_float32_in_range(0.2f, 1));
+        Draw_Quad *q;
+        switch (i % 4) {
+            case 0: q = DrawRectInFrame(p, size, color, frame); break;
+            case 1: q = DrawCircleInFrame(p, size, color, frame); break;
+            case 2: q = DrawImageInFrame(&image, p, size, color, frame); break;
+            default: q = DrawRectXformInFrame(M4RotateZ(M4Translate(M4Scalar(1.0), v3(p.x, p.y, 0)), get_random_float32_in_range(0, 2*PI32)), size, color, frame); break;
+        }
+        if (i % 3 == 0) q->image_mag_filter = GFX_FILTER_MODE_LINEAR;
+    }
+    
+    software_clear_render_target(a.gal_handle, 0, 0, 0, 1);
+    software_clear_render_target(b.gal_handle, 0, 0, 0, 1);
+    software_render_draw_frame(frame, a.gal_handle);
+    
+    Draw_Instance_Stream stream = {0};
+    draw_frame_build_instance_stream(frame, &stream);
+    assert(stream.scissors.count == 1 && stream.calls.count >= 2, "Failed: expected a scissor break, got %llu calls", stream.calls.count);
+    assert(gal_render_instance_stream(&stream, &b), "Failed: the software renderer has no instanced path");
+    
+    SDL_Surface *sa = (SDL_Surface*)a.gal_handle, *sb = (SDL_Surface*)b.gal_handle;
+    u64 total = (u64)sa->w*sa->h*4;
+    u64 off = test_software_count_different_bytes(sa, sb, 2);
+    assert(off*500 < total, "Failed: %llu of %llu bytes are different with instances", off, total);
+    
+    // Through gal it's the instanced path too
+    software_clear_render_target(b.gal_handle, 0, 0, 0, 1);
+    gal_render_draw_frame(frame, &b);
+    off = test_software_count_different_bytes(sa, sb, 2);
+    assert(off*500 < total, "Failed: %llu of %llu bytes are different through gal", off, total);
+    
+    draw_instance_stream_deinit(&stream);
+    gal_destroy_image(&image);
+    gal_destroy_image(&a);
+    gal_destroy_image(&b);
+    draw_frame_deinit(frame);
+    Dealloc(heap, frame);
+    window.width = old_width;
+    window.height = old_height;
+}
+#endif
+
+// Calls the null renderer directly, so it runs whatever renderer the tests were built with
+void test_null_renderer() {
+    Allocator heap = GetHeapAllocator();
+    Null_Data old_data = null_data;
+    null_data = (Null_Data){0};
+    int32_t old_width = window.width, old_height = window.height;
+    window.width = 1280;
+    window.height = 720;
+    f32 w = (f32)window.width;
+    
+    GAL_Renderer renderer = null_create_renderer();
+    assert(renderer.backend == GAL_BACKEND_NULL, "Failed: null renderer has backend %d", renderer.backend);
+    assert(renderer.initialize() == GAL_RESULT_SUCCESS, "Failed: null renderer didn't initialize");
+    GAL_Window_Desc window_desc = { .title = "Null", .width = 1280, .height = 720 };
+    assert(renderer.create_window(&window_desc) == GAL_RESULT_SUCCESS, "Failed: null renderer didn't make a window");
+    
+    // Textures are plain memory
+    u8 gray[4*3] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+    GAL_Texture_Desc desc = { .width = 4, .height = 3, .channels = 1, .initial_data = gray };
+    GAL_Texture_Handle font = renderer.create_texture(&desc, heap);
+    desc = (GAL_Texture_Desc){ .width = 16, .height = 8, .channels = 4, .is_render_target = true };
+    GAL_Texture_Handle target = renderer.create_texture(&desc, heap);
+    assert(font && target, "Failed: null renderer didn't create textures");
+    
+    u8 patch[2*2] = { 100, 101, 102, 103 };
+    renderer.update_texture(font, 1, 1, 2, 2, patch);
+    renderer.update_texture(font, 3, 2, 2, 2, patch); // Outside, ignored
+    u8 read[4*3];
+    renderer.read_texture(font, 0, 0, 4, 3, read);
+    u8 expected[4*3] = { 1, 2, 3, 4, 5, 100, 101, 8, 9, 102, 103, 12 };
+    assert(memcmp(read, expected, sizeof(read)) == 0, "Failed: null texture read back wrong");
+    
+    renderer.clear_render_target(target, 1, 0, 0.5f, 1);
+    u8 pixel[4];
+    renderer.read_texture(target, 15, 7, 1, 1, pixel);
+    assert(pixel[0] == 255 && pixel[1] == 0 && pixel[2] == 128 && pixel[3] == 255, "Failed: null render target cleared to %d %d %d %d", pixel[0], pixel[1], pixel[2], pixel[3]);
+    
+    GAL_Stats stats;
+    renderer.get_stats(&stats);
+    assert(stats.texture_count == 2 && stats.texture_bytes == 4*3 + 16*8*4, "Failed: null renderer has %llu textures of %llu bytes", stats.texture_count, stats.texture_bytes);
+    assert(stats.texture_uploads == 2 && stats.texture_upload_bytes == 4*3 + 2*2, "Failed: null renderer counted %llu uploads of %llu bytes", stats.texture_uploads, stats.texture_upload_bytes);
+    
+    // Frames are walked and checked
+    Draw_Frame *frame = Alloc(heap, sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    DrawFrameReset(frame);
+    Gal_Image font_image = { .width = 4, .height = 3, .channels = 1, .gal_handle = font, .allocator = heap };
+    // A destroyed texture whose slot was given to a new one is still caught
+    GAL_Texture_Desc dead_desc = { .width = 2, .height = 2, .channels = 1 };
+    GAL_Texture_Handle dead = renderer.create_texture(&dead_desc, heap);
+    renderer.destroy_texture(dead, heap);
+    GAL_Texture_Handle reused = renderer.create_texture(&dead_desc, heap);
+    assert(reused && reused != dead, "Failed: a new texture got the handle of a destroyed one");
+    Gal_Image dead_image = font_image;
+    dead_image.gal_handle = dead;
+    for (int i = 0; i < 10; i++) {
+        DrawRectInFrame(v2(-w/2 + i*10, 0), v2(8, 8), v4(1, 1, 1, 1), frame);
+    }
+    DrawImageInFrame(&font_image, v2(0, 0), v2(8, 8), v4(1, 1, 1, 1), frame);
+    DrawImageInFrame(&dead_image, v2(0, 0), v2(8, 8), v4(1, 1, 1, 1), frame);
+    Draw_Quad *nan_quad = DrawRectInFrame(v2(0, 0), v2(8, 8), v4(1, 1, 1, 1), frame);
+    nan_quad->top_left.x = NAN;
+    
+    renderer.begin_frame();
+    renderer.render_draw_frame_to_window(frame);
+    renderer.render_draw_frame(frame, target);
+    renderer.end_frame();
+    renderer.present();
+    
+    renderer.get_stats(&stats);
+    assert(stats.frames == 1, "Failed: null renderer counted %llu frames", stats.frames);
+    assert(stats.quads == 2*13 && stats.invalid_quads == 2*2, "Failed: null renderer counted %llu quads and %llu invalid", stats.quads, stats.invalid_quads);
+    assert(stats.draw_calls >= 2, "Failed: null renderer counted %llu draw calls", stats.draw_calls);
+    
+    // Streams are checked against their draw calls too
+    Draw_Instance_Stream stream = {0};
+    draw_frame_build_instance_stream(frame, &stream);
+    renderer.render_instances(&stream, 0);
+    GAL_Stats stream_stats;
+    renderer.get_stats(&stream_stats);
+    assert(stream_stats.quads - stats.quads == 13 && stream_stats.invalid_quads - stats.invalid_quads == 2, "Failed: null renderer counted %llu instances and %llu invalid", stream_stats.quads - stats.quads, stream_stats.invalid_quads - stats.invalid_quads);
+    stream.instances.data[10].texture_slot = 5;
+    stream.instances.data[0].scissor_index = 3;
+    renderer.render_instances(&stream, target);
+    renderer.get_stats(&stats);
+    assert(stats.invalid_quads - stream_stats.invalid_quads == 4, "Failed: null renderer didn't catch instances that don't match their draw call");
+    draw_instance_stream_deinit(&stream);
+    renderer.destroy_texture(font, heap);
+    renderer.destroy_texture(target, heap);
+    renderer.destroy_texture(reused, heap);
+    renderer.get_stats(&stats);
+    assert(stats.texture_count == 0 && stats.texture_bytes == 0, "Failed: null renderer has %llu textures of %llu bytes left", stats.texture_count, stats.texture_bytes);
+    
+    void *shader = 0;
+    assert(renderer.compile_shader(STR("void main() {}"), 16, &shader) == GAL_RESULT_SUCCESS && shader, "Failed: null renderer didn't compile a shader");
+    renderer.destroy_shader(shader);
+    
+    renderer.shutdown();
+    draw_frame_deinit(frame);
+    Dealloc(heap, frame);
+    null_data = old_data;
+    window.width = old_width;
+    window.height = old_height;
+}
+
+void test_gal_upload_queue_job(void *data, u64 job_index) {
+    Gal_Image *image = (Gal_Image*)data;
+    u8 row[8];
+    for (u32 y = (u32)job_index; y < image->height; y += 4) {
+        memset(row, (int)(y + 1), sizeof(row));
+        gal_queue_image_update(image, 0, y, 8, 1, row);
+    }
+}
+
+// Reading flushes, so this has several threads flushing at once
+void test_gal_upload_queue_flush_job(void *data, u64 job_index) {
+    Gal_Image *image = (Gal_Image*)data;
+    u8 row[8], read[8];
+    for (u32 y = (u32)job_index; y < image->height; y += 4) {
+        memset(row, (int)(y + 1), sizeof(row));
+        GAL_Upload_Fence fence = gal_queue_image_update(image, 0, y, 8, 1, row);
+        gal_read_image_data(image, 0, y, 8, 1, read);
+        assert(gal_is_upload_done(fence), "Failed: upload not done after a flush on another thread");
+        assert(read[0] == y + 1 && read[7] == y + 1, "Failed: row %u read back as %d", y, read[0]);
+    }
+}
+
+// Goes through whatever renderer is active, or the null renderer if a test shut it down
+void test_gal_upload_queue() {
+    Allocator heap = GetHeapAllocator();
+    bool own_renderer = !gal_get_renderer()->create_texture;
+    if (own_renderer) {
+        assert(gal_initialize(GAL_BACKEND_NULL) == GAL_RESULT_SUCCESS, "Failed to initialize the null renderer");
+    }
+    GAL_Upload_Stats before, after;
+    u8 read[8*16];
+    
+    Gal_Image a = {0}, b = {0};
+    assert(gal_create_image(&a, 8, 16, 1, 0, false, heap) == GAL_RESULT_SUCCESS, "Failed: could not create an image");
+    assert(gal_create_image(&b, 8, 16, 1, 0, false, heap) == GAL_RESULT_SUCCESS, "Failed: could not create an image");
+    gal_flush_uploads();
+    
+    // Rows from the top down like font_atlas_init go in as one upload
+    gal_get_upload_stats(&before);
+    GAL_Upload_Fence fence = 0;
+    for (u32 i = 0; i < 16; i++) {
+        u8 row[8];
+        for (u32 x = 0; x < 8; x++) row[x] = (u8)((15 - i)*8 + x);
+        GAL_Upload_Fence next = gal_queue_image_update(&a, 0, 15 - i, 8, 1, row);
+        assert(next > fence, "Failed: upload fences should count up");
+        fence = next;
+    }
+    assert(!gal_is_upload_done(fence), "Failed: upload done before the flush");
+    assert(gal_is_upload_done(0), "Failed: the 0 fence should always be done");
+    gal_flush_uploads();
+    assert(gal_is_upload_done(fence), "Failed: upload not done after the flush");
+    gal_get_upload_stats(&after);
+    assert(after.queued - before.queued == 16 && after.uploads - before.uploads == 1, "Failed: 16 rows went in as %llu uploads", after.uploads - before.uploads);
+    assert(after.upload_bytes - before.upload_bytes == 8*16, "Failed: merged rows uploaded %llu bytes", after.upload_bytes - before.upload_bytes);
+    gal_read_image_data(&a, 0, 0, 8, 16, read);
+    for (u32 i = 0; i < 8*16; i++) {
+        assert(read[i] == i, "Failed: byte %u of the merged rows is %d", i, read[i]);
+    }
+    
+    // Side by side, then something inside it. The last one queued wins.
+    gal_get_upload_stats(&before);
+    u8 ones[8*16], twos[2*2], threes[4*16];
+    memset(ones, 1, sizeof(ones));
+    memset(twos, 2, sizeof(twos));
+    memset(threes, 3, sizeof(threes));
+    gal_queue_image_update(&a, 0, 0, 4, 16, ones);
+    gal_queue_image_update(&a, 4, 0, 4, 16, threes);
+    gal_queue_image_update(&a, 3, 5, 2, 2, twos);
+    // Reading flushes
+    gal_read_image_data(&a, 0, 0, 8, 16, read);
+    gal_get_upload_stats(&after);
+    assert(after.uploads - before.uploads == 1, "Failed: side by side regions went in as %llu uploads", after.uploads - before.uploads);
+    for (u32 y = 0; y < 16; y++) {
+        for (u32 x = 0; x < 8; x++) {
+            u8 expected = (x >= 3 && x < 5 && y >= 5 && y < 7) ? 2 : (x < 4 ? 1 : 3);
+            assert(read[y*8 + x] == expected, "Failed: pixel %u, %u is %d, expected %d", x, y, read[y*8 + x], expected);
+        }
+    }
+    
+    // Something covering what came before it
+    gal_get_upload_stats(&before);
+    gal_queue_image_update(&a, 3, 5, 2, 2, twos);
+    gal_queue_image_update(&a, 0, 0, 8, 16, ones);
+    gal_flush_uploads();
+    gal_get_upload_stats(&after);
+    gal_read_image_data(&a, 0, 0, 8, 16, read);
+    assert(after.uploads - before.uploads == 1, "Failed: covering region went in as %llu uploads", after.uploads - before.uploads);
+    for (u32 i = 0; i < 8*16; i++) assert(read[i] == 1, "Failed: covered region came out on top");
+    
+    // Rects that aren't a rect together, and other images in between, stay apart
+    gal_get_upload_stats(&before);
+    gal_queue_image_update(&a, 0, 0, 2, 2, twos);
+    gal_queue_image_update(&b, 0, 0, 2, 2, twos);
+    gal_queue_image_update(&a, 0, 2, 2, 2, twos);
+    gal_queue_image_update(&a, 4, 8, 2, 2, twos);
+    gal_queue_image_update(&a, 1, 1, 2, 2, ones);
+    gal_queue_image_update(&b, 2, 0, 2, 2, ones);
+    gal_flush_uploads();
+    gal_get_upload_stats(&after);
+    assert(after.uploads - before.uploads == 4, "Failed: expected 4 uploads, got %llu", after.uploads - before.uploads);
+    gal_read_image_data(&a, 0, 0, 8, 16, read);
+    assert(read[0] == 2 && read[1*8 + 1] == 1 && read[2*8 + 2] == 1 && read[3*8 + 0] == 2 && read[8*8 + 4] == 2 && read[8*8 + 6] == 1, "Failed: separate uploads went in wrong");
+    gal_read_image_data(&b, 0, 0, 4, 2, read);
+    assert(read[0] == 2 && read[1] == 2 && read[2] == 1 && read[4 + 3] == 1, "Failed: second merged upload went in wrong");
+    
+    // Rows queued from several threads at once
+    gal_get_upload_stats(&before);
+    job_pool_run(get_job_pool(), test_gal_upload_queue_job, &b, 4);
+    gal_flush_uploads();
+    gal_get_upload_stats(&after);
+    assert(after.queued - before.queued == 16 && after.uploads - before.uploads <= 16, "Failed: threads queued %llu regions", after.queued - before.queued);
+    gal_read_image_data(&b, 0, 0, 8, 16, read);
+    for (u32 i = 0; i < 8*16; i++) {
+        assert(read[i] == i/8 + 1, "Failed: byte %u queued from a thread is %d", i, read[i]);
+    }
+    
+    // Flushed from several threads at once
+    job_pool_run(get_job_pool(), test_gal_upload_queue_flush_job, &b, 4);
+    
+    // Destroying an image drops what was queued for it, the fence still finishes
+    gal_get_upload_stats(&before);
+    fence = gal_queue_image_update(&b, 0, 0, 8, 16, ones);
+    gal_destroy_image(&b);
+    gal_flush_uploads();
+    gal_get_upload_stats(&after);
+    assert(gal_is_upload_done(fence) && after.uploads == before.uploads, "Failed: upload for a destroyed image");
+    
+    // Outside of the image
+    assert(gal_queue_image_update(&a, 4, 0, 8, 1, ones) == 0, "Failed: queued a region outside of the image");
+    
+    gal_destroy_image(&a);
+    if (own_renderer) gal_shutdown();
+}
+
+// GLSL for the OpenGL renderer, the null renderer takes anything
+#define TEST_SHADER_EXTENSION_SOURCE \
+    "layout(std140) uniform Shader_Extension_Data { vec4 tint; };\n" \
+    "vec4 pixel_shader_extension(vec4 color) { return color*tint; }\n"
+
+// Goes through whatever renderer is active if it can hand out shader binaries, or the null
+// renderer if a test shut it down
+void test_gal_shader_cache() {
+    bool own_renderer = !gal_get_renderer()->create_texture;
+    if (own_renderer) {
+        assert(gal_initialize(GAL_BACKEND_NULL) == GAL_RESULT_SUCCESS, "Failed to initialize the null renderer");
+    }
+    GAL_Renderer *renderer = gal_get_renderer();
+    if (!renderer->get_shader_binary || !renderer->load_shader_binary) {
+        print("(renderer has no shader binaries, skipping) ");
+        if (own_renderer) gal_shutdown();
+        return;
+    }
+    
+    string directory = STR("_test_shader_cache");
+    os_delete_directory(directory, true);
+    gal_set_shader_cache_directory(directory);
+    string source = STR(TEST_SHADER_EXTENSION_SOURCE);
+    GAL_Shader_Cache_Stats before, after;
+    void *shader = 0;
+    
+    // First time it's compiled and saved
+    gal_get_shader_cache_stats(&before);
+    assert(gal_compile_shader(source, STR(""), 16, &shader) == GAL_RESULT_SUCCESS && shader, "Failed: could not compile the shader");
+    gal_get_shader_cache_stats(&after);
+    assert(after.misses == before.misses + 1 && after.compiles == before.compiles + 1 && after.hits == before.hits, "Failed: the first compile should be a miss");
+    gal_destroy_shader(shader);
+    
+    // The driver might not have a binary to hand out (like GL without binary formats), then
+    // there is nothing to cache
+    if (after.bytes_saved == before.bytes_saved) {
+        print("(no shader binary saved, skipping) ");
+        os_delete_directory(directory, true);
+        gal_set_shader_cache_directory(STR(GAL_SHADER_CACHE_DEFAULT_DIRECTORY));
+        if (own_renderer) gal_shutdown();
+        return;
+    }
+    
+    // Then it's loaded
+    gal_get_shader_cache_stats(&before);
+    assert(gal_compile_shader(source, STR(""), 16, &shader) == GAL_RESULT_SUCCESS && shader, "Failed: could not load the shader");
+    gal_get_shader_cache_stats(&after);
+    assert(after.hits == before.hits + 1 && after.compiles == before.compiles && after.misses == before.misses, "Failed: the second compile should be a hit");
+    assert(after.bytes_loaded > before.bytes_loaded, "Failed: a hit should count the bytes loaded");
+    gal_destroy_shader(shader);
+    
+    // Other defines are another shader
+    gal_get_shader_cache_stats(&before);
+    assert(gal_compile_shader(source, STR("#define UNUSED 1"), 16, &shader) == GAL_RESULT_SUCCESS && shader, "Failed: could not compile the shader with defines");
+    gal_get_shader_cache_stats(&after);
+    assert(after.misses == before.misses + 1 && after.stale == before.stale, "Failed: other defines should be a miss");
+    gal_destroy_shader(shader);
+    
+    // A file from another cache version is compiled again and replaced
+    u64 key = gal_hash_bytes(GAL_HASH_SEED, &renderer->backend, sizeof(u32));
+    u64 no_defines = 0;
+    key = gal_hash_bytes(key, &no_defines, sizeof(no_defines));
+    key = gal_hash_bytes(key, source.data, source.count);
+    char path_buffer[256];
+    snprintf(path_buffer, sizeof(path_buffer), "%.*s/%016llx.shader", (int)directory.count, directory.data, (unsigned long long)key);
+    string path = STR(path_buffer);
+    string file;
+    assert(os_read_entire_file(path, &file, GetHeapAllocator()), "Failed: the cache file isn't where it should be");
+    GAL_Shader_Cache_Header *header = (GAL_Shader_Cache_Header*)file.data;
+    header->version += 1;
+    assert(os_write_entire_file(path, file), "Failed: could not write the cache file");
+    gal_get_shader_cache_stats(&before);
+    assert(gal_compile_shader(source, STR(""), 16, &shader) == GAL_RESULT_SUCCESS && shader, "Failed: could not compile the shader over a stale file");
+    gal_get_shader_cache_stats(&after);
+    assert(after.stale == before.stale + 1 && after.misses == before.misses + 1 && after.compiles == before.compiles + 1, "Failed: a file from another version should be stale");
+    gal_destroy_shader(shader);
+    gal_get_shader_cache_stats(&before);
+    assert(gal_compile_shader(source, STR(""), 16, &shader) == GAL_RESULT_SUCCESS && shader, "Failed: could not load the replaced shader");
+    gal_get_shader_cache_stats(&after);
+    assert(after.hits == before.hits + 1, "Failed: the stale file should have been replaced");
+    gal_destroy_shader(shader);
+    Dealloc(GetHeapAllocator(), file.data);
+    
+    // So is a damaged blob
+    assert(os_read_entire_file(path, &file, GetHeapAllocator()), "Failed: the cache file isn't where it should be");
+    file.data[file.count - 1] ^= 0xFF;
+    assert(os_write_entire_file(path, file), "Failed: could not write the cache file");
+    gal_get_shader_cache_stats(&before);
+    assert(gal_compile_shader(source, STR(""), 16, &shader) == GAL_RESULT_SUCCESS && shader, "Failed: could not compile the shader over a damaged file");
+    gal_get_shader_cache_stats(&after);
+    assert(after.stale == before.stale + 1 && after.compiles == before.compiles + 1, "Failed: a damaged file should be stale");
+    gal_destroy_shader(shader);
+    Dealloc(GetHeapAllocator(), file.data);
+    
+    // Extensions go through the cache too
+    Gal_Shader_Extension extension;
+    gal_get_shader_cache_stats(&before);
+    assert(gal_compile_shader_extension(source, STR(""), 16, &extension) == GAL_RESULT_SUCCESS && extension.ps && extension.cbuffer_size == 16, "Failed: could not compile the shader extension");
+    gal_get_shader_cache_stats(&after);
+    assert(after.hits == before.hits + 1, "Failed: the shader extension should be a hit");
+    gal_destroy_shader_extension(&extension);
+    assert(!extension.ps, "Failed: the shader extension should be cleared");
+    
+    // Without a directory it always compiles and nothing is written
+    os_delete_directory(directory, true);
+    gal_set_shader_cache_directory(STR(""));
+    gal_get_shader_cache_stats(&before);
+    assert(gal_compile_shader(source, STR(""), 16, &shader) == GAL_RESULT_SUCCESS && shader, "Failed: could not compile without a cache");
+    gal_get_shader_cache_stats(&after);
+    assert(after.compiles == before.compiles + 1 && after.bytes_saved == before.bytes_saved, "Failed: the disk cache should be off");
+    assert(!os_read_entire_file(path, &file, GetHeapAllocator()), "Failed: a cache file was written with the disk cache off");
+    gal_destroy_shader(shader);
+    
+    gal_set_shader_cache_directory(STR(GAL_SHADER_CACHE_DEFAULT_DIRECTORY));
+    if (own_renderer) {
+        gal_shutdown();
+        // Without a renderer it fails instead of crashing
+        void *no_shader = (void*)1;
+        assert(gal_compile_shader(source, STR(""), 16, &no_shader) != GAL_RESULT_SUCCESS && !no_shader, "Failed: compiled a shader without a renderer");
+        gal_destroy_shader((void*)1);
+    }
+}
+
+// Stands in for the renderer's drawing in test_gal_frame_pipeline, so it runs the same on
+// every backend and sees which frame got presented
+static u64 test_pipeline_presented_quads[8];
+static f32 test_pipeline_presented_cbuffer[8];
+static u64 test_pipeline_present_count;
+static u64 test_pipeline_pending_quads;
+static f32 test_pipeline_pending_cbuffer;
+static void test_pipeline_render_instances(Draw_Instance_Stream *stream, GAL_Texture_Handle target) {
+    (void)target;
+    test_pipeline_pending_quads = stream->instances.count;
+    test_pipeline_pending_cbuffer = stream->cbuffer ? *(f32*)stream->cbuffer : -1;
+}
+static void test_pipeline_present(void) {
+    if (test_pipeline_present_count < 8) {
+        test_pipeline_presented_quads[test_pipeline_present_count] = test_pipeline_pending_quads;
+        test_pipeline_presented_cbuffer[test_pipeline_present_count] = test_pipeline_pending_cbuffer;
+    }
+    test_pipeline_present_count += 1;
+}
+
+void test_gal_frame_pipeline() {
+    bool own_renderer = !gal_get_renderer()->create_texture;
+    if (own_renderer) {
+        assert(gal_initialize(GAL_BACKEND_NULL) == GAL_RESULT_SUCCESS, "Failed to initialize the null renderer");
+    }
+    GAL_Renderer *renderer = gal_get_renderer();
+    GAL_Renderer old_renderer = *renderer;
+    renderer->update = 0;
+    renderer->begin_frame = 0;
+    renderer->end_frame = 0;
+    renderer->render_instances = test_pipeline_render_instances;
+    renderer->present = test_pipeline_present;
+    test_pipeline_present_count = 0;
+    
+    int32_t old_width = window.width, old_height = window.height;
+    window.width = 1280;
+    window.height = 720;
+    Draw_Frame old_frame = drawFrame;
+    draw_frame_init(&drawFrame);
+    DrawFrameReset(&drawFrame);
+    uint32_t old_latency = gal_get_frame_latency();
+    GAL_Frame_Stats before, after;
+    
+    // Without latency the frame goes out in gal_update
+    gal_set_frame_latency(0);
+    for (u64 i = 0; i < 2; i++) DrawRectInFrame(v2(i*10, 0), v2(5, 5), COLOR_WHITE, &drawFrame);
+    gal_update();
+    assert(test_pipeline_present_count == 1 && test_pipeline_presented_quads[0] == 2, "Failed: latency 0 should present in gal_update");
+    
+    // With 1 it goes out in the next gal_update, and drawFrame is ready for the next frame
+    gal_set_frame_latency(1);
+    assert(gal_get_frame_latency() == 1, "Failed: latency wasn't set");
+    gal_get_frame_stats(&before);
+    f32 constants[4] = { 1, 0, 0, 0 };
+    drawFrame.cbuffer = constants;
+    drawFrame.shader_extension.cbuffer_size = sizeof(constants);
+    for (u64 i = 0; i < 3; i++) DrawRectInFrame(v2(i*10, 0), v2(5, 5), COLOR_WHITE, &drawFrame);
+    gal_update();
+    assert(test_pipeline_present_count == 1, "Failed: latency 1 presented the frame right away");
+    assert(drawFrame.quad_buffer.count == 0 && !drawFrame.cbuffer, "Failed: drawFrame should be reset after gal_update");
+    
+    // The frame keeps the cbuffer it had when it was handed over
+    constants[0] = 2;
+    drawFrame.cbuffer = constants;
+    drawFrame.shader_extension.cbuffer_size = sizeof(constants);
+    for (u64 i = 0; i < 5; i++) DrawRectInFrame(v2(i*10, 0), v2(5, 5), COLOR_WHITE, &drawFrame);
+    gal_update();
+    assert(test_pipeline_present_count == 2 && test_pipeline_presented_quads[1] == 3, "Failed: the frame before should be presented");
+    assert(test_pipeline_presented_cbuffer[1] == 1, "Failed: the cbuffer changed while the frame was in flight");
+    
+    gal_finish_frames();
+    assert(test_pipeline_present_count == 3 && test_pipeline_presented_quads[2] == 5 && test_pipeline_presented_cbuffer[2] == 2, "Failed: gal_finish_frames should present the frame in flight");
+    gal_finish_frames();
+    assert(test_pipeline_present_count == 3, "Failed: gal_finish_frames presented with nothing in flight");
+    gal_get_frame_stats(&after);
+    assert(after.frames == before.frames + 2 && after.pipelined_frames == before.pipelined_frames + 2, "Failed: frame stats");
+    
+    // Going back to 0 sends out what's in flight
+    for (u64 i = 0; i < 4; i++) DrawRectInFrame(v2(i*10, 0), v2(5, 5), COLOR_WHITE, &drawFrame);
+    gal_update();
+    gal_set_frame_latency(0);
+    assert(test_pipeline_present_count == 4 && test_pipeline_presented_quads[3] == 4, "Failed: turning latency off should present the frame in flight");
+    
+    // Z sorting happens on the worker too
+    gal_set_frame_latency(1);
+    drawFrame.enable_z_sorting = true;
+    for (u64 i = 0; i < 6; i++) {
+        push_z_layer_in_frame((s32)(6 - i), &drawFrame);
+        DrawRectInFrame(v2(i*10, 0), v2(5, 5), COLOR_WHITE, &drawFrame);
+        pop_z_layer_in_frame(&drawFrame);
+    }
+    gal_update();
+    gal_finish_frames();
+    assert(test_pipeline_present_count == 5 && test_pipeline_presented_quads[4] == 6, "Failed: z sorted frame through the pipeline");
+    
+    // The pacer keeps gal_update to one per refresh
+    gal_set_frame_pacing(true, 500);
+    gal_get_frame_stats(&before);
+    double start = OsGetElapsedSeconds();
+    for (u64 i = 0; i < 11; i++) gal_update();
+    double elapsed = OsGetElapsedSeconds() - start;
+    gal_get_frame_stats(&after);
+    gal_set_frame_pacing(false, 0);
+    assert(after.target_frame_seconds == 1.0/500.0, "Failed: target frame time is %f", after.target_frame_seconds);
+    // The first update sets the first deadline, the 10 after wait for theirs
+    assert(elapsed >= 10*0.002*0.95, "Failed: 11 paced frames at 500 Hz took %f seconds", elapsed);
+    assert(after.paced_frames + after.missed_deadlines - before.paced_frames - before.missed_deadlines == 10, "Failed: paced %llu, missed %llu", after.paced_frames - before.paced_frames, after.missed_deadlines - before.missed_deadlines);
+    
+    gal_set_frame_latency(old_latency);
+    gal_finish_frames();
+    draw_frame_deinit(&drawFrame);
+    drawFrame = old_frame;
+    window.width = old_width;
+    window.height = old_height;
+    *renderer = old_renderer;
+    if (own_renderer) gal_shutdown();
+}
+
+static bool test_timing_never_in(uint32_t query, uint64_t *nanoseconds) {
+    (void)query; (void)nanoseconds;
+    return false;
+}
+
+void test_gal_timing() {
+    bool own_renderer = !gal_get_renderer()->create_texture;
+    if (own_renderer) {
+        assert(gal_initialize(GAL_BACKEND_NULL) == GAL_RESULT_SUCCESS, "Failed to initialize the null renderer");
+    }
+    GAL_Renderer *renderer = gal_get_renderer();
+    if (!renderer->write_timestamp || !renderer->read_timestamp) {
+        print("(renderer has no timestamps, skipping) ");
+        if (own_renderer) gal_shutdown();
+        return;
+    }
+    
+    int32_t old_width = window.width, old_height = window.height;
+    window.width = 1280;
+    window.height = 720;
+    Draw_Frame frame;
+    draw_frame_init(&frame);
+    DrawFrameReset(&frame);
+    GAL_Timing_Stats before, after;
+    GAL_Timing_Result results[GAL_TIMING_MAX_REGIONS];
+    
+    // Off by default, nothing is timed
+    gal_get_timing_stats(&before);
+    gal_begin_timing(STR("Off"));
+    gal_end_timing();
+    gal_render_draw_frame_to_window(&frame);
+    gal_get_timing_stats(&after);
+    assert(after.frames == before.frames && after.dropped_regions == before.dropped_regions, "Failed: timing should be off");
+    
+    // Nested regions, read back once the queries are in, which takes a few frames on a GPU
+    gal_set_timing(true);
+    gal_get_timing_stats(&before);
+    f64 cpu_start = OsGetElapsedSeconds();
+    gal_begin_timing(STR("Outer"));
+    gal_begin_timing(STR("Inner region with a name that is longer than GAL_TIMING_MAX_NAME"));
+    DrawRectInFrame(v2(0, 0), v2(100, 100), COLOR_WHITE, &frame);
+    OsHighPrecisionSleep(2);
+    gal_end_timing();
+    gal_end_timing();
+    gal_render_draw_frame_to_window(&frame);
+    gal_get_timing_stats(&after);
+    for (u64 i = 0; i < 100 && after.frames == before.frames; i++) {
+        gal_render_draw_frame_to_window(&frame);
+        gal_get_timing_stats(&after);
+    }
+    assert(after.frames > before.frames, "Failed: timings never came back");
+    assert(after.dropped_frames == before.dropped_frames && after.dropped_regions == before.dropped_regions, "Failed: nothing should be dropped");
+    
+    u64 count = gal_get_timings(results, GAL_TIMING_MAX_REGIONS);
+    bool first_frame = after.frames == before.frames + 1;
+    if (first_frame) {
+        assert(count == 3, "Failed: expected 3 regions, got %llu", count);
+        assert(strcmp(results[0].name, "Outer") == 0 && results[0].depth == 0, "Failed: outer region is '%s' at %u", results[0].name, results[0].depth);
+        assert(strlen(results[1].name) == GAL_TIMING_MAX_NAME - 1 && results[1].depth == 1, "Failed: inner region name should be cut");
+        assert(strcmp(results[2].name, "Frame") == 0 && results[2].depth == 0, "Failed: gal should time the frame");
+        assert(results[1].start_seconds >= results[0].start_seconds && results[1].seconds <= results[0].seconds, "Failed: inner region should be inside the outer one");
+        assert(results[2].start_seconds >= results[0].start_seconds + results[0].seconds, "Failed: frame region should be after the outer one");
+        if (renderer->backend != GAL_BACKEND_OPENGL) {
+            // CPU timers see the sleep, a GPU doesn't
+            assert(results[1].seconds >= 0.0015, "Failed: inner region took %f seconds", results[1].seconds);
+            assert(results[0].start_seconds >= cpu_start - 0.001 && results[0].start_seconds < OsGetElapsedSeconds(), "Failed: start time isn't on the OsGetElapsedSeconds clock");
+        }
+    } else {
+        // Frames that came in at the same time, the newest one only has the frame region
+        assert(count >= 1 && strcmp(results[count - 1].name, "Frame") == 0, "Failed: newest frame should have the frame region");
+    }
+    
+    // Ending what wasn't begun is dropped, and so is a region past the limit
+    gal_get_timing_stats(&before);
+    gal_end_timing();
+    for (u64 i = 0; i < GAL_TIMING_MAX_REGIONS; i++) {
+        gal_begin_timing(STR("Region"));
+        gal_end_timing();
+    }
+    gal_render_draw_frame_to_window(&frame);
+    gal_get_timing_stats(&after);
+    // One for the stray end, and the frame region doesn't fit anymore
+    assert(after.dropped_regions == before.dropped_regions + 2, "Failed: dropped %llu regions", after.dropped_regions - before.dropped_regions);
+    
+    // Queries that never come in are dropped instead of waited on
+    bool (*old_read_timestamp)(uint32_t, uint64_t*) = renderer->read_timestamp;
+    renderer->read_timestamp = test_timing_never_in;
+    gal_get_timing_stats(&before);
+    for (u64 i = 0; i < GAL_TIMING_FRAMES + 2; i++) gal_render_draw_frame_to_window(&frame);
+    gal_get_timing_stats(&after);
+    renderer->read_timestamp = old_read_timestamp;
+    assert(after.frames == before.frames && after.dropped_frames >= before.dropped_frames + 2, "Failed: %llu frames dropped", after.dropped_frames - before.dropped_frames);
+    
+    gal_set_timing(false);
+    draw_frame_deinit(&frame);
+    window.width = old_width;
+    window.height = old_height;
+    if (own_renderer) gal_shutdown();
+}
+#endif /* OOGABOOGA_HEADLESS */
+
+typedef struct Test_Sort_Item {
+    s32 key;
+    u32 original_index;
+} Test_Sort_Item;
+DEFINE_SORT(Test_Sort_Item, a->key < b->key)
+int compare_test_sort_items(const void *a, const void *b) {
+    s32 ka = ((Test_Sort_Item*)a)->key;
+    s32 kb = ((Test_Sort_Item*)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+void fill_test_sort_items(Test_Sort_Item *items, u64 count, int pattern) {
+    for (u64 i = 0; i < count; i++) {
+        switch (pattern) {
+            case 0: items[i].key = (s32)get_random_int_in_range(-1000000, 1000000); break;
+            case 1: items[i].key = (s32)i; break;
+            case 2: items[i].key = (s32)(count - i); break;
+            case 3: items[i].key = 7; break;
+            case 4: items[i].key = (s32)get_random_int_in_range(0, 10); break;
+            case 5: items[i].key = (s32)(i % 2 == 0 ? i : count - i); break; // Organ pipe-ish
+        }
+        items[i].original_index = (u32)i;
+    }
+}
+void test_sort_algorithms() {
+    const u64 count = 100000;
+    Test_Sort_Item *items  = Alloc(GetHeapAllocator(), count * sizeof(Test_Sort_Item));
+    Test_Sort_Item *buffer = Alloc(GetHeapAllocator(), count * sizeof(Test_Sort_Item));
+    Test_Sort_Item *copy   = Alloc(GetHeapAllocator(), count * sizeof(Test_Sort_Item));
+    
+    u64 sizes[] = { 0, 1, 2, 23, 24, 25, 129, 1000, count };
+    
+    for (int pattern = 0; pattern < 6; pattern++) {
+        for (u64 s = 0; s < sizeof(sizes)/sizeof(sizes[0]); s++) {
+            u64 n = sizes[s];
+            
+            fill_test_sort_items(items, n, pattern);
+            pdq_sort(items, n, sizeof(Test_Sort_Item), compare_test_sort_items);
+            for (u64 i = 1; i < n; i++) assert(items[i-1].key <= items[i].key, "pdq_sort failed (pattern %d, count %llu)", pattern, n);
+            
+            fill_test_sort_items(items, n, pattern);
+            sort_Test_Sort_Item(items, n);
+            for (u64 i = 1; i < n; i++) assert(items[i-1].key <= items[i].key, "DEFINE_SORT sort failed (pattern %d, count %llu)", pattern, n);
+            
+            fill_test_sort_items(items, n, pattern);
+            parallel_merge_sort(items, buffer, n, sizeof(Test_Sort_Item), compare_test_sort_items);
+            for (u64 i = 1; i < n; i++) {
+                assert(items[i-1].key <= items[i].key, "parallel_merge_sort failed (pattern %d, count %llu)", pattern, n);
+                if (items[i-1].key == items[i].key) {
+                    assert(items[i-1].original_index < items[i].original_index, "parallel_merge_sort not stable (pattern %d, count %llu)", pattern, n);
+                }
+            }
+            
+            if (n == 0) continue;
+            
+            // Reference for partial_sort and nth_element
+            fill_test_sort_items(buffer, n, pattern);
+            memcpy(copy, buffer, n * sizeof(Test_Sort_Item));
+            memcpy(items, buffer, n * sizeof(Test_Sort_Item));
+            sort_Test_Sort_Item(copy, n);
+            
+            u64 top_n = min(n, 10);
+            partial_sort(items, n, sizeof(Test_Sort_Item), top_n, compare_test_sort_items);
+            for (u64 i = 0; i < top_n; i++) assert(items[i].key == copy[i].key, "partial_sort failed (pattern %d, count %llu)", pattern, n);
+            
+            u64 nth = n / 3;
+            memcpy(items, buffer, n * sizeof(Test_Sort_Item));
+            nth_element_Test_Sort_Item(items, n, nth);
+            assert(items[nth].key == copy[nth].key, "nth_element failed (pattern %d, count %llu)", pattern, n);
+            for (u64 i = 0; i < nth; i++)     assert(items[i].key <= items[nth].key, "nth_element failed (pattern %d, count %llu)", pattern, n);
+            for (u64 i = nth + 1; i < n; i++) assert(items[i].key >= items[nth].key, "nth_element failed (pattern %d, count %llu)", pattern, n);
+        }
+    }
+    
+    // Benchmark against merge_sort
+    const u64 bench_count = 1000000;
+    Test_Sort_Item *bench  = Alloc(GetHeapAllocator(), bench_count * sizeof(Test_Sort_Item));
+    Test_Sort_Item *bench_buffer = Alloc(GetHeapAllocator(), bench_count * sizeof(Test_Sort_Item));
+    
+    for (int algo = 0; algo < 4; algo++) {
+        fill_test_sort_items(bench, bench_count, 0);
+        f64 start = OsGetElapsedSeconds();
+        switch (algo) {
+            case 0: merge_sort(bench, bench_buffer, bench_count, sizeof(Test_Sort_Item), compare_test_sort_items); break;
+            case 1: parallel_merge_sort(bench, bench_buffer, bench_count, sizeof(Test_Sort_Item), compare_test_sort_items); break;
+            case 2: pdq_sort(bench, bench_count, sizeof(Test_Sort_Item), compare_test_sort_items); break;
+            case 3: sort_Test_Sort_Item(bench, bench_count); break;
+        }
+        f64 ms = (OsGetElapsedSeconds() - start) * 1000.0;
+        for (u64 i = 1; i < bench_count; i++) assert(bench[i-1].key <= bench[i].key, "Failed: not correctly sorted");
+        
+        const char *names[] = { "merge_sort", "parallel_merge_sort", "pdq_sort", "sort_Type (DEFINE_SORT)" };
+        print("%s on %llu items took %.2f ms\n", names[algo], bench_count, ms);
+    }
+    
+    Dealloc(GetHeapAllocator(), items);
+    Dealloc(GetHeapAllocator(), buffer);
+    Dealloc(GetHeapAllocator(), copy);
+    Dealloc(GetHeapAllocator(), bench);
+    Dealloc(GetHeapAllocator(), bench_buffer);
+}
+
+typedef struct Test_Thing {
+    int foo;
+    float bar;
+} Test_Thing;
+void test_growing_array() {
+    Test_Thing *things = 0;
+    
+    growing_array_init((void**)&things, sizeof(Test_Thing), GetHeapAllocator());
+    
+    Test_Thing new_thing;
+    new_thing.foo = 5;
+    new_thing.bar = 420.69;
+    growing_array_add((void**)&things, &new_thing);
+    
+    assert(growing_array_get_valid_count(things) == 1, "Failed: growing_array_get_valid_count");
+    
+    new_thing.foo = 1;
+    new_thing.bar = 123.45;
+    growing_array_add((void**)&things, &new_thing);
+    
+    assert(growing_array_get_valid_count(things) == 2, "Failed: growing_array_get_valid_count");
+    
+    assert(things[0].foo == 5 && floats_roughly_match(things[0].bar, 420.69), "Failed: growing_array_add");
+    assert(things[1].foo == 1 && floats_roughly_match(things[1].bar, 123.45), "Failed: growing_array_add");
+    
+    growing_array_ordered_remove_by_index((void**)&things, 0);
+    assert(things[0].foo == 1 && floats_roughly_match(things[0].bar, 123.45), "Failed: growing_array_ordered_remove_by_index");
+    assert(growing_array_get_valid_count(things) == 1, "Failed: growing_array_get_valid_count");
+    
+    new_thing.foo = 5;
+    new_thing.bar = 420.69;
+    growing_array_add((void**)&things, &new_thing);
+    assert(things[1].foo == 5 && floats_roughly_match(things[1].bar, 420.69), "Failed: growing_array_add");
+    
+    assert(growing_array_get_valid_count(things) == 2, "Failed: growing_array_get_valid_count");
+    
+    growing_array_unordered_remove_by_index((void**)&things, 0);
+    assert(things[0].foo == 5 && floats_roughly_match(things[0].bar, 420.69), "Failed: growing_array_unordered_remove_by_index");
+    assert(growing_array_get_valid_count(things) == 1, "Failed: growing_array_get_valid_count");
+    
+    
+    for (u32 i = 0; i < 100; i += 1) {
+        new_thing.foo = i;
+        new_thing.bar = i * 4.0;
+        growing_array_add((void**)&things, &new_thing);
+    }
+    
+    assert(growing_array_get_valid_count(things) == 101, "Failed: growing_array_get_valid_count");
+    
+    // Unordered remove by pointer
+    Test_Thing *thing = &things[50];
+    Test_Thing copy = *thing;
+    bool found = growing_array_unordered_remove_by_pointer((void**)&things, thing);
+    assert(found, "Failed: growing_array_unordered_remove_by_pointer");
+    assert(!bytes_match(&copy, thing, sizeof(Test_Thing)), "Failed: growing_array_unordered_remove_by_pointer");
+    
+    // Ordered remove by pointer
+    thing = &things[50];
+    copy = *thing;
+    found = growing_array_ordered_remove_by_pointer((void**)&things, thing);
+    assert(found, "Failed: growing_array_unordered_remove_by_pointer");
+    assert(!bytes_match(&copy, thing, sizeof(Test_Thing)), "Failed: growing_array_unordered_remove_by_pointer");
+    
+    assert(growing_array_get_valid_count(things) == 99, "Failed: growing_array_get_valid_count");
+}
+
+void test_bucket_array_push_job(void *data, u64 job_index) {
+    Bucket_Array *b = (Bucket_Array*)data;
+    for (u64 i = 0; i < 10000; i++) {
+        *(u64*)bucket_array_push_atomic(b) = job_index*10000 + i;
+    }
+}
+void test_bucket_array() {
+    Bucket_Array b;
+    bucket_array_init(&b, sizeof(Test_Thing));
+    
+    Test_Thing *first = (Test_Thing*)bucket_array_push(&b);
+    *first = (Test_Thing){ 0, 0 };
+    for (u32 i = 1; i < 100000; i++) {
+        Test_Thing *t = (Test_Thing*)bucket_array_push(&b);
+        *t = (Test_Thing){ i, i * 0.5f };
+    }
+    assert(bucket_array_get_count(&b) == 100000, "Failed: bucket_array_push");
+    assert(first == bucket_array_get(&b, 0) && first->foo == 0, "Failed: bucket array pointers should be stable");
+    
+    u64 total = 0;
+    u64 seen = 0;
+    for (u64 c = 0; c < bucket_array_get_chunk_count(&b); c++) {
+        u64 n;
+        Test_Thing *chunk = (Test_Thing*)bucket_array_get_chunk(&b, c, &n);
+        for (u64 i = 0; i < n; i++) {
+            assert(chunk[i].foo == (int)seen, "Failed: bucket array chunk iteration order");
+            total += chunk[i].foo;
+            seen += 1;
+        }
+    }
+    assert(seen == 100000 && total == 100000ull*99999ull/2, "Failed: bucket array chunk iteration");
+    
+    bucket_array_clear(&b);
+    assert(bucket_array_get_count(&b) == 0 && bucket_array_get_chunk_count(&b) == 0, "Failed: bucket_array_clear");
+    assert(bucket_array_push(&b) == first, "Failed: bucket_array_clear should reuse chunks");
+    
+    // Appending across chunk boundaries
+    Test_Thing *things = Alloc(GetHeapAllocator(), 10000*sizeof(Test_Thing));
+    for (u32 i = 0; i < 10000; i++) things[i] = (Test_Thing){ i + 1, 0 };
+    bucket_array_append(&b, things, 10000);
+    bucket_array_append(&b, things, 10000);
+    assert(bucket_array_get_count(&b) == 20001, "Failed: bucket_array_append count");
+    for (u64 i = 1; i < 20001; i++) {
+        assert(((Test_Thing*)bucket_array_get(&b, i))->foo == (int)((i - 1) % 10000 + 1), "Failed: bucket_array_append");
+    }
+    Dealloc(GetHeapAllocator(), things);
+    bucket_array_deinit(&b);
+    
+    // Concurrent producers
+    Bucket_Array values;
+    bucket_array_init(&values, sizeof(u64));
+    job_pool_run(get_job_pool(), test_bucket_array_push_job, &values, 8);
+    assert(bucket_array_get_count(&values) == 80000, "Failed: bucket_array_push_atomic");
+    
+    bool *found = Alloc(GetHeapAllocator(), 80000);
+    memset(found, 0, 80000);
+    for (u64 i = 0; i < 80000; i++) {
+        u64 v = *(u64*)bucket_array_get(&values, i);
+        assert(v < 80000 && !found[v], "Failed: bucket_array_push_atomic lost or duplicated a value");
+        found[v] = true;
+    }
+    Dealloc(GetHeapAllocator(), found);
+    bucket_array_deinit(&values);
+}
+
+DECLARE_ARRAY(Test_Thing)
+DEFINE_ARRAY(Test_Thing)
+DECLARE_SMALL_ARRAY(Test_Thing_Small_Array, Test_Thing, 4)
+DEFINE_SMALL_ARRAY(Test_Thing_Small_Array, Test_Thing, 4)
+void test_array() {
+    Test_Thing_Array things = ZERO(Test_Thing_Array);
+    
+    for (u32 i = 0; i < 1000; i += 1) {
+        Test_Thing *t = Test_Thing_Array_push(&things, (Test_Thing){ i, i * 2.0f });
+        assert(t == &things.data[i], "Failed: Test_Thing_Array_push");
+    }
+    assert(things.count == 1000, "Failed: Test_Thing_Array_push");
+    assert(things.capacity >= things.count, "Failed: Test_Thing_Array capacity");
+    for (u32 i = 0; i < 1000; i += 1) {
+        assert(things.data[i].foo == (int)i && floats_roughly_match(things.data[i].bar, i * 2.0f), "Failed: Test_Thing_Array_push");
+    }
+    
+    Test_Thing_Array_ordered_remove(&things, 0);
+    assert(things.count == 999 && things.data[0].foo == 1 && things.data[998].foo == 999, "Failed: Test_Thing_Array_ordered_remove");
+    Test_Thing_Array_unordered_remove(&things, 0);
+    assert(things.count == 998 && things.data[0].foo == 999, "Failed: Test_Thing_Array_unordered_remove");
+    Test_Thing_Array_pop(&things);
+    assert(things.count == 997, "Failed: Test_Thing_Array_pop");
+    
+    u64 count_before = things.count;
+    Test_Thing *bulk = Test_Thing_Array_push_n_uninitialized(&things, 5000);
+    for (u32 i = 0; i < 5000; i += 1) bulk[i] = (Test_Thing){ -(int)i, 0 };
+    assert(things.count == count_before + 5000, "Failed: Test_Thing_Array_push_n_uninitialized");
+    assert(things.data[count_before + 4999].foo == -4999, "Failed: Test_Thing_Array_push_n_uninitialized");
+    
+    Test_Thing_Array_clear(&things);
+    assert(things.count == 0, "Failed: Test_Thing_Array_clear");
+    Test_Thing_Array_deinit(&things);
+    
+    Test_Thing_Small_Array small;
+    Test_Thing_Small_Array_init(&small, GetHeapAllocator());
+    for (u32 i = 0; i < 4; i += 1) Test_Thing_Small_Array_push(&small, (Test_Thing){ i, 0 });
+    assert(small.data == small.inline_items, "Failed: small array should not allocate within its inline capacity");
+    Test_Thing_Small_Array_push(&small, (Test_Thing){ 4, 0 });
+    assert(small.data != small.inline_items, "Failed: small array should allocate past its inline capacity");
+    for (u32 i = 0; i < 5; i += 1) assert(small.data[i].foo == (int)i, "Failed: small array grow");
+    Test_Thing_Small_Array_deinit(&small);
+}
+
+
+typedef struct {
+    Binary_Semaphore *sem;
+    volatile LONG *counter;
+    int increments;
+} Test_Args;
+
+void increment_thread_proc(Thread *t) {
+    Test_Args *test_args = (Test_Args *)t->data;
+    for (int i = 0; i < test_args->increments; i++) {
+        OsBinarySemaphoreWait(test_args->sem);
+        InterlockedIncrement(test_args->counter);
+        OsBinarySemaphoreSignal(test_args->sem);
+    }
+}
+void test_os_binary_semaphore() {
+    {
+        // Multithreaded increment test
+        const int num_threads = 100;
+        const int increments_per_thread = 10000;
+
+        Binary_Semaphore sem;
+        OsBinarySemaphoreInit(&sem, true);
+
+        LONG counter = 0;
+        Thread threads[num_threads];
+        Test_Args args = { &sem, &counter, increments_per_thread };
+
+        for (int i = 0; i < num_threads; i++) {
+            OsThreadInit(&threads[i], increment_thread_proc);
+            threads[i].data = &args;
+            OsThreadStart(&threads[i]);
+        }
+
+        for (int i = 0; i < num_threads; i++) {
+            OsThreadJoin(&threads[i]);
+            OsThreadDestroy(&threads[i]);
+        }
+
+        assert(counter == num_threads * increments_per_thread, "Failed: Multithreaded increment test");
+
+        OsBinarySemaphoreDestroy(&sem);
+    }
+
+    {
+        // Signal before wait test
+        Binary_Semaphore sem;
+        OsBinarySemaphoreInit(&sem, false);
+
+        LONG counter = 0;
+
+        Thread thread;
+        Test_Args args = { &sem, &counter, 1 };
+        OsThreadInit(&thread, increment_thread_proc);
+        thread.data = &args;
+        OsThreadStart(&thread);
+
+        // Signal the semaphore after a delay
+        Sleep(100);
+        OsBinarySemaphoreSignal(&sem);
+
+        OsThreadJoin(&thread);
+        OsThreadDestroy(&thread);
+
+        assert(counter == 1, "Failed: Signal before wait test");
+
+        OsBinarySemaphoreDestroy(&sem);
+    }
+
+    {
+        // High contention test
+        const int num_threads = 100;
+        const int increments_per_thread = 1000;
+
+        Binary_Semaphore sem;
+        OsBinarySemaphoreInit(&sem, true);
+
+        LONG counter = 0;
+        Thread threads[num_threads];
+        Test_Args args = { &sem, &counter, increments_per_thread };
+
+        for (int i = 0; i < num_threads; i++) {
+            OsThreadInit(&threads[i], increment_thread_proc);
+            threads[i].data = &args;
+            OsThreadStart(&threads[i]);
+        }
+
+        for (int i = 0; i < num_threads; i++) {
             OsThreadJoin(&threads[i]);
             OsThreadDestroy(&threads[i]);
         }
@@ -1753,6 +4430,196 @@ static void test_opengl_backend() {
     gal_shutdown();
     print("OK!\n");
 }
+
+// Draws a grid of one pixel quads to a render target with a tiny stream ring, so frames don't
+// fit and calls are bigger than a whole region. Runs on Mesa's llvmpipe too
+// (LIBGL_ALWAYS_SOFTWARE=1 under Xvfb).
+static void test_opengl_check_grid(Gal_Image *target, u8 *pixels) {
+    gal_read_image_data(target, 0, 0, 64, 32, pixels);
+    for (u32 y = 0; y < 32; y++) {
+        for (u32 x = 0; x < 64; x++) {
+            u8 *p = &pixels[(y*64 + x)*4];
+            assert(p[0] == x*4 && p[1] == y*8 && p[2] == 128 && p[3] == 255, "Failed: pixel %u, %u of the grid is %d %d %d %d", x, y, p[0], p[1], p[2], p[3]);
+        }
+    }
+}
+static void test_opengl_draw_grid(Draw_Frame *frame, Gal_Image *target) {
+    f32 w = (f32)window.width, h = (f32)window.height;
+    DrawFrameReset(frame);
+    for (u32 y = 0; y < 32; y++) {
+        for (u32 x = 0; x < 64; x++) {
+            Vector4 color = v4((f32)(x*4)/255.0f, (f32)(y*8)/255.0f, 128.0f/255.0f, 1);
+            DrawRectInFrame(v2(-w/2 + x*w/64, -h/2 + y*h/32), v2(w/64, h/32), color, frame);
+        }
+    }
+    gal_clear_image(target, 0, 0, 0, 1);
+    gal_render_draw_frame(frame, target);
+}
+static void test_opengl_streaming() {
+    if (!getenv("DISPLAY")) {
+        print("Skipping OpenGL streaming test (no DISPLAY)\n");
+        return;
+    }
+    
+    GAL_Renderer *renderer = gal_get_renderer();
+    bool own_renderer = !renderer || renderer->backend != GAL_BACKEND_OPENGL || !opengl_data.gl_context;
+    if (own_renderer) {
+        assert(gal_initialize(GAL_BACKEND_OPENGL) == GAL_RESULT_SUCCESS, "Failed to initialize OpenGL backend");
+        renderer = gal_get_renderer();
+        GAL_Window_Desc desc = { .title = "Test Window", .width = 64, .height = 64 };
+        assert(renderer->create_window(&desc) == GAL_RESULT_SUCCESS, "Failed to create OpenGL window");
+    }
+    
+    Allocator heap = GetHeapAllocator();
+    int32_t old_width = window.width, old_height = window.height;
+    window.width = 1280;
+    window.height = 720;
+    f32 w = (f32)window.width, h = (f32)window.height;
+    Draw_Frame *frame = Alloc(heap, sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    u8 *pixels = Alloc(heap, 64*32*4);
+    
+    // Red in the bottom left quarter, like for the software renderer
+    Gal_Image target = {0};
+    assert(gal_create_image(&target, 64, 32, 4, 0, true, heap) == GAL_RESULT_SUCCESS, "Failed: could not create a render target");
+    gal_clear_image(&target, 0, 0, 1, 1);
+    DrawFrameReset(frame);
+    DrawRectInFrame(v2(-w/2, -h/2), v2(w/2, h/2), v4(1, 0, 0, 1), frame);
+    gal_render_draw_frame(frame, &target);
+    gal_read_image_data(&target, 0, 0, 64, 32, pixels);
+    for (u32 y = 0; y < 32; y++) {
+        for (u32 x = 0; x < 64; x++) {
+            u8 *p = &pixels[(y*64 + x)*4];
+            bool red = x < 32 && y < 16;
+            assert(p[0] == (red ? 255 : 0) && p[1] == 0 && p[2] == (red ? 0 : 255) && p[3] == 255, "Failed: pixel %u, %u of the render target is %d %d %d %d", x, y, p[0], p[1], p[2], p[3]);
+        }
+    }
+    
+    // A 2x2 texture stretched over the target with nearest filtering
+    u8 texels[2*2*4] = { 255, 0, 0, 255,   0, 255, 0, 255,   0, 0, 255, 255,   255, 255, 255, 255 };
+    Gal_Image image = {0};
+    gal_create_image(&image, 2, 2, 4, texels, false, heap);
+    DrawFrameReset(frame);
+    Draw_Quad *q = DrawImageInFrame(&image, v2(-w/2, -h/2), v2(w, h), v4(1, 1, 1, 1), frame);
+    q->image_min_filter = GFX_FILTER_MODE_NEAREST;
+    q->image_mag_filter = GFX_FILTER_MODE_NEAREST;
+    gal_render_draw_frame(frame, &target);
+    gal_read_image_data(&target, 0, 0, 64, 32, pixels);
+    u8 *corners[4] = { &pixels[(2*64 + 2)*4], &pixels[(2*64 + 60)*4], &pixels[(29*64 + 2)*4], &pixels[(29*64 + 60)*4] };
+    for (int i = 0; i < 4; i++) {
+        assert(memcmp(corners[i], &texels[i*4], 4) == 0, "Failed: texel %d drawn as %d %d %d %d", i, corners[i][0], corners[i][1], corners[i][2], corners[i][3]);
+    }
+    gal_destroy_image(&image);
+    
+    // Both ways of streaming, with a ring that's far too small at first
+    bool had_buffer_storage = opengl_data.use_buffer_storage;
+    for (int pass = had_buffer_storage ? 0 : 1; pass < 2; pass++) {
+        opengl_data.use_buffer_storage = pass == 0;
+        opengl_data.ring.reserved_size = 0;
+        opengl_ring_resize(4096);
+        assert((opengl_data.ring.mapped != 0) == (pass == 0), "Failed: ring is%s mapped", opengl_data.ring.mapped ? "" : " not");
+        
+        OpenGL_Stream_Stats before = opengl_data.stream_stats;
+        test_opengl_draw_grid(frame, &target);
+        test_opengl_check_grid(&target, pixels);
+        assert(opengl_data.stream_stats.region_overflows > before.region_overflows, "Failed: 2048 quads fit in 4096 bytes");
+        assert(opengl_data.ring.region_size == 4096, "Failed: the ring was resized in the middle of a frame");
+        
+        // Reserving in the middle of a frame waits for the end of it
+        opengl_reserve_vertex_buffer(8192);
+        assert(opengl_data.ring.region_size == 4096, "Failed: the ring was resized in the middle of a frame");
+        
+        // Grows to fit at the end of the frame, then the next frames go in one push each
+        renderer->present();
+        assert(opengl_data.ring.region_size >= 2048*sizeof(Draw_Quad_Instance), "Failed: the ring is still %llu bytes after a frame of %llu", opengl_data.ring.region_size, 2048*sizeof(Draw_Quad_Instance));
+        before = opengl_data.stream_stats;
+        for (int i = 0; i < OPENGL_FRAMES_IN_FLIGHT + 2; i++) {
+            test_opengl_draw_grid(frame, &target);
+            renderer->present();
+        }
+        test_opengl_check_grid(&target, pixels);
+        assert(opengl_data.stream_stats.region_overflows == before.region_overflows, "Failed: frames still overflow after the ring grew");
+        assert(opengl_data.stream_stats.ring_resizes == before.ring_resizes, "Failed: the ring was resized again");
+    }
+    opengl_data.use_buffer_storage = had_buffer_storage;
+    opengl_ring_resize(OPENGL_DEFAULT_REGION_SIZE);
+    
+    gal_destroy_image(&target);
+    Dealloc(heap, pixels);
+    draw_frame_deinit(frame);
+    Dealloc(heap, frame);
+    window.width = old_width;
+    window.height = old_height;
+    if (own_renderer) gal_shutdown();
+}
+// Draws through a shader extension, compiled the first time and loaded from the shader cache
+// the second time when the driver has program binaries
+static void test_opengl_shader_extension() {
+    if (!getenv("DISPLAY")) {
+        print("Skipping OpenGL shader extension test (no DISPLAY)\n");
+        return;
+    }
+    
+    GAL_Renderer *renderer = gal_get_renderer();
+    bool own_renderer = !renderer || renderer->backend != GAL_BACKEND_OPENGL || !opengl_data.gl_context;
+    if (own_renderer) {
+        assert(gal_initialize(GAL_BACKEND_OPENGL) == GAL_RESULT_SUCCESS, "Failed to initialize OpenGL backend");
+        renderer = gal_get_renderer();
+        GAL_Window_Desc desc = { .title = "Test Window", .width = 64, .height = 64 };
+        assert(renderer->create_window(&desc) == GAL_RESULT_SUCCESS, "Failed to create OpenGL window");
+    }
+    
+    Allocator heap = GetHeapAllocator();
+    int32_t old_width = window.width, old_height = window.height;
+    window.width = 1280;
+    window.height = 720;
+    f32 w = (f32)window.width, h = (f32)window.height;
+    Draw_Frame *frame = Alloc(heap, sizeof(Draw_Frame));
+    draw_frame_init(frame);
+    Gal_Image target = {0};
+    assert(gal_create_image(&target, 8, 8, 4, 0, true, heap) == GAL_RESULT_SUCCESS, "Failed: could not create a render target");
+    u8 pixels[8*8*4];
+    
+    string directory = STR("_test_shader_cache");
+    os_delete_directory(directory, true);
+    gal_set_shader_cache_directory(directory);
+    
+    Vector4 tints[2] = { v4(0, 1, 0, 1), v4(1, 0, 1, 1) };
+    for (int i = 0; i < 2; i++) {
+        GAL_Shader_Cache_Stats before, after;
+        gal_get_shader_cache_stats(&before);
+        Gal_Shader_Extension extension;
+        assert(gal_compile_shader_extension(STR(TEST_SHADER_EXTENSION_SOURCE), STR(""), sizeof(Vector4), &extension) == GAL_RESULT_SUCCESS, "Failed: could not compile the shader extension");
+        gal_get_shader_cache_stats(&after);
+        if (i == 1 && opengl_data.has_program_binary) {
+            assert(after.hits == before.hits + 1, "Failed: the shader extension should have been loaded from the cache");
+        }
+        
+        DrawFrameReset(frame);
+        frame->shader_extension = extension;
+        frame->cbuffer = &tints[i];
+        DrawRectInFrame(v2(-w/2, -h/2), v2(w, h), v4(1, 1, 1, 1), frame);
+        gal_clear_image(&target, 0, 0, 0, 1);
+        gal_render_draw_frame(frame, &target);
+        gal_read_image_data(&target, 0, 0, 8, 8, pixels);
+        u8 *p = &pixels[(4*8 + 4)*4];
+        u8 r = (u8)(tints[i].x*255), g = (u8)(tints[i].y*255), b = (u8)(tints[i].z*255);
+        assert(p[0] == r && p[1] == g && p[2] == b && p[3] == 255, "Failed: pixel drawn with the extension is %d %d %d %d, not %d %d %d 255", p[0], p[1], p[2], p[3], r, g, b);
+        
+        frame->shader_extension = (Gal_Shader_Extension){0};
+        frame->cbuffer = 0;
+        gal_destroy_shader_extension(&extension);
+    }
+    
+    os_delete_directory(directory, true);
+    gal_set_shader_cache_directory(STR(GAL_SHADER_CACHE_DEFAULT_DIRECTORY));
+    gal_destroy_image(&target);
+    draw_frame_deinit(frame);
+    Dealloc(heap, frame);
+    window.width = old_width;
+    window.height = old_height;
+    if (own_renderer) gal_shutdown();
+}
 #endif
 
 void oogabooga_run_tests() {
@@ -1760,6 +4627,14 @@ void oogabooga_run_tests() {
 	print("Testing growing array... ");
 	test_growing_array();
 	print("OK!\n");
+
+	print("Testing typed array... ");
+	test_array();
+	print("OK!\n");
+
+	print("Testing bucket array... ");
+	test_bucket_array();
+	print("OK!\n");
     
 	print("Testing allocator... ");
 	test_allocator(true);
@@ -1808,12 +4683,106 @@ void oogabooga_run_tests() {
 #if defined(RENDERER_OPENGL) && RENDERER_OPENGL
         print("Testing OpenGL backend... ");
         test_opengl_backend();
+        
+        print("Testing OpenGL streaming... ");
+        test_opengl_streaming();
+        print("OK!\n");
+        
+        print("Testing OpenGL shader extension... ");
+        test_opengl_shader_extension();
+        print("OK!\n");
 #endif
 
+	print("Testing sort algorithms... ");
+	test_sort_algorithms();
+	print("OK!\n");
+
 #ifndef OOGABOOGA_HEADLESS
         print("Testing radix sort... ");
         test_sort();
 	print("OK!\n");
+	
+	print("Testing draw frame camera... ");
+	test_draw_frame_camera();
+	print("OK!\n");
+	
+	print("Testing draw instance stream... ");
+	test_draw_instance_stream();
+	print("OK!\n");
+	
+	print("Testing draw calls... ");
+	test_draw_calls();
+	print("OK!\n");
+	
+	print("Testing texture atlas... ");
+	test_texture_atlas();
+	print("OK!\n");
+	
+	print("Testing batched drawing... ");
+	test_draw_batched();
+	print("OK!\n");
+	
+	print("Testing pixel snapping... ");
+	test_draw_pixel_snapping();
+	print("OK!\n");
+	
+	print("Testing draw scissors... ");
+	test_draw_scissors();
+	print("OK!\n");
+	
+	print("Testing draw lists... ");
+	test_draw_list();
+	print("OK!\n");
+	
+	print("Testing parallel draw recording... ");
+	test_draw_parallel_recording();
+	print("OK!\n");
+	
+	print("Testing spatial index... ");
+	test_spatial_index();
+	print("OK!\n");
+	
+	print("Testing audio DSP kernels... ");
+	test_audio_dsp();
+	print("OK!\n");
+	
+#if defined(RENDERER_SOFTWARE) && RENDERER_SOFTWARE
+	print("Testing software rasteriser... ");
+	test_software_rasteriser();
+	print("OK!\n");
+	
+	print("Testing software tiles... ");
+	test_software_tiles();
+	print("OK!\n");
+	
+	print("Testing software render targets... ");
+	test_software_render_targets();
+	print("OK!\n");
+	
+	print("Testing software instances... ");
+	test_software_instances();
+	print("OK!\n");
+#endif
+	
+	print("Testing null renderer... ");
+	test_null_renderer();
+	print("OK!\n");
+	
+	print("Testing GAL upload queue... ");
+	test_gal_upload_queue();
+	print("OK!\n");
+	
+	print("Testing GAL shader cache... ");
+	test_gal_shader_cache();
+	print("OK!\n");
+	
+	print("Testing GAL frame pipeline... ");
+	test_gal_frame_pipeline();
+	print("OK!\n");
+	
+	print("Testing GAL timing... ");
+	test_gal_timing();
+	print("OK!\n");
 #endif
 
 	
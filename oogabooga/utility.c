@@ -39,58 +39,189 @@ f32 min_f32(f32 a, f32 b) { return a < b ? a : b; }
 f64 max_f64(f64 a, f64 b) { return a > b ? a : b; }
 f64 min_f64(f64 a, f64 b) { return a < b ? a : b; }
 
+#define RADIX_SORT_BITS_PER_PASS 8
+#define RADIX_SORT_RADIX (1 << RADIX_SORT_BITS_PER_PASS)
+#define RADIX_SORT_MAX_KEY_BITS 32
+#define RADIX_SORT_MAX_PASSES (RADIX_SORT_MAX_KEY_BITS / RADIX_SORT_BITS_PER_PASS)
+// Below this we don't bother waking up the job pool
+#define RADIX_SORT_PARALLEL_THRESHOLD 100000
+#define RADIX_SORT_MAX_CHUNKS 32
+
+typedef u64 Radix_Sort_Histogram[RADIX_SORT_MAX_PASSES][RADIX_SORT_RADIX];
+
+typedef struct Radix_Sort_Job {
+	u64 *source;
+	u64 *destination;
+	u64 item_count;
+	u64 chunk_size;
+	u32 pass_count;
+	u32 pass;
+	Radix_Sort_Histogram *chunk_histograms;
+} Radix_Sort_Job;
+
+u32 radix_sort_digit(u64 pair, u32 pass) {
+	return (u32)(pair >> (32 + pass*RADIX_SORT_BITS_PER_PASS)) & (RADIX_SORT_RADIX-1);
+}
+
+// Counts the digits of every pass in one read of the chunk
+void radix_sort_histogram_job(void *data, u64 chunk) {
+	Radix_Sort_Job *job = (Radix_Sort_Job*)data;
+	u64 begin = chunk*job->chunk_size;
+	u64 end = min(begin + job->chunk_size, job->item_count);
+	
+	Radix_Sort_Histogram *h = &job->chunk_histograms[chunk];
+	memset(h, 0, sizeof(*h));
+	
+	for (u64 i = begin; i < end; i++) {
+		u64 pair = job->source[i];
+		for (u32 pass = 0; pass < job->pass_count; pass++) {
+			(*h)[pass][radix_sort_digit(pair, pass)] += 1;
+		}
+	}
+}
+// Recounts a single pass after earlier passes have moved items between chunks
+void radix_sort_count_job(void *data, u64 chunk) {
+	Radix_Sort_Job *job = (Radix_Sort_Job*)data;
+	u64 begin = chunk*job->chunk_size;
+	u64 end = min(begin + job->chunk_size, job->item_count);
+	
+	u64 *count = job->chunk_histograms[chunk][job->pass];
+	memset(count, 0, sizeof(u64)*RADIX_SORT_RADIX);
+	
+	for (u64 i = begin; i < end; i++) {
+		count[radix_sort_digit(job->source[i], job->pass)] += 1;
+	}
+}
+// Expects chunk_histograms[chunk][pass] to hold the chunk's output offsets
+void radix_sort_scatter_job(void *data, u64 chunk) {
+	Radix_Sort_Job *job = (Radix_Sort_Job*)data;
+	u64 begin = chunk*job->chunk_size;
+	u64 end = min(begin + job->chunk_size, job->item_count);
+	
+	u64 *offset = job->chunk_histograms[chunk][job->pass];
+	
+	for (u64 i = begin; i < end; i++) {
+		u64 pair = job->source[i];
+		job->destination[offset[radix_sort_digit(pair, job->pass)]++] = pair;
+	}
+}
+
+// Sorts 64-bit pairs laid out as (key << 32) | index by the lowest number_of_key_bits of the key.
+// Equal keys keep their order, so packing the original index in the low half makes this stable.
+// help_buffer must fit item_count pairs. The result ends up in either pairs or help_buffer
+// depending on how many passes were needed, so use the returned pointer.
+//
+// - The histograms for all passes are computed in one read.
+// - Passes where every key has the same digit are skipped entirely.
+// - Above RADIX_SORT_PARALLEL_THRESHOLD items the counting and scattering is split into
+//   chunks on the job pool. Each chunk gets its own output offsets per digit so the result
+//   is the same as the single threaded sort.
+u64 *radix_sort_key_index_pairs(u64 *pairs, u64 *help_buffer, u64 item_count, u64 number_of_key_bits) {
+	assert(number_of_key_bits > 0 && number_of_key_bits <= RADIX_SORT_MAX_KEY_BITS, "radix_sort_key_index_pairs supports 1-%d key bits, got %llu", RADIX_SORT_MAX_KEY_BITS, (unsigned long long)number_of_key_bits);
+	if (item_count <= 1) return pairs;
+	
+	Job_Pool *pool = 0;
+	u64 chunk_count = 1;
+	if (item_count >= RADIX_SORT_PARALLEL_THRESHOLD) {
+		pool = get_job_pool();
+		chunk_count = min(job_pool_get_worker_count(pool)+1, RADIX_SORT_MAX_CHUNKS);
+	}
+	
+	Radix_Sort_Histogram single_histogram;
+	
+	Radix_Sort_Job job = ZERO(Radix_Sort_Job);
+	job.item_count = item_count;
+	job.chunk_size = (item_count + chunk_count - 1) / chunk_count;
+	job.pass_count = (u32)((number_of_key_bits + RADIX_SORT_BITS_PER_PASS - 1) / RADIX_SORT_BITS_PER_PASS);
+	job.chunk_histograms = &single_histogram;
+	if (chunk_count > 1) {
+		job.chunk_histograms = (Radix_Sort_Histogram*)alloc_uninitialized(GetHeapAllocator(), chunk_count*sizeof(Radix_Sort_Histogram));
+	}
+	
+	job.source = pairs;
+	job.destination = help_buffer;
+	
+	if (chunk_count > 1) job_pool_run(pool, radix_sort_histogram_job, &job, chunk_count);
+	else                 radix_sort_histogram_job(&job, 0);
+	
+	bool has_moved_items = false;
+	for (u32 pass = 0; pass < job.pass_count; pass++) {
+		job.pass = pass;
+		
+		// The totals don't change when items move around, so the first histogram is still
+		// good for detecting passes that wouldn't do anything.
+		bool is_constant_digit = false;
+		for (u32 digit = 0; digit < RADIX_SORT_RADIX; digit++) {
+			u64 total = 0;
+			for (u64 chunk = 0; chunk < chunk_count; chunk++) total += job.chunk_histograms[chunk][pass][digit];
+			if (total == 0) continue;
+			is_constant_digit = total == item_count;
+			break;
+		}
+		if (is_constant_digit) continue;
+		
+		if (has_moved_items && chunk_count > 1) {
+			job_pool_run(pool, radix_sort_count_job, &job, chunk_count);
+		}
+		
+		u64 running = 0;
+		for (u32 digit = 0; digit < RADIX_SORT_RADIX; digit++) {
+			for (u64 chunk = 0; chunk < chunk_count; chunk++) {
+				u64 count = job.chunk_histograms[chunk][pass][digit];
+				job.chunk_histograms[chunk][pass][digit] = running;
+				running += count;
+			}
+		}
+		
+		if (chunk_count > 1) job_pool_run(pool, radix_sort_scatter_job, &job, chunk_count);
+		else                 radix_sort_scatter_job(&job, 0);
+		
+		u64 *temp = job.source;
+		job.source = job.destination;
+		job.destination = temp;
+		has_moved_items = true;
+	}
+	
+	if (chunk_count > 1) Dealloc(GetHeapAllocator(), job.chunk_histograms);
+	
+	return job.source;
+}
+
 // This is a very niche sort algorithm.
 // I use it for Z sorting quads.
 // help_buffer should be same size as collection.
-// This only works with integers, and it will use the first number_of_bits in the integer
-// at sort_value_offset_in_item for sorting.
-// There is a cost of memory as we need to double the buffer we're sorting BUT the performance
-// gain is very promising.
-// At 21 bits I'm able to sort a completely randomized collection of 100k integers at around
-// 8m cycles (or 2.5-2.6ms on my shitty laptop i5-11300H)
+// This only works with integers, and it will use the first number_of_bits (1-32) in the
+// integer at sort_value_offset_in_item for sorting. The value is treated as signed.
+// We only sort (key, index) pairs and then gather the items once at the end, so large items
+// like Draw_Quad are copied twice in total rather than twice per pass.
 void radix_sort(void *collection, void *help_buffer, u64 item_count, u64 item_size, u64 sort_value_offset_in_item, u64 number_of_bits) {
-    local_persist const int RADIX = 256;
-    local_persist const int BITS_PER_PASS = 8;
-    
-    const int PASS_COUNT = ((number_of_bits + BITS_PER_PASS - 1) / BITS_PER_PASS);
-    const u64 HALF_RANGE_OF_VALUE_BITS = 1ULL << (number_of_bits - 1);
-
-    u64 count[RADIX];
-    u64 prefix_sum[RADIX];
-
-    for (u32 pass = 0; pass < PASS_COUNT; ++pass) {
-        u32 shift = pass * BITS_PER_PASS;
-
-        memset(count, 0, sizeof(count));
-
-        for (u64 i = 0; i < item_count; ++i) {
-        	uint8_t *item = (uint8_t*)collection + i * item_size;
-        	
-            u64 sort_value = *(u64*)(item + sort_value_offset_in_item);
-            sort_value += HALF_RANGE_OF_VALUE_BITS; // We treat the value as a signed integer
-            
-            u32 digit = (sort_value >> shift) & (RADIX-1);
-            ++count[digit];
-        }
-
-        prefix_sum[0] = 0;
-        for (u32 i = 1; i < RADIX; ++i) {
-            prefix_sum[i] = prefix_sum[i - 1] + count[i - 1];
-        }
-
-        for (u64 i = 0; i < item_count; ++i) {
-        	uint8_t *item = (uint8_t*)collection + i * item_size;
-        	
-            u64 sort_value = *(u64*)(item + sort_value_offset_in_item);
-            sort_value += HALF_RANGE_OF_VALUE_BITS; // We treat the value as a signed integer
-            
-            u32 digit = (sort_value >> shift) & (RADIX-1);
-            memcpy((uint8_t*)help_buffer + prefix_sum[digit] * item_size, item, item_size);
-            ++prefix_sum[digit];
-        }
-
-        memcpy(collection, help_buffer, item_count * item_size);
-    }
+	if (item_count <= 1) return;
+	assert(item_count <= 0xFFFFFFFFull, "radix_sort supports at most 2^32 items");
+	assert(number_of_bits > 0 && number_of_bits <= RADIX_SORT_MAX_KEY_BITS, "radix_sort supports 1-%d bits, got %llu", RADIX_SORT_MAX_KEY_BITS, (unsigned long long)number_of_bits);
+	
+	const u64 HALF_RANGE_OF_VALUE_BITS = 1ULL << (number_of_bits - 1);
+	// Whole passes are sorted anyway, so keep every bit they cover like we always have
+	const u64 KEY_BITS = align_next(number_of_bits, RADIX_SORT_BITS_PER_PASS);
+	const u64 KEY_MASK = (1ULL << KEY_BITS) - 1;
+	
+	u64 *pairs = (u64*)alloc_uninitialized(GetHeapAllocator(), item_count*2*sizeof(u64));
+	
+	for (u64 i = 0; i < item_count; ++i) {
+		uint8_t *item = (uint8_t*)collection + i * item_size;
+		u64 sort_value = *(u64*)(item + sort_value_offset_in_item);
+		sort_value += HALF_RANGE_OF_VALUE_BITS; // We treat the value as a signed integer
+		pairs[i] = ((sort_value & KEY_MASK) << 32) | i;
+	}
+	
+	u64 *sorted = radix_sort_key_index_pairs(pairs, pairs + item_count, item_count, KEY_BITS);
+	
+	for (u64 i = 0; i < item_count; ++i) {
+		u64 index = sorted[i] & 0xFFFFFFFFull;
+		memcpy((uint8_t*)help_buffer + i * item_size, (uint8_t*)collection + index * item_size, item_size);
+	}
+	memcpy(collection, help_buffer, item_count * item_size);
+	
+	Dealloc(GetHeapAllocator(), pairs);
 }
 
 void merge_sort(void *collection, void *help_buffer, u64 item_count, u64 item_size, int (*compare)(const void *, const void *)) {
@@ -32,6 +32,7 @@ f64 min_f64(f64 a, f64 b);
 // Utility function for byte comparison
 bool bytes_match(void *a, void *b, u64 count);
 
+uint64_t *radix_sort_key_index_pairs(uint64_t *pairs, uint64_t *help_buffer, uint64_t item_count, uint64_t number_of_key_bits);
 void radix_sort(void *collection, void *help_buffer, uint64_t item_count, uint64_t item_size, uint64_t sort_value_offset_in_item, uint64_t number_of_bits);
 void merge_sort(void *collection, void *help_buffer, uint64_t item_count, uint64_t item_size, int (*compare)(const void *, const void *));
 